@@ -1,10 +1,15 @@
+#include <errno.h>
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <glib.h>
+#include <glib/gstdio.h>
 #include <neaacdec.h>
 
 #include <audacious/audtag.h>
+#include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/runtime.h>
@@ -41,6 +46,10 @@ const char * const AACDecoder::mimes[] = {"audio/aac", nullptr};
  */
 #define BUFFER_SIZE (FAAD_MIN_STREAMSIZE * 16)
 
+static const int adts_srates[] =
+ { 96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000,
+     11025, 8000, 0, 0, 0 };
+
 /*
  * These routines are derived from MPlayer.
  */
@@ -52,9 +61,6 @@ const char * const AACDecoder::mimes[] = {"audio/aac", nullptr};
 static int aac_parse_frame (unsigned char * buf, int * srate, int * num)
 {
     int i = 0, sr, fl = 0;
-    static int srates[] =
-     { 96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000,
-         11025, 8000, 0, 0, 0 };
 
     if ((buf[i] != 0xFF) || ((buf[i + 1] & 0xF6) != 0xF0))
         return 0;
@@ -65,7 +71,7 @@ static int aac_parse_frame (unsigned char * buf, int * srate, int * num)
     sr = (buf[i + 2] >> 2) & 0x0F;
     if (sr > 11)
         return 0;
-    *srate = srates[sr];
+    *srate = adts_srates[sr];
 
     fl =
      ((buf[i + 3] & 0x03) << 11) | (buf[i + 4] << 3) | ((buf[i +
@@ -147,123 +153,311 @@ static int aac_probe (unsigned char * buf, int len)
     return len;
 }
 
-/* Gets info (some approximated) from an AAC/ADTS file.  <length> is
- * milliseconds, <bitrate> is kilobits per second.  Any parameters that cannot
- * be read are set to -1. */
-static void calc_aac_info (VFSFile & handle, int * length, int * bitrate,
- int * samplerate, int * channels)
+/*
+ * ADTS frame index.  Raw AAC has no seek table, so the whole file is scanned
+ * once, recording the byte offset and sample position of every
+ * ADTS_INDEX_STEP'th frame.  This gives the exact length of VBR files and lets
+ * seeks start from a known frame.  The index is cached in the user directory,
+ * keyed by the file name and checked against the file size.  Once the cached
+ * indexes add up to more than ADTS_CACHE_SIZE, the least recently used ones
+ * are removed.
+ */
+
+#define ADTS_INDEX_MAGIC "AUDADTS1"
+#define ADTS_INDEX_STEP 32      /* frames between index points */
+#define ADTS_PREROLL 2048       /* samples decoded and dropped before a seek target */
+#define ADTS_SAMPLES 1024       /* samples per raw data block */
+#define ADTS_CACHE_SIZE (16 << 20)  /* bytes */
+
+struct AdtsPoint {
+    int64_t offset;             /* byte offset of the frame header */
+    int64_t sample;             /* sample position of the frame */
+};
+
+struct AdtsIndexHeader {
+    char magic[8];
+    int64_t file_size;
+    int64_t frames;
+    int64_t samples;            /* at the ADTS sample rate */
+    int64_t bytes;              /* total size of all frames */
+    int32_t rate;
+    int32_t n_points;
+};
+
+struct AdtsIndex {
+    AdtsIndexHeader header;
+    Index<AdtsPoint> points;
+
+    int length () const
+        { return header.samples * 1000 / header.rate; }
+};
+
+/* Parses a single ADTS header (at least 7 bytes).  Returns the size of the
+ * frame or 0 if there is no valid header. */
+static int adts_parse_header (const unsigned char * h, int * rate, int * blocks)
 {
-    NeAACDecHandle decoder;
-    NeAACDecFrameInfo frame;
-    bool initted = false;
-    int size = handle.fsize ();
-    unsigned char buffer[BUFFER_SIZE];
-    int offset = 0, filled = 0;
-    int found, bytes_used = 0, time_used = 0;
+    if (h[0] != 0xff || (h[1] & 0xf6) != 0xf0)
+        return 0;
+
+    int sr = (h[2] >> 2) & 0x0f;
+    if (sr > 11)
+        return 0;
 
-    decoder = nullptr;             /* avoid bogus uninitialized variable warning */
+    int len = ((h[3] & 0x03) << 11) | (h[4] << 3) | (h[5] >> 5);
+    if (len < ((h[1] & 0x01) ? 7 : 9))  /* header plus CRC, if present */
+        return 0;
 
-    *length = -1;
-    *bitrate = -1;
-    *samplerate = -1;
-    *channels = -1;
+    * rate = adts_srates[sr];
+    * blocks = (h[6] & 0x03) + 1;
+    return len;
+}
+
+static bool adts_scan (VFSFile & file, AdtsIndex & index)
+{
+    int64_t size = file.fsize ();
+    if (size <= 0 || file.fseek (0, VFS_SEEK_SET))
+        return false;
 
-    /* look for a representative bitrate in the middle of the file */
-    if (size < 0 || handle.fseek (size / 2, VFS_SEEK_SET) < 0)
-        goto DONE;
+    unsigned char buf[BUFFER_SIZE];
+    int64_t buf_offset = 0;
+    int filled = file.fread (buf, 1, sizeof buf);
+    int64_t offset = 0;
+
+    if (filled >= 10 && ! strncmp ((char *) buf, "ID3", 3))
+        offset = 10 + (buf[6] << 21) + (buf[7] << 14) + (buf[8] << 7) + buf[9];
+
+    AdtsIndexHeader & header = index.header;
+    memset (& header, 0, sizeof header);
+    memcpy (header.magic, ADTS_INDEX_MAGIC, sizeof header.magic);
+    header.file_size = size;
+    index.points.clear ();
 
-    for (found = 0; found < 32; found++)
+    while (offset < size)
     {
-        if (filled < BUFFER_SIZE / 2)
+        if (offset < buf_offset || offset + 7 > buf_offset + filled)
         {
-            memmove (buffer, buffer + offset, filled);
-            offset = 0;
+            if (file.fseek (offset, VFS_SEEK_SET))
+                break;
 
-            if (handle.fread (buffer + filled, 1, BUFFER_SIZE - filled)
-             != BUFFER_SIZE - filled)
-            {
-                PROBE_DEBUG ("Read failed.\n");
-                goto DONE;
-            }
+            buf_offset = offset;
+            filled = file.fread (buf, 1, sizeof buf);
 
-            filled = BUFFER_SIZE;
+            if (filled < 7)
+                break;
         }
 
-        if (!initted)
+        int rate, blocks;
+        int len = adts_parse_header (buf + (offset - buf_offset), & rate, & blocks);
+
+        /* skip over garbage and stray sync words */
+        if (! len || (header.rate && rate != header.rate))
         {
-            int inner, a;
-            unsigned long r;
-            unsigned char ch;
+            offset ++;
+            continue;
+        }
 
-            inner = find_aac_header (buffer + offset, filled, &a);
+        if (offset + len > size)
+            break;  /* truncated last frame */
 
-            if (inner < 0)
-            {
-                PROBE_DEBUG ("No ADTS header.\n");
-                goto DONE;
-            }
+        if (! (header.frames % ADTS_INDEX_STEP))
+            index.points.append (offset, header.samples);
 
-            offset += inner;
-            filled -= inner;
+        header.rate = rate;
+        header.frames ++;
+        header.samples += blocks * ADTS_SAMPLES;
+        header.bytes += len;
+        offset += len;
+    }
 
-            decoder = NeAACDecOpen ();
-            inner = NeAACDecInit (decoder, buffer + offset, filled, &r, &ch);
+    header.n_points = index.points.len ();
+    AUDDBG ("Indexed %" PRId64 " ADTS frames, %" PRId64 " samples at %d Hz.\n",
+     header.frames, header.samples, header.rate);
 
-            if (inner < 0)
-            {
-                PROBE_DEBUG ("Decoder init failed.\n");
-                NeAACDecClose (decoder);
-                goto DONE;
-            }
+    return header.samples > 0;
+}
 
-            offset += inner;
-            filled -= inner;
-            bytes_used += inner;
+static StringBuf adts_cache_dir ()
+{
+    return filename_build ({aud_get_path (AudPath::UserDir), "aac-index"});
+}
 
-            *samplerate = r;
-            *channels = ch;
-            initted = true;
-        }
+static StringBuf adts_cache_path (const char * filename)
+{
+    char * hash = g_compute_checksum_for_string (G_CHECKSUM_MD5, filename, -1);
+    StringBuf path = filename_build ({adts_cache_dir (), hash});
+    g_free (hash);
+    return path;
+}
 
-        if (NeAACDecDecode (decoder, &frame, buffer + offset, filled) == nullptr)
-        {
-            PROBE_DEBUG ("Decode failed.\n");
-            goto DONE;
-        }
+struct CachedIndex {
+    String path;
+    time_t used;
+    int64_t size;
+};
+
+static void adts_prune_cache (const char * cache_dir)
+{
+    Index<CachedIndex> files;
+    int64_t total = 0;
+
+    GDir * dir = g_dir_open (cache_dir, 0, nullptr);
+    if (! dir)
+        return;
+
+    const char * name;
+    while ((name = g_dir_read_name (dir)))
+    {
+        StringBuf path = filename_build ({cache_dir, name});
+        GStatBuf st;
 
-        if ((int)frame.samplerate != *samplerate || (int)frame.channels != *channels)
+        if (g_stat (path, & st) == 0 && S_ISREG (st.st_mode))
         {
-            PROBE_DEBUG ("Parameter mismatch.\n");
-            goto DONE;
+            files.append (String (path), st.st_mtime, (int64_t) st.st_size);
+            total += st.st_size;
         }
+    }
+
+    g_dir_close (dir);
 
-        offset += frame.bytesconsumed;
-        filled -= frame.bytesconsumed;
-        bytes_used += frame.bytesconsumed;
-        time_used += frame.samples / frame.channels * (int64_t) 1000 /
-         frame.samplerate;
+    if (total <= ADTS_CACHE_SIZE)
+        return;
+
+    files.sort ([] (const CachedIndex & a, const CachedIndex & b)
+        { return (a.used > b.used) - (a.used < b.used); });
+
+    for (const CachedIndex & file : files)
+    {
+        if (total <= ADTS_CACHE_SIZE)
+            break;
+
+        AUDDBG ("Removing cached ADTS index %s\n", (const char *) file.path);
+        g_remove (file.path);
+        total -= file.size;
     }
+}
+
+static bool adts_load_index (const char * filename, VFSFile & file, AdtsIndex & index)
+{
+    StringBuf path = adts_cache_path (filename);
+    VFSFile cache (filename_to_uri (path), "r");
+    if (! cache)
+        return false;
 
-    /* bits per millisecond = kilobits per second */
-    *bitrate = bytes_used * 8 / time_used;
+    AdtsIndexHeader & header = index.header;
 
-    if (size > 0)
-        *length = size * (int64_t) time_used / bytes_used;
+    if (cache.fread (& header, sizeof header, 1) != 1 ||
+     memcmp (header.magic, ADTS_INDEX_MAGIC, sizeof header.magic) ||
+     header.file_size != file.fsize () || header.rate <= 0 ||
+     header.samples <= 0 || header.n_points <= 0)
+        return false;
+
+    index.points.resize (header.n_points);
+    if (cache.fread (index.points.begin (), sizeof (AdtsPoint), header.n_points) != header.n_points)
+        return false;
 
-  DONE:
-    if (initted)
-        NeAACDecClose (decoder);
+    /* cheap sanity check that the file has not been rewritten in place */
+    unsigned char check[7];
+    int rate, blocks;
+
+    if (file.fseek (index.points[header.n_points - 1].offset, VFS_SEEK_SET) ||
+     file.fread (check, 1, sizeof check) != sizeof check ||
+     ! adts_parse_header (check, & rate, & blocks) || rate != header.rate)
+        return false;
+
+    g_utime (path, nullptr);  /* mark as recently used */
+    return true;
+}
+
+static void adts_save_index (const char * filename, const AdtsIndex & index)
+{
+    StringBuf path = adts_cache_path (filename);
+    StringBuf dir = adts_cache_dir ();
+
+    if (g_mkdir_with_parents (dir, 0755) < 0)
+    {
+        AUDERR ("Failed to create %s: %s\n", (const char *) dir, strerror (errno));
+        return;
+    }
+
+    VFSFile cache (filename_to_uri (path), "w");
+
+    if (! cache || cache.fwrite (& index.header, sizeof index.header, 1) != 1 ||
+     cache.fwrite (index.points.begin (), sizeof (AdtsPoint), index.points.len ())
+     != index.points.len ())
+    {
+        AUDERR ("Failed to write %s.\n", (const char *) path);
+        return;
+    }
+
+    adts_prune_cache (dir);
+}
+
+/* Loads the cached index for <filename>, scanning the file if needed. */
+static bool adts_get_index (const char * filename, VFSFile & file, AdtsIndex & index)
+{
+    if (adts_load_index (filename, file, index))
+        return true;
+
+    if (! adts_scan (file, index))
+        return false;
+
+    adts_save_index (filename, index);
+    return true;
+}
+
+/* Reads the sample rate and channel count from the ADTS frame at <offset>.
+ * Any parameters that cannot be read are set to -1. */
+static void calc_aac_info (VFSFile & handle, int64_t offset, int * samplerate,
+ int * channels)
+{
+    unsigned char buffer[BUFFER_SIZE];
+    unsigned long r;
+    unsigned char ch;
+
+    *samplerate = -1;
+    *channels = -1;
+
+    if (handle.fseek (offset, VFS_SEEK_SET) < 0)
+        return;
+
+    int filled = handle.fread (buffer, 1, sizeof buffer);
+    if (filled <= 0)
+    {
+        PROBE_DEBUG ("Read failed.\n");
+        return;
+    }
+
+    NeAACDecHandle decoder = NeAACDecOpen ();
+
+    if (NeAACDecInit (decoder, buffer, filled, &r, &ch) < 0)
+        PROBE_DEBUG ("Decoder init failed.\n");
+    else
+    {
+        *samplerate = r;
+        *channels = ch;
+    }
+
+    NeAACDecClose (decoder);
 }
 
 bool AACDecoder::read_tag (const char * filename, VFSFile & file, Tuple & tuple,
  Index<char> * image)
 {
-    int length, bitrate, samplerate, channels;
+    int length = -1, bitrate = -1, samplerate, channels = -1;
 
     tuple.set_str (Tuple::Codec, "MPEG-2/4 AAC");
 
-    // TODO: error handling
-    calc_aac_info (file, &length, &bitrate, &samplerate, &channels);
+    /* the index gives the exact length and average bitrate; the format is
+     * read from the first frame */
+    AdtsIndex index;
+    if (adts_get_index (filename, file, index))
+    {
+        length = index.length ();
+        if (length > 0)
+            bitrate = index.header.bytes * 8 / length;
+
+        calc_aac_info (file, index.points[0].offset, &samplerate, &channels);
+    }
 
     if (length > 0)
         tuple.set_int (Tuple::Length, length);
@@ -334,6 +528,54 @@ static void aac_seek (VFSFile & file, NeAACDecHandle dec, int time, int len,
     }
 }
 
+/* Seeks using the frame index.  Decoding restarts ADTS_PREROLL samples before
+ * the target; <skip> is set to the number of output frames to drop. */
+static bool adts_seek (VFSFile & file, NeAACDecHandle dec, const AdtsIndex & index,
+ int time, unsigned long out_rate, unsigned char * buf, int size, int * buflen,
+ int64_t * skip)
+{
+    int64_t target = (int64_t) time * index.header.rate / 1000;
+    int64_t start = target - ADTS_PREROLL;
+
+    int lo = 0, hi = index.points.len () - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (index.points[mid].sample <= start)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    const AdtsPoint & point = index.points[lo];
+
+    if (file.fseek (point.offset, VFS_SEEK_SET))
+        return false;
+
+    * buflen = file.fread (buf, 1, size);
+
+    unsigned char chan;
+    unsigned long rate;
+    int used;
+
+    if ((used = NeAACDecInit (dec, buf, * buflen, & rate, & chan)) < 0)
+    {
+        AUDERR ("Failed to initialize AAC decoder.\n");
+        * buflen = 0;
+        return true;
+    }
+
+    if (used)
+    {
+        * buflen -= used;
+        memmove (buf, buf + used, * buflen);
+        * buflen += file.fread (buf + * buflen, 1, size - * buflen);
+    }
+
+    * skip = aud::max (target - point.sample, (int64_t) 0) * out_rate / index.header.rate;
+    return true;
+}
+
 bool AACDecoder::play (const char * filename, VFSFile & file)
 {
     NeAACDecHandle decoder = 0;
@@ -344,6 +586,12 @@ bool AACDecoder::play (const char * filename, VFSFile & file)
     Tuple tuple = get_playback_tuple ();
     int bitrate = 1000 * aud::max (0, tuple.get_int (Tuple::Bitrate));
 
+    /* only a cached index is used here; a missing one is built on first seek */
+    AdtsIndex index;
+    bool have_index = adts_load_index (filename, file, index);
+    bool index_tried = have_index;
+    int64_t skip = 0;       /* output frames to drop after a seek */
+
     if ((decoder = NeAACDecOpen ()) == nullptr)
     {
         AUDERR ("Open Decoder Error\n");
@@ -358,6 +606,13 @@ bool AACDecoder::play (const char * filename, VFSFile & file)
 
     unsigned char buf[BUFFER_SIZE];
     int buflen;
+
+    if (file.fseek (0, VFS_SEEK_SET))
+    {
+        AUDERR ("Failed to seek to start of file.\n");
+        goto ERR_CLOSE_DECODER;
+    }
+
     buflen = file.fread (buf, 1, sizeof buf);
 
     /* == SKIP ID3 TAG == */
@@ -429,9 +684,21 @@ bool AACDecoder::play (const char * filename, VFSFile & file)
 
         if (seek_value >= 0)
         {
-            int length = tuple.get_int (Tuple::Length);
-            if (length > 0)
-                aac_seek (file, decoder, seek_value, length, buf, sizeof buf, & buflen);
+            if (! index_tried)
+            {
+                have_index = adts_get_index (filename, file, index);
+                index_tried = true;
+            }
+
+            skip = 0;
+
+            if (! have_index || ! adts_seek (file, decoder, index, seek_value,
+             samplerate, buf, sizeof buf, & buflen, & skip))
+            {
+                int length = tuple.get_int (Tuple::Length);
+                if (length > 0)
+                    aac_seek (file, decoder, seek_value, length, buf, sizeof buf, & buflen);
+            }
         }
 
         /* == CHECK FOR END OF FILE == */
@@ -473,6 +740,14 @@ bool AACDecoder::play (const char * filename, VFSFile & file)
 
         /* == PLAY THE SOUND == */
 
+        if (audio && info.samples && skip > 0)
+        {
+            int drop = aud::min (skip * info.channels, (int64_t) info.samples);
+            audio = (float *) audio + drop;
+            info.samples -= drop;
+            skip -= drop / info.channels;
+        }
+
         if (audio && info.samples)
             write_audio (audio, sizeof (float) * info.samples);
     }
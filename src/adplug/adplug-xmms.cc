@@ -43,6 +43,8 @@
 
 #include "adplug-xmms.h"
 
+#include "../render-cache-common/rendercache.h"
+
 #define CFG_ID "AdPlug"
 
 #define ADPLUG_MAME  0
@@ -172,6 +174,24 @@ bool AdPlugXMMS::read_tag (const char * filename, VFSFile & file, Tuple & tuple,
   return true;
 }
 
+/* The render cache key covers the file, the AdPlug version and the output
+ * settings.  Songs repeated endlessly never end, so they are not cached.
+ * Songs are only recorded as they play, since some of the OPL emulators keep
+ * their state in global variables. */
+static String cache_key (VFSFile & fd, int emulator, int freq, bool endless,
+ unsigned subsong)
+{
+  if (! render_cache_enabled () || endless)
+    return String ();
+
+  Index<char> data = fd.read_all ();
+  if (fd.fseek (0, VFS_SEEK_SET))
+    return String ();
+
+  return render_cache_key ("adplug", CAdPlug::get_version ().c_str (), data,
+   str_printf ("emulator=%d rate=%d subsong=%u", emulator, freq, subsong));
+}
+
 /* Main playback thread. Takes the filename to play as argument. */
 bool AdPlugXMMS::play (const char * filename, VFSFile & fd)
 {
@@ -181,6 +201,27 @@ bool AdPlugXMMS::play (const char * filename, VFSFile & fd)
   int freq = aud_get_int (CFG_ID, "Frequency");
   bool endless = aud_get_bool (CFG_ID, "Endless");
 
+  // reset to first subsong on new file
+  dbg_printf ("subsong, ");
+  if (! plr.filename || strcmp (filename, plr.filename))
+  {
+    plr.filename = String (filename);
+    plr.subsong = 0;
+  }
+
+  // look in the render cache
+  dbg_printf ("cache, ");
+  RenderCacheWriter writer;
+  String key = cache_key (fd, emulator, freq, endless, plr.subsong);
+
+  if (key)
+  {
+    if (render_cache_play (key, 2, freq))
+      return true;
+
+    writer.open (key, 2, freq);
+  }
+
   // Set XMMS main window information
   dbg_printf ("xmms, ");
   set_stream_bitrate (freq * SAMPLESIZE * 8);
@@ -216,6 +257,7 @@ bool AdPlugXMMS::play (const char * filename, VFSFile & fd)
   long toadd = 0, i, towrite;
   char *sndbuf, *sndbufpos;
   bool playing = true;  // Song self-end indicator.
+  bool stopped = false;
 
   // Try to load module
   dbg_printf ("factory, ");
@@ -227,14 +269,6 @@ bool AdPlugXMMS::play (const char * filename, VFSFile & fd)
     return false;
   }
 
-  // reset to first subsong on new file
-  dbg_printf ("subsong, ");
-  if (! plr.filename || strcmp (filename, plr.filename))
-  {
-    plr.filename = String (filename);
-    plr.subsong = 0;
-  }
-
   // Allocate audio buffer
   dbg_printf ("buffer, ");
   // 4 byte sample size
@@ -251,13 +285,18 @@ bool AdPlugXMMS::play (const char * filename, VFSFile & fd)
   while ((playing || endless))
   {
     if (check_stop ())
+    {
+      stopped = true;
       break;
+    }
 
     int seek = check_seek ();
 
     // seek requested ?
     if (seek != -1)
     {
+      writer.discard ();
+
       // backward seek ?
       if (seek < time)
       {
@@ -290,8 +329,12 @@ bool AdPlugXMMS::play (const char * filename, VFSFile & fd)
     }
 
     write_audio (sndbuf, SNDBUFSIZE * SAMPLESIZE);
+    writer.write ((const int16_t *) sndbuf, SNDBUFSIZE);
   }
 
+  if (! stopped)
+    writer.finish ();
+
   // free everything and exit
   dbg_printf ("free");
   plr.p.clear ();
@@ -354,7 +397,8 @@ const PreferencesWidget AdPlugXMMS::widgets[] = {
     WidgetInt (CFG_ID, "Frequency"), {8000, 192000, 50, N_("Hz")}),
   WidgetLabel (N_("<b>Miscellaneous</b>")),
   WidgetCheck (N_("Repeat song in endless loop"),
-    WidgetBool (CFG_ID, "Endless"))
+    WidgetBool (CFG_ID, "Endless")),
+  WidgetBox ({{render_cache_record_widgets}})
 };
 
 const PluginPreferences AdPlugXMMS::prefs = {{widgets}};
@@ -362,6 +406,7 @@ const PluginPreferences AdPlugXMMS::prefs = {{widgets}};
 bool AdPlugXMMS::init ()
 {
   aud_config_set_defaults (CFG_ID, defaults);
+  render_cache_init ();
 
   // Load database from disk and hand it to AdPlug
   dbg_printf ("database");
@@ -393,4 +438,6 @@ void AdPlugXMMS::cleanup ()
   dbg_printf ("db, ");
   plr.db.clear ();
   plr.filename = String ();
+
+  render_cache_cleanup ();
 }
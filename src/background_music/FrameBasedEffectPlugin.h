@@ -18,17 +18,98 @@
  * implied. In no event shall the authors be liable for any damages arising from
  * the use of this software.
  */
+#include "LoudnessCache.h"
 #include "LoudnessFrameProcessor.h"
+#include "R128Meter.h"
+#include <libaudcore/drct.h>
 #include <libaudcore/plugin.h>
 
 class FrameBasedEffectPlugin : public EffectPlugin
 {
-    Index<float> frame_in;
-    Index<float> frame_out;
+    /* Tracks shorter than this are not worth remembering. */
+    static constexpr int MINIMUM_MEASURED_SECONDS = 3;
+
     Index<float> output;
-    int current_channels = 0, current_rate = 0, channel_last_read = 0;
+    int current_channels = 0, current_rate = 0;
     LoudnessFrameProcessor detection;
 
+    /*
+     * Every track that is played from start to end is measured according to
+     * EBU R128. The result is cached and can be used to normalize the track
+     * with a fixed gain the next time it is played.
+     */
+    R128Meter meter;
+    LoudnessCache cache;
+    String track_uri;
+    bool track_started = false;
+    bool track_complete = false;
+    int track_length = 0;
+
+    float get_track_gain(const TrackLoudness & loudness) const
+    {
+        const double target = aud::clamp(
+            aud_get_double(CONFIG_SECTION_BACKGROUND_MUSIC,
+                           CONF_TARGET_LEVEL_VARIABLE),
+            CONF_TARGET_LEVEL_MIN, CONF_TARGET_LEVEL_MAX);
+        const double max_amplification = aud::clamp(
+            aud_get_double(CONFIG_SECTION_BACKGROUND_MUSIC,
+                           CONF_MAX_AMPLIFICATION_VARIABLE),
+            CONF_MAX_AMPLIFICATION_MIN, CONF_MAX_AMPLIFICATION_MAX);
+
+        double gain = std::min(target - loudness.loudness, max_amplification);
+        /* never push the true peak over full scale */
+        if (loudness.peak > 0)
+            gain = std::min(gain, -20.0 * log10(loudness.peak));
+
+        return static_cast<float>(pow(10.0, gain / 20.0));
+    }
+
+    void begin_track(String && uri)
+    {
+        track_started = true;
+        track_complete = true;
+        track_uri = std::move(uri);
+        track_length = aud_drct_get_length();
+        meter.reset(current_channels, current_rate);
+
+        const TrackLoudness * loudness = cache.lookup(track_uri);
+        const bool use_track_gain =
+            loudness && aud_get_int(CONFIG_SECTION_BACKGROUND_MUSIC,
+                                    CONF_NORMALIZATION_VARIABLE) ==
+                            NORMALIZATION_TRACK;
+
+        detection.set_fixed_gain(use_track_gain ? get_track_gain(*loudness)
+                                                : 0.0f);
+    }
+
+    void end_track()
+    {
+        /* playback that resumed in the middle of the track */
+        const int64_t played_ms =
+            aud::rescale<int64_t>(meter.frames(), current_rate, 1000);
+        if (track_length > 0 && played_ms < track_length - 1000)
+            track_complete = false;
+
+        if (track_started && track_complete && track_uri &&
+            meter.has_loudness() &&
+            played_ms >= MINIMUM_MEASURED_SECONDS * 1000)
+        {
+            TrackLoudness loudness;
+            loudness.loudness =
+                static_cast<float>(meter.integrated_loudness());
+            loudness.peak = meter.true_peak();
+
+            AUDDBG("%s: %.2f LUFS, true peak %.6f\n", (const char *)track_uri,
+                   loudness.loudness, loudness.peak);
+
+            cache.add(track_uri, loudness,
+                      aud_get_bool(CONFIG_SECTION_BACKGROUND_MUSIC,
+                                   CONF_WRITE_TAGS_VARIABLE));
+        }
+
+        track_started = false;
+    }
+
 public:
     FrameBasedEffectPlugin(const PluginInfo & info, int order)
         : EffectPlugin(info, order, true)
@@ -40,25 +121,25 @@ public:
     bool init() override
     {
         detection.init();
+        cache.load();
         return true;
     }
 
     void cleanup() override
     {
         output.clear();
-        frame_in.clear();
-        frame_out.clear();
+        cache.clear();
+        track_uri = String();
+        track_started = false;
     }
 
     void start(int & channels, int & rate) override
     {
         current_channels = channels;
         current_rate = rate;
-        channel_last_read = 0;
 
         detection.start(channels, rate);
-        frame_in.resize(current_channels);
-        frame_out.resize(current_channels);
+        track_started = false;
 
         flush(false);
     }
@@ -67,27 +148,19 @@ public:
     {
         detection.update_config();
 
-        int output_samples = 0;
-        output.resize(0);
+        /* a different track may start without finish() being called */
+        String uri = aud_drct_get_filename();
+        if (!track_started || uri != track_uri)
+            begin_track(std::move(uri));
 
-        // It is assumed data always contains a multiple of channels, but we
-        // don't care.
-        for (const float sample : data)
-        {
-            frame_in[channel_last_read++] = sample;
-            if (channel_last_read == current_channels)
-            {
-                // Processing happens per frame. Because of read-ahead there is
-                // not always output available yet.
-                if (detection.process_has_output(frame_in, frame_out))
-                {
-                    output.move_from(frame_out, 0, output_samples,
-                                     current_channels, true, false);
-                    output_samples += current_channels;
-                }
-                channel_last_read = 0;
-            }
-        }
+        // It is assumed data always contains a multiple of channels.
+        const int frames = data.len() / current_channels;
+        meter.add_frames(data.begin(), frames);
+
+        output.resize(frames * current_channels);
+        const int output_frames =
+            detection.process(data.begin(), output.begin(), frames);
+        output.resize(output_frames * current_channels);
 
         return output;
     }
@@ -95,12 +168,16 @@ public:
     bool flush(bool force) override
     {
         detection.flush();
+        /* after a seek, the measurement no longer covers the whole track */
+        track_complete = false;
         return true;
     }
 
     Index<float> & finish(Index<float> & data, bool end_of_playlist) override
     {
-        return process(data);
+        process(data);
+        end_track();
+        return output;
     }
 
     int adjust_delay(int delay) override
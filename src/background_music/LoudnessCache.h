@@ -0,0 +1,233 @@
+#ifndef AUDACIOUS_PLUGINS_BGM_LOUDNESS_CACHE_H
+#define AUDACIOUS_PLUGINS_BGM_LOUDNESS_CACHE_H
+/*
+ * Background music (equal loudness) Plugin for Audacious
+ * Copyright 2023 Michel Fleur
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/index.h>
+#include <libaudcore/mainloop.h>
+#include <libaudcore/multihash.h>
+#include <libaudcore/probe.h>
+#include <libaudcore/runtime.h>
+#include <libaudcore/tuple.h>
+
+/**
+ * Loudness of a completely played track, as measured by R128Meter.
+ */
+struct TrackLoudness
+{
+    /** ReplayGain 2.0 uses -18 LUFS as its reference level. */
+    static constexpr double REPLAYGAIN_REFERENCE = -18.0;
+
+    float loudness = 0; /* LUFS */
+    float peak = 0;     /* linear true peak */
+
+    [[nodiscard]] float replay_gain() const
+    {
+        return static_cast<float>(REPLAYGAIN_REFERENCE) - loudness;
+    }
+};
+
+/**
+ * Keeps the measured loudness of every track that has been played from start
+ * to end, keyed by URI. The cache file in the user directory is a plain
+ * text log with one "loudness<TAB>peak<TAB>uri" line per measurement; newer
+ * lines override older ones, so results only ever need to be appended.
+ * Repeating a measurement that did not change writes nothing, and the log is
+ * rewritten without the overridden lines when it is loaded.
+ *
+ * Optionally, results are also written to the file as ReplayGain tags. Tag
+ * writing touches the decoder and the file system, so it is done from the
+ * main loop rather than from the playback thread.
+ */
+class LoudnessCache
+{
+    SimpleHash<String, TrackLoudness> tracks_;
+    bool loaded_ = false;
+
+    pthread_mutex_t tag_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+    Index<String> tag_uris_;
+    Index<TrackLoudness> tag_values_;
+    QueuedFunc tag_writer_;
+
+    static StringBuf cache_path()
+    {
+        return filename_build(
+            {aud_get_path(AudPath::UserDir), "background_music-loudness"});
+    }
+
+    static StringBuf format_line(const char * uri,
+                                 const TrackLoudness & loudness)
+    {
+        return str_printf("%.2f\t%.6f\t%s\n", loudness.loudness, loudness.peak,
+                          uri);
+    }
+
+    void compact()
+    {
+        StringBuf path = cache_path();
+        StringBuf temp = str_concat({path, ".tmp"});
+
+        FILE * handle = fopen(temp, "w");
+        if (!handle)
+        {
+            AUDERR("Could not write %s\n", (const char *)temp);
+            return;
+        }
+
+        bool ok = true;
+        tracks_.iterate([&](const String & uri, TrackLoudness & loudness) {
+            if (fputs(format_line(uri, loudness), handle) < 0)
+                ok = false;
+        });
+
+        if (fclose(handle) != 0 || !ok || rename(temp, path) != 0)
+        {
+            AUDERR("Could not write %s\n", (const char *)path);
+            remove(temp);
+        }
+    }
+
+    static void write_tags(const char * uri, const TrackLoudness & loudness)
+    {
+        VFSFile file;
+        PluginHandle * decoder = aud_file_find_decoder(uri, true, file);
+        if (!decoder || !aud_file_can_write_tuple(uri, decoder))
+            return;
+
+        Tuple tuple;
+        if (!aud_file_read_tag(uri, decoder, file, tuple))
+            return;
+
+        file = VFSFile(); /* the decoder reopens the file for writing */
+
+        tuple.set_gain(Tuple::TrackGain, Tuple::GainDivisor,
+                       str_printf("%.2f", loudness.replay_gain()));
+        tuple.set_gain(Tuple::TrackPeak, Tuple::PeakDivisor,
+                       str_printf("%.6f", loudness.peak));
+
+        if (!aud_file_write_tuple(uri, decoder, tuple))
+            AUDERR("Could not write ReplayGain tags to %s\n", uri);
+    }
+
+    void write_pending_tags()
+    {
+        pthread_mutex_lock(&tag_mutex_);
+        Index<String> uris = std::move(tag_uris_);
+        Index<TrackLoudness> values = std::move(tag_values_);
+        pthread_mutex_unlock(&tag_mutex_);
+
+        for (int i = 0; i < uris.len(); i++)
+            write_tags(uris[i], values[i]);
+    }
+
+public:
+    void load()
+    {
+        if (loaded_)
+            return;
+
+        loaded_ = true;
+
+        FILE * handle = fopen(cache_path(), "r");
+        if (!handle)
+            return;
+
+        int lines = 0;
+        char line[4096];
+        while (fgets(line, sizeof line, handle))
+        {
+            lines++;
+
+            char * uri_start = strchr(line, '\t');
+            uri_start = uri_start ? strchr(uri_start + 1, '\t') : nullptr;
+            if (!uri_start)
+                continue;
+
+            char * end = uri_start + strlen(uri_start);
+            if (end > uri_start + 1 && end[-1] == '\n')
+                end[-1] = 0;
+
+            TrackLoudness loudness;
+            if (sscanf(line, "%f\t%f", &loudness.loudness, &loudness.peak) !=
+                2)
+                continue;
+
+            tracks_.add(String(uri_start + 1), std::move(loudness));
+        }
+
+        fclose(handle);
+
+        if (lines > tracks_.n_items())
+            compact();
+    }
+
+    void clear()
+    {
+        tag_writer_.stop();
+        write_pending_tags();
+        tracks_.clear();
+        loaded_ = false;
+    }
+
+    [[nodiscard]] const TrackLoudness * lookup(const String & uri)
+    {
+        return uri ? tracks_.lookup(uri) : nullptr;
+    }
+
+    void add(const String & uri, const TrackLoudness & loudness,
+             bool write_tag)
+    {
+        StringBuf line = format_line(uri, loudness);
+
+        /* replaying a track usually measures exactly the same loudness */
+        const TrackLoudness * known = tracks_.lookup(uri);
+        bool changed = !known || strcmp(format_line(uri, *known), line);
+
+        if (changed)
+        {
+            tracks_.add(uri, TrackLoudness(loudness));
+
+            FILE * handle = fopen(cache_path(), "a");
+            if (handle)
+            {
+                fputs(line, handle);
+                fclose(handle);
+            }
+            else
+                AUDERR("Could not write %s\n", (const char *)cache_path());
+        }
+
+        if (write_tag)
+        {
+            pthread_mutex_lock(&tag_mutex_);
+            tag_uris_.append(uri);
+            tag_values_.append(loudness);
+            pthread_mutex_unlock(&tag_mutex_);
+
+            tag_writer_.queue([this]() { write_pending_tags(); });
+        }
+    }
+};
+
+#endif // AUDACIOUS_PLUGINS_BGM_LOUDNESS_CACHE_H
@@ -43,6 +43,7 @@ class LoudnessFrameProcessor
     float maximum_amplification = 1;
     float perception_slow_balance = 0.3;
     float minimum_detection = 1e-6;
+    float fixed_gain = 0;
     RingBuf<float> read_ahead_buffer;
     int channels_ = 0;
     int processed_frames = 0;
@@ -63,6 +64,33 @@ class LoudnessFrameProcessor
         return powf(10.0f, 0.05f * decibels);
     }
 
+    float get_gain(const float * frame)
+    {
+        float square_sum = 0.0;
+        float square_max = 0.0;
+        for (int c = 0; c < channels_; c++)
+        {
+            const float square = frame[c] * frame[c];
+            square_max = std::max(square_max, square);
+            square_sum += square;
+        }
+        square_sum /= static_cast<float>(channels_);
+        square_sum += square_max;
+        const float perceived = FAST_VU_FUDGE_FACTOR *
+                                perceivedLoudness.get_mean_squared(square_sum);
+        const double weighted =
+            std::max(long_integration.integrate(square_sum), perceived);
+
+        const double rms = sqrt(weighted);
+
+        const float gain =
+            target_level /
+            std::max(minimum_detection,
+                     static_cast<float>(release_integration.get_envelope(rms)));
+
+        return fixed_gain > 0 ? fixed_gain : gain;
+    }
+
 public:
     [[nodiscard]] int latency() const { return perceivedLoudness.latency(); }
 
@@ -122,56 +150,57 @@ public:
         long_integration.set_scale(slow_weight);
     }
 
-    bool process_has_output(const Index<float> & frame_in,
-                            Index<float> & frame_out)
+    /**
+     * Sets a fixed gain, for example from a measured track loudness, to use
+     * instead of the live detection. A gain of zero returns to live
+     * detection. The detection keeps running either way, so that switching
+     * back does not start from scratch.
+     */
+    void set_fixed_gain(const float gain) { fixed_gain = gain; }
+
+    /**
+     * Processes a block of frames. Because of read-ahead, the first latency()
+     * frames after start or flush do not produce output yet.
+     * @param in Interleaved input frames
+     * @param out Space for as many frames as there are input frames
+     * @param frames The number of input frames
+     * @return The number of frames written to out
+     */
+    int process(const float * in, float * out, const int frames)
     {
-        bool has_output_data = processed_frames >= latency();
-        if (has_output_data)
-        {
-            read_ahead_buffer.move_out(frame_out.begin(), channels_);
-        }
-        else
-        {
-            processed_frames++;
-        }
-        read_ahead_buffer.copy_in(frame_in.begin(), channels_);
+        int output_frames = 0;
 
-        /*
-         * Following calculations need to happen to anticipate the (future)
-         * output.
-         */
-
-        float square_sum = 0.0;
-        float square_max = 0.0;
-        for (const float sample : frame_in)
+        for (int i = 0; i < frames; i++, in += channels_)
         {
-            const float square = sample * sample;
-            square_max = std::max(square_max, square);
-            square_sum += square;
-        }
-        square_sum /= static_cast<float>(channels_);
-        square_sum += square_max;
-        const float perceived = FAST_VU_FUDGE_FACTOR *
-                                perceivedLoudness.get_mean_squared(square_sum);
-        const double weighted =
-            std::max(long_integration.integrate(square_sum), perceived);
-
-        const double rms = sqrt(weighted);
+            const bool has_output_data = processed_frames >= latency();
+            if (has_output_data)
+            {
+                read_ahead_buffer.move_out(out, channels_);
+            }
+            else
+            {
+                processed_frames++;
+            }
+            read_ahead_buffer.copy_in(in, channels_);
 
-        const float gain =
-            target_level /
-            std::max(minimum_detection,
-                     static_cast<float>(release_integration.get_envelope(rms)));
+            /*
+             * The gain is calculated from the input frame to anticipate the
+             * (future) output.
+             */
+            const float gain = get_gain(in);
 
-        if (has_output_data)
-        {
-            for (float & sample : frame_out)
+            if (has_output_data)
             {
-                sample *= gain;
+                for (int c = 0; c < channels_; c++)
+                {
+                    out[c] *= gain;
+                }
+                out += channels_;
+                output_frames++;
             }
         }
 
-        return has_output_data;
+        return output_frames;
     }
 
     void flush()
@@ -0,0 +1,378 @@
+#ifndef AUDACIOUS_PLUGINS_BGM_R128METER_H
+#define AUDACIOUS_PLUGINS_BGM_R128METER_H
+/*
+ * Background music (equal loudness) Plugin for Audacious
+ * Copyright 2023 Michel Fleur
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+#include <algorithm>
+#include <cmath>
+#include <libaudcore/index.h>
+
+/**
+ * The K-weighting filter of ITU-R BS.1770: a high shelf that models the
+ * acoustic effect of the head, followed by a high pass. The analog prototypes
+ * are transformed for the actual sample rate, so that any rate gives the
+ * response that the standard specifies for 48 kHz.
+ */
+class KWeighting
+{
+    struct Biquad
+    {
+        double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    };
+
+    Biquad shelf_, high_pass_;
+
+public:
+    struct State
+    {
+        double s1 = 0, s2 = 0, s3 = 0, s4 = 0;
+    };
+
+    void set_rate(const int rate)
+    {
+        double f0 = 1681.974450955533;
+        double gain = 3.999843853973347;
+        double q = 0.7071752369554196;
+
+        double k = tan(M_PI * f0 / rate);
+        double vh = pow(10.0, gain / 20.0);
+        double vb = pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+
+        shelf_.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf_.b1 = 2.0 * (k * k - vh) / a0;
+        shelf_.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf_.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf_.a2 = (1.0 - k / q + k * k) / a0;
+
+        f0 = 38.13547087602444;
+        q = 0.5003270373238773;
+        k = tan(M_PI * f0 / rate);
+        a0 = 1.0 + k / q + k * k;
+
+        high_pass_.b0 = 1.0;
+        high_pass_.b1 = -2.0;
+        high_pass_.b2 = 1.0;
+        high_pass_.a1 = 2.0 * (k * k - 1.0) / a0;
+        high_pass_.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    /**
+     * Filters one channel of interleaved data and returns the sum of the
+     * squared output. Both stages run in transposed direct form II with the
+     * state kept in registers for the whole block.
+     */
+    double sum_squares(const float * data, const int stride, const int frames,
+                       State & state) const
+    {
+        const Biquad s = shelf_, h = high_pass_;
+        double s1 = state.s1, s2 = state.s2, s3 = state.s3, s4 = state.s4;
+        double sum = 0;
+
+        for (int i = 0; i < frames; i++, data += stride)
+        {
+            const double x = *data;
+            const double y = s.b0 * x + s1;
+            s1 = s.b1 * x - s.a1 * y + s2;
+            s2 = s.b2 * x - s.a2 * y;
+
+            const double z = h.b0 * y + s3;
+            s3 = h.b1 * y - h.a1 * z + s4;
+            s4 = h.b2 * y - h.a2 * z;
+
+            sum += z * z;
+        }
+
+        state = {s1, s2, s3, s4};
+        return sum;
+    }
+};
+
+/**
+ * Finds the true (inter-sample) peak of a signal by 4x oversampling, as
+ * described in annex 2 of ITU-R BS.1770. Each intermediate phase is a
+ * 12-tap windowed sinc interpolator.
+ */
+class TruePeak
+{
+    static constexpr int OVERSAMPLE = 4;
+    static constexpr int TAPS = 12;
+
+    float coefs_[OVERSAMPLE - 1][TAPS]{};
+    Index<float> history_; /* per channel, stored twice to stay contiguous */
+    int channels_ = 0;
+    int position_ = 0;
+    float peak_ = 0;
+
+public:
+    TruePeak()
+    {
+        for (int p = 1; p < OVERSAMPLE; p++)
+        {
+            double sum = 0;
+            for (int t = 0; t < TAPS; t++)
+            {
+                const double x = t - (TAPS / 2 - 1) -
+                                 static_cast<double>(p) / OVERSAMPLE;
+                const double w = 0.42 + 0.5 * cos(M_PI * x / (TAPS / 2)) +
+                                 0.08 * cos(2 * M_PI * x / (TAPS / 2));
+                coefs_[p - 1][t] = sin(M_PI * x) / (M_PI * x) * w;
+                sum += coefs_[p - 1][t];
+            }
+            for (float & c : coefs_[p - 1])
+                c /= sum;
+        }
+    }
+
+    void reset(const int channels)
+    {
+        channels_ = channels;
+        history_.resize(channels * 2 * TAPS);
+        history_.erase(0, -1);
+        position_ = 0;
+        peak_ = 0;
+    }
+
+    void add_frames(const float * data, const int frames)
+    {
+        float peak = peak_;
+
+        for (int c = 0; c < channels_; c++)
+        {
+            float * history = &history_[c * 2 * TAPS];
+            int position = position_;
+
+            for (int i = 0; i < frames; i++)
+            {
+                const float sample = data[i * channels_ + c];
+                history[position] = sample;
+                history[position + TAPS] = sample;
+                position = (position + 1 == TAPS) ? 0 : position + 1;
+
+                peak = std::max(peak, fabsf(sample));
+
+                const float * window = history + position;
+                for (auto & coefs : coefs_)
+                {
+                    float sum = 0;
+                    for (int t = 0; t < TAPS; t++)
+                        sum += window[t] * coefs[t];
+                    peak = std::max(peak, fabsf(sum));
+                }
+            }
+        }
+
+        position_ = (position_ + frames) % TAPS;
+        peak_ = peak;
+    }
+
+    [[nodiscard]] float peak() const { return peak_; }
+};
+
+/**
+ * Measures integrated loudness according to ITU-R BS.1770 and EBU R128:
+ * K-weighted mean square per channel, summed with the channel weights, over
+ * 400 ms blocks that overlap by 75%, with an absolute gate at -70 LUFS and a
+ * relative gate 10 LU below the ungated loudness.
+ *
+ * Audio is accepted in blocks of any size. Gated blocks are collected in a
+ * histogram with 0.01 LU resolution, so memory use does not depend on the
+ * length of the track.
+ */
+class R128Meter
+{
+    static constexpr int SUB_BLOCKS = 4; /* 100 ms each, per 400 ms block */
+    static constexpr double ABSOLUTE_GATE = -70.0;
+    static constexpr double RELATIVE_GATE = -10.0;
+    static constexpr double HISTOGRAM_MAX = 5.0;
+    static constexpr int HISTOGRAM_STEPS = 100; /* per LU */
+    static constexpr int HISTOGRAM_BINS =
+        static_cast<int>((HISTOGRAM_MAX - ABSOLUTE_GATE) * HISTOGRAM_STEPS);
+
+    struct Bin
+    {
+        int count = 0;
+        double energy = 0;
+    };
+
+    KWeighting filter_;
+    TruePeak true_peak_;
+    Index<KWeighting::State> states_;
+    Index<double> weights_;
+    Index<Bin> histogram_;
+
+    int channels_ = 0;
+    int sub_block_frames_ = 0;
+    int sub_block_filled_ = 0;
+    double sub_block_sum_ = 0;
+    double sub_blocks_[SUB_BLOCKS]{};
+    int sub_block_count_ = 0;
+    int64_t frames_ = 0;
+
+    static double energy_to_loudness(const double energy)
+    {
+        return -0.691 + 10.0 * log10(energy);
+    }
+
+    static double loudness_to_energy(const double loudness)
+    {
+        return pow(10.0, (loudness + 0.691) / 10.0);
+    }
+
+    static int histogram_bin(const double energy)
+    {
+        const double loudness = energy_to_loudness(energy);
+        const int bin = static_cast<int>((loudness - ABSOLUTE_GATE) *
+                                         HISTOGRAM_STEPS);
+        return aud::clamp(bin, 0, HISTOGRAM_BINS - 1);
+    }
+
+    void end_sub_block()
+    {
+        sub_blocks_[sub_block_count_ % SUB_BLOCKS] =
+            sub_block_sum_ / sub_block_frames_;
+        sub_block_count_++;
+        sub_block_sum_ = 0;
+        sub_block_filled_ = 0;
+
+        if (sub_block_count_ < SUB_BLOCKS)
+            return;
+
+        double energy = 0;
+        for (const double sub_block : sub_blocks_)
+            energy += sub_block;
+        energy /= SUB_BLOCKS;
+
+        if (energy > loudness_to_energy(ABSOLUTE_GATE))
+        {
+            Bin & bin = histogram_[histogram_bin(energy)];
+            bin.count++;
+            bin.energy += energy;
+        }
+    }
+
+public:
+    void reset(const int channels, const int rate)
+    {
+        channels_ = channels;
+        sub_block_frames_ = std::max(1, rate / 10);
+        filter_.set_rate(rate);
+        true_peak_.reset(channels);
+
+        states_.resize(channels);
+        for (auto & state : states_)
+            state = KWeighting::State();
+
+        /* 5.1 in the usual L R C LFE Ls Rs order */
+        weights_.resize(channels);
+        for (int c = 0; c < channels; c++)
+            weights_[c] = (channels == 6 && c == 3) ? 0.0
+                          : (channels == 6 && c >= 4) ? 1.41
+                                                      : 1.0;
+
+        histogram_.resize(HISTOGRAM_BINS);
+        for (auto & bin : histogram_)
+            bin = Bin();
+
+        sub_block_filled_ = 0;
+        sub_block_sum_ = 0;
+        sub_block_count_ = 0;
+        frames_ = 0;
+    }
+
+    void add_frames(const float * data, int frames)
+    {
+        true_peak_.add_frames(data, frames);
+        frames_ += frames;
+
+        while (frames > 0)
+        {
+            const int count =
+                std::min(frames, sub_block_frames_ - sub_block_filled_);
+
+            for (int c = 0; c < channels_; c++)
+            {
+                if (weights_[c] > 0)
+                    sub_block_sum_ +=
+                        weights_[c] * filter_.sum_squares(data + c, channels_,
+                                                          count, states_[c]);
+            }
+
+            data += count * channels_;
+            frames -= count;
+            sub_block_filled_ += count;
+
+            if (sub_block_filled_ == sub_block_frames_)
+                end_sub_block();
+        }
+    }
+
+    [[nodiscard]] int64_t frames() const { return frames_; }
+
+    /**
+     * @return Whether at least one gating block was above the absolute gate,
+     * in other words, whether integrated_loudness() is meaningful.
+     */
+    [[nodiscard]] bool has_loudness() const
+    {
+        for (const auto & bin : histogram_)
+        {
+            if (bin.count)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @return The gated integrated loudness in LUFS, or -70 LUFS (the
+     * absolute gate) for silence.
+     */
+    [[nodiscard]] double integrated_loudness() const
+    {
+        int count = 0;
+        double energy = 0;
+        for (const auto & bin : histogram_)
+        {
+            count += bin.count;
+            energy += bin.energy;
+        }
+
+        if (!count)
+            return ABSOLUTE_GATE;
+
+        const double gate = energy_to_loudness(energy / count) + RELATIVE_GATE;
+        const int first =
+            aud::clamp(static_cast<int>((gate - ABSOLUTE_GATE) * HISTOGRAM_STEPS),
+                       0, HISTOGRAM_BINS - 1);
+
+        count = 0;
+        energy = 0;
+        for (int i = first; i < HISTOGRAM_BINS; i++)
+        {
+            count += histogram_[i].count;
+            energy += histogram_[i].energy;
+        }
+
+        return count ? energy_to_loudness(energy / count) : ABSOLUTE_GATE;
+    }
+
+    /** @return The linear true peak of all channels. */
+    [[nodiscard]] float true_peak() const { return true_peak_.peak(); }
+};
+
+#endif // AUDACIOUS_PLUGINS_BGM_R128METER_H
@@ -20,8 +20,16 @@
 #include <libaudcore/i18n.h>
 #include <libaudcore/preferences.h>
 
+static constexpr const ComboItem normalization_items[] = {
+    ComboItem(N_("Equal loudness (live)"), NORMALIZATION_LIVE),
+    ComboItem(N_("Measured track loudness (EBU R128)"), NORMALIZATION_TRACK)};
+
 static constexpr const PreferencesWidget background_music_widgets[] = {
     WidgetLabel(N_("<b>Background music</b>")),
+    WidgetCombo(N_("Normalization:"),
+                WidgetInt(CONFIG_SECTION_BACKGROUND_MUSIC,
+                          CONF_NORMALIZATION_VARIABLE),
+                {{normalization_items}}),
     WidgetSpin(N_("Target level:"),
                WidgetFloat(CONFIG_SECTION_BACKGROUND_MUSIC,
                            CONF_TARGET_LEVEL_VARIABLE),
@@ -31,6 +39,9 @@ static constexpr const PreferencesWidget background_music_widgets[] = {
                            CONF_MAX_AMPLIFICATION_VARIABLE),
                {CONF_MAX_AMPLIFICATION_MIN, CONF_MAX_AMPLIFICATION_MAX, 1.0,
                 N_("dB")}),
+    WidgetCheck(N_("Write ReplayGain tags for measured tracks"),
+                WidgetBool(CONFIG_SECTION_BACKGROUND_MUSIC,
+                           CONF_WRITE_TAGS_VARIABLE)),
     WidgetLabel(N_("<b>Advanced</b>")),
     WidgetSpin(
         N_("Slow detection weight:"),
@@ -43,7 +54,11 @@ static constexpr const PreferencesWidget background_music_widgets[] = {
            "to the actual, faster loudness detection.\n"
            "A value of zero gives a more radio-like sound\n"
            "where soft passages get \"pulled up\" more quickly,\n"
-           "a value of two makes the sound feel less compressed."))};
+           "a value of two makes the sound feel less compressed.\n\n"
+           "Tracks that are played from start to end are measured\n"
+           "according to EBU R128. Measured track loudness uses a\n"
+           "fixed gain for tracks that have been measured before\n"
+           "and equal loudness for all other tracks."))};
 
 static constexpr const PluginPreferences background_music_preferences = {
     {background_music_widgets}};
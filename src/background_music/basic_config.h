@@ -38,6 +38,18 @@ static constexpr const char * CONF_SLOW_WEIGHT_DEFAULT_STRING = "0.5";
 static constexpr double CONF_SLOW_WEIGHT_MIN = 0.0;
 static constexpr double CONF_SLOW_WEIGHT_MAX = 2.0;
 
+static constexpr const char * CONF_NORMALIZATION_VARIABLE = "normalization";
+static constexpr const char * CONF_NORMALIZATION_DEFAULT_STRING = "0";
+
+enum Normalization
+{
+    NORMALIZATION_LIVE,
+    NORMALIZATION_TRACK
+};
+
+static constexpr const char * CONF_WRITE_TAGS_VARIABLE = "write_replaygain";
+static constexpr const char * CONF_WRITE_TAGS_DEFAULT_STRING = "FALSE";
+
 static constexpr const char * const background_music_defaults[] = {
     CONF_TARGET_LEVEL_VARIABLE, CONF_TARGET_LEVEL_DEFAULT_STRING,
     //
@@ -45,6 +57,10 @@ static constexpr const char * const background_music_defaults[] = {
     //
     CONF_SLOW_WEIGHT_VARIABLE, CONF_SLOW_WEIGHT_DEFAULT_STRING,
     //
+    CONF_NORMALIZATION_VARIABLE, CONF_NORMALIZATION_DEFAULT_STRING,
+    //
+    CONF_WRITE_TAGS_VARIABLE, CONF_WRITE_TAGS_DEFAULT_STRING,
+    //
     nullptr};
 
 #endif // AUDACIOUS_PLUGINS_BGM_BASIC_CONFIG_H
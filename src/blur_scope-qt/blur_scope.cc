@@ -38,20 +38,33 @@
 #include <libaudcore/preferences.h>
 #include <libaudqt/colorbutton.h>
 
+#include "../vis-common/blurimage.h"
+
 static void /* QWidget */ * bscope_get_color_chooser ();
+static void bscope_read_settings ();
 
 static const PreferencesWidget bscope_widgets[] = {
     WidgetLabel (N_("<b>Color</b>")),
-    WidgetCustomQt (bscope_get_color_chooser)
+    WidgetCustomQt (bscope_get_color_chooser),
+    WidgetLabel (N_("<b>Performance</b>")),
+    WidgetCheck (N_("Render at half resolution"),
+        WidgetBool ("BlurScope", "half_res", bscope_read_settings)),
+    WidgetSpin (N_("Frame rate limit:"),
+        WidgetInt ("BlurScope", "max_fps", bscope_read_settings),
+        {0, 240, 5, N_("per second (0 = no limit)")})
 };
 
 static const PluginPreferences bscope_prefs = {{bscope_widgets}};
 
 static const char * const bscope_defaults[] = {
  "color", aud::numeric_string<0xFF3F7F>::str,
+ "half_res", "FALSE",
+ "max_fps", "0",
  nullptr};
 
 static int bscope_color;
+static bool bscope_half_res;
+static int bscope_max_fps;
 
 class BlurScopeWidget : public QWidget {
 public:
@@ -59,18 +72,18 @@ public:
     ~BlurScopeWidget ();
 
     void resize (int w, int h);
+    void set_half_res (bool half_res);
 
     void clear ();
-    void blur ();
-    void draw_vert_line (int x, int y1, int y2);
+    void render (const float * pcm);
 
 protected:
     void resizeEvent (QResizeEvent *) override;
     void paintEvent (QPaintEvent *) override;
 
 private:
-    int m_width = 0, m_height = 0, m_image_size = 0;
-    uint32_t * m_image = nullptr, * m_corner = nullptr;
+    BlurImage m_image;
+    gint64 m_next_render = 0;
 };
 
 static BlurScopeWidget *s_widget = nullptr;
@@ -83,17 +96,17 @@ BlurScopeWidget::BlurScopeWidget (QWidget * parent) :
 
 BlurScopeWidget::~BlurScopeWidget ()
 {
-    g_free(m_image);
-    m_image = nullptr;
     s_widget = nullptr;
 }
 
 void BlurScopeWidget::paintEvent (QPaintEvent *)
 {
-    QImage img((unsigned char *) m_image, m_width, m_height, QImage::Format_RGB32);
+    QImage img (m_image.pixels (), m_image.width (), m_image.height (),
+     m_image.stride (), QImage::Format_RGB32);
     QPainter p (this);
 
-    p.drawImage (0, 0, img);
+    int scale = m_image.scale ();
+    p.drawImage (QRect (0, 0, img.width () * scale, img.height () * scale), img);
 }
 
 void BlurScopeWidget::resizeEvent (QResizeEvent *)
@@ -103,51 +116,35 @@ void BlurScopeWidget::resizeEvent (QResizeEvent *)
 
 void BlurScopeWidget::resize (int w, int h)
 {
-    m_width = w;
-    m_height = h;
-    m_image_size = (m_width << 2) * (m_height + 2);
-    m_image = (uint32_t *) g_realloc (m_image, m_image_size);
-    memset (m_image, 0, m_image_size);
-    m_corner = m_image + m_width + 1;
+    m_image.resize (w, h, bscope_half_res ? 2 : 1);
 }
 
-void BlurScopeWidget::clear ()
+void BlurScopeWidget::set_half_res (bool half_res)
 {
-    memset (m_image, 0, m_image_size);
+    m_image.set_scale (half_res ? 2 : 1);
     update ();
 }
 
-void BlurScopeWidget::blur ()
+void BlurScopeWidget::clear ()
 {
-    for (int y = 0; y < m_height; y ++)
-    {
-        uint32_t * p = m_corner + m_width * y;
-        uint32_t * end = p + m_width;
-        uint32_t * plast = p - m_width;
-        uint32_t * pnext = p + m_width;
-
-        /* We do a quick and dirty average of four color values, first masking
-         * off the lowest two bits.  Over a large area, this masking has the net
-         * effect of subtracting 1.5 from each value, which by a happy chance
-         * is just right for a gradual fade effect. */
-        for (; p < end; p ++)
-            * p = ((* plast ++ & 0xFCFCFC) + (p[-1] & 0xFCFCFC) + (p[1] &
-             0xFCFCFC) + (* pnext ++ & 0xFCFCFC)) >> 2;
-    }
+    m_image.clear ();
+    update ();
 }
 
-void BlurScopeWidget::draw_vert_line (int x, int y1, int y2)
+void BlurScopeWidget::render (const float * pcm)
 {
-    int y, h;
-
-    if (y1 < y2) {y = y1 + 1; h = y2 - y1;}
-    else if (y2 < y1) {y = y2; h = y1 - y2;}
-    else {y = y1; h = 1;}
+    /* with a frame rate limit, callbacks that come too early are dropped */
+    if (bscope_max_fps > 0)
+    {
+        gint64 now = g_get_monotonic_time ();
+        if (now < m_next_render)
+            return;
 
-    uint32_t * p = m_corner + y * m_width + x;
+        m_next_render = aud::max (m_next_render + G_USEC_PER_SEC / bscope_max_fps, now);
+    }
 
-    for (; h --; p += m_width)
-        * p = bscope_color;
+    m_image.render (pcm, bscope_color);
+    update ();
 }
 
 class BlurScopeQt : public VisPlugin
@@ -174,10 +171,25 @@ public:
 
 EXPORT BlurScopeQt aud_plugin_instance;
 
+static void bscope_read_settings ()
+{
+    bool half_res = aud_get_bool ("BlurScope", "half_res");
+    bscope_max_fps = aud_get_int ("BlurScope", "max_fps");
+
+    if (half_res != bscope_half_res)
+    {
+        bscope_half_res = half_res;
+
+        if (s_widget)
+            s_widget->set_half_res (half_res);
+    }
+}
+
 bool BlurScopeQt::init ()
 {
     aud_config_set_defaults ("BlurScope", bscope_defaults);
     bscope_color = aud_get_int ("BlurScope", "color");
+    bscope_read_settings ();
 
     return true;
 }
@@ -197,23 +209,7 @@ void BlurScopeQt::render_mono_pcm (const float * pcm)
 {
     g_assert(s_widget);
 
-    s_widget->blur ();
-
-    int width = s_widget->width ();
-    int height = s_widget->height ();
-
-    int prev_y = (0.5 + pcm[0]) * height;
-    prev_y = aud::clamp (prev_y, 0, height - 1);
-
-    for (int i = 0; i < width; i ++)
-    {
-        int y = (0.5 + pcm[i * 512 / width]) * height;
-        y = aud::clamp (y, 0, height - 1);
-        s_widget->draw_vert_line (i, prev_y, y);
-        prev_y = y;
-    }
-
-    s_widget->update ();
+    s_widget->render (pcm);
 }
 
 void * BlurScopeQt::get_qt_widget ()
@@ -34,20 +34,33 @@
 #include <libaudcore/preferences.h>
 #include <libaudgui/gtk-compat.h>
 
+#include "../vis-common/blurimage.h"
+
 static void /* GtkWidget */ * bscope_get_color_chooser ();
+static void bscope_read_settings ();
 
 static const PreferencesWidget bscope_widgets[] = {
     WidgetLabel (N_("<b>Color</b>")),
-    WidgetCustomGTK (bscope_get_color_chooser)
+    WidgetCustomGTK (bscope_get_color_chooser),
+    WidgetLabel (N_("<b>Performance</b>")),
+    WidgetCheck (N_("Render at half resolution"),
+        WidgetBool ("BlurScope", "half_res", bscope_read_settings)),
+    WidgetSpin (N_("Frame rate limit:"),
+        WidgetInt ("BlurScope", "max_fps", bscope_read_settings),
+        {0, 240, 5, N_("per second (0 = no limit)")})
 };
 
 static const PluginPreferences bscope_prefs = {{bscope_widgets}};
 
 static const char * const bscope_defaults[] = {
  "color", aud::numeric_string<0xFF3F7F>::str,
+ "half_res", "FALSE",
+ "max_fps", "0",
  nullptr};
 
 static int bscope_color;
+static bool bscope_half_res;
+static int bscope_max_fps;
 
 class BlurScope : public VisPlugin
 {
@@ -75,9 +88,6 @@ private:
     void draw_to_cairo (cairo_t * cr);
     void draw ();
 
-    void blur ();
-    void draw_vert_line (int x, int y1, int y2);
-
     static gboolean configure_event (GtkWidget * widget, GdkEventConfigure * event, void * user);
 #ifdef USE_GTK3
     static gboolean draw_event (GtkWidget * widget, cairo_t * cr, void * user);
@@ -86,16 +96,30 @@ private:
 #endif
 
     GtkWidget * area = nullptr;
-    int width = 0, height = 0, stride = 0, image_size = 0;
-    uint32_t * image = nullptr, * corner = nullptr;
+    gint64 next_render = 0;
 };
 
 EXPORT BlurScope aud_plugin_instance;
 
+static BlurImage image;
+
+static void bscope_read_settings ()
+{
+    bool half_res = aud_get_bool ("BlurScope", "half_res");
+    bscope_max_fps = aud_get_int ("BlurScope", "max_fps");
+
+    if (half_res != bscope_half_res)
+    {
+        bscope_half_res = half_res;
+        image.set_scale (half_res ? 2 : 1);
+    }
+}
+
 bool BlurScope::init ()
 {
     aud_config_set_defaults ("BlurScope", bscope_defaults);
     bscope_color = aud_get_int ("BlurScope", "color");
+    bscope_read_settings ();
 
     return true;
 }
@@ -104,26 +128,29 @@ void BlurScope::cleanup ()
 {
     aud_set_int ("BlurScope", "color", bscope_color);
 
-    g_free (image);
-    image = nullptr;
+    image = BlurImage ();
 }
 
 void BlurScope::resize (int w, int h)
 {
-    width = w;
-    height = h;
-    stride = width + 2;
-    image_size = (stride << 2) * (height + 2);
-    image = (uint32_t *) g_realloc (image, image_size);
-    memset (image, 0, image_size);
-    corner = image + stride + 1;
+    image.resize (w, h, bscope_half_res ? 2 : 1);
 }
 
 void BlurScope::draw_to_cairo (cairo_t * cr)
 {
     cairo_surface_t * surf = cairo_image_surface_create_for_data
-     ((unsigned char *) image, CAIRO_FORMAT_RGB24, width, height, stride << 2);
-    cairo_set_source_surface (cr, surf, 0, 0);
+     ((unsigned char *) image.pixels (), CAIRO_FORMAT_RGB24, image.width (),
+     image.height (), image.stride ());
+
+    if (image.scale () > 1)
+    {
+        cairo_scale (cr, image.scale (), image.scale ());
+        cairo_set_source_surface (cr, surf, 0, 0);
+        cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_FAST);
+    }
+    else
+        cairo_set_source_surface (cr, surf, 0, 0);
+
     cairo_paint (cr);
     cairo_surface_destroy (surf);
 }
@@ -178,58 +205,23 @@ void * BlurScope::get_gtk_widget ()
 
 void BlurScope::clear ()
 {
-    memset (image, 0, image_size);
+    image.clear ();
     draw ();
 }
 
-void BlurScope::blur ()
-{
-    for (int y = 0; y < height; y ++)
-    {
-        uint32_t * p = corner + stride * y;
-        uint32_t * end = p + width;
-        uint32_t * plast = p - stride;
-        uint32_t * pnext = p + stride;
-
-        /* We do a quick and dirty average of four color values, first masking
-         * off the lowest two bits.  Over a large area, this masking has the net
-         * effect of subtracting 1.5 from each value, which by a happy chance
-         * is just right for a gradual fade effect. */
-        for (; p < end; p ++)
-            * p = ((* plast ++ & 0xFCFCFC) + (p[-1] & 0xFCFCFC) + (p[1] &
-             0xFCFCFC) + (* pnext ++ & 0xFCFCFC)) >> 2;
-    }
-}
-
-void BlurScope::draw_vert_line (int x, int y1, int y2)
-{
-    int y, h;
-
-    if (y1 < y2) {y = y1 + 1; h = y2 - y1;}
-    else if (y2 < y1) {y = y2; h = y1 - y2;}
-    else {y = y1; h = 1;}
-
-    uint32_t * p = corner + y * stride + x;
-
-    for (; h --; p += stride)
-        * p = bscope_color;
-}
-
 void BlurScope::render_mono_pcm (const float * pcm)
 {
-    blur ();
-
-    int prev_y = (0.5 + pcm[0]) * height;
-    prev_y = aud::clamp (prev_y, 0, height - 1);
-
-    for (int i = 0; i < width; i ++)
+    /* with a frame rate limit, callbacks that come too early are dropped */
+    if (bscope_max_fps > 0)
     {
-        int y = (0.5 + pcm[i * 512 / width]) * height;
-        y = aud::clamp (y, 0, height - 1);
-        draw_vert_line (i, prev_y, y);
-        prev_y = y;
+        gint64 now = g_get_monotonic_time ();
+        if (now < next_render)
+            return;
+
+        next_render = aud::max (next_render + G_USEC_PER_SEC / bscope_max_fps, now);
     }
 
+    image.render (pcm, bscope_color);
     draw ();
 }
 
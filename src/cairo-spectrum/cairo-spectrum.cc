@@ -28,6 +28,8 @@
 #include <libaudgui/gtk-compat.h>
 #include <libaudgui/libaudgui-gtk.h>
 
+#include "../vis-common/bandmap.h"
+
 #define MAX_BANDS   (256)
 #define VIS_DELAY 2 /* delay before falloff in frames */
 #define VIS_FALLOFF 2 /* falloff in pixels per frame */
@@ -54,7 +56,7 @@ public:
 EXPORT CairoSpectrum aud_plugin_instance;
 
 static GtkWidget * spect_widget = nullptr;
-static float xscale[MAX_BANDS + 1];
+static BandMapper mapper;
 static int width, height, bands;
 static int bars[MAX_BANDS + 1];
 static int delay[MAX_BANDS + 1];
@@ -64,10 +66,13 @@ void CairoSpectrum::render_freq (const float * freq)
     if (! bands)
         return;
 
+    float db[MAX_BANDS];
+    mapper.compute_db (freq, db);
+
     for (int i = 0; i < bands; i ++)
     {
         /* 40 dB range */
-        int x = 40 + compute_freq_band (freq, xscale, i, bands);
+        int x = 40 + db[i];
         x = aud::clamp (x, 0, 40);
 
         bars[i] -= aud::max (0, VIS_FALLOFF - delay[i]);
@@ -131,7 +136,7 @@ static gboolean configure_event (GtkWidget * widget, GdkEventConfigure * event)
 
     bands = width / 10;
     bands = aud::clamp (bands, 12, MAX_BANDS);
-    Visualizer::compute_log_xscale (xscale, bands);
+    mapper.init (bands);
 
     return true;
 }
@@ -21,33 +21,78 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 #include <libaudcore/ringbuf.h>
 #include <libaudcore/runtime.h>
 
+#include "slidingmin.h"
+
 /* Response time adjustments.  Maybe this should be adjustable? */
 #define CHUNK_TIME 0.2f /* seconds */
 #define CHUNKS 5
 #define DECAY 0.3f
 
+/* True peaks are found by 4x oversampling with a 12-tap interpolator per
+ * phase; the detector lags the input by half the filter length. */
+#define OVERSAMPLE 4
+#define TP_TAPS 12
+#define TP_DELAY (TP_TAPS / 2)
+
+enum {
+    MODE_COMPRESSOR,
+    MODE_LIMITER
+};
+
 /* What is a "normal" volume?  Replay Gain stuff claims to use 89 dB, but what
  * does that translate to in our PCM range? */
 static const char * const compressor_defaults[] = {
+    "mode", "0",
     "center", "0.5",
     "range", "0.5",
+    "ceiling", "-1",
+    "lookahead", "5",
+    "attack", "5",
+    "release", "100",
      nullptr
 };
 
+static const ComboItem compressor_modes[] = {
+    ComboItem (N_("Compressor"), MODE_COMPRESSOR),
+    ComboItem (N_("Look-ahead limiter"), MODE_LIMITER)
+};
+
 static const PreferencesWidget compressor_widgets[] = {
+    WidgetCombo (N_("Mode:"),
+        WidgetInt ("compressor", "mode"),
+        {{compressor_modes}}),
     WidgetLabel (N_("<b>Compression</b>")),
     WidgetSpin (N_("Center volume:"),
         WidgetFloat ("compressor", "center"),
         {0.1, 1, 0.1}),
     WidgetSpin (N_("Dynamic range:"),
         WidgetFloat ("compressor", "range"),
-        {0.0, 3.0, 0.1})
+        {0.0, 3.0, 0.1}),
+    WidgetLabel (N_("<b>Limiter</b>")),
+    WidgetSpin (N_("Ceiling:"),
+        WidgetFloat ("compressor", "ceiling"),
+        {-12, 0, 0.1, N_("dBTP")}),
+    WidgetSpin (N_("Look-ahead:"),
+        WidgetInt ("compressor", "lookahead"),
+        {1, 20, 1, N_("ms")}),
+    WidgetSpin (N_("Attack:"),
+        WidgetInt ("compressor", "attack"),
+        {1, 20, 1, N_("ms")}),
+    WidgetSpin (N_("Release:"),
+        WidgetInt ("compressor", "release"),
+        {10, 2000, 10, N_("ms")})
 };
 
 static const PluginPreferences compressor_prefs = {{compressor_widgets}};
@@ -89,7 +134,7 @@ static RingBuf<float> buffer, peaks;
 static Index<float> output;
 static int chunk_size;
 static float current_peak;
-static int current_channels, current_rate;
+static int current_channels, current_rate, current_mode;
 
 /* I used to find the maximum sample and take that as the peak, but that doesn't
  * work well on badly clipped tracks.  Now, I use the highly sophisticated
@@ -122,9 +167,282 @@ static void do_ramp (float * data, int length, float peak_a, float peak_b)
     }
 }
 
+/* The limiter delays the audio by the look-ahead time (plus the detector lag)
+ * and, for every frame, works out the gain needed to keep the true peak of
+ * every frame within the look-ahead window under the ceiling.  The gain is
+ * held at the minimum over the window, smoothed over the attack time and
+ * then released exponentially.  As long as the attack is no longer than the
+ * look-ahead, the gain is fully down by the time a peak comes out. */
+
+struct Limiter {
+    int lookahead, attack;  /* frames */
+    float ceiling, release;
+
+    /* true-peak detector: per-channel history, stored twice over so that
+     * the last TP_TAPS samples are always contiguous */
+    Index<float> history;
+    int hist_pos;
+    Index<float> prev_peak;  /* per channel, for the previous interval */
+
+    SlidingMin min;  /* over lookahead + 1 frames */
+
+    /* moving average over the attack time */
+    Index<float> avg_ring;
+    int avg_pos;
+    double avg_sum;
+
+    float gain;
+    int warmup;  /* frames still to come before the first output */
+    Index<float> gains;
+};
+
+static Limiter lim;
+static float tp_coefs[OVERSAMPLE - 1][TP_TAPS];
+
+static void make_tp_coefs ()
+{
+    for (int p = 1; p < OVERSAMPLE; p ++)
+    {
+        double sum = 0;
+
+        for (int t = 0; t < TP_TAPS; t ++)
+        {
+            /* interpolating between taps TP_DELAY - 1 and TP_DELAY */
+            double x = t - (TP_DELAY - 1) - (double) p / OVERSAMPLE;
+            double w = 0.42 + 0.5 * cos (M_PI * x / TP_DELAY) +
+             0.08 * cos (2 * M_PI * x / TP_DELAY);
+            double c = sin (M_PI * x) / (M_PI * x) * w;
+
+            tp_coefs[p - 1][t] = c;
+            sum += c;
+        }
+
+        for (int t = 0; t < TP_TAPS; t ++)
+            tp_coefs[p - 1][t] /= sum;
+    }
+}
+
+static float dot_taps (const float * a, const float * b)
+{
+#if defined(__SSE2__)
+    __m128 sum = _mm_mul_ps (_mm_loadu_ps (a), _mm_loadu_ps (b));
+    sum = _mm_add_ps (sum, _mm_mul_ps (_mm_loadu_ps (a + 4), _mm_loadu_ps (b + 4)));
+    sum = _mm_add_ps (sum, _mm_mul_ps (_mm_loadu_ps (a + 8), _mm_loadu_ps (b + 8)));
+    sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+    sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+    return _mm_cvtss_f32 (sum);
+#elif defined(__ARM_NEON)
+    float32x4_t sum = vmulq_f32 (vld1q_f32 (a), vld1q_f32 (b));
+    sum = vmlaq_f32 (sum, vld1q_f32 (a + 4), vld1q_f32 (b + 4));
+    sum = vmlaq_f32 (sum, vld1q_f32 (a + 8), vld1q_f32 (b + 8));
+    float32x2_t half = vadd_f32 (vget_low_f32 (sum), vget_high_f32 (sum));
+    return vget_lane_f32 (vpadd_f32 (half, half), 0);
+#else
+    float sum = 0;
+    for (int t = 0; t < TP_TAPS; t ++)
+        sum += a[t] * b[t];
+    return sum;
+#endif
+}
+
+static int limiter_latency ()
+{
+    return lim.lookahead + TP_DELAY;
+}
+
+static void limiter_setup ()
+{
+    int lookahead = aud_get_int ("compressor", "lookahead");
+    int attack = aud_get_int ("compressor", "attack");
+
+    lim.lookahead = aud::rescale (aud::clamp (lookahead, 1, 20), 1000, current_rate);
+    lim.attack = aud::clamp (aud::rescale (attack, 1000, current_rate), 1, lim.lookahead);
+
+    lim.history.resize (current_channels * 2 * TP_TAPS);
+    lim.history.erase (0, -1);
+    lim.hist_pos = 0;
+    lim.prev_peak.resize (current_channels);
+    lim.prev_peak.erase (0, -1);
+
+    lim.min.reset (lim.lookahead + 1);
+
+    lim.avg_ring.resize (lim.attack);
+    for (float & g : lim.avg_ring)
+        g = 1;
+
+    lim.avg_pos = 0;
+    lim.avg_sum = lim.attack;
+
+    lim.gain = 1;
+    lim.warmup = limiter_latency ();
+}
+
+/* true peak of the frame TP_DELAY frames back, given the newest frame */
+static float detect_peak (const float * in)
+{
+    float peak = 0;
+
+    for (int c = 0; c < current_channels; c ++)
+    {
+        float * hist = & lim.history[c * 2 * TP_TAPS];
+        float sample = in ? in[c] : 0;
+
+        hist[lim.hist_pos] = sample;
+        hist[lim.hist_pos + TP_TAPS] = sample;
+
+        const float * window = hist + lim.hist_pos + 1;
+
+        /* the interval between these two samples */
+        float interval = aud::max (fabsf (window[TP_DELAY - 1]), fabsf (window[TP_DELAY]));
+        for (int p = 0; p < OVERSAMPLE - 1; p ++)
+            interval = aud::max (interval, fabsf (dot_taps (window, tp_coefs[p])));
+
+        /* a sample is affected by the intervals on both sides of it */
+        peak = aud::max (peak, aud::max (interval, lim.prev_peak[c]));
+        lim.prev_peak[c] = interval;
+    }
+
+    lim.hist_pos = (lim.hist_pos + 1 == TP_TAPS) ? 0 : lim.hist_pos + 1;
+
+    return peak;
+}
+
+static float next_gain (const float * in)
+{
+    float peak = detect_peak (in);
+    float wanted = (peak > lim.ceiling) ? lim.ceiling / peak : 1;
+
+    float held = lim.min.push (wanted);
+
+    /* moving average, so that the gain ramps down over the attack time */
+    lim.avg_sum += held - lim.avg_ring[lim.avg_pos];
+    lim.avg_ring[lim.avg_pos] = held;
+    lim.avg_pos = (lim.avg_pos + 1 == lim.attack) ? 0 : lim.avg_pos + 1;
+
+    float smooth = aud::min ((float) (lim.avg_sum / lim.attack), 1.0f);
+
+    if (smooth < lim.gain)
+        lim.gain = smooth;
+    else
+        lim.gain += (smooth - lim.gain) * lim.release;
+
+    return lim.gain;
+}
+
+static void apply_gains (float * data, const float * gains, int frames, int channels)
+{
+    int f = 0;
+
+#if defined(__SSE2__)
+    if (channels == 1)
+    {
+        for (; f + 4 <= frames; f += 4)
+            _mm_storeu_ps (data + f, _mm_mul_ps (_mm_loadu_ps (data + f),
+             _mm_loadu_ps (gains + f)));
+    }
+    else if (channels == 2)
+    {
+        for (; f + 4 <= frames; f += 4)
+        {
+            __m128 g = _mm_loadu_ps (gains + f);
+            float * d = data + 2 * f;
+            _mm_storeu_ps (d, _mm_mul_ps (_mm_loadu_ps (d), _mm_unpacklo_ps (g, g)));
+            _mm_storeu_ps (d + 4, _mm_mul_ps (_mm_loadu_ps (d + 4), _mm_unpackhi_ps (g, g)));
+        }
+    }
+#elif defined(__ARM_NEON)
+    if (channels == 1)
+    {
+        for (; f + 4 <= frames; f += 4)
+            vst1q_f32 (data + f, vmulq_f32 (vld1q_f32 (data + f), vld1q_f32 (gains + f)));
+    }
+    else if (channels == 2)
+    {
+        for (; f + 4 <= frames; f += 4)
+        {
+            float32x4x2_t g = vzipq_f32 (vld1q_f32 (gains + f), vld1q_f32 (gains + f));
+            float * d = data + 2 * f;
+            vst1q_f32 (d, vmulq_f32 (vld1q_f32 (d), g.val[0]));
+            vst1q_f32 (d + 4, vmulq_f32 (vld1q_f32 (d + 4), g.val[1]));
+        }
+    }
+#endif
+
+    for (; f < frames; f ++)
+    {
+        for (int c = 0; c < channels; c ++)
+            data[f * channels + c] *= gains[f];
+    }
+}
+
+/* Runs frames through the limiter and appends whatever comes out of the
+ * delay to the output.  With no input, feeds silence to the detector to
+ * drain the delay. */
+static void limiter_run (const float * data, int frames)
+{
+    lim.ceiling = powf (10, aud_get_double ("compressor", "ceiling") / 20);
+    lim.release = 1 - expf (-1000.0f / (aud::clamp (aud_get_int ("compressor",
+     "release"), 10, 2000) * (float) current_rate));
+
+    lim.gains.resize (0);
+
+    for (int f = 0; f < frames; f ++)
+    {
+        float gain = next_gain (data ? data + f * current_channels : nullptr);
+
+        if (lim.warmup)
+            lim.warmup --;
+        else
+            lim.gains.append (gain);
+    }
+
+    if (data)
+    {
+        int samples = frames * current_channels;
+        if (buffer.space () < samples)
+            buffer.alloc (buffer.len () + samples);
+
+        buffer.copy_in (data, samples);
+    }
+
+    int out_frames = aud::min (lim.gains.len (), buffer.len () / current_channels);
+    int offset = output.len ();
+
+    buffer.move_out (output, -1, out_frames * current_channels);
+    apply_gains (output.begin () + offset, lim.gains.begin (), out_frames, current_channels);
+}
+
+/* switching modes (or the look-ahead time) in the middle of a song: pass on
+ * what is buffered as it is and start over */
+static void check_mode ()
+{
+    int mode = aud_get_int ("compressor", "mode");
+    int lookahead = aud::rescale (aud::clamp (aud_get_int ("compressor",
+     "lookahead"), 1, 20), 1000, current_rate);
+    int attack = aud::clamp (aud::rescale (aud_get_int ("compressor", "attack"),
+     1000, current_rate), 1, lookahead);
+
+    if (mode == current_mode && (mode != MODE_LIMITER ||
+     (lookahead == lim.lookahead && attack == lim.attack)))
+        return;
+
+    while (buffer.len ())
+        buffer.move_out (output, -1, buffer.linear ());
+
+    peaks.discard ();
+    current_peak = 0.0f;
+    current_mode = mode;
+
+    if (mode == MODE_LIMITER)
+        limiter_setup ();
+    else
+        buffer.alloc (chunk_size * CHUNKS);
+}
+
 bool Compressor::init ()
 {
     aud_config_set_defaults ("compressor", compressor_defaults);
+    make_tp_coefs ();
     return true;
 }
 
@@ -133,6 +451,7 @@ void Compressor::cleanup ()
     buffer.destroy ();
     peaks.destroy ();
     output.clear ();
+    lim = Limiter ();
 }
 
 void Compressor::start (int & channels, int & rate)
@@ -145,12 +464,20 @@ void Compressor::start (int & channels, int & rate)
     buffer.alloc (chunk_size * CHUNKS);
     peaks.alloc (CHUNKS);
 
+    current_mode = aud_get_int ("compressor", "mode");
     flush (true);
 }
 
 Index<float> & Compressor::process (Index<float> & data)
 {
     output.resize (0);
+    check_mode ();
+
+    if (current_mode == MODE_LIMITER)
+    {
+        limiter_run (data.begin (), data.len () / current_channels);
+        return output;
+    }
 
     int offset = 0;
     int remain = data.len ();
@@ -198,12 +525,25 @@ bool Compressor::flush (bool force)
     peaks.discard ();
 
     current_peak = 0.0f;
+
+    if (current_mode == MODE_LIMITER)
+        limiter_setup ();
+
     return true;
 }
 
 Index<float> & Compressor::finish (Index<float> & data, bool end_of_playlist)
 {
     output.resize (0);
+    check_mode ();
+
+    if (current_mode == MODE_LIMITER)
+    {
+        limiter_run (data.begin (), data.len () / current_channels);
+        limiter_run (nullptr, limiter_latency ());
+        limiter_setup ();
+        return output;
+    }
 
     peaks.discard ();
 
@@ -0,0 +1,81 @@
+/*
+ * Dynamic Range Compression Sliding Minimum Check
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Compares the limiter's sliding minimum against a plain scan of the window.
+ * A long strictly rising sequence keeps every value in the queue, so it is
+ * the case that used to push the queue one past its storage. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "slidingmin.h"
+
+#define LENGTH 1000
+
+static int check (const char * name, const float * values, int window)
+{
+    SlidingMin min;
+    min.reset (window);
+
+    int failed = 0;
+
+    for (int i = 0; i < LENGTH; i ++)
+    {
+        float got = min.push (values[i]);
+
+        float want = values[i];
+        for (int j = aud::max (i - window + 1, 0); j < i; j ++)
+            want = aud::min (want, values[j]);
+
+        if (got != want || min.count () > window)
+        {
+            printf ("%s, window %d, value %d: got %f (queue %d), expected %f\n",
+             name, window, i, got, min.count (), want);
+            failed ++;
+            break;
+        }
+    }
+
+    return failed;
+}
+
+int main ()
+{
+    static float rising[LENGTH], falling[LENGTH], noise[LENGTH];
+
+    for (int i = 0; i < LENGTH; i ++)
+    {
+        rising[i] = (float) i / LENGTH;
+        falling[i] = 1 - (float) i / LENGTH;
+        noise[i] = (float) rand () / RAND_MAX;
+    }
+
+    int checked = 0, failed = 0;
+
+    for (int window = 1; window <= 40; window ++)
+    {
+        failed += check ("rising", rising, window);
+        failed += check ("falling", falling, window);
+        failed += check ("noise", noise, window);
+        checked += 3;
+    }
+
+    printf ("%d sequences checked, %d failed\n", checked, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Dynamic Range Compression Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef COMPRESSOR_SLIDINGMIN_H
+#define COMPRESSOR_SLIDINGMIN_H
+
+#include <libaudcore/index.h>
+
+/* Minimum over the last <window> values pushed (monotonic queue).  The queue
+ * never holds more than <window> entries, since whatever has left the window
+ * is dropped from the front before the new value goes in at the back. */
+
+class SlidingMin
+{
+public:
+    void reset (int window)
+    {
+        m_value.resize (window);
+        m_frame.resize (window);
+        m_head = m_count = m_frame_no = 0;
+    }
+
+    float push (float value)
+    {
+        int size = m_value.len ();
+
+        if (m_count && m_frame[m_head] <= m_frame_no - size)
+        {
+            m_head = (m_head + 1 == size) ? 0 : m_head + 1;
+            m_count --;
+        }
+
+        while (m_count)
+        {
+            int back = m_head + m_count - 1;
+            if (back >= size)
+                back -= size;
+
+            if (m_value[back] < value)
+                break;
+
+            m_count --;
+        }
+
+        int back = m_head + m_count;
+        if (back >= size)
+            back -= size;
+
+        m_value[back] = value;
+        m_frame[back] = m_frame_no;
+        m_count ++;
+        m_frame_no ++;
+
+        return m_value[m_head];
+    }
+
+    int count () const
+        { return m_count; }
+
+private:
+    Index<float> m_value;
+    Index<int> m_frame;
+    int m_head = 0, m_count = 0, m_frame_no = 0;
+};
+
+#endif
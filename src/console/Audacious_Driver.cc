@@ -17,6 +17,8 @@
 #include "Music_Emu.h"
 #include "Gzip_Reader.h"
 
+#include "../render-cache-common/rendercache.h"
+
 static const int fade_threshold = 10 * 1000;
 static const int fade_length    = 8 * 1000;
 
@@ -141,14 +143,14 @@ int ConsoleFileHandler::load(int sample_rate)
     return 0;
 }
 
-static int get_track_length(const track_info_t &info)
+static int get_track_length(const track_info_t &info, const AudaciousConsoleConfig &cfg = audcfg)
 {
     int length = info.length;
     if (length <= 0)
         length = info.intro_length + 2 * info.loop_length;
 
     if (length <= 0)
-        length = audcfg.loop_length * 1000;
+        length = cfg.loop_length * 1000;
     else if (length >= fade_threshold)
         length += fade_length;
 
@@ -194,46 +196,44 @@ bool ConsolePlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple,
     return true;
 }
 
-bool ConsolePlugin::play(const char *filename, VFSFile &file)
+static int select_sample_rate(gme_type_t type, const AudaciousConsoleConfig &cfg)
 {
-    int length, sample_rate;
-    track_info_t info;
-
-    // identify file
-    ConsoleFileHandler fh(filename, file);
-    if (!fh.m_type)
-        return false;
-
-    if (fh.m_track < 0)
-        fh.m_track = 0;
-
-    // select sample rate
-    sample_rate = 0;
-    if (fh.m_type == gme_spc_type)
+    int sample_rate = 0;
+    if (type == gme_spc_type)
         sample_rate = 32000;
-    if (audcfg.resample)
-        sample_rate = audcfg.resample_rate;
+    if (cfg.resample)
+        sample_rate = cfg.resample_rate;
     if (sample_rate == 0)
         sample_rate = 44100;
 
+    return sample_rate;
+}
+
+/* Creates the emulator and starts the track with the given settings.  Returns
+ * the time (milliseconds) at which the fade begins, or -1 on error. */
+static int start_track(ConsoleFileHandler &fh, int sample_rate, const AudaciousConsoleConfig &cfg)
+{
+    int length;
+    track_info_t info;
+
     // create emulator and load file
     if (fh.load(sample_rate))
-        return false;
+        return -1;
 
     // stereo echo depth
-    gme_set_stereo_depth(fh.m_emu, 1.0 / 100 * audcfg.echo);
+    gme_set_stereo_depth(fh.m_emu, 1.0 / 100 * cfg.echo);
 
     // set equalizer
-    if (audcfg.treble || audcfg.bass)
+    if (cfg.treble || cfg.bass)
     {
         Music_Emu::equalizer_t eq;
 
         // bass - logarithmic, 2 to 8194 Hz
-        double bass = 1.0 - (audcfg.bass / 200.0 + 0.5);
+        double bass = 1.0 - (cfg.bass / 200.0 + 0.5);
         eq.bass = (long) (2.0 + pow( 2.0, bass * 13 ));
 
         // treble - -50 to 0 to +5 dB
-        double treble = audcfg.treble / 100.0;
+        double treble = cfg.treble / 100.0;
         eq.treble = treble * (treble < 0 ? 50.0 : 5.0);
 
         fh.m_emu->set_equalizer(eq);
@@ -243,34 +243,167 @@ bool ConsolePlugin::play(const char *filename, VFSFile &file)
     length = -1;
     if (!log_err(fh.m_emu->track_info(&info, fh.m_track)))
     {
-        if (fh.m_type == gme_spc_type && audcfg.ignore_spc_length)
+        if (fh.m_type == gme_spc_type && cfg.ignore_spc_length)
             info.length = -1;
 
-        length = get_track_length(info);
-        set_stream_bitrate(fh.m_emu->voice_count() * 1000);
+        length = get_track_length(info, cfg);
     }
 
     // start track
     if (log_err(fh.m_emu->start_track(fh.m_track)))
-        return false;
+        return -1;
 
     log_warning(fh.m_emu);
 
-    open_audio(FMT_S16_NE, sample_rate, 2);
-
     // set fade time
     if (length <= 0)
-        length = audcfg.loop_length * 1000;
+        length = cfg.loop_length * 1000;
     if (length >= fade_threshold + fade_length)
         length -= fade_length / 2;
     fh.m_emu->set_fade(length, fade_length);
 
+    return length;
+}
+
+/* the copy of Game_Music_Emu 0.5.2 in this directory, with our changes */
+static const char engine_version[] = "gme-0.5.2-1";
+
+/* The render cache key covers the file and every setting that changes the
+ * output.  The companion playlist can only change the length of the track,
+ * which is covered through the fade time. */
+static String cache_key(const Index<char> &data, int track, int sample_rate,
+ int fade, const AudaciousConsoleConfig &cfg)
+{
+    return render_cache_key("gme", engine_version, data,
+     str_printf("track=%d rate=%d echo=%d treble=%d bass=%d fade=%d",
+     track, sample_rate, cfg.echo, cfg.treble, cfg.bass, fade));
+}
+
+/* Each Music_Emu is independent, so a render does not disturb playback.  The
+ * file is opened again when the render starts. */
+class ConsoleRenderJob : public RenderCacheJob
+{
+public:
+    ConsoleRenderJob(const char *filename, const AudaciousConsoleConfig &cfg) :
+        m_filename(filename), m_cfg(cfg) {}
+
+    bool render(RenderCacheWriter &writer) override;
+
+private:
+    String m_filename;
+    AudaciousConsoleConfig m_cfg;
+};
+
+bool ConsoleRenderJob::render(RenderCacheWriter &writer)
+{
+    VFSFile file(m_filename, "r");
+    if (!file)
+        return false;
+
+    ConsoleFileHandler fh(m_filename, file);
+    if (!fh.m_type)
+        return false;
+
+    if (fh.m_track < 0)
+        fh.m_track = 0;
+
+    if (start_track(fh, select_sample_rate(fh.m_type, m_cfg), m_cfg) < 0)
+        return false;
+
+    while (!fh.m_emu->track_ended())
+    {
+        if (RenderCacheWriter::cancelled())
+            return false;
+
+        int const buf_size = 1024;
+        Music_Emu::sample_t buf[buf_size];
+
+        fh.m_emu->play(buf_size, buf);
+        writer.write(buf, buf_size / 2);
+    }
+
+    return true;
+}
+
+static void prerender_add(const char *filename)
+{
+    VFSFile file(filename, "r");
+    if (!file)
+        return;
+
+    Index<char> data = file.read_all();
+    if (file.fseek(0, VFS_SEEK_SET))
+        return;
+
+    /* the settings are copied, so that the render matches the key */
+    AudaciousConsoleConfig cfg = audcfg;
+
+    ConsoleFileHandler fh(filename, file);
+    if (!fh.m_type)
+        return;
+
+    if (fh.m_track < 0)
+        fh.m_track = 0;
+
+    int sample_rate = select_sample_rate(fh.m_type, cfg);
+    int fade = start_track(fh, sample_rate, cfg);
+
+    String key;
+    if (fade >= 0)
+        key = cache_key(data, fh.m_track, sample_rate, fade, cfg);
+
+    if (key)
+        render_cache_prerender(key, 2, sample_rate, new ConsoleRenderJob(filename, cfg));
+}
+
+bool ConsolePlugin::play(const char *filename, VFSFile &file)
+{
+    RenderCacheWriter writer;
+    Index<char> data;
+
+    if (render_cache_enabled())
+    {
+        data = file.read_all();
+        if (file.fseek(0, VFS_SEEK_SET))
+            return false;
+    }
+
+    // identify file
+    ConsoleFileHandler fh(filename, file);
+    if (!fh.m_type)
+        return false;
+
+    if (fh.m_track < 0)
+        fh.m_track = 0;
+
+    render_cache_prerender_next(this, filename, prerender_add);
+
+    int sample_rate = select_sample_rate(fh.m_type, audcfg);
+    int fade = start_track(fh, sample_rate, audcfg);
+    if (fade < 0)
+        return false;
+
+    String key = cache_key(data, fh.m_track, sample_rate, fade, audcfg);
+    if (key)
+    {
+        if (render_cache_play(key, 2, sample_rate))
+            return true;
+
+        writer.open(key, 2, sample_rate);
+    }
+
+    set_stream_bitrate(fh.m_emu->voice_count() * 1000);
+    open_audio(FMT_S16_NE, sample_rate, 2);
+
     while (!check_stop())
     {
         /* Perform seek, if requested */
         int seek_value = check_seek();
         if (seek_value >= 0)
+        {
+            writer.discard();
             fh.m_emu->seek(seek_value);
+        }
 
         /* Fill and play buffer of audio */
         int const buf_size = 1024;
@@ -279,9 +412,13 @@ bool ConsolePlugin::play(const char *filename, VFSFile &file)
         fh.m_emu->play(buf_size, buf);
 
         write_audio(buf, sizeof(buf));
+        writer.write(buf, buf_size / 2);
 
         if (fh.m_emu->track_ended())
+        {
+            writer.finish();
             break;
+        }
     }
 
     return true;
@@ -13,6 +13,8 @@
 
 #include <libaudcore/runtime.h>
 
+#include "../render-cache-common/rendercache.h"
+
 #define CON_CFGID "console"
 
 AudaciousConsoleConfig audcfg;
@@ -41,11 +43,14 @@ bool ConsolePlugin::init ()
     audcfg.echo = aud_get_int (CON_CFGID, "echo");
     audcfg.inc_spc_reverb = aud_get_bool (CON_CFGID, "inc_spc_reverb");
 
+    render_cache_init ();
     return true;
 }
 
 void ConsolePlugin::cleanup ()
 {
+    render_cache_cleanup ();
+
     aud_set_int (CON_CFGID, "loop_length", audcfg.loop_length);
     aud_set_bool (CON_CFGID, "resample", audcfg.resample);
     aud_set_int (CON_CFGID, "resample_rate", audcfg.resample_rate);
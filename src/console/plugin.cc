@@ -9,6 +9,8 @@
 #include "configure.h"
 #include "plugin.h"
 
+#include "../render-cache-common/rendercache.h"
+
 EXPORT ConsolePlugin aud_plugin_instance;
 
 const char ConsolePlugin::about[] =
@@ -50,7 +52,8 @@ const PreferencesWidget ConsolePlugin::widgets[] = {
     WidgetCheck (N_("Ignore length from SPC tags"),
         WidgetBool (audcfg.ignore_spc_length)),
     WidgetCheck (N_("Increase reverb"),
-        WidgetBool (audcfg.inc_spc_reverb))
+        WidgetBool (audcfg.inc_spc_reverb)),
+    WidgetBox ({{render_cache_widgets}})
 };
 
 const PluginPreferences ConsolePlugin::prefs = {{widgets}};
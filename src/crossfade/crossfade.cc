@@ -40,6 +40,7 @@ static const char * const crossfade_defaults[] = {
     "no_fade_in", "FALSE",
     "use_sigmoid", "FALSE",
     "sigmoid_steepness", "6",
+    "smart", "FALSE",
     nullptr
 };
 
@@ -69,6 +70,8 @@ static const PreferencesWidget crossfade_widgets[] = {
         WidgetFloat ("crossfade", "sigmoid_steepness"),
         {2.0, 16.0, 0.5, N_("(higher is steeper)")},
         WIDGET_CHILD),
+    WidgetCheck (N_("Smart fade (follow fade-outs, skip silence)"),
+        WidgetBool ("crossfade", "smart")),
     WidgetLabel (N_("<b>Tip</b>")),
     WidgetLabel (N_("For better crossfading, enable\n"
                     "the Silence Removal effect."))
@@ -119,28 +122,44 @@ void Crossfade::cleanup ()
     output.clear ();
 }
 
-static void do_linear_ramp (float * data, int length, float a, float b)
-{
-    for (int i = 0; i < length; i ++)
-        (* data ++) *= (a * (length - i) + b * i) / length;
-}
+/* The fade curve is tabulated and interpolated per frame. */
+#define RAMP_SIZE 1024
+
+static float ramp_table[RAMP_SIZE + 1];
+static int ramp_sigmoid = -1;
+static float ramp_steepness;
 
-static void do_sigmoid_ramp (float * data, int length, float a, float b)
+static void update_ramp_table ()
 {
+    bool sigmoid = aud_get_bool ("crossfade", "use_sigmoid");
     float steepness = aud_get_double ("crossfade", "sigmoid_steepness");
-    for (int i = 0; i < length; i ++)
+
+    if (sigmoid == ramp_sigmoid && (! sigmoid || steepness == ramp_steepness))
+        return;
+
+    for (int i = 0; i <= RAMP_SIZE; i ++)
     {
-        float linear = (a * (length - i) + b * i) / length;
-        (* data ++) *= 0.5f + 0.5f * tanhf (steepness * (linear - 0.5f));
+        float linear = (float) i / RAMP_SIZE;
+        ramp_table[i] = sigmoid ? 0.5f + 0.5f * tanhf (steepness * (linear - 0.5f)) : linear;
     }
+
+    ramp_sigmoid = sigmoid;
+    ramp_steepness = steepness;
 }
 
-static void do_ramp (float * data, int length, float a, float b)
+static void do_ramp (float * data, int frames, float a, float b)
 {
-    if (aud_get_bool ("crossfade", "use_sigmoid"))
-        do_sigmoid_ramp (data, length, a, b);
-    else
-        do_linear_ramp (data, length, a, b);
+    update_ramp_table ();
+
+    for (int f = 0; f < frames; f ++)
+    {
+        float pos = (a * (frames - f) + b * f) / frames * RAMP_SIZE;
+        int i = aud::clamp ((int) pos, 0, RAMP_SIZE - 1);
+        float gain = ramp_table[i] + (ramp_table[i + 1] - ramp_table[i]) * (pos - i);
+
+        for (int c = 0; c < current_channels; c ++)
+            (* data ++) *= gain;
+    }
 }
 
 static void mix (float * data, float * add, int length)
@@ -149,35 +168,208 @@ static void mix (float * data, float * add, int length)
         (* data ++) += (* add ++);
 }
 
-/* stupid simple resampling/rechanneling algorithm */
-static void reformat (int channels, int rate)
-{
-    if (channels == current_channels && rate == current_rate)
-        return;
+/* When the next song has a different sample rate, the buffered end of the
+ * previous one is converted with a windowed-sinc interpolator (32 taps, 256
+ * phases), which is low-passed just below the new Nyquist frequency when
+ * reducing the rate. */
+#define SINC_TAPS 32
+#define SINC_PHASES 256
 
-    int old_frames = buffer.len () / current_channels;
+static void resample (int rate)
+{
+    int channels = current_channels;
+    int old_frames = buffer.len () / channels;
     int new_frames = (int64_t) old_frames * rate / current_rate;
+    double step = (double) current_rate / rate;
+    double cutoff = aud::min (1.0, 0.95 * rate / current_rate);
 
-    int map[AUD_MAX_CHANNELS];
-    for (int c = 0; c < channels; c ++)
-        map[c] = c * current_channels / channels;
+    float table[(SINC_PHASES + 1) * SINC_TAPS];
+
+    for (int p = 0; p <= SINC_PHASES; p ++)
+    {
+        float * coefs = table + p * SINC_TAPS;
+        double sum = 0;
+
+        for (int t = 0; t < SINC_TAPS; t ++)
+        {
+            double x = t - (SINC_TAPS / 2 - 1) - (double) p / SINC_PHASES;
+            double w = 0.42 + 0.5 * cos (M_PI * x / (SINC_TAPS / 2)) +
+             0.08 * cos (2 * M_PI * x / (SINC_TAPS / 2));
+            double y = M_PI * cutoff * x;
+
+            coefs[t] = (fabs (y) < 1e-9 ? 1 : sin (y) / y) * w;
+            sum += coefs[t];
+        }
+
+        for (int t = 0; t < SINC_TAPS; t ++)
+            coefs[t] /= sum;
+    }
 
     Index<float> new_buffer;
     new_buffer.resize (new_frames * channels);
 
     for (int f = 0; f < new_frames; f ++)
     {
-        int f0 = (int64_t) f * current_rate / rate;
-        int s0 = f0 * current_channels;
-        int s = f * channels;
+        double pos = f * step;
+        int f0 = (int) pos;
+        int first = f0 - (SINC_TAPS / 2 - 1);
+        const float * coefs = table + (int) ((pos - f0) * SINC_PHASES + 0.5) * SINC_TAPS;
+        float * out = & new_buffer[f * channels];
 
         for (int c = 0; c < channels; c ++)
-            new_buffer[s + c] = buffer[s0 + map[c]];
+        {
+            float sum = 0;
+
+            if (first >= 0 && first + SINC_TAPS <= old_frames)
+            {
+                const float * in = & buffer[first * channels + c];
+                for (int t = 0; t < SINC_TAPS; t ++)
+                    sum += in[t * channels] * coefs[t];
+            }
+            else
+            {
+                /* repeat the edge samples */
+                for (int t = 0; t < SINC_TAPS; t ++)
+                {
+                    int i = aud::clamp (first + t, 0, old_frames - 1);
+                    sum += buffer[i * channels + c] * coefs[t];
+                }
+            }
+
+            out[c] = sum;
+        }
     }
 
     buffer = std::move (new_buffer);
 }
 
+/* stupid simple rechanneling algorithm */
+static void rechannel (int channels)
+{
+    int frames = buffer.len () / current_channels;
+
+    int map[AUD_MAX_CHANNELS];
+    for (int c = 0; c < channels; c ++)
+        map[c] = c * current_channels / channels;
+
+    Index<float> new_buffer;
+    new_buffer.resize (frames * channels);
+
+    for (int f = 0; f < frames; f ++)
+    {
+        for (int c = 0; c < channels; c ++)
+            new_buffer[f * channels + c] = buffer[f * current_channels + map[c]];
+    }
+
+    buffer = std::move (new_buffer);
+    current_channels = channels;
+}
+
+static void reformat (int channels, int rate)
+{
+    if (channels != current_channels)
+        rechannel (channels);
+
+    if (rate != current_rate && buffer.len ())
+        resample (rate);
+}
+
+/* Smart mode looks at the level of the buffered end of a song: audio after it
+ * has become quiet is dropped, so that the next song starts where the music
+ * actually ends, and if the song fades out by itself, it is not faded out a
+ * second time.  Silence at the start of the next song is skipped as well. */
+#define SMART_BLOCK 0.05f       /* seconds */
+#define SMART_QUIET 0.0316f     /* -30 dB relative to the loudest block */
+#define SMART_FADING 0.25f      /* -12 dB from first to last quarter */
+#define SMART_SILENCE 0.0056f   /* -45 dBFS */
+
+static bool skip_silence;
+static int skipped_frames;
+
+static bool smart_trim ()
+{
+    int block = current_channels * aud::max (1, (int) (current_rate * SMART_BLOCK));
+    int blocks = buffer.len () / block;
+
+    if (blocks < 4)
+        return false;
+
+    Index<float> levels;
+    levels.resize (blocks);
+
+    float loudest = 0;
+
+    for (int b = 0; b < blocks; b ++)
+    {
+        const float * data = & buffer[b * block];
+        float sum = 0;
+
+        for (int i = 0; i < block; i ++)
+            sum += data[i] * data[i];
+
+        levels[b] = sqrtf (sum / block);
+        loudest = aud::max (loudest, levels[b]);
+    }
+
+    if (loudest < SMART_SILENCE)
+        return false;
+
+    int last = blocks - 1;
+    while (last > 0 && levels[last] < loudest * SMART_QUIET)
+        last --;
+
+    int keep = (last + 1) * block;
+    if (keep < buffer.len ())
+        buffer.remove (keep, -1);
+
+    /* compare the first and last quarter of what is left */
+    int quarter = aud::max (1, (last + 1) / 4);
+    float head = 0, tail = 0;
+
+    for (int b = 0; b < quarter; b ++)
+    {
+        head = aud::max (head, levels[b]);
+        tail = aud::max (tail, levels[last - b]);
+    }
+
+    if (tail >= head * SMART_FADING)
+        return false;
+
+    /* fading out by itself; just avoid a click where it is cut off */
+    do_ramp (& buffer[keep - block], block / current_channels, 1.0, 0.0);
+    return true;
+}
+
+static void run_skip_silence (Index<float> & data)
+{
+    int limit = buffer.len () / current_channels;
+    int frames = data.len () / current_channels;
+    int skip = 0;
+
+    while (skip < frames && skipped_frames < limit)
+    {
+        const float * frame = & data[skip * current_channels];
+        bool quiet = true;
+
+        for (int c = 0; c < current_channels; c ++)
+            quiet = quiet && fabsf (frame[c]) < SMART_SILENCE;
+
+        if (! quiet)
+        {
+            skip_silence = false;
+            break;
+        }
+
+        skip ++;
+        skipped_frames ++;
+    }
+
+    if (skipped_frames >= limit)
+        skip_silence = false;
+
+    data.remove (0, skip * current_channels);
+}
+
 static int buffer_needed_for_state ()
 {
     double overlap = 0;
@@ -222,14 +414,23 @@ void Crossfade::start (int & channels, int & rate)
 
 static void run_fadeout ()
 {
-    do_ramp (buffer.begin (), buffer.len (), 1.0, 0.0);
+    bool smart = aud_get_bool ("crossfade", "smart");
+
+    if (! smart || ! smart_trim ())
+        do_ramp (buffer.begin (), buffer.len () / current_channels, 1.0, 0.0);
 
     state = STATE_FADEIN;
     fadein_point = 0;
+
+    skip_silence = smart;
+    skipped_frames = 0;
 }
 
 static void run_fadein (Index<float> & data)
 {
+    if (skip_silence)
+        run_skip_silence (data);
+
     int length = buffer.len ();
 
     if (fadein_point < length)
@@ -239,7 +440,7 @@ static void run_fadein (Index<float> & data)
         float b = (float) (fadein_point + copy) / length;
 
         if (! aud_get_bool ("crossfade", "no_fade_in"))
-            do_ramp (data.begin (), copy, a, b);
+            do_ramp (data.begin (), copy / current_channels, a, b);
 
         mix (& buffer[fadein_point], data.begin (), copy);
         data.remove (0, copy);
@@ -326,7 +527,7 @@ Index<float> & Crossfade::finish (Index<float> & data, bool end_of_playlist)
 
     if (end_of_playlist && (state == STATE_FINISHED || state == STATE_FLUSHED))
     {
-        do_ramp (buffer.begin (), buffer.len (), 1.0, 0.0);
+        do_ramp (buffer.begin (), buffer.len () / current_channels, 1.0, 0.0);
 
         state = STATE_OFF;
         output_data_as_ready (0, true);
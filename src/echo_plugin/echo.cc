@@ -1,9 +1,37 @@
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 
 #define MAX_DELAY 1000
+#define MAX_TAPS 4
+#define MAX_DEPTH 10
+
+/* base delay (ms) that the modulation sweeps up from */
+#define CHORUS_DELAY 15
+#define FLANGER_DELAY 1
+
+/* length of the crossfade when the echo delay is changed (ms) */
+#define FADE_TIME 50
+
+/* windowed-sinc interpolation for fractional delays */
+#define SINC_TAPS 8
+#define SINC_PHASES 256
+
+enum {
+    MODE_ECHO,
+    MODE_CHORUS,
+    MODE_FLANGER
+};
 
 static const char echo_about[] =
  N_("Echo Plugin\n"
@@ -12,22 +40,45 @@ static const char echo_about[] =
     "Updated for Audacious by William Pitcock and John Lindgren, 2010-2014");
 
 static const char * const echo_defaults[] = {
+ "mode", "0",
  "delay", "500",
+ "taps", "1",
  "feedback", "50",
  "volume", "50",
+ "depth", "3",
+ "rate", "0.5",
  nullptr};
 
+static const ComboItem echo_modes[] = {
+    ComboItem (N_("Echo"), MODE_ECHO),
+    ComboItem (N_("Chorus"), MODE_CHORUS),
+    ComboItem (N_("Flanger"), MODE_FLANGER)
+};
+
 static const PreferencesWidget echo_widgets[] = {
     WidgetLabel (N_("<b>Echo</b>")),
+    WidgetCombo (N_("Mode:"),
+        WidgetInt ("echo_plugin", "mode"),
+        {{echo_modes}}),
     WidgetSpin (N_("Delay:"),
         WidgetInt ("echo_plugin", "delay"),
         {0, MAX_DELAY, 10, N_("ms")}),
+    WidgetSpin (N_("Taps:"),
+        WidgetInt ("echo_plugin", "taps"),
+        {1, MAX_TAPS, 1}),
     WidgetSpin (N_("Feedback:"),
         WidgetInt ("echo_plugin", "feedback"),
         {0, 100, 1, "%"}),
     WidgetSpin (N_("Volume:"),
         WidgetInt ("echo_plugin", "volume"),
-        {0, 100, 1, "%"})
+        {0, 100, 1, "%"}),
+    WidgetLabel (N_("<b>Chorus / Flanger</b>")),
+    WidgetSpin (N_("Depth:"),
+        WidgetFloat ("echo_plugin", "depth"),
+        {0, MAX_DEPTH, 0.1, N_("ms")}),
+    WidgetSpin (N_("Rate:"),
+        WidgetFloat ("echo_plugin", "rate"),
+        {0.05, 5, 0.05, N_("Hz")})
 };
 
 static const PluginPreferences echo_prefs = {{echo_widgets}};
@@ -53,12 +104,57 @@ public:
 
 EXPORT EchoPlugin aud_plugin_instance;
 
+/* The delay line is interleaved and indexed by frame.  The first SINC_TAPS
+ * frames are repeated after the end, so that neither the block copy nor the
+ * interpolator ever has to wrap in the middle of a read. */
 static Index<float> buffer;
-static int w_ofs;
+static int buffer_frames, w_pos;
+
+struct TapSet {
+    int delay, taps;  /* delay in frames */
+
+    bool operator== (const TapSet & b) const
+        { return delay == b.delay && taps == b.taps; }
+    bool operator!= (const TapSet & b) const
+        { return ! operator== (b); }
+};
+
+static TapSet cur_set, next_set;
+static int fade_pos, fade_frames;
+
+static float cur_volume, cur_feedback, cur_depth;
+static double lfo_phase;
+
+static float sinc_table[SINC_PHASES + 1][SINC_TAPS];
+
+static void make_sinc_table ()
+{
+    for (int p = 0; p <= SINC_PHASES; p ++)
+    {
+        double frac = (double) p / SINC_PHASES;
+        double sum = 0;
+
+        for (int t = 0; t < SINC_TAPS; t ++)
+        {
+            /* distance of this tap from the point being read */
+            double x = t - (SINC_TAPS / 2 - 1) - frac;
+            double w = 0.42 + 0.5 * cos (M_PI * x / (SINC_TAPS / 2)) +
+             0.08 * cos (2 * M_PI * x / (SINC_TAPS / 2));
+            double s = (fabs (x) < 1e-9) ? 1 : sin (M_PI * x) / (M_PI * x);
+
+            sinc_table[p][t] = s * w;
+            sum += s * w;
+        }
+
+        for (int t = 0; t < SINC_TAPS; t ++)
+            sinc_table[p][t] /= sum;
+    }
+}
 
 bool EchoPlugin::init ()
 {
     aud_config_set_defaults ("echo_plugin", echo_defaults);
+    make_sinc_table ();
     return true;
 }
 
@@ -77,39 +173,261 @@ void EchoPlugin::start (int & channels, int & rate)
         echo_channels = channels;
         echo_rate = rate;
 
-        buffer.resize (aud::rescale (MAX_DELAY, 1000, rate) * channels);
+        buffer_frames = aud::rescale (MAX_DELAY, 1000, rate) + SINC_TAPS + 1;
+        buffer.resize ((buffer_frames + SINC_TAPS) * channels);
         buffer.erase (0, -1);
 
-        w_ofs = 0;
+        w_pos = 0;
+        cur_set = next_set = {-1, 1};
+        fade_frames = aud::rescale (FADE_TIME, 1000, rate);
+        lfo_phase = 0;
+    }
+}
+
+static void advance_write (int frames)
+{
+    /* keep the copy of the first frames up to date */
+    if (w_pos < SINC_TAPS)
+    {
+        int n = aud::min (frames, SINC_TAPS - w_pos) * echo_channels;
+        float * f = & buffer[w_pos * echo_channels];
+        memcpy (f + buffer_frames * echo_channels, f, sizeof (float) * n);
+    }
+
+    w_pos += frames;
+    if (w_pos == buffer_frames)
+        w_pos = 0;
+}
+
+static int wrap_read (int frame)
+{
+    return (frame < 0) ? frame + buffer_frames : frame;
+}
+
+/* out = in + buf * volume, buf = in + buf * feedback */
+static void mix_block (float * data, const float * src, float * dst, int n,
+ float volume, float feedback)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    __m128 v = _mm_set1_ps (volume);
+    __m128 fb = _mm_set1_ps (feedback);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 in = _mm_loadu_ps (data + i);
+        __m128 buf = _mm_loadu_ps (src + i);
+        _mm_storeu_ps (data + i, _mm_add_ps (in, _mm_mul_ps (buf, v)));
+        _mm_storeu_ps (dst + i, _mm_add_ps (in, _mm_mul_ps (buf, fb)));
+    }
+#elif defined(__ARM_NEON)
+    float32x4_t v = vdupq_n_f32 (volume);
+    float32x4_t fb = vdupq_n_f32 (feedback);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t in = vld1q_f32 (data + i);
+        float32x4_t buf = vld1q_f32 (src + i);
+        vst1q_f32 (data + i, vmlaq_f32 (in, buf, v));
+        vst1q_f32 (dst + i, vmlaq_f32 (in, buf, fb));
+    }
+#endif
+
+    for (; i < n; i ++)
+    {
+        float in = data[i];
+        float buf = src[i];
+        data[i] = in + buf * volume;
+        dst[i] = in + buf * feedback;
+    }
+}
+
+/* single tap with steady parameters: runs of frames that don't wrap and
+ * don't read anything written in the same run are mixed in one go */
+static void echo_block (float * data, int frames, int delay, float volume, float feedback)
+{
+    while (frames > 0)
+    {
+        int r_pos = wrap_read (w_pos - delay);
+
+        int n = aud::min (frames, buffer_frames - w_pos);
+        n = aud::min (n, buffer_frames - r_pos);
+        if (delay > 0)
+            n = aud::min (n, delay);
+
+        mix_block (data, & buffer[r_pos * echo_channels],
+         & buffer[w_pos * echo_channels], n * echo_channels, volume, feedback);
+
+        advance_write (n);
+
+        data += n * echo_channels;
+        frames -= n;
+    }
+}
+
+/* the taps are evenly spaced and get quieter towards the end; the last one
+ * is fed back */
+static float read_taps (const TapSet & set, int channel, float & last)
+{
+    float sum = 0;
+
+    for (int k = 1; k <= set.taps; k ++)
+    {
+        int frame = wrap_read (w_pos - set.delay * k / set.taps);
+        last = buffer[frame * echo_channels + channel];
+        sum += last * (set.taps + 1 - k) / set.taps;
+    }
+
+    return sum;
+}
+
+/* general case: several taps, a crossfade to a new delay, or a change of
+ * volume or feedback, which is ramped across the block */
+static void echo_frames (float * data, int frames, float volume, float feedback)
+{
+    float volume_step = (volume - cur_volume) / frames;
+    float feedback_step = (feedback - cur_feedback) / frames;
+
+    for (int f = 0; f < frames; f ++)
+    {
+        float vol = cur_volume + volume_step * (f + 1);
+        float fb = cur_feedback + feedback_step * (f + 1);
+
+        bool fading = (next_set != cur_set);
+        float x = fading ? (float) fade_pos / fade_frames : 0;
+
+        for (int c = 0; c < echo_channels; c ++)
+        {
+            float in = data[c], last = 0;
+            float wet = read_taps (cur_set, c, last);
+
+            if (fading)
+            {
+                float next_last = 0;
+                float next_wet = read_taps (next_set, c, next_last);
+
+                wet += (next_wet - wet) * x;
+                last += (next_last - last) * x;
+            }
+
+            data[c] = in + wet * vol;
+            buffer[w_pos * echo_channels + c] = in + last * fb;
+        }
+
+        if (fading && ++ fade_pos >= fade_frames)
+            cur_set = next_set;
+
+        advance_write (1);
+        data += echo_channels;
+    }
+}
+
+static float read_fractional (float delay, int channel)
+{
+    float pos = w_pos - delay;
+    int base = floorf (pos);
+    int phase = (int) ((pos - base) * SINC_PHASES + 0.5f);
+
+    int frame = wrap_read (base - (SINC_TAPS / 2 - 1));
+    const float * src = & buffer[frame * echo_channels + channel];
+    const float * coefs = sinc_table[phase];
+
+    float sum = 0;
+    for (int t = 0; t < SINC_TAPS; t ++)
+        sum += src[t * echo_channels] * coefs[t];
+
+    return sum;
+}
+
+/* chorus and flanger: the delay is swept by a sine wave, a quarter cycle
+ * apart on each channel, and read between samples */
+static void modulate_frames (float * data, int frames, float base, float depth,
+ float rate, float volume, float feedback)
+{
+    float depth_step = (depth - cur_depth) / frames;
+    float volume_step = (volume - cur_volume) / frames;
+    float feedback_step = (feedback - cur_feedback) / frames;
+    double lfo_step = 2 * M_PI * rate / echo_rate;
+
+    for (int f = 0; f < frames; f ++)
+    {
+        float dep = cur_depth + depth_step * (f + 1);
+        float vol = cur_volume + volume_step * (f + 1);
+        float fb = cur_feedback + feedback_step * (f + 1);
+
+        for (int c = 0; c < echo_channels; c ++)
+        {
+            float lfo = 0.5f + 0.5f * sinf (lfo_phase + c * M_PI_2);
+            float wet = read_fractional (base + dep * lfo, c);
+            float in = data[c];
+
+            data[c] = in + wet * vol;
+            buffer[w_pos * echo_channels + c] = in + wet * fb;
+        }
+
+        lfo_phase += lfo_step;
+        if (lfo_phase >= 2 * M_PI)
+            lfo_phase -= 2 * M_PI;
+
+        advance_write (1);
+        data += echo_channels;
     }
 }
 
 Index<float> & EchoPlugin::process (Index<float> & data)
 {
-    int delay = aud_get_int ("echo_plugin", "delay");
+    int mode = aud_get_int ("echo_plugin", "mode");
     float feedback = aud_get_int ("echo_plugin", "feedback") / 100.0f;
     float volume = aud_get_int ("echo_plugin", "volume") / 100.0f;
 
-    int interval = aud::rescale (delay, 1000, echo_rate) * echo_channels;
-    interval = aud::clamp (interval, 0, buffer.len ());  // sanity check
+    int frames = data.len () / echo_channels;
+    if (! frames)
+        return data;
+
+    if (mode == MODE_CHORUS || mode == MODE_FLANGER)
+    {
+        float base = aud::rescale<float> ((mode == MODE_CHORUS) ?
+         CHORUS_DELAY : FLANGER_DELAY, 1000, echo_rate);
+        float depth = aud::rescale<float> (aud::clamp (aud_get_double
+         ("echo_plugin", "depth"), 0.0, (double) MAX_DEPTH), 1000, echo_rate);
+        float rate = aud::clamp (aud_get_double ("echo_plugin", "rate"), 0.0, 20.0);
+
+        /* a chorus with feedback just rings */
+        if (mode == MODE_CHORUS)
+            feedback = 0;
 
-    int r_ofs = w_ofs - interval;
-    if (r_ofs < 0)
-        r_ofs += buffer.len ();
+        /* stay clear of the frame being written */
+        base = aud::max (base, (float) SINC_TAPS);
 
-    float * end = data.end ();
+        modulate_frames (data.begin (), frames, base, depth, rate, volume, feedback);
 
-    for (float * f = data.begin (); f < end; f++)
+        cur_depth = depth;
+        cur_set = next_set = {-1, 1};
+    }
+    else
     {
-        float in = * f;
-        float buf = buffer[r_ofs];
+        int delay = aud::rescale (aud_get_int ("echo_plugin", "delay"), 1000, echo_rate);
+        int taps = aud::clamp (aud_get_int ("echo_plugin", "taps"), 1, MAX_TAPS);
+        TapSet set = {aud::clamp (delay, 0, buffer_frames - SINC_TAPS - 1), taps};
 
-        * f = in + buf * volume;
-        buffer[w_ofs] = in + buf * feedback;
+        if (cur_set.delay < 0)
+            cur_set = next_set = set;  /* nothing to fade from */
+        else if (next_set == cur_set && set != cur_set)
+        {
+            next_set = set;
+            fade_pos = 0;
+        }
 
-        r_ofs = (r_ofs + 1) % buffer.len ();
-        w_ofs = (w_ofs + 1) % buffer.len ();
+        if (next_set == cur_set && cur_set.taps == 1 &&
+         volume == cur_volume && feedback == cur_feedback)
+            echo_block (data.begin (), frames, cur_set.delay, volume, feedback);
+        else
+            echo_frames (data.begin (), frames, volume, feedback);
     }
 
+    cur_volume = volume;
+    cur_feedback = feedback;
+
     return data;
 }
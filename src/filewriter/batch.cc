@@ -0,0 +1,185 @@
+/*  FileWriter-Plugin
+ *  Copyright (c) 2026 Audacious developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Worker pool for batch mode.  Each job is one complete track: the decoded
+ * audio (spooled to a temporary file by the output thread) plus the output
+ * file it is to be encoded into.  Every job gets its own converter and
+ * encoder instance, so up to "batch_jobs" tracks are encoded at once while
+ * the player moves on to decoding the next track.
+ */
+
+#include <glib.h>
+#include <pthread.h>
+
+#include <libaudcore/runtime.h>
+
+#include "filewriter.h"
+#include "convert.h"
+
+struct BatchJob
+{
+    FileWriterImpl * impl;
+    VFSFile output, spool;
+    format_info info;
+    int out_fmt;
+    Tuple tuple;
+};
+
+static pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t batch_cond = PTHREAD_COND_INITIALIZER;
+
+static Index<SmartPtr<BatchJob>> batch_queue;
+static Index<pthread_t> batch_threads;
+static bool batch_quit;
+
+static void batch_run (BatchJob & job)
+{
+    int64_t start = g_get_monotonic_time ();
+
+    SmartPtr<FileWriterEncoder> encoder (job.impl->open (job.output,
+     {job.out_fmt, job.info.frequency, job.info.channels}, job.tuple));
+
+    if (! encoder)
+    {
+        AUDERR ("Failed to start encoder for %s.\n", job.output.filename ());
+        return;
+    }
+
+    if (job.spool.fseek (0, VFS_SEEK_SET) < 0)
+    {
+        AUDERR ("Failed to rewind temporary file for %s.\n", job.output.filename ());
+        encoder->close (job.output);
+        return;
+    }
+
+    Converter converter;
+    converter.init (job.info.format, job.out_fmt);
+
+    /* encode one second at a time */
+    int frame_size = FMT_SIZEOF (job.info.format) * job.info.channels;
+    Index<char> block;
+    block.resize (frame_size * job.info.frequency);
+
+    int64_t total = 0, length;
+    while ((length = job.spool.fread (block.begin (), 1, block.len ())) > 0)
+    {
+        length -= length % frame_size;
+
+        auto & buf = converter.process (block.begin (), length);
+        encoder->write (job.output, buf.begin (), buf.len ());
+
+        total += length;
+    }
+
+    encoder->close (job.output);
+
+    double audio_secs = (double) total / (frame_size * job.info.frequency);
+    double encode_secs = (double) (g_get_monotonic_time () - start) / G_USEC_PER_SEC;
+
+    AUDINFO ("Encoded %s: %.1f s of audio in %.1f s.\n",
+     job.output.filename (), audio_secs, encode_secs);
+}
+
+static void * batch_worker (void *)
+{
+    pthread_mutex_lock (& batch_mutex);
+
+    while (1)
+    {
+        if (! batch_queue.len ())
+        {
+            if (batch_quit)
+                break;
+
+            pthread_cond_wait (& batch_cond, & batch_mutex);
+            continue;
+        }
+
+        SmartPtr<BatchJob> job = std::move (batch_queue[0]);
+        batch_queue.remove (0, 1);
+
+        pthread_cond_broadcast (& batch_cond); /* signal room in queue */
+        pthread_mutex_unlock (& batch_mutex);
+
+        batch_run (* job);
+        job.clear (); /* closes and deletes the temporary file */
+
+        pthread_mutex_lock (& batch_mutex);
+    }
+
+    pthread_mutex_unlock (& batch_mutex);
+    return nullptr;
+}
+
+static int batch_n_jobs ()
+{
+    int jobs = aud_get_int ("filewriter", "batch_jobs");
+    return aud::clamp (jobs > 0 ? jobs : g_get_num_processors (), 1, 64);
+}
+
+void batch_submit (FileWriterImpl * impl, VFSFile && output, VFSFile && spool,
+ const format_info & info, int out_fmt, Tuple && tuple)
+{
+    pthread_mutex_lock (& batch_mutex);
+
+    if (! batch_threads.len ())
+    {
+        int jobs = batch_n_jobs ();
+        AUDDBG ("Starting %d encoder threads.\n", jobs);
+
+        for (int i = 0; i < jobs; i ++)
+        {
+            pthread_t thread;
+            if (! pthread_create (& thread, nullptr, batch_worker, nullptr))
+                batch_threads.append (thread);
+        }
+    }
+
+    if (! batch_threads.len ())
+    {
+        AUDERR ("Failed to create encoder threads.\n");
+        pthread_mutex_unlock (& batch_mutex);
+        return;
+    }
+
+    /* Keep at most one waiting job per worker.  This limits the disk space
+     * used by temporary files when decoding is faster than encoding. */
+    while (batch_queue.len () >= batch_threads.len ())
+        pthread_cond_wait (& batch_cond, & batch_mutex);
+
+    batch_queue.append (SmartNew<BatchJob> (BatchJob {impl, std::move (output),
+     std::move (spool), info, out_fmt, std::move (tuple)}));
+
+    pthread_cond_broadcast (& batch_cond);
+    pthread_mutex_unlock (& batch_mutex);
+}
+
+void batch_finish ()
+{
+    pthread_mutex_lock (& batch_mutex);
+    batch_quit = true;
+    pthread_cond_broadcast (& batch_cond);
+    pthread_mutex_unlock (& batch_mutex);
+
+    for (pthread_t thread : batch_threads)
+        pthread_join (thread, nullptr);
+
+    batch_threads.clear ();
+    batch_quit = false;
+}
@@ -3,8 +3,19 @@
 
 #include <libaudcore/index.h>
 
-void convert_init (int input_fmt, int output_fmt);
-const Index<char> & convert_process (const void * ptr, int length);
-void convert_free ();
+class Converter
+{
+public:
+    void init (int input_fmt, int output_fmt);
+    const Index<char> & process (const void * ptr, int length);
+    void free ();
+
+private:
+    int in_fmt = 0;
+    int out_fmt = 0;
+
+    Index<char> output;
+    Index<float> temp;
+};
 
 #endif
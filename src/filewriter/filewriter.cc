@@ -21,18 +21,27 @@
  */
 
 #include <glib.h>
+#include <pthread.h>
 #include <string.h>
 
 #include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
+#include <libaudcore/interface.h>
+#include <libaudcore/playlist.h>
 #include <libaudcore/plugin.h>
+#include <libaudcore/plugins.h>
 #include <libaudcore/preferences.h>
+#include <libaudcore/ringbuf.h>
 #include <libaudcore/runtime.h>
 
 #ifdef FILEWRITER_MP3
 #include <lame/lame.h>
 #endif
 
+#ifdef FILEWRITER_OPUS
+#include <opusenc.h>
+#endif
+
 #include "filewriter.h"
 #include "convert.h"
 
@@ -54,6 +63,7 @@ public:
     constexpr FileWriter () : OutputPlugin (info, 0, true) {}
 
     bool init () override;
+    void cleanup () override;
 
     StereoVolume get_volume () override { return {0, 0}; }
     void set_volume (StereoVolume v) override {}
@@ -62,9 +72,9 @@ public:
     bool open_audio (int fmt, int rate, int nch, String & error) override;
     void close_audio () override;
 
-    void period_wait () override {}
+    void period_wait () override;
     int write_audio (const void * ptr, int length) override;
-    void drain () override {}
+    void drain () override;
 
     int get_delay () override { return 0; }
 
@@ -109,6 +119,9 @@ enum fileext_t
 #endif
 #ifdef FILEWRITER_FLAC
     FLAC,
+#endif
+#ifdef FILEWRITER_OPUS
+    OPUS,
 #endif
     FILEEXT_MAX
 };
@@ -123,13 +136,44 @@ static const char *fileext_str[FILEEXT_MAX] =
     ".ogg",
 #endif
 #ifdef FILEWRITER_FLAC
-    ".flac"
+    ".flac",
+#endif
+#ifdef FILEWRITER_OPUS
+    ".opus"
 #endif
 };
 
 static FileWriterImpl *plugin;
+static FileWriterEncoder *encoder;
+static Converter converter;
 static VFSFile output_file;
 
+/* in batch mode, the decoded audio is spooled to a temporary file and the
+ * file is encoded by the worker pool in batch.cc once it is complete */
+static bool batch_active;
+static VFSFile spool_file;
+static format_info spool_info;
+
+/*
+ * When "encoder_thread" is enabled, write_audio() only copies the incoming
+ * PCM into a bounded ring buffer; conversion and encoding happen in a
+ * separate thread, so that the decoder is not throttled to the speed of the
+ * encoder.  The ring buffer is protected by encoder_mutex; the encoder thread
+ * copies a block out under the lock and encodes it with the lock released.
+ * When the buffer is full, period_wait() blocks until the encoder catches up.
+ */
+static pthread_mutex_t encoder_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t encoder_cond = PTHREAD_COND_INITIALIZER;
+
+static bool encoder_running, encoder_quit, encoder_busy;
+static pthread_t encoder_thread;
+static RingBuf<char> encoder_queue;
+static int encoder_frame_size, encoder_bytes_per_sec;
+
+/* statistics, reported when the file is closed */
+static int64_t encoder_bytes_total, encoder_time_total; /* microseconds */
+static int encoder_peak_depth;
+
 FileWriterImpl *plugins[FILEEXT_MAX] = {
     &wav_plugin,
 #ifdef FILEWRITER_MP3
@@ -141,6 +185,9 @@ FileWriterImpl *plugins[FILEEXT_MAX] = {
 #ifdef FILEWRITER_FLAC
     &flac_plugin,
 #endif
+#ifdef FILEWRITER_OPUS
+    &opus_plugin,
+#endif
 };
 
 const char * const FileWriter::defaults[] = {
@@ -153,8 +200,44 @@ const char * const FileWriter::defaults[] = {
  "prependnumber", "FALSE",
  "save_original", "FALSE",
  "use_suffix", "FALSE",
+ "encoder_thread", "TRUE",
+ "encoder_buffer", "2000",
+ "batch_mode", "FALSE",
+ "batch_jobs", "0",
  nullptr};
 
+/* Plays the selected entries in a new playlist, so that they are written out
+ * through this plugin.  Decoding still goes through the playback core (there
+ * is only one), but in batch mode it runs ahead of the encoders and each
+ * finished track is encoded in parallel on the worker pool. */
+static void convert_selected ()
+{
+    if (aud_plugin_get_current (PluginType::Output) != aud_plugin_by_header (& aud_plugin_instance))
+    {
+        aud_ui_show_error (_("To convert tracks, select the FileWriter plugin "
+         "as the output plugin first."));
+        return;
+    }
+
+    auto playlist = Playlist::active_playlist ();
+    int entries = playlist.n_entries ();
+
+    Index<PlaylistAddItem> items;
+
+    for (int i = 0; i < entries; i ++)
+    {
+        if (playlist.entry_selected (i))
+            items.append (playlist.entry_filename (i), playlist.entry_tuple (i, Playlist::NoWait));
+    }
+
+    if (! items.len ())
+        return;
+
+    auto batch = Playlist::new_playlist ();
+    batch.set_title (_("Conversion"));
+    batch.insert_items (0, std::move (items), true);
+}
+
 bool FileWriter::init ()
 {
     aud_config_set_defaults ("filewriter", defaults);
@@ -190,9 +273,20 @@ bool FileWriter::init ()
     mp3_id3_only_v2 = aud_get_int ("filewriter_mp3", "only_v2_val");
 #endif
 
+    aud_plugin_menu_add (AudMenuID::Playlist, convert_selected,
+     _("Convert Selected Tracks"), "document-save");
+
     return true;
 }
 
+void FileWriter::cleanup ()
+{
+    aud_plugin_menu_remove (AudMenuID::Playlist, convert_selected);
+
+    /* wait for any files still being encoded */
+    batch_finish ();
+}
+
 static StringBuf get_file_path ()
 {
     String path = aud_get_str ("filewriter", "file_path");
@@ -290,6 +384,102 @@ static StringBuf format_filename (const char * suffix)
     return filename.settle ();
 }
 
+static void * encoder_worker (void *)
+{
+    Index<char> block;
+
+    pthread_mutex_lock (& encoder_mutex);
+
+    while (1)
+    {
+        if (! encoder_queue.len ())
+        {
+            /* the queue is drained before the thread exits */
+            if (encoder_quit)
+                break;
+
+            pthread_cond_wait (& encoder_cond, & encoder_mutex);
+            continue;
+        }
+
+        /* encode about 50 ms at a time to keep the lock hold time short */
+        int length = aud::min (encoder_queue.len (), encoder_bytes_per_sec / 20);
+        length = aud::max (length - length % encoder_frame_size, encoder_frame_size);
+
+        block.resize (length);
+        encoder_queue.move_out (block.begin (), length);
+        encoder_busy = true;
+
+        pthread_cond_broadcast (& encoder_cond); /* signal room in queue */
+        pthread_mutex_unlock (& encoder_mutex);
+
+        int64_t start = g_get_monotonic_time ();
+
+        auto & buf = converter.process (block.begin (), length);
+        encoder->write (output_file, buf.begin (), buf.len ());
+
+        int64_t elapsed = g_get_monotonic_time () - start;
+
+        pthread_mutex_lock (& encoder_mutex);
+
+        encoder_bytes_total += length;
+        encoder_time_total += elapsed;
+        encoder_busy = false;
+
+        pthread_cond_broadcast (& encoder_cond); /* signal block complete */
+    }
+
+    pthread_mutex_unlock (& encoder_mutex);
+    return nullptr;
+}
+
+static void encoder_start (int fmt, int rate, int nch)
+{
+    int buffer_ms = aud::clamp (aud_get_int ("filewriter", "encoder_buffer"), 100, 30000);
+
+    encoder_frame_size = FMT_SIZEOF (fmt) * nch;
+    encoder_bytes_per_sec = encoder_frame_size * rate;
+    encoder_queue.alloc (encoder_frame_size *
+     aud::max (aud::rescale (buffer_ms, 1000, rate), 1));
+
+    encoder_quit = false;
+    encoder_busy = false;
+    encoder_bytes_total = 0;
+    encoder_time_total = 0;
+    encoder_peak_depth = 0;
+
+    if (pthread_create (& encoder_thread, nullptr, encoder_worker, nullptr))
+    {
+        AUDERR ("Failed to create encoder thread, encoding synchronously.\n");
+        encoder_queue.destroy ();
+        return;
+    }
+
+    encoder_running = true;
+}
+
+static void encoder_stop ()
+{
+    pthread_mutex_lock (& encoder_mutex);
+    encoder_quit = true;
+    pthread_cond_broadcast (& encoder_cond);
+    pthread_mutex_unlock (& encoder_mutex);
+
+    pthread_join (encoder_thread, nullptr);
+
+    encoder_running = false;
+
+    double audio_secs = (double) encoder_bytes_total / encoder_bytes_per_sec;
+    double encode_secs = (double) encoder_time_total / G_USEC_PER_SEC;
+
+    AUDINFO ("Encoded %.1f s of audio in %.1f s (%.1fx realtime), "
+     "peak queue depth %d%%.\n", audio_secs, encode_secs,
+     encode_secs > 0 ? audio_secs / encode_secs : 0.0,
+     encoder_peak_depth * 100 / aud::max (encoder_queue.size (), 1));
+
+    encoder_queue.destroy ();
+}
+
 bool FileWriter::open_audio (int fmt, int rate, int nch, String & error)
 {
     int ext = aud_get_int ("filewriter", "fileext");
@@ -302,13 +492,31 @@ bool FileWriter::open_audio (int fmt, int rate, int nch, String & error)
     plugin = plugins[ext];
 
     int out_fmt = plugin->format_required (fmt);
-    convert_init (fmt, out_fmt);
 
     output_file = safe_create (filename);
-    if (output_file)
+    if (output_file && aud_get_bool ("filewriter", "batch_mode"))
     {
-        if (plugin->open (output_file, {out_fmt, rate, nch}, in_tuple))
+        spool_file = VFSFile::tmpfile ();
+        if (spool_file)
+        {
+            spool_info = {fmt, rate, nch};
+            batch_active = true;
             return true;
+        }
+
+        error = String (_("Error creating temporary file"));
+    }
+    else if (output_file)
+    {
+        converter.init (fmt, out_fmt);
+
+        if ((encoder = plugin->open (output_file, {out_fmt, rate, nch}, in_tuple)))
+        {
+            if (aud_get_bool ("filewriter", "encoder_thread"))
+                encoder_start (fmt, rate, nch);
+
+            return true;
+        }
     }
     else
     {
@@ -325,16 +533,84 @@ bool FileWriter::open_audio (int fmt, int rate, int nch, String & error)
 
 int FileWriter::write_audio (const void * ptr, int length)
 {
-    auto & buf = convert_process (ptr, length);
-    plugin->write (output_file, buf.begin (), buf.len ());
+    if (batch_active)
+    {
+        if (spool_file.fwrite (ptr, 1, length) != length)
+            AUDERR ("Error writing to temporary file.\n");
+
+        return length;
+    }
+
+    if (! encoder_running)
+    {
+        auto & buf = converter.process (ptr, length);
+        encoder->write (output_file, buf.begin (), buf.len ());
+
+        return length;
+    }
+
+    pthread_mutex_lock (& encoder_mutex);
+
+    /* only queue whole frames so that the encoder never sees a partial one */
+    length = aud::min (length, encoder_queue.space ());
+    length -= length % encoder_frame_size;
+
+    encoder_queue.copy_in ((const char *) ptr, length);
+    encoder_peak_depth = aud::max (encoder_peak_depth, encoder_queue.len ());
+
+    pthread_cond_broadcast (& encoder_cond);
+    pthread_mutex_unlock (& encoder_mutex);
 
     return length;
 }
 
+void FileWriter::period_wait ()
+{
+    if (! encoder_running)
+        return;
+
+    pthread_mutex_lock (& encoder_mutex);
+
+    while (encoder_queue.space () < encoder_frame_size)
+        pthread_cond_wait (& encoder_cond, & encoder_mutex);
+
+    pthread_mutex_unlock (& encoder_mutex);
+}
+
+void FileWriter::drain ()
+{
+    if (! encoder_running)
+        return;
+
+    pthread_mutex_lock (& encoder_mutex);
+
+    while (encoder_queue.len () || encoder_busy)
+        pthread_cond_wait (& encoder_cond, & encoder_mutex);
+
+    pthread_mutex_unlock (& encoder_mutex);
+}
+
 void FileWriter::close_audio ()
 {
-    plugin->close (output_file);
-    convert_free ();
+    if (batch_active)
+    {
+        int out_fmt = plugin->format_required (spool_info.format);
+        batch_submit (plugin, std::move (output_file), std::move (spool_file),
+         spool_info, out_fmt, std::move (in_tuple));
+
+        batch_active = false;
+    }
+    else
+    {
+        if (encoder_running)
+            encoder_stop ();
+
+        encoder->close (output_file);
+        delete encoder;
+        encoder = nullptr;
+
+        converter.free ();
+    }
 
     plugin = nullptr;
     output_file = VFSFile ();
@@ -378,6 +654,9 @@ static const ComboItem plugin_combo[] = {
 #ifdef FILEWRITER_FLAC
     ,ComboItem ("FLAC", FLAC)
 #endif
+#ifdef FILEWRITER_OPUS
+    ,ComboItem ("Opus", OPUS)
+#endif
 };
 
 static const PreferencesWidget main_widgets[] = {
@@ -408,7 +687,20 @@ static const PreferencesWidget main_widgets[] = {
         {FILENAME_FROM_TAG}),
     WidgetSeparator ({true}),
     WidgetCheck (N_("Prepend track number to file name"),
-        WidgetBool ("filewriter", "prependnumber"))
+        WidgetBool ("filewriter", "prependnumber")),
+    WidgetSeparator ({true}),
+    WidgetCheck (N_("Encode in a separate thread"),
+        WidgetBool ("filewriter", "encoder_thread")),
+    WidgetSpin (N_("Encoder buffer size:"),
+        WidgetInt ("filewriter", "encoder_buffer"),
+        {100, 30000, 100, N_("ms")},
+        WIDGET_CHILD),
+    WidgetCheck (N_("Batch mode (encode finished tracks in parallel)"),
+        WidgetBool ("filewriter", "batch_mode")),
+    WidgetSpin (N_("Parallel jobs:"),
+        WidgetInt ("filewriter", "batch_jobs"),
+        {0, 64, 1, N_("(0 = one per CPU)")},
+        WIDGET_CHILD)
 };
 
 #ifdef FILEWRITER_MP3
@@ -568,6 +860,29 @@ static const PreferencesWidget vorbis_widgets[] = {
 };
 #endif
 
+#ifdef FILEWRITER_OPUS
+static const ComboItem opus_frame_sizes[] = {
+    ComboItem(N_("2.5 ms"), OPUS_FRAMESIZE_2_5_MS),
+    ComboItem(N_("5 ms"), OPUS_FRAMESIZE_5_MS),
+    ComboItem(N_("10 ms"), OPUS_FRAMESIZE_10_MS),
+    ComboItem(N_("20 ms"), OPUS_FRAMESIZE_20_MS),
+    ComboItem(N_("40 ms"), OPUS_FRAMESIZE_40_MS),
+    ComboItem(N_("60 ms"), OPUS_FRAMESIZE_60_MS)
+};
+
+static const PreferencesWidget opus_widgets[] = {
+    WidgetSpin(N_("Bitrate:"),
+        WidgetInt("filewriter_opus", "bitrate"),
+        {6, 512, 1, N_("kbit/s")}),
+    WidgetSpin(N_("Complexity:"),
+        WidgetInt("filewriter_opus", "complexity"),
+        {0, 10, 1}),
+    WidgetCombo(N_("Frame size:"),
+        WidgetInt("filewriter_opus", "frame_size"),
+        {{opus_frame_sizes}})
+};
+#endif
+
 static const NotebookTab tabs[] = {
     {N_("General"), {main_widgets}}
 #ifdef FILEWRITER_MP3
@@ -576,6 +891,9 @@ static const NotebookTab tabs[] = {
 #ifdef FILEWRITER_VORBIS
     ,{"Vorbis", {vorbis_widgets}}
 #endif
+#ifdef FILEWRITER_OPUS
+    ,{"Opus", {opus_widgets}}
+#endif
 };
 
 const PreferencesWidget FileWriter::widgets[] = {
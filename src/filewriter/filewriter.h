@@ -34,12 +34,21 @@ struct format_info {
     int channels;
 };
 
+/* State of one output file being encoded.  Each file gets its own instance,
+ * so that several files can be encoded at the same time. */
+class FileWriterEncoder
+{
+public:
+    virtual ~FileWriterEncoder () {}
+
+    virtual void write (VFSFile & file, const void * data, int length) = 0;
+    virtual void close (VFSFile & file) = 0;
+};
+
 struct FileWriterImpl
 {
     void (* init) ();
-    bool (* open) (VFSFile & file, const format_info & info, const Tuple & tuple);
-    void (* write) (VFSFile & file, const void * data, int length);
-    void (* close) (VFSFile & file);
+    FileWriterEncoder * (* open) (VFSFile & file, const format_info & info, const Tuple & tuple);
     int (* format_required) (int fmt);
 };
 
@@ -57,4 +66,13 @@ extern FileWriterImpl vorbis_plugin;
 extern FileWriterImpl flac_plugin;
 #endif
 
+#ifdef FILEWRITER_OPUS
+extern FileWriterImpl opus_plugin;
+#endif
+
+/* batch.cc */
+void batch_submit (FileWriterImpl * impl, VFSFile && output, VFSFile && spool,
+ const format_info & info, int out_fmt, Tuple && tuple);
+void batch_finish ();
+
 #endif
@@ -27,9 +27,24 @@
 
 #include <libaudcore/audstrings.h>
 
-static int channels;
-static FLAC__StreamEncoder *flac_encoder;
-static FLAC__StreamMetadata *flac_metadata;
+#include "../sampleconv-common/sampleconv.h"
+
+class FLACEncoder : public FileWriterEncoder
+{
+public:
+    ~FLACEncoder ();
+
+    bool open (VFSFile & file, const format_info & info, const Tuple & tuple);
+
+    void write (VFSFile & file, const void * data, int length) override;
+    void close (VFSFile & file) override;
+
+private:
+    int channels = 0;
+    FLAC__StreamEncoder *flac_encoder = nullptr;
+    FLAC__StreamMetadata *flac_metadata = nullptr;
+    Index<FLAC__int32> encbuffer;
+};
 
 static FLAC__StreamEncoderWriteStatus flac_write_cb(const FLAC__StreamEncoder *encoder,
     const FLAC__byte buffer[], size_t bytes, unsigned samples, unsigned current_frame, void * data)
@@ -94,7 +109,7 @@ static void insert_vorbis_comment (FLAC__StreamMetadata * meta,
      meta->data.vorbis_comment.num_comments, comment, true);
 }
 
-static bool flac_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+bool FLACEncoder::open (VFSFile & file, const format_info & info, const Tuple & tuple)
 {
     flac_encoder = FLAC__stream_encoder_new();
 
@@ -122,55 +137,25 @@ static bool flac_open (VFSFile & file, const format_info & info, const Tuple & t
     return true;
 }
 
-static void flac_write (VFSFile & file, const void * data, int length)
+void FLACEncoder::write (VFSFile & file, const void * data, int length)
 {
-#if 1
-    FLAC__int32 *encbuffer[2];
-    int16_t *tmpdata = (int16_t *) data;
-    int i;
-
-    encbuffer[0] = new FLAC__int32[length / channels];
-    encbuffer[1] = new FLAC__int32[length / channels];
-
-    if (channels == 1)
-    {
-        for (i = 0; i < (length / 2); i++)
-        {
-            encbuffer[0][i] = tmpdata[i];
-            encbuffer[1][i] = tmpdata[i];
-        }
-    }
-    else
-    {
-        for (i = 0; i < (length / 4); i++)
-        {
-            encbuffer[0][i] = tmpdata[2 * i];
-            encbuffer[1][i] = tmpdata[2 * i + 1];
-        }
-    }
-
-    FLAC__stream_encoder_process(flac_encoder, (const FLAC__int32 **)encbuffer, length / (channels * 2));
-
-    delete[] encbuffer[0];
-    delete[] encbuffer[1];
-#else
-    FLAC__int32 *encbuffer;
-    int16_t *tmpdata = (int16_t *) data;
-    int i;
+    int samples = length / sizeof (int16_t);
 
-    encbuffer = new FLAC__int32[length];
+    encbuffer.resize (samples);
+    sampleconv_widen_s16 ((const int16_t *) data, encbuffer.begin (), samples);
 
-    for (i=0; i < length; i++) {
-        encbuffer[i] = tmpdata[i];
-    }
-
-    FLAC__stream_encoder_process_interleaved(flac_encoder, encbuffer, length);
+    FLAC__stream_encoder_process_interleaved (flac_encoder, encbuffer.begin (), samples / channels);
+}
 
-    delete[] encbuffer;
-#endif
+FLACEncoder::~FLACEncoder ()
+{
+    if (flac_encoder)
+        FLAC__stream_encoder_delete(flac_encoder);
+    if (flac_metadata)
+        FLAC__metadata_object_delete(flac_metadata);
 }
 
-static void flac_close (VFSFile & file)
+void FLACEncoder::close (VFSFile & file)
 {
     if (flac_encoder)
     {
@@ -184,6 +169,18 @@ static void flac_close (VFSFile & file)
         FLAC__metadata_object_delete(flac_metadata);
         flac_metadata = nullptr;
     }
+
+    encbuffer.clear ();
+}
+
+static FileWriterEncoder * flac_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+{
+    auto encoder = new FLACEncoder;
+    if (encoder->open (file, info, tuple))
+        return encoder;
+
+    delete encoder;
+    return nullptr;
 }
 
 static int flac_format_required (int fmt)
@@ -194,8 +191,6 @@ static int flac_format_required (int fmt)
 FileWriterImpl flac_plugin = {
     nullptr,  // init
     flac_open,
-    flac_write,
-    flac_close,
     flac_format_required,
 };
 
@@ -29,13 +29,25 @@
 #include <libaudcore/audstrings.h>
 #include <libaudcore/runtime.h>
 
-static lame_global_flags *gfp;
-static unsigned char encbuffer[LAME_MAXMP3BUFFER];
-static int id3v2_size;
+class MP3Encoder : public FileWriterEncoder
+{
+public:
+    ~MP3Encoder ();
+
+    bool open (VFSFile & file, const format_info & info, const Tuple & tuple);
+
+    void write (VFSFile & file, const void * data, int length) override;
+    void close (VFSFile & file) override;
 
-static int channels;
-static unsigned long numsamples;
-static Index<unsigned char> write_buffer;
+private:
+    lame_global_flags *gfp = nullptr;
+    unsigned char encbuffer[LAME_MAXMP3BUFFER];
+    int id3v2_size = 0;
+
+    int channels = 0;
+    unsigned long numsamples = 0;
+    Index<unsigned char> write_buffer;
+};
 
 static void lame_debugf(const char *format, va_list ap)
 {
@@ -74,7 +86,13 @@ static void mp3_init ()
     aud_config_set_defaults ("filewriter_mp3", mp3_defaults);
 }
 
-static bool mp3_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+MP3Encoder::~MP3Encoder ()
+{
+    if (gfp)
+        lame_close(gfp);
+}
+
+bool MP3Encoder::open (VFSFile & file, const format_info & info, const Tuple & tuple)
 {
     int imp3;
 
@@ -175,7 +193,7 @@ static bool mp3_open (VFSFile & file, const format_info & info, const Tuple & tu
     return true;
 }
 
-static void mp3_write (VFSFile & file, const void * data, int length)
+void MP3Encoder::write (VFSFile & file, const void * data, int length)
 {
     int encoded;
 
@@ -205,7 +223,7 @@ static void mp3_write (VFSFile & file, const void * data, int length)
     numsamples += length / (2 * channels);
 }
 
-static void mp3_close (VFSFile & file)
+void MP3Encoder::close (VFSFile & file)
 {
     int imp3, encout;
 
@@ -245,9 +263,20 @@ static void mp3_close (VFSFile & file)
     write_buffer.clear ();
 
     lame_close(gfp);
+    gfp = nullptr;
     AUDDBG("lame_close() done\n");
 }
 
+static FileWriterEncoder * mp3_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+{
+    auto encoder = new MP3Encoder;
+    if (encoder->open (file, info, tuple))
+        return encoder;
+
+    delete encoder;
+    return nullptr;
+}
+
 static int mp3_format_required (int fmt)
 {
     return FMT_FLOAT;
@@ -256,8 +285,6 @@ static int mp3_format_required (int fmt)
 FileWriterImpl mp3_plugin = {
     mp3_init,
     mp3_open,
-    mp3_write,
-    mp3_close,
     mp3_format_required,
 };
 
@@ -0,0 +1,188 @@
+/*  FileWriter Opus Plugin
+ *  Copyright (c) 2026 Audacious developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "filewriter.h"
+
+#ifdef FILEWRITER_OPUS
+
+#include <opusenc.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/runtime.h>
+
+static const char * const opus_defaults[] = {
+ "bitrate", "96",
+ "complexity", "10",
+ "frame_size", aud::numeric_string<OPUS_FRAMESIZE_20_MS>::str,
+ nullptr};
+
+#define GET_INT(n) aud_get_int("filewriter_opus", n)
+
+class OpusOggEncoder : public FileWriterEncoder
+{
+public:
+    ~OpusOggEncoder ();
+
+    bool open (VFSFile & file, const format_info & info, const Tuple & tuple);
+
+    void write (VFSFile & file, const void * data, int length) override;
+    void close (VFSFile & file) override;
+
+private:
+    static int write_cb (void * user, const unsigned char * ptr, opus_int32 len);
+    static int close_cb (void * user);
+
+    OggOpusEnc * enc = nullptr;
+    int channels = 0;
+};
+
+static void opus_init ()
+{
+    aud_config_set_defaults ("filewriter_opus", opus_defaults);
+}
+
+static void add_string_from_tuple (OggOpusComments * comments, const char * name,
+ const Tuple & tuple, Tuple::Field field)
+{
+    String val = tuple.get_str (field);
+    if (val)
+        ope_comments_add (comments, name, val);
+}
+
+static void add_int_from_tuple (OggOpusComments * comments, const char * name,
+ const Tuple & tuple, Tuple::Field field)
+{
+    int val = tuple.get_int (field);
+    if (val > 0)
+        ope_comments_add (comments, name, int_to_str (val));
+}
+
+/* libopusenc hands us whole Ogg pages */
+int OpusOggEncoder::write_cb (void * user, const unsigned char * ptr, opus_int32 len)
+{
+    auto file = (VFSFile *) user;
+
+    if (file->fwrite (ptr, 1, len) != len)
+    {
+        AUDERR ("write error\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/* the file itself is closed by the caller */
+int OpusOggEncoder::close_cb (void *)
+{
+    return 0;
+}
+
+OpusOggEncoder::~OpusOggEncoder ()
+{
+    if (enc)
+        ope_encoder_destroy (enc);
+}
+
+bool OpusOggEncoder::open (VFSFile & file, const format_info & info, const Tuple & tuple)
+{
+    static const OpusEncCallbacks callbacks = {write_cb, close_cb};
+
+    OggOpusComments * comments = ope_comments_create ();
+    if (! comments)
+        return false;
+
+    add_string_from_tuple (comments, "TITLE", tuple, Tuple::Title);
+    add_string_from_tuple (comments, "ARTIST", tuple, Tuple::Artist);
+    add_string_from_tuple (comments, "ALBUM", tuple, Tuple::Album);
+    add_string_from_tuple (comments, "ALBUMARTIST", tuple, Tuple::AlbumArtist);
+    add_string_from_tuple (comments, "GENRE", tuple, Tuple::Genre);
+    add_string_from_tuple (comments, "DATE", tuple, Tuple::Date);
+    add_string_from_tuple (comments, "COMMENT", tuple, Tuple::Comment);
+    add_int_from_tuple (comments, "TRACKNUMBER", tuple, Tuple::Track);
+    add_int_from_tuple (comments, "DISCNUMBER", tuple, Tuple::Disc);
+
+    /* mapping family 0 covers mono and stereo, family 1 the Vorbis channel
+     * layouts up to 8 channels; anything beyond that is left unassigned */
+    int family = (info.channels <= 2) ? 0 : (info.channels <= 8) ? 1 : 255;
+
+    /* libopusenc resamples internally if the input is not at 48 kHz */
+    int error = OPE_OK;
+    enc = ope_encoder_create_callbacks (& callbacks, & file, comments,
+     info.frequency, info.channels, family, & error);
+
+    ope_comments_destroy (comments);
+
+    if (! enc)
+    {
+        AUDERR ("Failed to create Opus encoder: %s\n", ope_strerror (error));
+        return false;
+    }
+
+    int bitrate = aud::clamp (GET_INT ("bitrate"), 6, 512);
+    int complexity = aud::clamp (GET_INT ("complexity"), 0, 10);
+
+    if (ope_encoder_ctl (enc, OPUS_SET_BITRATE (bitrate * 1000)) != OPE_OK ||
+     ope_encoder_ctl (enc, OPUS_SET_COMPLEXITY (complexity)) != OPE_OK ||
+     ope_encoder_ctl (enc, OPUS_SET_EXPERT_FRAME_DURATION (GET_INT ("frame_size"))) != OPE_OK)
+        AUDWARN ("Failed to apply some Opus encoder settings.\n");
+
+    channels = info.channels;
+    return true;
+}
+
+void OpusOggEncoder::write (VFSFile & file, const void * data, int length)
+{
+    int frames = length / (sizeof (float) * channels);
+
+    int error = ope_encoder_write_float (enc, (const float *) data, frames);
+    if (error != OPE_OK)
+        AUDERR ("Opus encoding error: %s\n", ope_strerror (error));
+}
+
+void OpusOggEncoder::close (VFSFile & file)
+{
+    int error = ope_encoder_drain (enc);
+    if (error != OPE_OK)
+        AUDERR ("Opus encoding error: %s\n", ope_strerror (error));
+
+    ope_encoder_destroy (enc);
+    enc = nullptr;
+}
+
+static FileWriterEncoder * opus_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+{
+    auto encoder = new OpusOggEncoder;
+    if (encoder->open (file, info, tuple))
+        return encoder;
+
+    delete encoder;
+    return nullptr;
+}
+
+static int opus_format_required (int fmt)
+{
+    return FMT_FLOAT;
+}
+
+FileWriterImpl opus_plugin = {
+    opus_init,
+    opus_open,
+    opus_format_required,
+};
+
+#endif
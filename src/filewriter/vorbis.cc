@@ -30,14 +30,7 @@
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 
-static ogg_stream_state os;
-static ogg_page og;
-static ogg_packet op;
-
-static vorbis_dsp_state vd;
-static vorbis_block vb;
-static vorbis_info vi;
-static vorbis_comment vc;
+#include "../sampleconv-common/sampleconv.h"
 
 static const char * const vorbis_defaults[] = {
  "base_quality", "0.5",
@@ -45,7 +38,28 @@ static const char * const vorbis_defaults[] = {
 
 #define GET_DOUBLE(n) aud_get_double("filewriter_vorbis", n)
 
-static int channels;
+class VorbisEncoder : public FileWriterEncoder
+{
+public:
+    bool open (VFSFile & file, const format_info & info, const Tuple & tuple);
+
+    void write (VFSFile & file, const void * data, int length) override;
+    void close (VFSFile & file) override;
+
+private:
+    void write_real (VFSFile & file, const void * data, int length);
+
+    ogg_stream_state os;
+    ogg_page og;
+    ogg_packet op;
+
+    vorbis_dsp_state vd;
+    vorbis_block vb;
+    vorbis_info vi;
+    vorbis_comment vc;
+
+    int channels = 0;
+};
 
 static void vorbis_init ()
 {
@@ -60,7 +74,7 @@ static void add_string_from_tuple (vorbis_comment * vc, const char * name,
         vorbis_comment_add_tag (vc, name, val);
 }
 
-static bool vorbis_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+bool VorbisEncoder::open (VFSFile & file, const format_info & info, const Tuple & tuple)
 {
     ogg_packet header;
     ogg_packet header_comm;
@@ -117,21 +131,12 @@ static bool vorbis_open (VFSFile & file, const format_info & info, const Tuple &
     return true;
 }
 
-static void vorbis_write_real (VFSFile & file, const void * data, int length)
+void VorbisEncoder::write_real (VFSFile & file, const void * data, int length)
 {
     int samples = length / sizeof (float);
-    int channel;
-    float * end = (float *) data + samples;
     float * * buffer = vorbis_analysis_buffer (& vd, samples / channels);
-    float * from, * to;
 
-    for (channel = 0; channel < channels; channel ++)
-    {
-        to = buffer[channel];
-
-        for (from = (float *) data + channel; from < end; from += channels)
-            * to ++ = * from;
-    }
+    sampleconv_deinterleave ((const float *) data, buffer, channels, samples / channels);
 
     vorbis_analysis_wrote (& vd, samples / channels);
 
@@ -154,15 +159,15 @@ static void vorbis_write_real (VFSFile & file, const void * data, int length)
     }
 }
 
-static void vorbis_write (VFSFile & file, const void * data, int length)
+void VorbisEncoder::write (VFSFile & file, const void * data, int length)
 {
     if (length > 0) /* don't signal end of file yet */
-        vorbis_write_real (file, data, length);
+        write_real (file, data, length);
 }
 
-static void vorbis_close (VFSFile & file)
+void VorbisEncoder::close (VFSFile & file)
 {
-    vorbis_write_real (file, nullptr, 0); /* signal end of file */
+    write_real (file, nullptr, 0); /* signal end of file */
 
     while (ogg_stream_flush (& os, & og))
     {
@@ -178,6 +183,16 @@ static void vorbis_close (VFSFile & file)
     vorbis_info_clear(&vi);
 }
 
+static FileWriterEncoder * vorbis_open (VFSFile & file, const format_info & info, const Tuple & tuple)
+{
+    auto encoder = new VorbisEncoder;
+    if (encoder->open (file, info, tuple))
+        return encoder;
+
+    delete encoder;
+    return nullptr;
+}
+
 static int vorbis_format_required (int fmt)
 {
     return FMT_FLOAT;
@@ -186,8 +201,6 @@ static int vorbis_format_required (int fmt)
 FileWriterImpl vorbis_plugin = {
     vorbis_init,
     vorbis_open,
-    vorbis_write,
-    vorbis_close,
     vorbis_format_required,
 };
 
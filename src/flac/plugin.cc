@@ -23,6 +23,7 @@
 #include <libaudcore/runtime.h>
 
 #include "flacng.h"
+#include "../sampleconv-common/sampleconv.h"
 
 EXPORT FLACng aud_plugin_instance;
 
@@ -98,27 +99,13 @@ bool FLACng::is_our_file(const char *filename, VFSFile &file)
 
 static void squeeze_audio(int32_t* src, void* dst, unsigned count, unsigned res)
 {
-    int32_t* rp = src;
-    int8_t*  wp = (int8_t*) dst;
-    int16_t* wp2 = (int16_t*) dst;
-    int32_t* wp4 = (int32_t*) dst;
-
     switch (res)
     {
         case 8:
-            for (unsigned i = 0; i < count; i++, wp++, rp++)
-                *wp = *rp & 0xff;
-            break;
-
         case 16:
-            for (unsigned i = 0; i < count; i++, wp2++, rp++)
-                *wp2 = *rp & 0xffff;
-            break;
-
         case 24:
         case 32:
-            for (unsigned i = 0; i < count; i++, wp4++, rp++)
-                *wp4 = *rp;
+            sampleconv_pack_s32(src, dst, SAMPLE_SIZE(res), count);
             break;
 
         default:
@@ -22,6 +22,7 @@
  */
 
 #include <math.h>
+#include <stdio.h>
 #include <string.h>
 
 #include <libaudcore/i18n.h>
@@ -33,6 +34,7 @@
 #include <gtk/gtk.h>
 
 #include <GL/gl.h>
+#include <GL/glext.h>
 
 #ifdef GDK_WINDOWING_X11
 #include <GL/glx.h>
@@ -47,6 +49,8 @@
 #include <gdk/gdkwin32.h>
 #endif
 
+#include "../vis-common/bandmap.h"
+
 #define NUM_BANDS 32
 #define DB_RANGE 40
 
@@ -84,7 +88,7 @@ public:
 
 EXPORT GLSpectrum aud_plugin_instance;
 
-static float logscale[NUM_BANDS + 1];
+static BandMapper mapper;
 static float colors[NUM_BANDS][NUM_BANDS][3];
 
 #ifdef GDK_WINDOWING_X11
@@ -103,7 +107,79 @@ static GtkWidget * s_widget = nullptr;
 
 static int s_pos = 0;
 static float s_angle = 25, s_anglespeed = 0.05f;
-static float s_bars[NUM_BANDS][NUM_BANDS];
+
+/* ring of the last NUM_BANDS frames, newest first from s_pos; stored twice so
+ * that these rows are always contiguous and can be uploaded in one piece */
+static float s_bars[2 * NUM_BANDS][NUM_BANDS];
+static bool s_bars_dirty = true;
+
+/* OpenGL 2.0 and instancing entry points, resolved at run time */
+#define GL_FUNCS(F) \
+    F (PFNGLGENBUFFERSPROC, GenBuffers) \
+    F (PFNGLBINDBUFFERPROC, BindBuffer) \
+    F (PFNGLBUFFERDATAPROC, BufferData) \
+    F (PFNGLBUFFERSUBDATAPROC, BufferSubData) \
+    F (PFNGLDELETEBUFFERSPROC, DeleteBuffers) \
+    F (PFNGLCREATESHADERPROC, CreateShader) \
+    F (PFNGLSHADERSOURCEPROC, ShaderSource) \
+    F (PFNGLCOMPILESHADERPROC, CompileShader) \
+    F (PFNGLGETSHADERIVPROC, GetShaderiv) \
+    F (PFNGLGETSHADERINFOLOGPROC, GetShaderInfoLog) \
+    F (PFNGLDELETESHADERPROC, DeleteShader) \
+    F (PFNGLCREATEPROGRAMPROC, CreateProgram) \
+    F (PFNGLATTACHSHADERPROC, AttachShader) \
+    F (PFNGLBINDATTRIBLOCATIONPROC, BindAttribLocation) \
+    F (PFNGLLINKPROGRAMPROC, LinkProgram) \
+    F (PFNGLGETPROGRAMIVPROC, GetProgramiv) \
+    F (PFNGLGETPROGRAMINFOLOGPROC, GetProgramInfoLog) \
+    F (PFNGLUSEPROGRAMPROC, UseProgram) \
+    F (PFNGLDELETEPROGRAMPROC, DeleteProgram) \
+    F (PFNGLENABLEVERTEXATTRIBARRAYPROC, EnableVertexAttribArray) \
+    F (PFNGLDISABLEVERTEXATTRIBARRAYPROC, DisableVertexAttribArray) \
+    F (PFNGLVERTEXATTRIBPOINTERPROC, VertexAttribPointer) \
+    F (PFNGLVERTEXATTRIBDIVISORPROC, VertexAttribDivisor) \
+    F (PFNGLDRAWARRAYSINSTANCEDPROC, DrawArraysInstanced)
+
+static struct {
+#define DECLARE_FUNC(type, name) type name;
+    GL_FUNCS (DECLARE_FUNC)
+#undef DECLARE_FUNC
+} gl;
+
+/* retained-mode renderer: a single bar mesh drawn NUM_BANDS x NUM_BANDS times,
+ * with position and color per instance and height read from the s_bars ring */
+enum {
+    ATTR_CORNER,
+    ATTR_OFFSET,
+    ATTR_COLOR,
+    ATTR_HEIGHT
+};
+
+#define MESH_VERTICES 24
+
+static GLuint s_program;
+static GLuint s_mesh_vbo, s_instance_vbo, s_height_vbo;
+
+static const char vertex_shader[] =
+ "#version 110\n"
+ "attribute vec4 corner;\n"  /* unit bar corner and shading factor */
+ "attribute vec2 offset;\n"
+ "attribute vec3 color;\n"
+ "attribute float height;\n"
+ "void main ()\n"
+ "{\n"
+ "    float h = 1.6 * height;\n"
+ "    gl_FrontColor = vec4 (color * (0.2 + 0.8 * h) * corner.w, 1.0);\n"
+ "    gl_Position = gl_ModelViewProjectionMatrix * vec4 (offset.x + corner.x,\n"
+ "     h * corner.y, offset.y + corner.z, 1.0);\n"
+ "}\n";
+
+static const char fragment_shader[] =
+ "#version 110\n"
+ "void main ()\n"
+ "{\n"
+ "    gl_FragColor = gl_Color;\n"
+ "}\n";
 
 bool GLSpectrum::init ()
 {
@@ -115,8 +191,7 @@ bool GLSpectrum::init ()
     }
 #endif
 
-    for (int i = 0; i <= NUM_BANDS; i ++)
-        logscale[i] = powf (256, (float) i / NUM_BANDS) - 0.5f;
+    mapper.init (NUM_BANDS);
 
     for (int y = 0; y < NUM_BANDS; y ++)
     {
@@ -135,48 +210,12 @@ bool GLSpectrum::init ()
     return true;
 }
 
-/* stolen from the skins plugin */
-/* convert linear frequency graph to logarithmic one */
-static void make_log_graph (const float * freq, float * graph)
-{
-    for (int i = 0; i < NUM_BANDS; i ++)
-    {
-        /* sum up values in freq array between logscale[i] and logscale[i + 1],
-           including fractional parts */
-        int a = ceilf (logscale[i]);
-        int b = floorf (logscale[i + 1]);
-        float sum = 0;
-
-        if (b < a)
-            sum += freq[b] * (logscale[i + 1] - logscale[i]);
-        else
-        {
-            if (a > 0)
-                sum += freq[a - 1] * (a - logscale[i]);
-            for (; a < b; a ++)
-                sum += freq[a];
-            if (b < 256)
-                sum += freq[b] * (logscale[i + 1] - b);
-        }
-
-        /* fudge factor to make the graph have the same overall height as a
-           12-band one no matter how many bands there are */
-        sum *= (float) NUM_BANDS / 12;
-
-        /* convert to dB */
-        float val = 20 * log10f (sum);
-
-        /* scale (-DB_RANGE, 0.0) to (0.0, 1.0) */
-        val = 1 + val / DB_RANGE;
-
-        graph[i] = aud::clamp (val, 0.0f, 1.0f);
-    }
-}
-
 void GLSpectrum::render_freq (const float * freq)
 {
-    make_log_graph (freq, s_bars[s_pos]);
-    s_pos = (s_pos + 1) % NUM_BANDS;
+    s_pos = (s_pos + NUM_BANDS - 1) % NUM_BANDS;
+    mapper.compute_scaled (freq, DB_RANGE, s_bars[s_pos]);
+    memcpy (s_bars[s_pos + NUM_BANDS], s_bars[s_pos], sizeof s_bars[0]);
+    s_bars_dirty = true;
 
     s_angle += s_anglespeed;
     if (s_angle > 45 || s_angle < -45)
@@ -189,6 +228,7 @@ void GLSpectrum::render_freq (const float * freq)
 void GLSpectrum::clear ()
 {
     memset (s_bars, 0, sizeof s_bars);
+    s_bars_dirty = true;
 
     if (s_widget)
         gtk_widget_queue_draw (s_widget);
@@ -238,6 +278,52 @@ static void draw_bar (float x, float z, float h, float r, float g, float b)
      r * (0.2f + 0.8f * h), g * (0.2f + 0.8f * h), b * (0.2f + 0.8f * h));
 }
 
+static void draw_instanced ()
+{
+    gl.UseProgram (s_program);
+
+    gl.BindBuffer (GL_ARRAY_BUFFER, s_mesh_vbo);
+    gl.VertexAttribPointer (ATTR_CORNER, 4, GL_FLOAT, false, 0, nullptr);
+
+    gl.BindBuffer (GL_ARRAY_BUFFER, s_instance_vbo);
+    gl.VertexAttribPointer (ATTR_OFFSET, 2, GL_FLOAT, false, 5 * sizeof (float), nullptr);
+    gl.VertexAttribPointer (ATTR_COLOR, 3, GL_FLOAT, false, 5 * sizeof (float),
+     (void *) (2 * sizeof (float)));
+
+    gl.BindBuffer (GL_ARRAY_BUFFER, s_height_vbo);
+
+    if (s_bars_dirty)
+    {
+        gl.BufferSubData (GL_ARRAY_BUFFER, 0, sizeof s_bars, s_bars);
+        s_bars_dirty = false;
+    }
+
+    gl.VertexAttribPointer (ATTR_HEIGHT, 1, GL_FLOAT, false, 0,
+     (void *) (s_pos * sizeof s_bars[0]));
+
+    for (int a = ATTR_CORNER; a <= ATTR_HEIGHT; a ++)
+    {
+        gl.EnableVertexAttribArray (a);
+        gl.VertexAttribDivisor (a, (a == ATTR_CORNER) ? 0 : 1);
+    }
+
+    /* the mesh is wound clockwise, so culling drops the hidden side face */
+    glEnable (GL_CULL_FACE);
+    glFrontFace (GL_CW);
+    gl.DrawArraysInstanced (GL_TRIANGLES, 0, MESH_VERTICES, NUM_BANDS * NUM_BANDS);
+    glFrontFace (GL_CCW);
+    glDisable (GL_CULL_FACE);
+
+    for (int a = ATTR_CORNER; a <= ATTR_HEIGHT; a ++)
+    {
+        gl.VertexAttribDivisor (a, 0);
+        gl.DisableVertexAttribArray (a);
+    }
+
+    gl.BindBuffer (GL_ARRAY_BUFFER, 0);
+    gl.UseProgram (0);
+}
+
 static void draw_bars ()
 {
     glPushMatrix ();
@@ -245,19 +331,221 @@ static void draw_bars ()
     glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
     glRotatef (s_angle + 180.0f, 0.0f, 1.0f, 0.0f);
 
-    for (int i = 0; i < NUM_BANDS; i ++)
+    if (s_program)
+        draw_instanced ();
+    else
+    {
+        for (int i = 0; i < NUM_BANDS; i ++)
+        {
+            float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+
+            for (int j = 0; j < NUM_BANDS; j ++)
+            {
+                draw_bar (1.6f - BAR_SPACING * j, z,
+                 s_bars[s_pos + NUM_BANDS - 1 - i][j] * 1.6,
+                 colors[i][j][0], colors[i][j][1], colors[i][j][2]);
+            }
+        }
+    }
+
+    glPopMatrix ();
+}
+
+static void * get_proc_address (const char * name)
+{
+#if defined (GDK_WINDOWING_X11)
+    return (void *) glXGetProcAddressARB ((const GLubyte *) name);
+#elif defined (GDK_WINDOWING_WIN32)
+    return (void *) wglGetProcAddress (name);
+#else
+    return nullptr;
+#endif
+}
+
+static bool gl_version_at_least (int major, int minor)
+{
+    auto version = (const char *) glGetString (GL_VERSION);
+    int have_major, have_minor;
+
+    if (! version || sscanf (version, "%d.%d", & have_major, & have_minor) != 2)
+        return false;
+
+    return have_major > major || (have_major == major && have_minor >= minor);
+}
+
+static bool gl_has_extension (const char * name)
+{
+    auto list = (const char *) glGetString (GL_EXTENSIONS);
+    int len = strlen (name);
+
+    for (const char * found = list; found && (found = strstr (found, name)); found += len)
+    {
+        if ((found == list || found[-1] == ' ') && (! found[len] || found[len] == ' '))
+            return true;
+    }
+
+    return false;
+}
+
+static GLuint compile_shader (GLenum type, const char * source)
+{
+    GLuint shader = gl.CreateShader (type);
+    gl.ShaderSource (shader, 1, & source, nullptr);
+    gl.CompileShader (shader);
+
+    GLint ok = 0;
+    gl.GetShaderiv (shader, GL_COMPILE_STATUS, & ok);
+
+    if (! ok)
     {
-        float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+        char log[512] = "";
+        gl.GetShaderInfoLog (shader, sizeof log, nullptr, log);
+        AUDERR ("Shader compilation failed: %s\n", log);
+        gl.DeleteShader (shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+static bool create_program ()
+{
+    GLuint vertex = compile_shader (GL_VERTEX_SHADER, vertex_shader);
+    GLuint fragment = compile_shader (GL_FRAGMENT_SHADER, fragment_shader);
+
+    if (vertex && fragment)
+    {
+        s_program = gl.CreateProgram ();
+        gl.AttachShader (s_program, vertex);
+        gl.AttachShader (s_program, fragment);
+
+        gl.BindAttribLocation (s_program, ATTR_CORNER, "corner");
+        gl.BindAttribLocation (s_program, ATTR_OFFSET, "offset");
+        gl.BindAttribLocation (s_program, ATTR_COLOR, "color");
+        gl.BindAttribLocation (s_program, ATTR_HEIGHT, "height");
 
+        gl.LinkProgram (s_program);
+
+        GLint ok = 0;
+        gl.GetProgramiv (s_program, GL_LINK_STATUS, & ok);
+
+        if (! ok)
+        {
+            char log[512] = "";
+            gl.GetProgramInfoLog (s_program, sizeof log, nullptr, log);
+            AUDERR ("Shader linking failed: %s\n", log);
+            gl.DeleteProgram (s_program);
+            s_program = 0;
+        }
+    }
+
+    if (vertex)
+        gl.DeleteShader (vertex);
+    if (fragment)
+        gl.DeleteShader (fragment);
+
+    return s_program != 0;
+}
+
+/* the four visible faces of a bar, with the shading used by draw_rectangle() */
+static void build_mesh (float mesh[MESH_VERTICES][4])
+{
+    static const float faces[4][4][3] = {
+        {{0, 1, 0}, {1, 1, 0}, {1, 1, 1}, {0, 1, 1}},  /* top */
+        {{0, 0, 0}, {0, 1, 0}, {0, 1, 1}, {0, 0, 1}},  /* left */
+        {{1, 1, 0}, {1, 0, 0}, {1, 0, 1}, {1, 1, 1}},  /* right */
+        {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}}   /* front */
+    };
+    static const float shades[4] = {1, 0.65f, 0.65f, 0.8f};
+    static const int corners[6] = {0, 1, 2, 0, 2, 3};
+
+    for (int f = 0; f < 4; f ++)
+    {
+        for (int c = 0; c < 6; c ++)
+        {
+            const float * v = faces[f][corners[c]];
+            float * out = mesh[6 * f + c];
+
+            out[0] = v[0] * BAR_WIDTH;
+            out[1] = v[1];
+            out[2] = v[2] * BAR_WIDTH;
+            out[3] = shades[f];
+        }
+    }
+}
+
+static void create_renderer ()
+{
+    if (! gl_version_at_least (2, 0))
+        return;
+
+    if (! gl_version_at_least (3, 3) && ! (gl_has_extension ("GL_ARB_instanced_arrays") &&
+     (gl_version_at_least (3, 1) || gl_has_extension ("GL_ARB_draw_instanced"))))
+        return;
+
+#define LOAD_FUNC(type, name) gl.name = (type) get_proc_address ("gl" #name);
+    GL_FUNCS (LOAD_FUNC)
+#undef LOAD_FUNC
+
+    if (! gl_version_at_least (3, 3))
+        gl.VertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)
+         get_proc_address ("glVertexAttribDivisorARB");
+    if (! gl_version_at_least (3, 1))
+        gl.DrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)
+         get_proc_address ("glDrawArraysInstancedARB");
+
+#define CHECK_FUNC(type, name) if (! gl.name) return;
+    GL_FUNCS (CHECK_FUNC)
+#undef CHECK_FUNC
+
+    if (! create_program ())
+        return;
+
+    float mesh[MESH_VERTICES][4];
+    build_mesh (mesh);
+
+    /* instances follow the s_bars ring, nearest row first */
+    float instances[NUM_BANDS][NUM_BANDS][5];
+
+    for (int i = 0; i < NUM_BANDS; i ++)
+    {
         for (int j = 0; j < NUM_BANDS; j ++)
         {
-            draw_bar (1.6f - BAR_SPACING * j, z,
-             s_bars[(s_pos + i) % NUM_BANDS][j] * 1.6,
-             colors[i][j][0], colors[i][j][1], colors[i][j][2]);
+            float * inst = instances[NUM_BANDS - 1 - i][j];
+
+            inst[0] = 1.6f - BAR_SPACING * j;
+            inst[1] = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+            memcpy (inst + 2, colors[i][j], sizeof colors[i][j]);
         }
     }
 
-    glPopMatrix ();
+    gl.GenBuffers (1, & s_mesh_vbo);
+    gl.BindBuffer (GL_ARRAY_BUFFER, s_mesh_vbo);
+    gl.BufferData (GL_ARRAY_BUFFER, sizeof mesh, mesh, GL_STATIC_DRAW);
+
+    gl.GenBuffers (1, & s_instance_vbo);
+    gl.BindBuffer (GL_ARRAY_BUFFER, s_instance_vbo);
+    gl.BufferData (GL_ARRAY_BUFFER, sizeof instances, instances, GL_STATIC_DRAW);
+
+    gl.GenBuffers (1, & s_height_vbo);
+    gl.BindBuffer (GL_ARRAY_BUFFER, s_height_vbo);
+    gl.BufferData (GL_ARRAY_BUFFER, sizeof s_bars, s_bars, GL_STREAM_DRAW);
+    s_bars_dirty = false;
+
+    gl.BindBuffer (GL_ARRAY_BUFFER, 0);
+}
+
+static void destroy_renderer ()
+{
+    if (! s_program)
+        return;
+
+    GLuint buffers[] = {s_mesh_vbo, s_instance_vbo, s_height_vbo};
+    gl.DeleteBuffers (3, buffers);
+    gl.DeleteProgram (s_program);
+
+    s_mesh_vbo = s_instance_vbo = s_height_vbo = 0;
+    s_program = 0;
 }
 
 #ifdef USE_GTK3
@@ -388,6 +676,11 @@ static void widget_realized ()
     glDepthMask (GL_TRUE);
     glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
     glClearColor (0, 0, 0, 1);
+
+    create_renderer ();
+
+    if (! s_program)
+        AUDINFO ("Instanced rendering not available, using immediate mode.\n");
 }
 
 static void widget_destroyed ()
@@ -397,6 +690,7 @@ static void widget_destroyed ()
 #ifdef GDK_WINDOWING_X11
     if (s_context)
     {
+        destroy_renderer ();
         glXMakeCurrent (s_display, None, nullptr);
         glXDestroyContext (s_display, s_context);
         s_context = nullptr;
@@ -408,6 +702,7 @@ static void widget_destroyed ()
 #ifdef GDK_WINDOWING_WIN32
     if (s_glrc)
     {
+        destroy_renderer ();
         wglMakeCurrent (s_hdc, nullptr);
         wglDeleteContext (s_glrc);
         s_glrc = nullptr;
@@ -29,6 +29,7 @@
 #include <libaudgui/libaudgui-gtk.h>
 
 #include "ui_infoarea.h"
+#include "../vis-common/bandmap.h"
 
 #define ALPHA_STEPS 10
 static inline float TO_ALPHA (int steps) { return (float) steps / ALPHA_STEPS; }
@@ -87,14 +88,18 @@ static UIInfoArea * area = nullptr;
 
 void InfoAreaVis::render_freq (const float * freq)
 {
-    /* xscale[i] = pow (256, i / VIS_BANDS) - 0.5; */
-    const float xscale[VIS_BANDS + 1] = {0.5, 1.09, 2.02, 3.5, 5.85, 9.58,
-     15.5, 24.9, 39.82, 63.5, 101.09, 160.77, 255.5};
+    static BandMapper mapper;
+
+    if (! mapper.bands ())
+        mapper.init (VIS_BANDS);
+
+    float db[VIS_BANDS];
+    mapper.compute_db (freq, db);
 
     for (int i = 0; i < VIS_BANDS; i ++)
     {
         /* 40 dB range */
-        float x = 40 + compute_freq_band (freq, xscale, i, VIS_BANDS);
+        float x = 40 + db[i];
 
         bars[i] -= aud::max (0, VIS_FALLOFF - delay[i]);
 
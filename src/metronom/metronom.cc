@@ -16,6 +16,7 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -33,6 +34,7 @@
 #define BUF_SAMPLES     512
 #define BUF_BYTES       (BUF_SAMPLES * 2)
 #define MAX_AMPL        0x7fff
+#define CLICK_SAMPLES   256
 
 class Metronome : public InputPlugin
 {
@@ -129,10 +131,13 @@ static bool metronom_get_cp(const char *filename, metronom_t *pmetronom, String
             return false;
 
         flag = false;
-        for (id = 0; id < TACT_ID_MAX && !flag; id++)
+        for (id = 0; id < TACT_ID_MAX; id++)
         {
             if (pmetronom->num == tact_id[id][0] && pmetronom->den == tact_id[id][1])
+            {
                 flag = true;
+                break;
+            }
         }
 
         if (!flag)
@@ -150,16 +155,36 @@ static bool metronom_get_cp(const char *filename, metronom_t *pmetronom, String
     return true;
 }
 
+/* One click at full amplitude: a short up-down-up pulse, smoothed and then
+ * left to decay.  It is computed once and mixed in at each beat. */
+static void make_click(float click[CLICK_SAMPLES])
+{
+    double goal = 0, current = 0, last = 0;
+
+    for (int t = 0; t < CLICK_SAMPLES; t++)
+    {
+        if (t == 0 || t == 25)
+            goal = 1;
+        else if (t == 10)
+            goal = -1;
+
+        /* makes curve a little bit smoother  */
+        double value = (last + current + goal) / 3;
+        last = current;
+        current = value;
+        click[t] = value;
+
+        if (t > 35)
+            goal = goal * 7 / 8;
+    }
+}
+
 bool Metronome::play (const char * filename, VFSFile &)
 {
     metronom_t pmetronom;
     int16_t data[BUF_SAMPLES];
-    int t = 0, tact, num;
-    int datagoal = 0;
-    int datamiddle = 0;
-    int datacurrent = datamiddle;
-    int datalast = datamiddle;
-    int data_form[TACT_FORM_MAX];
+    float click[CLICK_SAMPLES];
+    float data_form[TACT_FORM_MAX];
     String desc;
 
     set_stream_bitrate(sizeof(data[0]) * 8 * AUDIO_FREQ);
@@ -171,47 +196,45 @@ bool Metronome::play (const char * filename, VFSFile &)
         return false;
     }
 
-    tact = 60 * AUDIO_FREQ / pmetronom.bpm;
+    make_click(click);
 
     /* prepare weighted amplitudes */
-    for (num = 0; num < pmetronom.num; num++)
-    {
+    for (int num = 0; num < pmetronom.num; num++)
         data_form[num] = MAX_AMPL * tact_form[pmetronom.id][num];
-    }
 
-    num = 0;
+    /* Beat n starts at sample n * 60 * AUDIO_FREQ / bpm, computed exactly
+     * so that the tempo does not drift however long it plays.  <beat> is
+     * the first beat that may still be sounding at <pos>. */
+    int64_t pos = 0, beat = 0;
+
     while (!check_stop())
     {
-        int i;
+        float mix[BUF_SAMPLES] = {};
 
-        for (i = 0; i < BUF_SAMPLES; i++)
+        for (int64_t b = beat;; b++)
         {
-            if (t == tact)
-            {
-                t = 0;
-                datagoal = data_form[num];
-            }
-            else if (t == 10)
-            {
-                datagoal = -data_form[num];
-            }
-            else if (t == 25)
+            int64_t start = b * 60 * AUDIO_FREQ / pmetronom.bpm;
+            if (start >= pos + BUF_SAMPLES)
+                break;
+
+            if (start + CLICK_SAMPLES <= pos)
             {
-                datagoal = data_form[num];
-                /* circle through weighted amplitudes */
-                num++;
-                if (num >= pmetronom.num)
-                    num = 0;
+                beat = b + 1;
+                continue;
             }
-            /* makes curve a little bit smoother  */
-            data[i] = (datalast + datacurrent + datagoal) / 3;
-            datalast = datacurrent;
-            datacurrent = data[i];
-            if (t > 35)
-                datagoal = (datamiddle + 7 * datagoal) / 8;
-            t++;
+
+            float amp = data_form[b % pmetronom.num];
+            int from = aud::max(start, pos) - pos;
+            int to = aud::min(start + CLICK_SAMPLES, pos + BUF_SAMPLES) - pos;
+
+            for (int i = from; i < to; i++)
+                mix[i] += amp * click[pos + i - start];
         }
 
+        for (int i = 0; i < BUF_SAMPLES; i++)
+            data[i] = lrintf(mix[i]);
+
+        pos += BUF_SAMPLES;
         write_audio(data, BUF_BYTES);
     }
 
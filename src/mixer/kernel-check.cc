@@ -0,0 +1,92 @@
+/*
+ * Channel Mixer Kernel Check
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Runs every specialised (SSE2/NEON or unrolled) kernel against the generic
+ * loop on random matrices and samples.  The frame counts cover every
+ * remainder of the vector loops, so the scalar tails are checked as well. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "kernels.h"
+
+#define MAX_CHANNELS 8
+#define MAX_FRAMES 67
+
+static float random_sample ()
+{
+    return (float) rand () / RAND_MAX * 2 - 1;
+}
+
+int main ()
+{
+    float matrix[MAX_CHANNELS * MAX_CHANNELS];
+    float in[MAX_CHANNELS * MAX_FRAMES];
+    float expected[MAX_CHANNELS * MAX_FRAMES];
+    float got[MAX_CHANNELS * MAX_FRAMES];
+
+    int checked = 0, failed = 0;
+    srand (1);
+
+    for (int in_ch = 1; in_ch <= MAX_CHANNELS; in_ch ++)
+    {
+        for (int out_ch = 1; out_ch <= MAX_CHANNELS; out_ch ++)
+        {
+            MixKernel kernel = mixer_get_kernel (in_ch, out_ch);
+            if (kernel == mixer_mix_generic)
+                continue;
+
+            bool ok = true;
+
+            for (int frames = 0; frames <= MAX_FRAMES && ok; frames ++)
+            {
+                for (int i = 0; i < in_ch * out_ch; i ++)
+                    matrix[i] = random_sample ();
+                for (int i = 0; i < in_ch * frames; i ++)
+                    in[i] = random_sample ();
+
+                /* catch kernels that write past the end */
+                for (int i = 0; i < MAX_CHANNELS * MAX_FRAMES; i ++)
+                    got[i] = expected[i] = 12345;
+
+                mixer_mix_generic (matrix, in_ch, out_ch, in, expected, frames);
+                kernel (matrix, in_ch, out_ch, in, got, frames);
+
+                for (int i = 0; i < MAX_CHANNELS * MAX_FRAMES && ok; i ++)
+                {
+                    /* the sums may be associated differently */
+                    if (fabsf (got[i] - expected[i]) > 1e-5f * in_ch)
+                    {
+                        printf ("%d -> %d channels, %d frames: sample %d is %f, "
+                         "expected %f\n", in_ch, out_ch, frames, i, got[i], expected[i]);
+                        ok = false;
+                    }
+                }
+            }
+
+            checked ++;
+            if (! ok)
+                failed ++;
+        }
+    }
+
+    printf ("%d kernels checked, %d failed\n", checked, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Channel Mixer Plugin for Audacious
+ * Copyright 2011-2012 John Lindgren and Michał Lipski
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "kernels.h"
+
+/* Generic kernel, specialized at compile time for common shapes so that the
+ * loops are unrolled and the coefficients stay in registers. */
+template<int IN, int OUT>
+static void mix_fixed (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    float m[OUT * IN];
+    memcpy (m, matrix, sizeof m);
+
+    while (frames --)
+    {
+        for (int o = 0; o < OUT; o ++)
+        {
+            float sum = 0;
+            for (int i = 0; i < IN; i ++)
+                sum += m[o * IN + i] * in[i];
+
+            out[o] = sum;
+        }
+
+        in += IN;
+        out += OUT;
+    }
+}
+
+void mixer_mix_generic (const float * matrix, int in_ch, int out_ch,
+ const float * in, float * out, int frames)
+{
+    while (frames --)
+    {
+        for (int o = 0; o < out_ch; o ++)
+        {
+            const float * row = matrix + o * in_ch;
+            float sum = 0;
+            for (int i = 0; i < in_ch; i ++)
+                sum += row[i] * in[i];
+
+            out[o] = sum;
+        }
+
+        in += in_ch;
+        out += out_ch;
+    }
+}
+
+static void mix_1_to_2 (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    int f = 0;
+
+#if defined(__SSE2__)
+    __m128 m = _mm_setr_ps (matrix[0], matrix[1], matrix[0], matrix[1]);
+
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 x = _mm_loadu_ps (in + f);
+        _mm_storeu_ps (out + 2 * f, _mm_mul_ps (_mm_unpacklo_ps (x, x), m));
+        _mm_storeu_ps (out + 2 * f + 4, _mm_mul_ps (_mm_unpackhi_ps (x, x), m));
+    }
+#elif defined(__ARM_NEON)
+    float32x4_t m = {matrix[0], matrix[1], matrix[0], matrix[1]};
+
+    for (; f + 4 <= frames; f += 4)
+    {
+        float32x4x2_t x = vzipq_f32 (vld1q_f32 (in + f), vld1q_f32 (in + f));
+        vst1q_f32 (out + 2 * f, vmulq_f32 (x.val[0], m));
+        vst1q_f32 (out + 2 * f + 4, vmulq_f32 (x.val[1], m));
+    }
+#endif
+
+    mix_fixed<1, 2> (matrix, 1, 2, in + f, out + 2 * f, frames - f);
+}
+
+static void mix_2_to_1 (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    int f = 0;
+
+#if defined(__SSE2__)
+    __m128 l = _mm_set1_ps (matrix[0]);
+    __m128 r = _mm_set1_ps (matrix[1]);
+
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 a = _mm_loadu_ps (in + 2 * f);
+        __m128 b = _mm_loadu_ps (in + 2 * f + 4);
+        __m128 left = _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0));
+        __m128 right = _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1));
+        _mm_storeu_ps (out + f, _mm_add_ps (_mm_mul_ps (left, l), _mm_mul_ps (right, r)));
+    }
+#elif defined(__ARM_NEON)
+    for (; f + 4 <= frames; f += 4)
+    {
+        float32x4x2_t x = vld2q_f32 (in + 2 * f);
+        vst1q_f32 (out + f, vmlaq_n_f32 (vmulq_n_f32 (x.val[0], matrix[0]),
+         x.val[1], matrix[1]));
+    }
+#endif
+
+    mix_fixed<2, 1> (matrix, 2, 1, in + 2 * f, out + f, frames - f);
+}
+
+/* Stereo output from 2, 4 or 8 channels, two frames at a time: each vector
+ * holds left and right of both frames, and each input channel is broadcast
+ * to match. */
+template<int IN>
+static void mix_to_2 (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    int f = 0;
+
+#if defined(__SSE2__)
+    __m128 m[IN];
+    for (int i = 0; i < IN; i ++)
+        m[i] = _mm_setr_ps (matrix[i], matrix[IN + i], matrix[i], matrix[IN + i]);
+
+    for (; f + 2 <= frames; f += 2)
+    {
+        const float * a = in + IN * f;
+        __m128 sum = _mm_setzero_ps ();
+
+        if constexpr (IN == 2)
+        {
+            __m128 x = _mm_loadu_ps (a);
+            sum = _mm_add_ps (_mm_mul_ps (_mm_shuffle_ps (x, x, _MM_SHUFFLE (2, 2, 0, 0)), m[0]),
+             _mm_mul_ps (_mm_shuffle_ps (x, x, _MM_SHUFFLE (3, 3, 1, 1)), m[1]));
+        }
+        else
+        {
+            for (int v = 0; v < IN; v += 4)
+            {
+                __m128 x = _mm_loadu_ps (a + v);
+                __m128 y = _mm_loadu_ps (a + IN + v);
+                sum = _mm_add_ps (sum, _mm_mul_ps (_mm_shuffle_ps (x, y, _MM_SHUFFLE (0, 0, 0, 0)), m[v]));
+                sum = _mm_add_ps (sum, _mm_mul_ps (_mm_shuffle_ps (x, y, _MM_SHUFFLE (1, 1, 1, 1)), m[v + 1]));
+                sum = _mm_add_ps (sum, _mm_mul_ps (_mm_shuffle_ps (x, y, _MM_SHUFFLE (2, 2, 2, 2)), m[v + 2]));
+                sum = _mm_add_ps (sum, _mm_mul_ps (_mm_shuffle_ps (x, y, _MM_SHUFFLE (3, 3, 3, 3)), m[v + 3]));
+            }
+        }
+
+        _mm_storeu_ps (out + 2 * f, sum);
+    }
+#elif defined(__ARM_NEON)
+    float32x2_t m[IN];
+    for (int i = 0; i < IN; i ++)
+        m[i] = (float32x2_t) {matrix[i], matrix[IN + i]};
+
+    for (; f < frames; f ++)
+    {
+        const float * a = in + IN * f;
+        float32x2_t sum = vmul_n_f32 (m[0], a[0]);
+        for (int i = 1; i < IN; i ++)
+            sum = vmla_n_f32 (sum, m[i], a[i]);
+
+        vst1_f32 (out + 2 * f, sum);
+    }
+#endif
+
+    mix_fixed<IN, 2> (matrix, IN, 2, in + IN * f, out + 2 * f, frames - f);
+}
+
+static const struct {
+    int in, out;
+    MixKernel kernel;
+} kernels[] = {
+    {1, 2, mix_1_to_2},
+    {2, 1, mix_2_to_1},
+    {2, 2, mix_to_2<2>},
+    {4, 2, mix_to_2<4>},
+    {8, 2, mix_to_2<8>},
+    {3, 2, mix_fixed<3, 2>},
+    {5, 2, mix_fixed<5, 2>},
+    {6, 2, mix_fixed<6, 2>},
+    {7, 2, mix_fixed<7, 2>},
+    {2, 4, mix_fixed<2, 4>},
+    {2, 6, mix_fixed<2, 6>},
+    {2, 8, mix_fixed<2, 8>},
+    {6, 4, mix_fixed<6, 4>},
+    {8, 6, mix_fixed<8, 6>}
+};
+
+MixKernel mixer_get_kernel (int in, int out)
+{
+    for (auto & k : kernels)
+    {
+        if (k.in == in && k.out == out)
+            return k.kernel;
+    }
+
+    return mixer_mix_generic;
+}
@@ -0,0 +1,36 @@
+/*
+ * Channel Mixer Plugin for Audacious
+ * Copyright 2011-2012 John Lindgren and Michał Lipski
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef MIXER_KERNELS_H
+#define MIXER_KERNELS_H
+
+/* Applies an out_ch x in_ch matrix, stored row-major as
+ * matrix[out * in_ch + in], to interleaved frames. */
+typedef void (* MixKernel) (const float * matrix, int in_ch, int out_ch,
+ const float * in, float * out, int frames);
+
+/* the reference implementation, for any shape */
+void mixer_mix_generic (const float * matrix, int in_ch, int out_ch,
+ const float * in, float * out, int frames);
+
+/* the fastest kernel for the shape: a specialised one if there is one,
+ * otherwise mixer_mix_generic */
+MixKernel mixer_get_kernel (int in_ch, int out_ch);
+
+#endif
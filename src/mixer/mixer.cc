@@ -17,20 +17,32 @@
  * the use of this software.
  */
 
-/* TODO: implement more surround converters.
-         There should be more options for in * out cases (for example,
-         the user may wish to mix stereo up to quadro but keep 5.1 as-is,
-         rather than downmixing 5.1 to quadro). A possible design might
-         be a choice of output channels for each input channel count that
-         we care about. */
-
+/* Channels are converted by multiplying each input frame with a matrix of
+ * output x input coefficients.  The standard matrices are derived from the
+ * usual speaker layout for each channel count: channels that the output lacks
+ * are folded into their neighbours at -3 dB (as in ITU-R BS.775), and the LFE
+ * is dropped.  Matrices for particular conversions can also be entered by the
+ * user.
+ *
+ * TODO: There should be more options for in * out cases (for example,
+ *       the user may wish to mix stereo up to quadro but keep 5.1 as-is,
+ *       rather than downmixing 5.1 to quadro). A possible design might
+ *       be a choice of output channels for each input channel count that
+ *       we care about. */
+
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 
+#include "kernels.h"
+
 class ChannelMixer : public EffectPlugin
 {
 public:
@@ -58,186 +70,247 @@ public:
 
 EXPORT ChannelMixer aud_plugin_instance;
 
-typedef Index<float> & (* Converter) (Index<float> & data);
+#define MAX AUD_MAX_CHANNELS
+#define FOLD 0.70710678f  /* -3 dB */
 
-static Index<float> mixer_buf;
+enum Speaker {
+    FL, FR, FC, LFE, BL, BR, SL, SR, BC, NONE
+};
 
-static Index<float> & mono_to_stereo (Index<float> & data)
-{
-    int frames = data.len ();
-    mixer_buf.resize (2 * frames);
+/* the usual layouts for 1 to 8 channels; "quadro" has its rear pair as side
+ * channels, as have the 5- and 5.1-channel layouts */
+static const Speaker layouts[9][8] = {
+    {},
+    {FC},
+    {FL, FR},
+    {FL, FR, FC},
+    {FL, FR, SL, SR},
+    {FL, FR, FC, SL, SR},
+    {FL, FR, FC, LFE, SL, SR},
+    {FL, FR, FC, LFE, BC, SL, SR},
+    {FL, FR, FC, LFE, BL, BR, SL, SR}
+};
 
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+static int input_channels, output_channels;
+static float mixer_matrix[MAX * MAX];
+static MixKernel mixer_kernel;
+static Index<float> mixer_buf;
 
-    while (frames --)
+static int find_speaker (const Speaker * layout, int channels, Speaker speaker)
+{
+    for (int c = 0; c < channels; c ++)
     {
-        float val = * get ++;
-        * set ++ = val;
-        * set ++ = val;
+        if (layout[c] == speaker)
+            return c;
     }
 
-    return mixer_buf;
+    return -1;
 }
 
-static Index<float> & stereo_to_mono (Index<float> & data)
+/* Adds a speaker's signal to the output, at the same position if the output
+ * has one, otherwise folded into the nearest pair (or single speaker). */
+static void route (float * column, int out, Speaker speaker, float gain, int depth = 0)
 {
-    int frames = data.len () / 2;
-    mixer_buf.resize (frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+    const Speaker * layout = layouts[out];
+    int c = find_speaker (layout, out, speaker);
 
-    while (frames --)
+    if (c >= 0)
     {
-        float val = * get ++;
-        val += * get ++;
-        * set ++ = val / 2;
+        column[c * MAX] += gain;
+        return;
     }
 
-    return mixer_buf;
-}
-
-static Index<float> & quadro_to_stereo (Index<float> & data)
-{
-    int frames = data.len () / 4;
-    mixer_buf.resize (2 * frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+    if (depth > 2)
+        return;
 
-    while (frames --)
+    switch (speaker)
     {
-        float front_left  = * get ++;
-        float front_right = * get ++;
-        float back_left   = * get ++;
-        float back_right  = * get ++;
-        * set ++ = front_left + (back_left * 0.7);
-        * set ++ = front_right + (back_right * 0.7);
+    case FL:
+    case FR:
+        /* only a mono output lacks the front pair */
+        route (column, out, FC, gain * FOLD, depth + 1);
+        break;
+    case FC:
+        route (column, out, FL, gain * FOLD, depth + 1);
+        route (column, out, FR, gain * FOLD, depth + 1);
+        break;
+    case SL:
+    case BL:
+        if (find_speaker (layout, out, speaker == SL ? BL : SL) >= 0)
+            route (column, out, speaker == SL ? BL : SL, gain, depth + 1);
+        else
+            route (column, out, FL, gain * FOLD, depth + 1);
+        break;
+    case SR:
+    case BR:
+        if (find_speaker (layout, out, speaker == SR ? BR : SR) >= 0)
+            route (column, out, speaker == SR ? BR : SR, gain, depth + 1);
+        else
+            route (column, out, FR, gain * FOLD, depth + 1);
+        break;
+    case BC:
+        route (column, out, BL, gain * FOLD, depth + 1);
+        route (column, out, BR, gain * FOLD, depth + 1);
+        break;
+    default:
+        break;  /* LFE is dropped */
     }
-
-    return mixer_buf;
 }
 
-static Index<float> & stereo_to_quadro (Index<float> & data)
+/* Parses user matrices of the form "6>2: 1 0 0.7 0 0.7 0  0 1 0.7 0 0 0.7",
+ * separated by semicolons, with one row of input coefficients for each
+ * output channel in turn.  Returns true if one was found for this case. */
+static bool custom_matrix (int in, int out, float * matrix)
 {
-    int frames = data.len () / 2;
-    mixer_buf.resize (4 * frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin();
+    String custom = aud_get_str ("mixer", "custom");
 
-    while (frames --)
+    for (const String & entry : str_list_to_index (custom, ";"))
     {
-        float left  = * get ++;
-        float right = * get ++;
-        * set ++ = left;   // front left
-        * set ++ = right;  // front right
-        * set ++ = left;   // rear left
-        * set ++ = right;  // rear right
+        int entry_in, entry_out, offset = 0;
+        if (sscanf (entry, " %d > %d : %n", & entry_in, & entry_out, & offset) < 2 ||
+         ! offset || entry_in != in || entry_out != out)
+            continue;
+
+        auto values = str_list_to_index (entry + offset, " ,");
+        if (values.len () != in * out)
+        {
+            AUDERR ("Mixer matrix for %d to %d channels needs %d values.\n",
+             in, out, in * out);
+            continue;
+        }
+
+        for (int i = 0; i < in * out; i ++)
+            matrix[i] = str_to_double (values[i]);
+
+        return true;
     }
 
-    return mixer_buf;
+    return false;
 }
 
-static Index<float> & surround_5p1_to_stereo (Index<float> & data)
+static void standard_matrix (int in, int out, float * matrix)
 {
-    int frames = data.len () / 6;
-    mixer_buf.resize (2 * frames);
+    /* built column-wise in a MAX x MAX scratch matrix */
+    float full[MAX * MAX] {};
 
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+    if (in > 8 || out > 8)
+    {
+        /* no standard layout; keep the channels that both sides have */
+        for (int c = 0; c < aud::min (in, out); c ++)
+            full[c * MAX + c] = 1;
+    }
+    else if (in == 1)
+    {
+        /* mono goes to the front pair at full level */
+        if (out == 1)
+            full[0] = 1;
+        else
+            full[0] = full[MAX] = 1;
+    }
+    else if (out == 1)
+    {
+        /* downmix to stereo first, then average */
+        float stereo[MAX * MAX] {};
+        for (int i = 0; i < in; i ++)
+            route (stereo + i, 2, layouts[in][i], 1);
 
-    while (frames --)
+        for (int i = 0; i < in; i ++)
+            full[i] = (stereo[i] + stereo[MAX + i]) / 2;
+    }
+    else
     {
-        float front_left  = * get ++;
-        float front_right = * get ++;
-        float center = * get ++;
-        float lfe    = * get ++;
-        float rear_left   = * get ++;
-        float rear_right  = * get ++;
-        * set ++ = front_left + (center * 0.5) + (lfe * 0.5) + (rear_left * 0.5);
-        * set ++ = front_right + (center * 0.5) + (lfe * 0.5) + (rear_right * 0.5);
+        for (int i = 0; i < in; i ++)
+            route (full + i, out, layouts[in][i], 1);
+
+        /* copy the front pair to the surrounds if the input has none */
+        if (aud_get_bool ("mixer", "upmix_surround") &&
+         find_speaker (layouts[in], in, SL) < 0 && find_speaker (layouts[in], in, BL) < 0)
+        {
+            for (Speaker s : {SL, SR, BL, BR})
+            {
+                int c = find_speaker (layouts[out], out, s);
+                if (c >= 0)
+                    full[c * MAX + ((s == SL || s == BL) ? 0 : 1)] = 1;
+            }
+        }
     }
 
-    return mixer_buf;
+    for (int o = 0; o < out; o ++)
+    {
+        for (int i = 0; i < in; i ++)
+            matrix[o * in + i] = full[o * MAX + i];
+    }
 }
 
-/* 5 channels case. Quad + center channel */
-static Index<float> & quadro_5_to_stereo (Index<float> & data)
+static void normalize_matrix (int in, int out, float * matrix)
 {
-    int frames = data.len () / 5;
-    mixer_buf.resize (2 * frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+    float max_sum = 0;
 
-    while (frames --)
+    for (int o = 0; o < out; o ++)
     {
-        float front_left  = * get ++;
-        float front_right = * get ++;
-        float center = * get ++;
-        float rear_left   = * get ++;
-        float rear_right  = * get ++;
-        * set ++ = front_left + (center * 0.5) + rear_left;
-        * set ++ = front_right + (center * 0.5) + rear_right;
-    }
+        float sum = 0;
+        for (int i = 0; i < in; i ++)
+            sum += fabsf (matrix[o * in + i]);
 
-    return mixer_buf;
-}
+        max_sum = aud::max (max_sum, sum);
+    }
 
-static Converter get_converter (int in, int out)
-{
-    if (in == 1 && out == 2)
-        return mono_to_stereo;
-    if (in == 2 && out == 1)
-        return stereo_to_mono;
-    if (in == 2 && out == 4)
-        return stereo_to_quadro;
-    if (in == 4 && out == 2)
-        return quadro_to_stereo;
-    if (in == 5 && out == 2)
-        return quadro_5_to_stereo;
-    if (in == 6 && out == 2)
-        return surround_5p1_to_stereo;
-
-    return nullptr;
+    if (max_sum > 1)
+    {
+        for (int i = 0; i < in * out; i ++)
+            matrix[i] /= max_sum;
+    }
 }
 
-static int input_channels, output_channels;
-
 void ChannelMixer::start (int & channels, int & rate)
 {
     input_channels = channels;
-    output_channels = aud_get_int ("mixer", "channels");
+    output_channels = aud::clamp (aud_get_int ("mixer", "channels"), 1, MAX);
 
-    if (input_channels == output_channels)
-        return;
+    if (input_channels > MAX)
+        output_channels = input_channels;
 
-    if (! get_converter (input_channels, output_channels))
+    if (input_channels == output_channels)
     {
-        AUDERR ("Converting %d to %d channels is not implemented.\n",
-         input_channels, output_channels);
-        return;
+        /* a custom matrix may still swap or balance the channels */
+        if (input_channels > MAX || ! custom_matrix (input_channels,
+         output_channels, mixer_matrix))
+        {
+            mixer_kernel = nullptr;
+            return;
+        }
+    }
+    else if (! custom_matrix (input_channels, output_channels, mixer_matrix))
+    {
+        standard_matrix (input_channels, output_channels, mixer_matrix);
+
+        if (aud_get_bool ("mixer", "normalize"))
+            normalize_matrix (input_channels, output_channels, mixer_matrix);
     }
 
+    mixer_kernel = mixer_get_kernel (input_channels, output_channels);
     channels = output_channels;
 }
 
 Index<float> & ChannelMixer::process (Index<float> & data)
 {
-    if (input_channels == output_channels)
+    if (! mixer_kernel)
         return data;
 
-    Converter converter = get_converter (input_channels, output_channels);
-    if (converter)
-        return converter (data);
+    int frames = data.len () / input_channels;
+    mixer_buf.resize (frames * output_channels);
+
+    mixer_kernel (mixer_matrix, input_channels, output_channels, data.begin (),
+     mixer_buf.begin (), frames);
 
-    return data;
+    return mixer_buf;
 }
 
 const char * const ChannelMixer::defaults[] = {
  "channels", "2",
+ "upmix_surround", "TRUE",
+ "normalize", "FALSE",
+ "custom", "",
   nullptr};
 
 bool ChannelMixer::init ()
@@ -259,7 +332,17 @@ const PreferencesWidget ChannelMixer::widgets[] = {
     WidgetLabel (N_("<b>Channel Mixer</b>")),
     WidgetSpin (N_("Output channels:"),
         WidgetInt ("mixer", "channels"),
-        {1, AUD_MAX_CHANNELS, 1})
+        {1, AUD_MAX_CHANNELS, 1}),
+    WidgetCheck (N_("Copy front channels to surround when upmixing"),
+        WidgetBool ("mixer", "upmix_surround")),
+    WidgetCheck (N_("Scale down mixes that could clip"),
+        WidgetBool ("mixer", "normalize")),
+    WidgetLabel (N_("<b>Custom Matrices</b>")),
+    WidgetEntry (N_("Matrices:"),
+        WidgetString ("mixer", "custom")),
+    WidgetLabel (N_("For example, \"6>2: 1 0 0.7 0 0.7 0  0 1 0.7 0 0 0.7\" mixes\n"
+                    "5.1 to stereo with one row of six input weights for each\n"
+                    "output channel.  Separate several matrices with \";\"."))
 };
 
 const PluginPreferences ChannelMixer::prefs = {{widgets}};
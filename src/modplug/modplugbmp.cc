@@ -18,6 +18,8 @@
 
 #include "archive/open.h"
 
+#include "../render-cache-common/rendercache.h"
+
 using namespace std;
 
 // ModplugXMMS member functions ===============================
@@ -26,9 +28,15 @@ bool ModplugXMMS::init ()
 {
     load_settings ();
     apply_settings ();
+    render_cache_init ();
     return true;
 }
 
+void ModplugXMMS::cleanup ()
+{
+    render_cache_cleanup ();
+}
+
 bool ModplugXMMS::is_our_file (const char * filename, VFSFile & file)
 {
     string lExt;
@@ -146,7 +154,7 @@ bool ModplugXMMS::is_our_file (const char * filename, VFSFile & file)
     return false;
 }
 
-void ModplugXMMS::PlayLoop()
+void ModplugXMMS::PlayLoop(RenderCacheWriter & writer)
 {
     uint32_t lLength;
 
@@ -154,13 +162,19 @@ void ModplugXMMS::PlayLoop()
     {
         int seek_time = check_seek ();
         if (seek_time != -1)
+        {
+            writer.discard ();
             mSoundFile->SetCurrentPos (seek_time * (int64_t)
              mSoundFile->GetMaxPosition () / (mSoundFile->GetSongTime () * 1000));
+        }
 
         lLength = mSoundFile->Read (mBuffer, mBufSize);
 
         if (! lLength)
+        {
+            writer.finish ();
             break;
+        }
 
         if(mModProps.mPreamp)
         {
@@ -177,9 +191,33 @@ void ModplugXMMS::PlayLoop()
         }
 
         write_audio (mBuffer, mBufSize);
+        writer.write ((const int16_t *) mBuffer, mBufSize / (2 * mModProps.mChannels));
     }
 }
 
+/* The render cache key covers the module and every setting that changes the
+ * output.  Songs that repeat forever are not cached.  Songs are only recorded
+ * as they play, since libmodplug keeps its mixer settings in static members
+ * of CSoundFile. */
+static String cache_key (Archive * archive, const ModplugSettings & props)
+{
+    if (! render_cache_enabled () || props.mLoopCount < 0)
+        return String ();
+
+    Index<char> data;
+    data.insert ((const char *) archive->Map (), 0, archive->Size ());
+
+    return render_cache_key ("modplug", MODPLUG_VERSION, data, str_printf (
+     "channels=%d resampling=%d rate=%d reverb=%d,%d,%d megabass=%d,%d,%d "
+     "surround=%d,%d,%d preamp=%d,%g oversample=%d noise=%d loops=%d",
+     props.mChannels, props.mResamplingMode, props.mFrequency,
+     props.mReverb, props.mReverbDepth, props.mReverbDelay,
+     props.mMegabass, props.mBassAmount, props.mBassRange,
+     props.mSurround, props.mSurroundDepth, props.mSurroundDelay,
+     props.mPreamp, props.mPreampLevel, props.mOversamp,
+     props.mNoiseReduction, props.mLoopCount));
+}
+
 bool ModplugXMMS::play (const char * filename, VFSFile & file)
 {
     //open and mmap the file
@@ -190,6 +228,21 @@ bool ModplugXMMS::play (const char * filename, VFSFile & file)
         return false;
     }
 
+    RenderCacheWriter writer;
+    String key = cache_key (mArchive, mModProps);
+
+    if (key)
+    {
+        if (render_cache_play (key, mModProps.mChannels, mModProps.mFrequency))
+        {
+            delete mArchive;
+            mArchive = nullptr;
+            return true;
+        }
+
+        writer.open (key, mModProps.mChannels, mModProps.mFrequency);
+    }
+
     mSoundFile = new CSoundFile;
 
     //find buftime to get approx. 512 samples/block
@@ -261,7 +314,7 @@ bool ModplugXMMS::play (const char * filename, VFSFile & file)
 
     open_audio(FMT_S16_NE, mModProps.mFrequency, mModProps.mChannels);
 
-    PlayLoop();
+    PlayLoop(writer);
 
     delete[] mBuffer;
     mBuffer = nullptr;
@@ -42,6 +42,7 @@
 
 class CSoundFile;
 class Archive;
+class RenderCacheWriter;
 
 struct PreferencesWidget;
 
@@ -65,6 +66,7 @@ public:
         .with_exts (exts)) {}
 
     bool init () override;
+    void cleanup () override;
 
     bool is_our_file (const char * filename, VFSFile & file) override;
     bool read_tag (const char * filename, VFSFile & file, Tuple & tuple, Index<char> * image) override;
@@ -86,7 +88,7 @@ private:
     void load_settings ();
     void apply_settings ();
 
-    void PlayLoop();
+    void PlayLoop(RenderCacheWriter & writer);
 };
 
 #endif //included
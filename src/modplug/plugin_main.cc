@@ -14,6 +14,8 @@
 #include <libaudcore/runtime.h>
 #include <libaudcore/preferences.h>
 
+#include "../render-cache-common/rendercache.h"
+
 #define MODPLUG_CFGID "modplug"
 
 EXPORT ModplugXMMS aud_plugin_instance;
@@ -121,7 +123,8 @@ static const PreferencesWidget widget_columns[] = {
 
 const PreferencesWidget ModplugXMMS::widgets[] = {
     WidgetBox ({{widget_columns}, true}),
-    WidgetLabel (N_("These settings will take effect when Audacious is restarted."))
+    WidgetLabel (N_("These settings will take effect when Audacious is restarted.")),
+    WidgetBox ({{render_cache_record_widgets}})
 };
 
 const PluginPreferences ModplugXMMS::prefs = {{widgets}};
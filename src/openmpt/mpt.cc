@@ -26,6 +26,7 @@
 
 #include <string.h>
 
+#include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
@@ -38,6 +39,10 @@ static bool force_apply = false;
 static constexpr const char *CFG_SECTION               = "openmpt";
 static constexpr const char *SETTING_STEREO_SEPARATION = "stereo_separation";
 static constexpr const char *SETTING_INTERPOLATOR      = "interpolator";
+static constexpr const char *SETTING_BLOCK_SIZE        = "block_size";
+static constexpr const char *SETTING_SUBSONGS          = "subsongs";
+
+static constexpr int default_block_size = 8192; /* frames */
 
 class MPTPlugin : public InputPlugin
 {
@@ -55,7 +60,7 @@ public:
         &prefs,
     };
 
-    static constexpr auto iinfo = InputInfo(0)
+    static constexpr auto iinfo = InputInfo(FlagSubtunes)
         .with_exts(exts);
 
     constexpr MPTPlugin() : InputPlugin(info, iinfo) { }
@@ -66,6 +71,8 @@ public:
         {
             SETTING_STEREO_SEPARATION, aud::numeric_string<MPTWrap::default_stereo_separation>::str,
             SETTING_INTERPOLATOR, aud::numeric_string<MPTWrap::default_interpolator>::str,
+            SETTING_BLOCK_SIZE, aud::numeric_string<default_block_size>::str,
+            SETTING_SUBSONGS, "FALSE",
             nullptr,
         };
 
@@ -76,40 +83,77 @@ public:
 
     bool is_our_file(const char *filename, VFSFile &file) override
     {
-        MPTWrap mpt;
-        return mpt.open(file);
+        MPTInfo info;
+        return MPTWrap::read_info(file, info);
     }
 
     bool read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *) override
     {
-        MPTWrap mpt;
-        if (!mpt.open(file))
+        MPTInfo info;
+        if (!MPTWrap::read_info(file, info))
             return false;
 
+        int subsong = -1;
+        uri_parse(filename, nullptr, nullptr, nullptr, &subsong);
+
+        int subsongs = info.subsong_durations.len();
+
         tuple.set_filename(filename);
-        tuple.set_format(mpt.format(), mpt.channels(), mpt.rate(), 0);
-        tuple.set_int(Tuple::Length, mpt.duration());
+        tuple.set_format(info.format, MPTWrap::channels(), MPTWrap::rate(), 0);
 
-        const String &title = mpt.title();
-        if (strlen(title) > 0)
-            tuple.set_str(Tuple::Title, title);
+        if (strlen(info.title) > 0)
+            tuple.set_str(Tuple::Title, info.title);
+
+        if (subsong >= 1 && subsong <= subsongs)
+        {
+            const String &name = info.subsong_names[subsong - 1];
+            if (strlen(name) > 0)
+                tuple.set_str(Tuple::Title, name);
+            if (strlen(info.title) > 0)
+                tuple.set_str(Tuple::Album, info.title);
+
+            tuple.set_int(Tuple::Length, info.subsong_durations[subsong - 1]);
+            tuple.set_int(Tuple::Subtune, subsong);
+            tuple.set_int(Tuple::NumSubtunes, subsongs);
+            tuple.set_int(Tuple::Track, subsong);
+        }
+        else
+        {
+            tuple.set_int(Tuple::Length, info.duration);
+
+            if (subsong < 0 && subsongs > 1 && aud_get_bool(CFG_SECTION, SETTING_SUBSONGS))
+                tuple.set_subtunes(subsongs, nullptr);
+        }
 
         return true;
     }
 
     bool play(const char *filename, VFSFile &file) override
     {
+        Index<char> data = file.read_all();
+
         MPTWrap mpt;
-        if (!mpt.open(file))
+        if (!mpt.open(data))
             return false;
 
+        data.clear();
+
+        int subsong = -1;
+        uri_parse(filename, nullptr, nullptr, nullptr, &subsong);
+
+        if (subsong >= 1)
+            mpt.select_subsong(subsong - 1);
+
         force_apply = true;
 
+        int block_size = aud::clamp(aud_get_int(CFG_SECTION, SETTING_BLOCK_SIZE), 256, 65536);
+        Index<float> buffer;
+        buffer.resize(block_size * mpt.channels());
+
         open_audio(FMT_FLOAT, mpt.rate(), mpt.channels());
 
         while (!check_stop())
         {
-            float buffer[16384];
             int seek_value = check_seek();
 
             if (seek_value >= 0)
@@ -122,11 +166,11 @@ public:
                 force_apply = false;
             }
 
-            auto n = mpt.read(buffer, aud::n_elems(buffer));
+            auto n = mpt.read(buffer.begin(), buffer.len());
             if (n == 0)
                 break;
 
-            write_audio(buffer, n * sizeof buffer[0]);
+            write_audio(buffer.begin(), n * sizeof buffer[0]);
         }
 
         return true;
@@ -160,6 +204,15 @@ const PreferencesWidget MPTPlugin::widgets[] =
             N_("Interpolation:"),
             WidgetInt(CFG_SECTION, SETTING_INTERPOLATOR, values_changed),
             { MPTWrap::interpolators }
+    ),
+    WidgetSpin(
+            N_("Render block size:"),
+            WidgetInt(CFG_SECTION, SETTING_BLOCK_SIZE),
+            { 256, 65536, 256, N_("frames") }
+    ),
+    WidgetCheck(
+            N_("List subsongs as separate playlist entries"),
+            WidgetBool(CFG_SECTION, SETTING_SUBSONGS)
     )
 };
 
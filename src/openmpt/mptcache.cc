@@ -0,0 +1,298 @@
+/*
+ * OpenMPT Module Information Cache
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/multihash.h>
+#include <libaudcore/runtime.h>
+
+#include <libopenmpt/libopenmpt.h>
+
+#include "mptcache.h"
+
+/* One line per module:
+ *   key <TAB> duration <TAB> format <TAB> title [<TAB> duration <TAB> name]...
+ * with one duration/name pair per subsong and all strings percent-encoded.
+ *
+ * Entries that are looked up are appended again once they have drifted
+ * into the older half of the file, so the order of the lines approximates
+ * the order of use.  When the file has grown to twice the number of
+ * entries, or beyond the entry limit, it is rewritten with only the latest
+ * line of the most recently used entries; modules that were edited or
+ * deleted eventually drop out that way. */
+
+#define MAX_ENTRIES 65536
+
+struct Entry
+{
+    MPTInfo info;
+    int line = 0;  /* number of the latest line for this entry */
+};
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static SimpleHash<String, Entry> entries;
+static int lines;
+static bool loaded = false;
+
+static StringBuf cache_path()
+{
+    return filename_build({aud_get_path(AudPath::UserDir), "openmpt-cache"});
+}
+
+static String encode(const String &str)
+{
+    return String(str_encode_percent(str ? (const char *)str : ""));
+}
+
+static StringBuf format_line(const char *key, const MPTInfo &info)
+{
+    String format = encode(info.format), title = encode(info.title);
+    StringBuf line = str_printf("%s\t%d\t%s\t%s", key, info.duration,
+     (const char *)format, (const char *)title);
+
+    for (int i = 0; i < info.subsong_durations.len(); i++)
+    {
+        String name = encode(info.subsong_names[i]);
+        str_append_printf(line, "\t%d\t%s", info.subsong_durations[i],
+         (const char *)name);
+    }
+
+    return line;
+}
+
+static void append_line(const char *key, const MPTInfo &info)
+{
+    StringBuf line = format_line(key, info);
+
+    FILE *handle = fopen(cache_path(), "a");
+    if (handle)
+    {
+        fprintf(handle, "%s\n", (const char *)line);
+        fclose(handle);
+    }
+    else
+        AUDERR("Could not write %s\n", (const char *)cache_path());
+
+    lines++;
+}
+
+static void copy_info(const MPTInfo &from, MPTInfo &to)
+{
+    to.format = from.format;
+    to.title = from.title;
+    to.duration = from.duration;
+
+    to.subsong_durations.clear();
+    to.subsong_durations.insert(from.subsong_durations.begin(), 0,
+     from.subsong_durations.len());
+
+    to.subsong_names.clear();
+    for (const String &name : from.subsong_names)
+        to.subsong_names.append(name);
+}
+
+/* splits at tabs, keeping empty fields (unlike str_list_to_index) */
+static Index<String> split_fields(char *line)
+{
+    Index<String> fields;
+
+    while (true)
+    {
+        char *tab = strchr(line, '\t');
+        if (tab)
+            *tab = 0;
+
+        fields.append(String(line));
+
+        if (!tab)
+            break;
+
+        line = tab + 1;
+    }
+
+    return fields;
+}
+
+static bool parse_line(char *line, String &key, MPTInfo &info)
+{
+    Index<String> fields = split_fields(line);
+    if (fields.len() < 4 || fields.len() % 2)
+        return false;
+
+    key = fields[0];
+    info.duration = atoi(fields[1]);
+    info.format = String(str_decode_percent(fields[2]));
+    info.title = String(str_decode_percent(fields[3]));
+
+    for (int i = 4; i < fields.len(); i += 2)
+    {
+        info.subsong_durations.append(atoi(fields[i]));
+        info.subsong_names.append(String(str_decode_percent(fields[i + 1])));
+    }
+
+    return true;
+}
+
+struct CompactItem
+{
+    const String *key;
+    Entry *entry;
+};
+
+static void compact()
+{
+    Index<CompactItem> items;
+    entries.iterate([&](const String &key, Entry &entry) {
+        items.append(&key, &entry);
+    });
+
+    /* oldest first */
+    items.sort([](const CompactItem &a, const CompactItem &b) {
+        return a.entry->line - b.entry->line;
+    });
+
+    int drop = aud::max(items.len() - MAX_ENTRIES, 0);
+
+    StringBuf path = cache_path();
+    StringBuf temp = str_concat({path, ".tmp"});
+
+    FILE *handle = fopen(temp, "w");
+    if (!handle)
+    {
+        AUDERR("Could not write %s\n", (const char *)temp);
+        return;
+    }
+
+    bool ok = true;
+    for (int i = drop; i < items.len(); i++)
+    {
+        StringBuf line = format_line(*items[i].key, items[i].entry->info);
+        if (fprintf(handle, "%s\n", (const char *)line) < 0)
+            ok = false;
+
+        items[i].entry->line = i - drop;
+    }
+
+    if (fclose(handle) != 0 || !ok || rename(temp, path) != 0)
+    {
+        AUDERR("Could not write %s\n", (const char *)path);
+        remove(temp);
+        return;
+    }
+
+    Index<String> dropped;
+    for (int i = 0; i < drop; i++)
+        dropped.append(*items[i].key);
+    for (const String &key : dropped)
+        entries.remove(key);
+
+    lines = items.len() - drop;
+}
+
+static void load()
+{
+    loaded = true;
+    lines = 0;
+
+    FILE *handle = fopen(cache_path(), "r");
+    if (!handle)
+        return;
+
+    char *line = nullptr;
+    size_t size = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &size, handle)) > 0)
+    {
+        if (line[len - 1] == '\n')
+            line[len - 1] = 0;
+
+        String key;
+        Entry entry;
+        if (parse_line(line, key, entry.info))
+        {
+            entry.line = lines;
+            entries.add(key, std::move(entry));
+        }
+
+        lines++;
+    }
+
+    free(line);
+    fclose(handle);
+
+    if (lines > 2 * entries.n_items() || entries.n_items() > MAX_ENTRIES)
+        compact();
+}
+
+String mpt_cache_key(const Index<char> &data)
+{
+    /* FNV-1a */
+    uint64_t hash = 0xcbf29ce484222325;
+    for (char c : data)
+        hash = (hash ^ (unsigned char)c) * 0x100000001b3;
+
+    return String(str_printf("%08x-%x-%016llx", openmpt_get_library_version(),
+     (unsigned)data.len(), (unsigned long long)hash));
+}
+
+bool mpt_cache_lookup(const char *key, MPTInfo &info)
+{
+    pthread_mutex_lock(&mutex);
+
+    if (!loaded)
+        load();
+
+    Entry *entry = entries.lookup(String(key));
+    if (entry)
+    {
+        copy_info(entry->info, info);
+
+        if (lines - entry->line > MAX_ENTRIES / 2)
+        {
+            entry->line = lines;
+            append_line(key, entry->info);
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+    return entry != nullptr;
+}
+
+void mpt_cache_add(const char *key, const MPTInfo &info)
+{
+    Entry entry;
+    copy_info(info, entry.info);
+
+    pthread_mutex_lock(&mutex);
+
+    if (!loaded)
+        load();
+
+    entry.line = lines;
+    append_line(key, info);
+    entries.add(String(key), std::move(entry));
+
+    pthread_mutex_unlock(&mutex);
+}
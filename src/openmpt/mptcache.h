@@ -0,0 +1,47 @@
+/*
+ * OpenMPT Module Information Cache
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef AUDACIOUS_MPT_MPTCACHE_H
+#define AUDACIOUS_MPT_MPTCACHE_H
+
+#include <libaudcore/index.h>
+#include <libaudcore/objects.h>
+
+/* Everything read_tag() needs to know about a module.  Durations are in
+ * milliseconds; "duration" covers all subsongs played in sequence. */
+struct MPTInfo
+{
+    String format;
+    String title;
+    int duration = 0;
+    Index<int> subsong_durations;
+    Index<String> subsong_names;
+};
+
+/* libopenmpt can only find the length of a module by simulating its playback,
+ * once for every subsong.  The results are kept in a plain text log in the
+ * user directory, keyed on the contents of the file and the library version,
+ * so that rescanning a playlist does not repeat the simulation.  Newer lines
+ * override older ones; the log is compacted when it is loaded, keeping the
+ * most recently used entries. */
+String mpt_cache_key(const Index<char> &data);
+bool mpt_cache_lookup(const char *key, MPTInfo &info);
+void mpt_cache_add(const char *key, const MPTInfo &info);
+
+#endif
@@ -27,11 +27,9 @@
 #include <algorithm>
 #include <iterator>
 
-#define WANT_VFS_STDIO_COMPAT
 #include "mptwrap.h"
 
 constexpr ComboItem MPTWrap::interpolators[];
-constexpr openmpt_stream_callbacks MPTWrap::callbacks;
 
 static String to_aud_str(const char * str)
 {
@@ -40,10 +38,10 @@ static String to_aud_str(const char * str)
     return aud_str;
 }
 
-bool MPTWrap::open(VFSFile &file)
+bool MPTWrap::open(const Index<char> &data)
 {
-    auto m = openmpt_module_create2(callbacks, &file, openmpt_log_func_silent,
-     nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+    auto m = openmpt_module_create_from_memory2(data.begin(), data.len(),
+     openmpt_log_func_silent, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
 
     if (m == nullptr)
         return false;
@@ -52,27 +50,57 @@ bool MPTWrap::open(VFSFile &file)
 
     openmpt_module_select_subsong(mod.get(), -1);
 
-    m_duration = openmpt_module_get_duration_seconds(mod.get()) * 1000;
-    m_title = to_aud_str(openmpt_module_get_metadata(mod.get(), "title"));
-    m_format = to_aud_str(openmpt_module_get_metadata(mod.get(), "type_long"));
-
     return true;
 }
 
-size_t MPTWrap::stream_read(void *instance, void *buf, size_t n)
+void MPTWrap::select_subsong(int subsong)
 {
-    return VFS(instance)->fread(buf, 1, n);
+    openmpt_module_select_subsong(mod.get(), subsong);
 }
 
-int MPTWrap::stream_seek(void *instance, int64_t offset, int whence)
+/* Every duration is found by simulating playback, so this is by far the most
+ * expensive part of reading a module. */
+void MPTWrap::measure(MPTInfo &info)
 {
-    VFSSeekType w = to_vfs_seek_type(whence);
-    return VFS(instance)->fseek(offset, w) >= 0 ? 0 : -1;
+    info.format = to_aud_str(openmpt_module_get_metadata(mod.get(), "type_long"));
+    info.title = to_aud_str(openmpt_module_get_metadata(mod.get(), "title"));
+
+    openmpt_module_select_subsong(mod.get(), -1);
+    info.duration = openmpt_module_get_duration_seconds(mod.get()) * 1000;
+
+    int subsongs = openmpt_module_get_num_subsongs(mod.get());
+
+    if (subsongs > 1)
+    {
+        for (int i = 0; i < subsongs; i++)
+        {
+            openmpt_module_select_subsong(mod.get(), i);
+            info.subsong_durations.append(openmpt_module_get_duration_seconds(mod.get()) * 1000);
+            info.subsong_names.append(to_aud_str(openmpt_module_get_subsong_name(mod.get(), i)));
+        }
+    }
+
+    openmpt_module_select_subsong(mod.get(), -1);
 }
 
-int64_t MPTWrap::stream_tell(void *instance)
+bool MPTWrap::read_info(VFSFile &file, MPTInfo &info)
 {
-    return VFS(instance)->ftell();
+    Index<char> data = file.read_all();
+    if (data.len() == 0)
+        return false;
+
+    String key = mpt_cache_key(data);
+    if (mpt_cache_lookup(key, info))
+        return true;
+
+    MPTWrap mpt;
+    if (!mpt.open(data))
+        return false;
+
+    mpt.measure(info);
+    mpt_cache_add(key, info);
+
+    return true;
 }
 
 bool MPTWrap::is_valid_interpolator(int interpolator_value)
@@ -33,6 +33,8 @@
 
 #include <libopenmpt/libopenmpt.h>
 
+#include "mptcache.h"
+
 class MPTWrap
 {
 public:
@@ -58,30 +60,22 @@ public:
     static bool is_valid_stereo_separation(int);
     void set_stereo_separation(int);
 
-    bool open(VFSFile &);
+    bool open(const Index<char> &);
+    void select_subsong(int);
     int64_t read(float *, int64_t);
     void seek(int pos);
 
     static constexpr int rate() { return 48000; }
     static constexpr int channels() { return 2; }
 
-    int duration() const { return m_duration; }
-    const String & title() const { return m_title; }
-    const String & format() const { return m_format; }
+    /* Looks the file up in the module information cache, and only loads and
+     * measures the module if it is not there yet. */
+    static bool read_info(VFSFile &, MPTInfo &);
 
 private:
-    static size_t stream_read(void *, void *, size_t);
-    static int stream_seek(void *, int64_t, int);
-    static int64_t stream_tell(void *);
-    static VFSFile *VFS(void *instance) { return reinterpret_cast<VFSFile *>(instance); }
-
-    static constexpr openmpt_stream_callbacks callbacks = { stream_read, stream_seek, stream_tell };
+    void measure(MPTInfo &);
 
     SmartPtr<openmpt_module, openmpt_module_destroy> mod;
-
-    int m_duration = 0;
-    String m_title;
-    String m_format;
 };
 
 #endif
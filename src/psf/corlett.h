@@ -7,6 +7,11 @@
 
 // corlett.h
 
+#ifndef CORLETT_H
+#define CORLETT_H
+
+#include <stdint.h>
+
 #define MAX_UNKNOWN_TAGS			32
 
 typedef struct {
@@ -33,3 +38,4 @@ typedef struct {
 int corlett_decode(uint8_t *input, uint32_t input_len, uint8_t **output, uint64_t *size, corlett_t **c);
 uint32_t psfTimeToMS(char *str);
 
+#endif
@@ -34,24 +34,13 @@
 #include "cpuintrf.h"
 #include "psx.h"
 
-#include "peops/stdafx.h"
-#include "peops/externals.h"
-#include "peops/registers.h"
-#include "peops/spu.h"
-
 #include "corlett.h"
 
 #define DEBUG_LOADER	(0)
 
 #define LE32(x) FROM_LE32(x)
 
-static corlett_t	*c = nullptr;
-static char 		psfby[256];
-int			psf_refresh  = -1;
-
-static uint32_t initialPC, initialGP, initialSP;
-
-int32_t psf_start(uint8_t *buffer, uint32_t length)
+int32_t PSXMachine::psf_start(uint8_t *buffer, uint32_t length)
 {
 	uint8_t *file, *lib_decoded, *alib_decoded;
 	uint32_t offset, plength, PC, SP, GP, lengthMS, fadeMS;
@@ -112,7 +101,7 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 		printf("Loading library: %s\n", c->lib);
 		#endif
 
-		Index<char> buf = ao_get_lib(c->lib);
+		Index<char> buf = ao_get_lib(dirpath, c->lib);
 
 		if (!buf.len())
 			return AO_FAIL;
@@ -197,7 +186,7 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 			printf("Loading aux library: %s\n", c->libaux[i]);
 			#endif
 
-			Index<char> buf = ao_get_lib(c->libaux[i]);
+			Index<char> buf = ao_get_lib(dirpath, c->libaux[i]);
 
 			if (!buf.len())
 				return AO_FAIL;
@@ -286,8 +275,8 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 	#endif
 
 	psx_hw_init();
-	SPUinit();
-	SPUopen();
+	SPUinit(spu());
+	SPUopen(spu());
 
 	lengthMS = psfTimeToMS(c->inf_length);
 	fadeMS = psfTimeToMS(c->inf_fade);
@@ -301,7 +290,7 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 		lengthMS = ~0;
 	}
 
-	setlength(lengthMS, fadeMS);
+	setlength(spu(), lengthMS, fadeMS);
 
 	// patch illegal Chocobo Dungeon 2 code - CaitSith2 put a jump in the delay slot from a BNE
 	// and rely on Highly Experimental's buggy-ass CPU to rescue them.  Verified on real hardware
@@ -330,14 +319,14 @@ int32_t psf_start(uint8_t *buffer, uint32_t length)
 	return AO_SUCCESS;
 }
 
-int32_t psf_execute(void (*update)(const void *, int))
+int32_t PSXMachine::psf_execute(void (*update)(const void *, int, void *), void *user)
 {
 	int i;
 
 	while (!stop_flag) {
 		for (i = 0; i < 44100 / 60; i++) {
 			psx_hw_slice();
-			SPUasync(384, update);
+			SPUasync(spu(), 384, update, user);
 		}
 
 		psx_hw_frame();
@@ -346,9 +335,9 @@ int32_t psf_execute(void (*update)(const void *, int))
 	return AO_SUCCESS;
 }
 
-int32_t psf_stop(void)
+int32_t PSXMachine::psf_stop(void)
 {
-	SPUclose();
+	SPUclose(spu());
 	free(c);
 
 	return AO_SUCCESS;
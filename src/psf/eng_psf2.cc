@@ -53,16 +53,9 @@
 #include "cpuintrf.h"
 #include "psx.h"
 
-#include "peops2/stdafx.h"
-#include "peops2/externals.h"
-#include "peops2/regs.h"
-#include "peops2/registers.h"
-#include "peops2/spu.h"
-
 #include "corlett.h"
 
 #define DEBUG_LOADER	(0)
-#define MAX_FS		(32)	// maximum # of filesystems (libs and subdirectories)
 
 // ELF relocation helpers
 #define ELF32_R_SYM(val)                ((val) >> 8)
@@ -70,17 +63,6 @@
 
 #define LE32(x) FROM_LE32(x)
 
-static corlett_t	*c = nullptr;
-
-// main RAM
-static uint32_t initialPC, initialSP;
-static uint32_t loadAddr, lengthMS, fadeMS;
-
-static uint8_t *filesys[MAX_FS];
-static Index<char> lib_raw_file;
-static uint32_t fssize[MAX_FS];
-static int num_fs;
-
 static void do_iopmod(uint8_t *start, uint32_t offset)
 {
 	#if DEBUG_LOADER
@@ -100,7 +82,7 @@ static void do_iopmod(uint8_t *start, uint32_t offset)
 	#endif
 }
 
-uint32_t psf2_load_elf(uint8_t *start, uint32_t len)
+uint32_t PSXMachine::psf2_load_elf(uint8_t *start, uint32_t len)
 {
 	uint32_t entry, shoff, shentsize, shnum;
 	uint32_t type, addr, offset, size, shent;
@@ -179,7 +161,6 @@ uint32_t psf2_load_elf(uint8_t *start, uint32_t len)
 		  		for (rec = 0; rec < (size/8); rec++)
 				{
 					uint32_t offs, info, target, temp, val, vallo;
-					static uint32_t hi16offs = 0, hi16target = 0;
 
 					offs = start[offset+(rec*8)] | start[offset+1+(rec*8)]<<8 | start[offset+2+(rec*8)]<<16 | start[offset+3+(rec*8)]<<24;
 					info = start[offset+4+(rec*8)] | start[offset+5+(rec*8)]<<8 | start[offset+6+(rec*8)]<<16 | start[offset+7+(rec*8)]<<24;
@@ -342,7 +323,7 @@ static uint32_t load_file_ex(uint8_t *top, uint8_t *start, uint32_t len, const c
 	return 0xffffffff;
 }
 
-static uint32_t load_file(int fs, const char *file, uint8_t *buf, uint32_t buflen)
+uint32_t PSXMachine::load_file(int fs, const char *file, uint8_t *buf, uint32_t buflen)
 {
 	return load_file_ex(filesys[fs], filesys[fs], fssize[fs], file, buf, buflen);
 }
@@ -421,7 +402,7 @@ static dump_files(int fs, uint8_t *buf, uint32_t buflen)
 #endif
 
 // find a file on our filesystems
-uint32_t psf2_load_file(const char *file, uint8_t *buf, uint32_t buflen)
+uint32_t PSXMachine::psf2_load_file(const char *file, uint8_t *buf, uint32_t buflen)
 {
 	int i;
 	uint32_t flen;
@@ -438,7 +419,7 @@ uint32_t psf2_load_file(const char *file, uint8_t *buf, uint32_t buflen)
 	return 0xffffffff;
 }
 
-int32_t psf2_start(uint8_t *buffer, uint32_t length)
+int32_t PSXMachine::psf2_start(uint8_t *buffer, uint32_t length)
 {
 	uint8_t *file, *lib_decoded;
 	uint32_t irx_len;
@@ -477,7 +458,7 @@ int32_t psf2_start(uint8_t *buffer, uint32_t length)
 		printf("Loading library: %s\n", c->lib);
 		#endif
 
-		lib_raw_file = ao_get_lib(c->lib);
+		lib_raw_file = ao_get_lib(dirpath, c->lib);
 
 		if (!lib_raw_file.len())
 			return AO_FAIL;
@@ -526,7 +507,7 @@ int32_t psf2_start(uint8_t *buffer, uint32_t length)
 	{
 		lengthMS = ~0;
 	}
-	setlength2(lengthMS, fadeMS);
+	setlength2(spu2(), lengthMS, fadeMS);
 
 	mips_init();
 	mips_reset(nullptr);
@@ -559,13 +540,13 @@ int32_t psf2_start(uint8_t *buffer, uint32_t length)
 	memcpy(initial_ram, psx_ram, 2*1024*1024);
 
 	psx_hw_init();
-	SPU2init();
-	SPU2open(nullptr);
+	SPU2init(spu2());
+	SPU2open(spu2(), nullptr);
 
 	return AO_SUCCESS;
 }
 
-int32_t psf2_execute(void (*update)(const void *, int))
+int32_t PSXMachine::psf2_execute(void (*update)(const void *, int, void *), void *user)
 {
 	int i;
 
@@ -573,7 +554,7 @@ int32_t psf2_execute(void (*update)(const void *, int))
 	{
 		for (i = 0; i < 44100 / 60; i++)
 		{
-			SPU2async(update);
+			SPU2async(spu2(), update, user);
 			ps2_hw_slice();
 		}
 
@@ -583,16 +564,16 @@ int32_t psf2_execute(void (*update)(const void *, int))
 	return AO_SUCCESS;
 }
 
-int32_t psf2_stop(void)
+int32_t PSXMachine::psf2_stop(void)
 {
-	SPU2close();
+	SPU2close(spu2());
 	lib_raw_file.clear();
 	free(c);
 
 	return AO_SUCCESS;
 }
 
-int32_t psf2_command(int32_t command, int32_t parameter)
+int32_t PSXMachine::psf2_command(int32_t command, int32_t parameter)
 {
 	union cpuinfo mipsinfo;
 	uint32_t lengthMS, fadeMS;
@@ -600,15 +581,15 @@ int32_t psf2_command(int32_t command, int32_t parameter)
 	switch (command)
 	{
 		case COMMAND_RESTART:
-			SPU2close();
+			SPU2close(spu2());
 
 			memcpy(psx_ram, initial_ram, 2*1024*1024);
 
 			mips_init();
 			mips_reset(nullptr);
 			psx_hw_init();
-			SPU2init();
-			SPU2open(nullptr);
+			SPU2init(spu2());
+			SPU2open(spu2(), nullptr);
 
 			mipsinfo.i = initialPC;
 			mips_set_info(CPUINFO_INT_PC, &mipsinfo);
@@ -636,7 +617,7 @@ int32_t psf2_command(int32_t command, int32_t parameter)
 			{
 				lengthMS = ~0;
 			}
-			setlength2(lengthMS, fadeMS);
+			setlength2(spu2(), lengthMS, fadeMS);
 
 			return AO_SUCCESS;
 
@@ -644,12 +625,12 @@ int32_t psf2_command(int32_t command, int32_t parameter)
 	return AO_FAIL;
 }
 
-uint32_t psf2_get_loadaddr(void)
+uint32_t PSXMachine::psf2_get_loadaddr(void)
 {
 	return loadAddr;
 }
 
-void psf2_set_loadaddr(uint32_t addr)
+void PSXMachine::psf2_set_loadaddr(uint32_t addr)
 {
 	loadAddr = addr;
 }
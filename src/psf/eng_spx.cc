@@ -39,17 +39,7 @@
 #include "cpuintrf.h"
 #include "psx.h"
 
-#include "peops/stdafx.h"
-#include "peops/externals.h"
-#include "peops/registers.h"
-#include "peops/spu.h"
-
-static uint8_t *start_of_file, *song_ptr;
-static uint32_t cur_tick, cur_event, num_events, next_tick, end_tick;
-static int old_fmt;
-static char name[128], song[128], company[128];
-
-int32_t spx_start(uint8_t *buffer, uint32_t length)
+int32_t PSXMachine::spx_start(uint8_t *buffer, uint32_t length)
 {
 	int i;
 	uint16_t reg;
@@ -61,19 +51,19 @@ int32_t spx_start(uint8_t *buffer, uint32_t length)
 
 	start_of_file = buffer;
 
-	SPUinit();
-	SPUopen();
-	setlength(~0, 0);
+	SPUinit(spu());
+	SPUopen(spu());
+	setlength(spu(), ~0, 0);
 
 	// upload the SPU RAM image
-	SPUinjectRAMImage((unsigned short *)&buffer[0]);
+	SPUinjectRAMImage(spu(), (unsigned short *)&buffer[0]);
 
 	// apply the register image
 	for (i = 0; i < 512; i += 2)
 	{
 		reg = buffer[0x80000+i] | buffer[0x80000+i+1]<<8;
 
-		SPUwriteRegister((i/2)+0x1f801c00, reg);
+		SPUwriteRegister(spu(), (i/2)+0x1f801c00, reg);
 	}
 
 	old_fmt = 1;
@@ -114,7 +104,7 @@ int32_t spx_start(uint8_t *buffer, uint32_t length)
 	return AO_SUCCESS;
 }
 
-static void spx_tick(void)
+void PSXMachine::spx_tick(void)
 {
 	uint32_t time, reg, size;
 	uint16_t rdata;
@@ -129,7 +119,7 @@ static void spx_tick(void)
 			reg = song_ptr[4] | song_ptr[5]<<8 | song_ptr[6]<<16 | song_ptr[7]<<24;
 			rdata = song_ptr[8] | song_ptr[9]<<8;
 
-			SPUwriteRegister(reg, rdata);
+			SPUwriteRegister(spu(), reg, rdata);
 
 			cur_event++;
 			song_ptr += 12;
@@ -152,7 +142,7 @@ static void spx_tick(void)
 						reg = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
 						rdata = song_ptr[4] | song_ptr[5]<<8;
 
-						SPUwriteRegister(reg, rdata);
+						SPUwriteRegister(spu(), reg, rdata);
 
 						next_tick = song_ptr[6] | song_ptr[7]<<8 | song_ptr[8]<<16 | song_ptr[9]<<24;
 						song_ptr += 10;
@@ -160,7 +150,7 @@ static void spx_tick(void)
 
 					case 1:	// read register
 				 		reg = song_ptr[0] | song_ptr[1]<<8 | song_ptr[2]<<16 | song_ptr[3]<<24;
-						SPUreadRegister(reg);
+						SPUreadRegister(spu(), reg);
 						next_tick = song_ptr[4] | song_ptr[5]<<8 | song_ptr[6]<<16 | song_ptr[7]<<24;
 						song_ptr += 8;
 						break;
@@ -202,7 +192,7 @@ static void spx_tick(void)
 	cur_tick++;
 }
 
-int32_t spx_execute(void (*update)(const void *, int))
+int32_t PSXMachine::spx_execute(void (*update)(const void *, int, void *), void *user)
 {
 	int i, run = 1;
 
@@ -218,7 +208,7 @@ int32_t spx_execute(void (*update)(const void *, int))
 			for (i = 0; i < 44100 / 60; i++)
 			{
 			  	spx_tick();
-				SPUasync(384, update);
+				SPUasync(spu(), 384, update, user);
 			}
 		}
 	}
@@ -226,9 +216,9 @@ int32_t spx_execute(void (*update)(const void *, int))
 	return AO_SUCCESS;
 }
 
-int32_t spx_stop(void)
+int32_t PSXMachine::spx_stop(void)
 {
-	SPUclose();
+	SPUclose(spu());
 
 	return AO_SUCCESS;
 }
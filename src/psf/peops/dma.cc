@@ -29,17 +29,15 @@
 
 #define _IN_DMA
 
-extern uint32_t psx_ram[(2*1024*1024)/4+4];
-
 //#include "externals.h"
 ////////////////////////////////////////////////////////////////////////
 // READ DMA (many values)
 ////////////////////////////////////////////////////////////////////////
 
-void SPUreadDMAMem(u32 usPSXMem,int iSize)
+void PSXSPU::SPUreadDMAMem(u32 usPSXMem,int iSize)
 {
  int i;
- u16 *ram16 = (u16 *)&psx_ram[0];
+ u16 *ram16 = (u16 *)&machine->psx_ram[0];
 
  for(i=0;i<iSize;i++)
   {
@@ -62,10 +60,10 @@ void SPUreadDMAMem(u32 usPSXMem,int iSize)
 // WRITE DMA (many values)
 ////////////////////////////////////////////////////////////////////////
 
-void SPUwriteDMAMem(u32 usPSXMem,int iSize)
+void PSXSPU::SPUwriteDMAMem(u32 usPSXMem,int iSize)
 {
  int i;
- u16 *ram16 = (u16 *)&psx_ram[0];
+ u16 *ram16 = (u16 *)&machine->psx_ram[0];
 
  for(i=0;i<iSize;i++)
   {
@@ -26,5 +26,7 @@
 
 #include <stdint.h>
 
-void SPUwriteDMAMem(uint32_t usPSXMem, int iSize);
-void SPUreadDMAMem(uint32_t usPSXMem, int iSize);
+class PSXSPU;
+
+void SPUwriteDMAMem(PSXSPU *spu, uint32_t usPSXMem, int iSize);
+void SPUreadDMAMem(PSXSPU *spu, uint32_t usPSXMem, int iSize);
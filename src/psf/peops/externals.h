@@ -197,4 +197,112 @@ typedef struct
  int IN_COEF_R;      // (coef.)
 } REVERBInfo;
 
+///////////////////////////////////////////////////////////
+// SPU instance
+///////////////////////////////////////////////////////////
+
+class PSXMachine;
+
+// Everything that used to be a global of spu.c and the files it includes.
+// The emulated machine creates one with SPUcreate() (see spu.h) the first
+// time it touches the SPU; all members start out zero, as globals did.
+
+class PSXSPU
+{
+public:
+ explicit PSXSPU(PSXMachine *machine) : machine(machine) {}
+
+ // spu.c
+ int psf_seek(u32 t);
+ void setendless(int e);
+ void setlength(s32 stop, s32 fade);
+ int SPUasync(u32 cycles, void (*update)(const void *, int, void *), void *user);
+ int SPUinit(void);
+ int SPUopen(void);
+ int SPUclose(void);
+ int SPUshutdown(void);
+ void SPUinjectRAMImage(u16 *pIncoming);
+
+ // registers.c
+ void SPUwriteRegister(u32 reg, u16 val);
+ u16 SPUreadRegister(u32 reg);
+
+ // dma.c
+ void SPUreadDMAMem(u32 usPSXMem, int iSize);
+ void SPUwriteDMAMem(u32 usPSXMem, int iSize);
+
+private:
+ // spu.c
+ inline void StartSound(int ch);
+ void SetupStreams(void);
+ void RemoveStreams(void);
+
+ // reverb.c
+ inline s64 g_buffer(int iOff);
+ inline void s_buffer(int iOff,int iVal);
+ inline void s_buffer1(int iOff,int iVal);
+ inline void MixREVERBLeftRight(s32 *oleft, s32 *oright, s32 inleft, s32 inright);
+
+ // adsr.c
+ void InitADSR(void);
+ inline void StartADSR(int ch);
+ inline int MixADSR(int ch);
+
+ // registers.c
+ void SoundOn(int start,int end,u16 val);
+ void SoundOff(int start,int end,u16 val);
+ void FModOn(int start,int end,u16 val);
+ void NoiseOn(int start,int end,u16 val);
+ void SetVolumeLR(int right, u8 ch,s16 vol);
+ void SetPitch(int ch,u16 val);
+
+ PSXMachine *machine;                                  // for the irq and dma
+
+ // psx buffer / addresses
+
+ u16  regArea[0x200] {};
+ u16  spuMem[256*1024] {};
+ u8 * spuMemC = nullptr;
+ u8 * pSpuIrq = nullptr;
+ u8 * pSpuBuffer = nullptr;
+
+ // user settings
+ int             iVolume = 0;
+
+ // MAIN infos struct for each channel
+
+ SPUCHAN         s_chan[MAXCHAN+1] {};                 // channel + 1 infos (1 is security for fmod handling)
+ REVERBInfo      rvb {};
+
+ u32   dwNoiseVal = 1;                                 // global noise generator
+
+ u16  spuCtrl = 0;                                     // some vars to store psx reg infos
+ u16  spuStat = 0;
+ u16  spuIrq = 0;
+ u32  spuAddr = 0xffffffff;                            // address into spu mem
+ int  bSPUIsOpen = 0;
+
+ s16 * pS = nullptr;
+ s32 ttemp = 0;
+ s32 dosampies = 0;
+
+ u32 sampcount = 0;
+ u32 decaybegin = 0;
+ u32 decayend = 0;
+ u32 seektime = 0;
+ int endless = 0;
+
+#ifdef TIMEO
+ u64 begintime = 0;
+#endif
+
+ // adsr.c
+ u32 RateTable[160] {};
+
+ // reverb.c
+ s32 downbuf[2][8] {};
+ s32 upbuf[2][8] {};
+ int dbpos = 0, ubpos = 0;
+};
+
 #endif // PEOPS_EXTERNALS
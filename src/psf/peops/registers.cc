@@ -45,18 +45,11 @@
 #include "../peops/externals.h"
 #include "../peops/registers.h"
 
-static void SoundOn(int start,int end,u16 val);
-static void SoundOff(int start,int end,u16 val);
-static void FModOn(int start,int end,u16 val);
-static void NoiseOn(int start,int end,u16 val);
-static void SetVolumeLR(int right, u8 ch,s16 vol);
-static void SetPitch(int ch,u16 val);
-
 ////////////////////////////////////////////////////////////////////////
 // WRITE REGISTERS: called by main emu
 ////////////////////////////////////////////////////////////////////////
 
-void SPUwriteRegister(u32 reg, u16 val)
+void PSXSPU::SPUwriteRegister(u32 reg, u16 val)
 {
  const u32 r=reg&0xfff;
  regArea[(r-0xc00)>>1] = val;
@@ -296,7 +289,7 @@ void SPUwriteRegister(u32 reg, u16 val)
 // READ REGISTER: called by main emu
 ////////////////////////////////////////////////////////////////////////
 
-u16 SPUreadRegister(u32 reg)
+u16 PSXSPU::SPUreadRegister(u32 reg)
 {
  const u32 r=reg&0xfff;
 
@@ -360,7 +353,7 @@ u16 SPUreadRegister(u32 reg)
 // SOUND ON register write
 ////////////////////////////////////////////////////////////////////////
 
-static void SoundOn(int start,int end,u16 val)     // SOUND ON PSX COMAND
+void PSXSPU::SoundOn(int start,int end,u16 val)     // SOUND ON PSX COMAND
 {
  int ch;
 
@@ -378,7 +371,7 @@ static void SoundOn(int start,int end,u16 val)     // SOUND ON PSX COMAND
 // SOUND OFF register write
 ////////////////////////////////////////////////////////////////////////
 
-static void SoundOff(int start,int end,u16 val)    // SOUND OFF PSX COMMAND
+void PSXSPU::SoundOff(int start,int end,u16 val)    // SOUND OFF PSX COMMAND
 {
  int ch;
  for(ch=start;ch<end;ch++,val>>=1)                     // loop channels
@@ -394,7 +387,7 @@ static void SoundOff(int start,int end,u16 val)    // SOUND OFF PSX COMMAND
 // FMOD register write
 ////////////////////////////////////////////////////////////////////////
 
-static void FModOn(int start,int end,u16 val)      // FMOD ON PSX COMMAND
+void PSXSPU::FModOn(int start,int end,u16 val)      // FMOD ON PSX COMMAND
 {
  int ch;
 
@@ -419,7 +412,7 @@ static void FModOn(int start,int end,u16 val)      // FMOD ON PSX COMMAND
 // NOISE register write
 ////////////////////////////////////////////////////////////////////////
 
-static void NoiseOn(int start,int end,u16 val)     // NOISE ON PSX COMMAND
+void PSXSPU::NoiseOn(int start,int end,u16 val)     // NOISE ON PSX COMMAND
 {
  int ch;
 
@@ -442,7 +435,7 @@ static void NoiseOn(int start,int end,u16 val)     // NOISE ON PSX COMMAND
 
 // please note: sweep is wrong.
 
-static void SetVolumeLR(int right, u8 ch,s16 vol)            // LEFT VOLUME
+void PSXSPU::SetVolumeLR(int right, u8 ch,s16 vol)            // LEFT VOLUME
 {
  //if(vol&0xc000)
  //printf("%d %08x\n",right,vol);
@@ -484,7 +477,7 @@ static void SetVolumeLR(int right, u8 ch,s16 vol)            // LEFT VOLUME
 // PITCH register write
 ////////////////////////////////////////////////////////////////////////
 
-static void SetPitch(int ch,u16 val)               // SET PITCH
+void PSXSPU::SetPitch(int ch,u16 val)               // SET PITCH
 {
  int NP;
  if(val>0x3fff) NP=0x3fff;                             // get pitch val
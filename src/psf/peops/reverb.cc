@@ -51,7 +51,7 @@
 
 ////////////////////////////////////////////////////////////////////////
 
-static inline s64 g_buffer(int iOff)                          // get_buffer content helper: takes care about wraps
+inline s64 PSXSPU::g_buffer(int iOff)                          // get_buffer content helper: takes care about wraps
 {
  s16 * p=(s16 *)spuMem;
  iOff=(iOff*4)+rvb.CurrAddr;
@@ -62,7 +62,7 @@ static inline s64 g_buffer(int iOff)                          // get_buffer cont
 
 ////////////////////////////////////////////////////////////////////////
 
-static inline void s_buffer(int iOff,int iVal)                // set_buffer content helper: takes care about wraps and clipping
+inline void PSXSPU::s_buffer(int iOff,int iVal)                // set_buffer content helper: takes care about wraps and clipping
 {
  s16 * p=(s16 *)spuMem;
  iOff=(iOff*4)+rvb.CurrAddr;
@@ -75,7 +75,7 @@ static inline void s_buffer(int iOff,int iVal)                // set_buffer cont
 
 ////////////////////////////////////////////////////////////////////////
 
-static inline void s_buffer1(int iOff,int iVal)                // set_buffer (+1 sample) content helper: takes care about wraps and clipping
+inline void PSXSPU::s_buffer1(int iOff,int iVal)                // set_buffer (+1 sample) content helper: takes care about wraps and clipping
 {
  s16 * p=(s16 *)spuMem;
  iOff=(iOff*4)+rvb.CurrAddr+1;
@@ -86,11 +86,8 @@ static inline void s_buffer1(int iOff,int iVal)                // set_buffer (+1
  *(p+iOff)=(s16)BFLIP16((s16)iVal);
 }
 
-static inline void MixREVERBLeftRight(s32 *oleft, s32 *oright, s32 inleft, s32 inright)
+inline void PSXSPU::MixREVERBLeftRight(s32 *oleft, s32 *oright, s32 inleft, s32 inright)
 {
-   static s32 downbuf[2][8];
-   static s32 upbuf[2][8];
-   static int dbpos=0,ubpos=0;
    static s32 downcoeffs[8]={ /* Symmetry is sexy. */
 				1283,5344,10895,15243,
 				15243,10895,5344,1283
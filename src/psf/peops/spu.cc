@@ -83,6 +83,7 @@
 #include "../peops/externals.h"
 #include "../peops/registers.h"
 #include "../peops/spu.h"
+#include "../psx.h"
 
 // Enable experimental silence skipping
 // Currently it is too aggressive, destroying the rhythm of some songs
@@ -96,38 +97,12 @@
 // globals
 ////////////////////////////////////////////////////////////////////////
 
-// psx buffer / addresses
-
-static u16  regArea[0x200];
-static u16  spuMem[256*1024];
-static u8 * spuMemC;
-static u8 * pSpuIrq=0;
-static u8 * pSpuBuffer;
-
-// user settings
-static int             iVolume;
-
-// MAIN infos struct for each channel
-
-static SPUCHAN         s_chan[MAXCHAN+1];                     // channel + 1 infos (1 is security for fmod handling)
-static REVERBInfo      rvb;
-
-static u32   dwNoiseVal=1;                          // global noise generator
-
-static u16  spuCtrl=0;                             // some vars to store psx reg infos
-static u16  spuStat=0;
-static u16  spuIrq=0;
-static u32  spuAddr=0xffffffff;                    // address into spu mem
-static int  bSPUIsOpen=0;
-
 static const int f[5][2] = {
 			{    0,  0  },
                         {   60,  0  },
                         {  115, -52 },
                         {   98, -55 },
                         {  122, -60 } };
-static s16 * pS;
-static s32 ttemp;
 
 ////////////////////////////////////////////////////////////////////////
 // CODE AREA
@@ -156,7 +131,7 @@ static s32 ttemp;
 // START SOUND... called by main thread to setup a new sound on a channel
 ////////////////////////////////////////////////////////////////////////
 
-static inline void StartSound(int ch)
+inline void PSXSPU::StartSound(int ch)
 {
  StartADSR(ch);
 
@@ -182,26 +157,20 @@ static inline void StartSound(int ch)
 // basically the whole sound processing is done in this fat func!
 ////////////////////////////////////////////////////////////////////////
 
-static u32 sampcount;
-static u32 decaybegin;
-static u32 decayend;
-
-static u32 seektime;
-int psf_seek(u32 t)
+int PSXSPU::psf_seek(u32 t)
 {
  seektime=t*441/10;
  if(seektime>=sampcount) return(1);
  return(0);
 }
 
-static int endless;
-void setendless(int e)
+void PSXSPU::setendless(int e)
 {
  endless=e;
 }
 
 // Counting to 65536 results in full volume offage.
-void setlength(s32 stop, s32 fade)
+void PSXSPU::setlength(s32 stop, s32 fade)
 {
  if(stop==~0 || endless)
  {
@@ -218,10 +187,9 @@ void setlength(s32 stop, s32 fade)
 }
 
 #define CLIP(_x) {if(_x>32767) _x=32767; if(_x<-32767) _x=-32767;}
-int SPUasync(u32 cycles, void (*update)(const void *, int))
+int PSXSPU::SPUasync(u32 cycles, void (*update)(const void *, int, void *), void *user)
 {
  int volmul=iVolume;
- static s32 dosampies;
  s32 temp;
 
  ttemp+=cycles;
@@ -319,7 +287,7 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
                {
 		 //extern s32 spuirqvoodoo;
                  s_chan[ch].iIrqDone=1;                // -> debug flag
-		 SPUirq();
+		 machine->SPUirq();
 		//puts("IRQ");
 		 //if(spuirqvoodoo!=-1)
 		 //{
@@ -469,7 +437,7 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
    {
     if(sampcount>=decayend)
     {
-      update(nullptr, 0);
+      update(nullptr, 0, user);
       return(0);
     }
     dmul=256-(256*(sampcount-decaybegin)/(decayend-decaybegin));
@@ -526,7 +494,7 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
 
    if (iSilenceCount < 20)
 #endif
-     update((u8*)pSpuBuffer,(u8*)pS-(u8*)pSpuBuffer);
+     update((u8*)pSpuBuffer,(u8*)pS-(u8*)pSpuBuffer,user);
 
    pS=(short *)pSpuBuffer;
  }
@@ -535,7 +503,6 @@ int SPUasync(u32 cycles, void (*update)(const void *, int))
 }
 
 #ifdef TIMEO
-static u64 begintime;
 static u64 gettime64(void)
 {
  struct timeval tv;
@@ -556,7 +523,7 @@ static u64 gettime64(void)
 // SPUINIT: this func will be called first by the main emu
 ////////////////////////////////////////////////////////////////////////
 
-int SPUinit(void)
+int PSXSPU::SPUinit(void)
 {
  spuMemC=(u8*)spuMem;                      // just small setup
  memset((void *)s_chan,0,MAXCHAN*sizeof(SPUCHAN));
@@ -576,7 +543,7 @@ int SPUinit(void)
 // SETUPSTREAMS: init most of the spu buffers
 ////////////////////////////////////////////////////////////////////////
 
-static void SetupStreams(void)
+void PSXSPU::SetupStreams(void)
 {
  int i;
 
@@ -597,7 +564,7 @@ static void SetupStreams(void)
 // REMOVESTREAMS: free most buffer
 ////////////////////////////////////////////////////////////////////////
 
-static void RemoveStreams(void)
+void PSXSPU::RemoveStreams(void)
 {
  free(pSpuBuffer);                                     // free mixing buffer
  pSpuBuffer=nullptr;
@@ -619,7 +586,7 @@ static void RemoveStreams(void)
 // SPUOPEN: called by main emu after init
 ////////////////////////////////////////////////////////////////////////
 
-int SPUopen(void)
+int PSXSPU::SPUopen(void)
 {
  if(bSPUIsOpen) return 0;                              // security for some stupid main emus
  spuIrq=0;
@@ -646,7 +613,7 @@ int SPUopen(void)
 // SPUCLOSE: called before shutdown
 ////////////////////////////////////////////////////////////////////////
 
-int SPUclose(void)
+int PSXSPU::SPUclose(void)
 {
  if(!bSPUIsOpen) return 0;                             // some security
 
@@ -661,12 +628,12 @@ int SPUclose(void)
 // SPUSHUTDOWN: called by main emu on final exit
 ////////////////////////////////////////////////////////////////////////
 
-int SPUshutdown(void)
+int PSXSPU::SPUshutdown(void)
 {
  return 0;
 }
 
-void SPUinjectRAMImage(u16 *pIncoming)
+void PSXSPU::SPUinjectRAMImage(u16 *pIncoming)
 {
 	int i;
 
@@ -675,3 +642,34 @@ void SPUinjectRAMImage(u16 *pIncoming)
 		spuMem[i] = pIncoming[i];
 	}
 }
+
+////////////////////////////////////////////////////////////////////////
+// INTERFACE: the functions above, for a given instance
+////////////////////////////////////////////////////////////////////////
+
+PSXSPU *SPUcreate(PSXMachine *machine)
+{
+ return new PSXSPU(machine);
+}
+
+void SPUdestroy(PSXSPU *spu)
+{
+ spu->SPUclose();                                      // frees the buffers if still open
+ delete spu;
+}
+
+int psf_seek(PSXSPU *spu, u32 t) { return spu->psf_seek(t); }
+void setendless(PSXSPU *spu, int e) { spu->setendless(e); }
+void setlength(PSXSPU *spu, s32 stop, s32 fade) { spu->setlength(stop, fade); }
+
+int SPUasync(PSXSPU *spu, u32 cycles, void (*update)(const void *, int, void *), void *user)
+ { return spu->SPUasync(cycles, update, user); }
+int SPUinit(PSXSPU *spu) { return spu->SPUinit(); }
+int SPUopen(PSXSPU *spu) { return spu->SPUopen(); }
+int SPUclose(PSXSPU *spu) { return spu->SPUclose(); }
+int SPUshutdown(PSXSPU *spu) { return spu->SPUshutdown(); }
+void SPUinjectRAMImage(PSXSPU *spu, u16 *pIncoming) { spu->SPUinjectRAMImage(pIncoming); }
+void SPUreadDMAMem(PSXSPU *spu, u32 usPSXMem, int iSize) { spu->SPUreadDMAMem(usPSXMem, iSize); }
+void SPUwriteDMAMem(PSXSPU *spu, u32 usPSXMem, int iSize) { spu->SPUwriteDMAMem(usPSXMem, iSize); }
+u16 SPUreadRegister(PSXSPU *spu, u32 reg) { return spu->SPUreadRegister(reg); }
+void SPUwriteRegister(PSXSPU *spu, u32 reg, u16 val) { spu->SPUwriteRegister(reg, val); }
@@ -24,19 +24,30 @@
 //
 //*************************************************************************//
 
-void SPUirq(void);
-
-int psf_seek(uint32_t t);
-void setendless(int e);
-void setlength(int32_t stop, int32_t fade);
-
-int SPUasync(uint32_t cycles, void (*update)(const void *, int));
-void SPU_flushboot(void);
-int SPUinit(void);
-int SPUopen(void);
-int SPUclose(void);
-int SPUshutdown(void);
-void SPUinjectRAMImage(uint16_t *pIncoming);
-void SPUreadDMAMem(uint32_t usPSXMem, int iSize);
-void SPUwriteDMAMem(uint32_t usPSXMem, int iSize);
-uint16_t SPUreadRegister(uint32_t reg);
+#ifndef PEOPS_SPU_H
+#define PEOPS_SPU_H
+
+#include <stdint.h>
+
+class PSXMachine;
+class PSXSPU;
+
+PSXSPU *SPUcreate(PSXMachine *machine);
+void SPUdestroy(PSXSPU *spu);
+
+int psf_seek(PSXSPU *spu, uint32_t t);
+void setendless(PSXSPU *spu, int e);
+void setlength(PSXSPU *spu, int32_t stop, int32_t fade);
+
+int SPUasync(PSXSPU *spu, uint32_t cycles, void (*update)(const void *, int, void *), void *user);
+int SPUinit(PSXSPU *spu);
+int SPUopen(PSXSPU *spu);
+int SPUclose(PSXSPU *spu);
+int SPUshutdown(PSXSPU *spu);
+void SPUinjectRAMImage(PSXSPU *spu, uint16_t *pIncoming);
+void SPUreadDMAMem(PSXSPU *spu, uint32_t usPSXMem, int iSize);
+void SPUwriteDMAMem(PSXSPU *spu, uint32_t usPSXMem, int iSize);
+uint16_t SPUreadRegister(PSXSPU *spu, uint32_t reg);
+void SPUwriteRegister(PSXSPU *spu, uint32_t reg, uint16_t val);
+
+#endif
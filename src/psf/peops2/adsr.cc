@@ -41,9 +41,7 @@
 // ADSR func
 ////////////////////////////////////////////////////////////////////////
 
-unsigned long RateTable[160];
-
-static void InitADSR(void)                                    // INIT ADSR
+void PS2SPU::InitADSR(void)                                    // INIT ADSR
 {
  unsigned long r,rs,rd;int i;
 
@@ -66,7 +64,7 @@ static void InitADSR(void)                                    // INIT ADSR
 
 ////////////////////////////////////////////////////////////////////////
 
-static void StartADSR(int ch)                          // MIX ADSR
+void PS2SPU::StartADSR(int ch)                          // MIX ADSR
 {
  s_chan[ch].ADSRX.lVolume=1;                           // and init some adsr vars
  s_chan[ch].ADSRX.State=0;
@@ -75,7 +73,7 @@ static void StartADSR(int ch)                          // MIX ADSR
 
 ////////////////////////////////////////////////////////////////////////
 
-static int MixADSR(int ch)                             // MIX ADSR
+int PS2SPU::MixADSR(int ch)                             // MIX ADSR
 {
  if(s_chan[ch].bStop)                                  // should be stopped:
   {                                                    // do release
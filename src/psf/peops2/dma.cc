@@ -34,18 +34,17 @@
 #include "../peops2/dma.h"
 #include "../peops2/externals.h"
 #include "../peops2/registers.h"
+#include "../psx.h"
 //#include "debug.h"
 
-extern uint32_t psx_ram[(2*1024*1024)/4+4];
-
 ////////////////////////////////////////////////////////////////////////
 // READ DMA (many values)
 ////////////////////////////////////////////////////////////////////////
 
-EXPORT_GCC void CALLBACK SPU2readDMA4Mem(u32 usPSXMem,int iSize)
+EXPORT_GCC void CALLBACK PS2SPU::SPU2readDMA4Mem(u32 usPSXMem,int iSize)
 {
  int i;
- u16 *ram16 = (u16 *)&psx_ram[0];
+ u16 *ram16 = (u16 *)&machine->psx_ram[0];
 
  for(i=0;i<iSize;i++)
   {
@@ -65,10 +64,10 @@ EXPORT_GCC void CALLBACK SPU2readDMA4Mem(u32 usPSXMem,int iSize)
  spuStat2[0]=0x80;                                     // DMA complete
 }
 
-EXPORT_GCC void CALLBACK SPU2readDMA7Mem(u32 usPSXMem,int iSize)
+EXPORT_GCC void CALLBACK PS2SPU::SPU2readDMA7Mem(u32 usPSXMem,int iSize)
 {
  int i;
- u16 *ram16 = (u16 *)&psx_ram[0];
+ u16 *ram16 = (u16 *)&machine->psx_ram[0];
 
  for(i=0;i<iSize;i++)
   {
@@ -99,10 +98,10 @@ EXPORT_GCC void CALLBACK SPU2readDMA7Mem(u32 usPSXMem,int iSize)
 // WRITE DMA (many values)
 ////////////////////////////////////////////////////////////////////////
 
-EXPORT_GCC void CALLBACK SPU2writeDMA4Mem(u32 usPSXMem,int iSize)
+EXPORT_GCC void CALLBACK PS2SPU::SPU2writeDMA4Mem(u32 usPSXMem,int iSize)
 {
  int i;
- u16 *ram16 = (u16 *)&psx_ram[0];
+ u16 *ram16 = (u16 *)&machine->psx_ram[0];
 
  for(i=0;i<iSize;i++)
   {
@@ -118,10 +117,10 @@ EXPORT_GCC void CALLBACK SPU2writeDMA4Mem(u32 usPSXMem,int iSize)
  spuStat2[0]=0x80;                                     // DMA complete
 }
 
-EXPORT_GCC void CALLBACK SPU2writeDMA7Mem(u32 usPSXMem,int iSize)
+EXPORT_GCC void CALLBACK PS2SPU::SPU2writeDMA7Mem(u32 usPSXMem,int iSize)
 {
  int i;
- u16 *ram16 = (u16 *)&psx_ram[0];
+ u16 *ram16 = (u16 *)&machine->psx_ram[0];
 
  for(i=0;i<iSize;i++)
   {
@@ -140,7 +139,7 @@ EXPORT_GCC void CALLBACK SPU2writeDMA7Mem(u32 usPSXMem,int iSize)
 // INTERRUPTS
 ////////////////////////////////////////////////////////////////////////
 
-void InterruptDMA4(void)
+void PS2SPU::InterruptDMA4(void)
 {
 // taken from linuzappz nullptr spu2
 //	spu2Rs16(CORE0_ATTR)&= ~0x30;
@@ -152,12 +151,12 @@ void InterruptDMA4(void)
  spuStat2[0]|=0x80;
 }
 
-EXPORT_GCC void CALLBACK SPU2interruptDMA4(void)
+EXPORT_GCC void CALLBACK PS2SPU::SPU2interruptDMA4(void)
 {
  InterruptDMA4();
 }
 
-void InterruptDMA7(void)
+void PS2SPU::InterruptDMA7(void)
 {
 // taken from linuzappz nullptr spu2
 //	spu2Rs16(CORE1_ATTR)&= ~0x30;
@@ -169,7 +168,7 @@ void InterruptDMA7(void)
  spuStat2[1]|=0x80;
 }
 
-EXPORT_GCC void CALLBACK SPU2interruptDMA7(void)
+EXPORT_GCC void CALLBACK PS2SPU::SPU2interruptDMA7(void)
 {
  InterruptDMA7();
 }
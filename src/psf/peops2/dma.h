@@ -26,12 +26,11 @@
 
 #include <stdint.h>
 
-void InterruptDMA4(void);
-void InterruptDMA7(void);
+class PS2SPU;
 
-void SPU2readDMA4Mem(uint32_t usPSXMem,int iSize);
-void SPU2writeDMA4Mem(uint32_t usPSXMem,int iSize);
-void SPU2readDMA7Mem(uint32_t usPSXMem,int iSize);
-void SPU2writeDMA7Mem(uint32_t usPSXMem,int iSize);
-void SPU2interruptDMA4(void);
-void SPU2interruptDMA7(void);
+void SPU2readDMA4Mem(PS2SPU *spu,uint32_t usPSXMem,int iSize);
+void SPU2writeDMA4Mem(PS2SPU *spu,uint32_t usPSXMem,int iSize);
+void SPU2readDMA7Mem(PS2SPU *spu,uint32_t usPSXMem,int iSize);
+void SPU2writeDMA7Mem(PS2SPU *spu,uint32_t usPSXMem,int iSize);
+void SPU2interruptDMA4(PS2SPU *spu);
+void SPU2interruptDMA7(PS2SPU *spu);
@@ -240,141 +240,177 @@ typedef struct
  int IN_COEF_L;      // (coef.)
  int IN_COEF_R;      // (coef.)
 } REVERBInfo2;
-
-#ifdef _WINDOWS
-//extern HINSTANCE hInst;
-//#define WM_MUTE (WM_USER+543)
-#endif
-
-///////////////////////////////////////////////////////////
-// SPU.C globals
-///////////////////////////////////////////////////////////
-
-#ifndef _IN_SPU
-
-// psx buffers / addresses
-
-extern unsigned short  regArea[];
-extern unsigned short  spuMem[];
-extern unsigned char * spuMemC;
-extern unsigned char * pSpuIrq[];
-extern unsigned char * pSpuBuffer;
-
-// user settings
-
-extern int        iUseXA;
-extern int        iVolume;
-extern int        iXAPitch;
-extern int        iUseTimer;
-extern int        iSPUIRQWait;
-extern int        iDebugMode;
-extern int        iRecordMode;
-extern int        iUseReverb;
-extern int        iUseInterpolation;
-extern int        iDisStereo;
-// MISC
-
-extern SPUCHAN2 s_chan[];
-extern REVERBInfo2 rvb[];
-
-extern unsigned long dwNoiseVal;
-extern unsigned short spuCtrl2[];
-extern unsigned short spuStat2[];
-extern unsigned long  spuIrq2[];
-extern unsigned long  spuAddr2[];
-extern unsigned long   spuRvbAddr2[];
-extern unsigned long   spuRvbAEnd2[];
-
-extern int      bEndThread;
-extern int      bThreadEnded;
-extern int      bSpuInit;
-
-extern int      SSumR[];
-extern int      SSumL[];
-extern int      iCycle;
-extern short *  pS;
-extern unsigned long dwNewChannel2[];
-extern unsigned long dwEndChannel2[];
-
-extern int iSpuAsyncWait;
-
-#ifdef _WINDOWS
-//extern HWND    hWMain;                               // window handle
-//extern HWND    hWDebug;
-#endif
-
-extern void (CALLBACK *cddavCallback)(unsigned short,unsigned short);
-
-#endif
-
-///////////////////////////////////////////////////////////
-// CFG.C globals
 ///////////////////////////////////////////////////////////
-
-#ifndef _IN_CFG
-
-#ifndef _WINDOWS
-extern char * pConfigFile;
-#endif
-
-#endif
-
+// SPU instance
 ///////////////////////////////////////////////////////////
-// DSOUND.C globals
-///////////////////////////////////////////////////////////
-
-#ifndef _IN_DSOUND
 
-#ifdef _WINDOWS
-extern unsigned long LastWrite;
-extern unsigned long LastPlay;
-#endif
+class PSXMachine;
 
-#endif
+// Everything that used to be a global of spu.c, xa.c and the files they
+// include.  The emulated machine creates one with SPU2create() (see spu.h)
+// the first time it touches the SPU; all members start out as the globals
+// did.
 
-///////////////////////////////////////////////////////////
-// RECORD.C globals
-///////////////////////////////////////////////////////////
-
-#ifndef _IN_RECORD
-
-#ifdef _WINDOWS
-extern int iDoRecord;
-#endif
-
-#endif
-
-///////////////////////////////////////////////////////////
-// XA.C globals
-///////////////////////////////////////////////////////////
-
-#ifndef _IN_XA
-
-extern xa_decode_t   * xapGlobal;
-
-extern unsigned long * XAFeed;
-extern unsigned long * XAPlay;
-extern unsigned long * XAStart;
-extern unsigned long * XAEnd;
-
-extern unsigned long   XARepeat;
-extern unsigned long   XALastVal;
-
-extern int           iLeftXAVol;
-extern int           iRightXAVol;
-
-#endif
-
-///////////////////////////////////////////////////////////
-// REVERB.C globals
-///////////////////////////////////////////////////////////
-
-#ifndef _IN_REVERB
-
-extern int *          sRVBPlay[];
-extern int *          sRVBEnd[];
-extern int *          sRVBStart[];
-
-#endif
+class PS2SPU
+{
+public:
+ explicit PS2SPU(PSXMachine *machine) : machine(machine) {}
+
+ // spu.c
+ int psf2_seek(u32 t);
+ void setendless2(int e);
+ void setlength2(s32 stop, s32 fade);
+ void SPU2async(void (*update)(const void *, int, void *), void *user);
+ long SPU2init(void);
+ long SPU2open(void *pDsp);
+ void SPU2close(void);
+
+ // registers.c
+ void SPU2write(unsigned long reg, unsigned short val);
+ unsigned short SPU2read(unsigned long reg);
+
+ // dma.c
+ void SPU2readDMA4Mem(u32 usPSXMem,int iSize);
+ void SPU2readDMA7Mem(u32 usPSXMem,int iSize);
+ void SPU2writeDMA4Mem(u32 usPSXMem,int iSize);
+ void SPU2writeDMA7Mem(u32 usPSXMem,int iSize);
+ void SPU2interruptDMA4(void);
+ void SPU2interruptDMA7(void);
+
+private:
+ // spu.c
+ inline void InterpolateUp(int ch);
+ inline void InterpolateDown(int ch);
+ inline void StartSound(int ch);
+ void *MAINThread(void (*update)(const void *, int, void *), void *user);
+ void SetupTimer(void);
+ void RemoveTimer(void);
+ void SetupStreams(void);
+ void RemoveStreams(void);
+
+ // reverb.c
+ void StartREVERB(int ch);
+ inline void InitREVERB(void);
+ void StoreREVERB(int ch,int ns);
+ inline int g_buffer(int iOff,int core);
+ inline void s_buffer(int iOff,int iVal,int core);
+ inline void s_buffer1(int iOff,int iVal,int core);
+ int MixREVERBLeft(int ns,int core);
+ int MixREVERBRight(int core);
+
+ // adsr.c
+ void InitADSR(void);
+ void StartADSR(int ch);
+ int MixADSR(int ch);
+
+ // registers.c
+ void SoundOn(int start,int end,unsigned short val);
+ void SoundOff(int start,int end,unsigned short val);
+ void VolumeOn(int start,int end,unsigned short val,int iRight);
+ void FModOn(int start,int end,unsigned short val);
+ void NoiseOn(int start,int end,unsigned short val);
+ void SetVolumeL(unsigned char ch,short vol);
+ void SetVolumeR(unsigned char ch,short vol);
+ void SetPitch(int ch,unsigned short val);
+ void ReverbOn(int start,int end,unsigned short val,int iRight);
+ void SetReverbAddr(int core);
+
+ // dma.c
+ void InterruptDMA4(void);
+ void InterruptDMA7(void);
+
+ // xa.c
+ inline void MixXA(void);
+ inline void FeedXA(xa_decode_t *xap);
+
+ PSXMachine *machine;                                  // for the dma
+
+ // psx buffers / addresses
+
+ unsigned short  regArea[32*1024] {};
+ unsigned short  spuMem[1*1024*1024] {};
+ unsigned char * spuMemC = nullptr;
+ unsigned char * pSpuIrq[2] {};
+ unsigned char * pSpuBuffer = nullptr;
+
+ // user settings
+
+ int             iUseXA=0;
+ int             iXAPitch=1;
+ int             iUseTimer=2;
+ int             iSPUIRQWait=1;
+ int             iDebugMode=0;
+ int             iRecordMode=0;
+ int             iUseReverb=1;
+ int             iUseInterpolation=2;
+
+ // MAIN infos struct for each channel
+
+ SPUCHAN2         s_chan[MAXCHAN+1] {};                // channel + 1 infos (1 is security for fmod handling)
+ REVERBInfo2      rvb[2] {};
+
+ unsigned long   dwNoiseVal=1;                         // global noise generator
+
+ unsigned short  spuCtrl2[2] {};                       // some vars to store psx reg infos
+ unsigned short  spuStat2[2] {};
+ unsigned long   spuIrq2[2] {};
+ unsigned long   spuAddr2[2] {};                       // address into spu mem
+ unsigned long   spuRvbAddr2[2] {};
+ unsigned long   spuRvbAEnd2[2] {};
+ int             bEndThread=0;                         // thread handlers
+ int             bThreadEnded=0;
+ int             bSpuInit=0;
+ int             bSPUIsOpen=0;
+
+ unsigned long dwNewChannel2[2] {};                    // flags for faster testing, if new channel starts
+ unsigned long dwEndChannel2[2] {};
+
+ // UNUSED IN PS2 YET
+ void (CALLBACK *irqCallback)(void)=0;                 // func of main emu, called on spu irq
+ void (CALLBACK *cddavCallback)(unsigned short,unsigned short)=0;
+
+ // certain globals (were local before, but with the new timeproc I need em global)
+
+ int SSumR[NSSIZE] {};
+ int SSumL[NSSIZE] {};
+ int iCycle=0;
+ short * pS = nullptr;
+
+ int lastch=-1;                                        // last channel processed on spu irq in timer mode
+ int iSecureStart=0;                                   // secure start counter
+
+ u32 sampcount=0;
+ u32 decaybegin=0;
+ u32 decayend=0;
+ u32 seektime=0;
+ int endless=0;
+
+ int iSpuAsyncWait=0;
+
+ // reverb.c
+ int *          sRVBPlay[2] {};
+ int *          sRVBEnd[2] {};
+ int *          sRVBStart[2] {};
+
+ // adsr.c
+ unsigned long RateTable[160] {};
+
+ // xa.c
+ xa_decode_t   * xapGlobal=0;
+
+ unsigned long * XAFeed  = nullptr;
+ unsigned long * XAPlay  = nullptr;
+ unsigned long * XAStart = nullptr;
+ unsigned long * XAEnd   = nullptr;
+
+ unsigned long   XARepeat  = 0;
+ unsigned long   XALastVal = 0;
+
+ int             iLeftXAVol  = 32767;
+ int             iRightXAVol = 32767;
+
+ int gauss_ptr = 0;
+ int gauss_window[8] {};
+};
 
 #endif // PEOPS2_EXTERNALS
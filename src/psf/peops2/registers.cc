@@ -43,8 +43,6 @@
 
 #include "../peops2/externals.h"
 #include "../peops2/registers.h"
-#include "../peops2/regs.h"
-#include "../peops2/reverb.h"
 
 /*
 // adsr time values (in ms) by James Higgs ... see the end of
@@ -64,18 +62,11 @@
 #define SUSTAIN_MS     441L
 #define RELEASE_MS     437L
 
-// Prototypes
-void SetVolumeL(unsigned char ch,short vol);
-void SetVolumeR(unsigned char ch,short vol);
-void ReverbOn(int start,int end,unsigned short val,int iRight);
-void SetReverbAddr(int core);
-void VolumeOn(int start,int end,unsigned short val,int iRight);
-
 ////////////////////////////////////////////////////////////////////////
 // WRITE REGISTERS: called by main emu
 ////////////////////////////////////////////////////////////////////////
 
-EXPORT_GCC void CALLBACK SPU2write(unsigned long reg, unsigned short val)
+EXPORT_GCC void CALLBACK PS2SPU::SPU2write(unsigned long reg, unsigned short val)
 {
  long r=reg&0xffff;
 
@@ -786,7 +777,7 @@ EXPORT_GCC void CALLBACK SPU2write(unsigned long reg, unsigned short val)
 // READ REGISTER: called by main emu
 ////////////////////////////////////////////////////////////////////////
 
-EXPORT_GCC unsigned short CALLBACK SPU2read(unsigned long reg)
+EXPORT_GCC unsigned short CALLBACK PS2SPU::SPU2read(unsigned long reg)
 {
  long r=reg&0xffff;
 
@@ -1116,7 +1107,7 @@ EXPORT_GCC unsigned short CALLBACK SPU2readPS1Port(unsigned long reg)
 // SOUND ON register write
 ////////////////////////////////////////////////////////////////////////
 
-void SoundOn(int start,int end,unsigned short val)     // SOUND ON PSX COMAND
+void PS2SPU::SoundOn(int start,int end,unsigned short val)     // SOUND ON PSX COMAND
 {
  int ch;
 
@@ -1135,7 +1126,7 @@ void SoundOn(int start,int end,unsigned short val)     // SOUND ON PSX COMAND
 // SOUND OFF register write
 ////////////////////////////////////////////////////////////////////////
 
-void SoundOff(int start,int end,unsigned short val)    // SOUND OFF PSX COMMAND
+void PS2SPU::SoundOff(int start,int end,unsigned short val)    // SOUND OFF PSX COMMAND
 {
  int ch;
  for(ch=start;ch<end;ch++,val>>=1)                     // loop channels
@@ -1151,7 +1142,7 @@ void SoundOff(int start,int end,unsigned short val)    // SOUND OFF PSX COMMAND
 // FMOD register write
 ////////////////////////////////////////////////////////////////////////
 
-void FModOn(int start,int end,unsigned short val)      // FMOD ON PSX COMMAND
+void PS2SPU::FModOn(int start,int end,unsigned short val)      // FMOD ON PSX COMMAND
 {
  int ch;
 
@@ -1176,7 +1167,7 @@ void FModOn(int start,int end,unsigned short val)      // FMOD ON PSX COMMAND
 // NOISE register write
 ////////////////////////////////////////////////////////////////////////
 
-void NoiseOn(int start,int end,unsigned short val)     // NOISE ON PSX COMMAND
+void PS2SPU::NoiseOn(int start,int end,unsigned short val)     // NOISE ON PSX COMMAND
 {
  int ch;
 
@@ -1200,7 +1191,7 @@ void NoiseOn(int start,int end,unsigned short val)     // NOISE ON PSX COMMAND
 // please note: sweep and phase invert are wrong... but I've never seen
 // them used
 
-void SetVolumeL(unsigned char ch,short vol)            // LEFT VOLUME
+void PS2SPU::SetVolumeL(unsigned char ch,short vol)            // LEFT VOLUME
 {
  s_chan[ch].iLeftVolRaw=vol;
 
@@ -1228,7 +1219,7 @@ void SetVolumeL(unsigned char ch,short vol)            // LEFT VOLUME
 // RIGHT VOLUME register write
 ////////////////////////////////////////////////////////////////////////
 
-void SetVolumeR(unsigned char ch,short vol)            // RIGHT VOLUME
+void PS2SPU::SetVolumeR(unsigned char ch,short vol)            // RIGHT VOLUME
 {
  s_chan[ch].iRightVolRaw=vol;
 
@@ -1255,7 +1246,7 @@ void SetVolumeR(unsigned char ch,short vol)            // RIGHT VOLUME
 // PITCH register write
 ////////////////////////////////////////////////////////////////////////
 
-void SetPitch(int ch,unsigned short val)               // SET PITCH
+void PS2SPU::SetPitch(int ch,unsigned short val)               // SET PITCH
 {
  int NP;
  double intr;
@@ -1278,7 +1269,7 @@ void SetPitch(int ch,unsigned short val)               // SET PITCH
 // REVERB register write
 ////////////////////////////////////////////////////////////////////////
 
-void ReverbOn(int start,int end,unsigned short val,int iRight)  // REVERB ON PSX COMMAND
+void PS2SPU::ReverbOn(int start,int end,unsigned short val,int iRight)  // REVERB ON PSX COMMAND
 {
  int ch;
 
@@ -1301,7 +1292,7 @@ void ReverbOn(int start,int end,unsigned short val,int iRight)  // REVERB ON PSX
 // REVERB START register write
 ////////////////////////////////////////////////////////////////////////
 
-void SetReverbAddr(int core)
+void PS2SPU::SetReverbAddr(int core)
 {
  long val=spuRvbAddr2[core];
 
@@ -1323,7 +1314,7 @@ void SetReverbAddr(int core)
 // DRY LEFT/RIGHT per voice switches
 ////////////////////////////////////////////////////////////////////////
 
-void VolumeOn(int start,int end,unsigned short val,int iRight)  // VOLUME ON PSX COMMAND
+void PS2SPU::VolumeOn(int start,int end,unsigned short val,int iRight)  // VOLUME ON PSX COMMAND
 {
  int ch;
 
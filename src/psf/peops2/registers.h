@@ -150,8 +150,10 @@
 #define H_ExtRight       0x0db6
 #define H_Reverb         0x0dc0
 
-unsigned short SPU2read(unsigned long reg);
-void SPU2write(unsigned long reg, unsigned short val);
+class PS2SPU;
+
+unsigned short SPU2read(PS2SPU *spu, unsigned long reg);
+void SPU2write(PS2SPU *spu, unsigned long reg, unsigned short val);
 
 //###########################################################################
 
@@ -43,21 +43,11 @@
 // will be included from spu.c
 #ifdef _IN_SPU
 
-////////////////////////////////////////////////////////////////////////
-// globals
-////////////////////////////////////////////////////////////////////////
-
-// REVERB info and timing vars...
-
-int *          sRVBPlay[2];
-int *          sRVBEnd[2];
-int *          sRVBStart[2];
-
 ////////////////////////////////////////////////////////////////////////
 // START REVERB
 ////////////////////////////////////////////////////////////////////////
 
-static void StartREVERB(int ch)
+void PS2SPU::StartREVERB(int ch)
 {
  int core=ch/24;
 
@@ -72,7 +62,7 @@ static void StartREVERB(int ch)
 // HELPER FOR NEILL'S REVERB: re-inits our reverb mixing buf
 ////////////////////////////////////////////////////////////////////////
 
-static inline void InitREVERB(void)
+inline void PS2SPU::InitREVERB(void)
 {
  if(iUseReverb==1)
   {
@@ -85,7 +75,7 @@ static inline void InitREVERB(void)
 // STORE REVERB
 ////////////////////////////////////////////////////////////////////////
 
-static void StoreREVERB(int ch,int ns)
+void PS2SPU::StoreREVERB(int ch,int ns)
 {
  int core=ch/24;
 
@@ -105,7 +95,7 @@ static void StoreREVERB(int ch,int ns)
 
 ////////////////////////////////////////////////////////////////////////
 
-static inline int g_buffer(int iOff,int core)                   // get_buffer content helper: takes care about wraps
+inline int PS2SPU::g_buffer(int iOff,int core)                  // get_buffer content helper: takes care about wraps
 {
  short * p=(short *)spuMem;
  iOff=(iOff)+rvb[core].CurrAddr;
@@ -116,7 +106,7 @@ static inline int g_buffer(int iOff,int core)                   // get_buffer co
 
 ////////////////////////////////////////////////////////////////////////
 
-static inline void s_buffer(int iOff,int iVal,int core)        // set_buffer content helper: takes care about wraps and clipping
+inline void PS2SPU::s_buffer(int iOff,int iVal,int core)       // set_buffer content helper: takes care about wraps and clipping
 {
  short * p=(short *)spuMem;
  iOff=(iOff)+rvb[core].CurrAddr;
@@ -129,7 +119,7 @@ static inline void s_buffer(int iOff,int iVal,int core)        // set_buffer con
 
 ////////////////////////////////////////////////////////////////////////
 
-static inline void s_buffer1(int iOff,int iVal,int core)      // set_buffer (+1 sample) content helper: takes care about wraps and clipping
+inline void PS2SPU::s_buffer1(int iOff,int iVal,int core)     // set_buffer (+1 sample) content helper: takes care about wraps and clipping
 {
  short * p=(short *)spuMem;
  iOff=(iOff)+rvb[core].CurrAddr+1;
@@ -142,7 +132,7 @@ static inline void s_buffer1(int iOff,int iVal,int core)      // set_buffer (+1
 
 ////////////////////////////////////////////////////////////////////////
 
-static int MixREVERBLeft(int ns,int core)
+int PS2SPU::MixREVERBLeft(int ns,int core)
 {
  if(iUseReverb==1)
   {
@@ -229,7 +219,7 @@ static int MixREVERBLeft(int ns,int core)
 
 ////////////////////////////////////////////////////////////////////////
 
-static int MixREVERBRight(int core)
+int PS2SPU::MixREVERBRight(int core)
 {
  if(iUseReverb==1)                                     // Neill's reverb:
   {
@@ -100,7 +100,6 @@
 #define _IN_SPU
 
 #include "../peops2/externals.h"
-#include "../peops2/regs.h"
 #include "../peops2/dma.h"
 #include "../peops2/spu.h"
 
@@ -108,64 +107,11 @@
 // globals
 ////////////////////////////////////////////////////////////////////////
 
-// psx buffer / addresses
-
-unsigned short  regArea[32*1024];
-unsigned short  spuMem[1*1024*1024];
-unsigned char * spuMemC;
-unsigned char * pSpuIrq[2];
-unsigned char * pSpuBuffer;
-
-// user settings
-
-int             iUseXA=0;
-int             iXAPitch=1;
-int             iUseTimer=2;
-int             iSPUIRQWait=1;
-int             iDebugMode=0;
-int             iRecordMode=0;
-int             iUseReverb=1;
-int             iUseInterpolation=2;
-
-// MAIN infos struct for each channel
-
-SPUCHAN2         s_chan[MAXCHAN+1];                     // channel + 1 infos (1 is security for fmod handling)
-REVERBInfo2      rvb[2];
-
-unsigned long   dwNoiseVal=1;                          // global noise generator
-
-unsigned short  spuCtrl2[2];                           // some vars to store psx reg infos
-unsigned short  spuStat2[2];
-unsigned long   spuIrq2[2];
-unsigned long   spuAddr2[2];                           // address into spu mem
-unsigned long   spuRvbAddr2[2];
-unsigned long   spuRvbAEnd2[2];
-int             bEndThread=0;                          // thread handlers
-int             bThreadEnded=0;
-int             bSpuInit=0;
-int             bSPUIsOpen=0;
-
-unsigned long dwNewChannel2[2];                        // flags for faster testing, if new channel starts
-unsigned long dwEndChannel2[2];
-
-// UNUSED IN PS2 YET
-void (CALLBACK *irqCallback)(void)=0;                  // func of main emu, called on spu irq
-void (CALLBACK *cddavCallback)(unsigned short,unsigned short)=0;
-
-// certain globals (were local before, but with the new timeproc I need em global)
-
 const int f[5][2] = {   {    0,  0  },
                         {   60,  0  },
                         {  115, -52 },
                         {   98, -55 },
                         {  122, -60 } };
-int SSumR[NSSIZE];
-int SSumL[NSSIZE];
-int iCycle=0;
-short * pS;
-
-static int lastch=-1;      // last channel processed on spu irq in timer mode
-static int iSecureStart=0; // secure start counter
 
 ////////////////////////////////////////////////////////////////////////
 // CODE AREA
@@ -219,7 +165,7 @@ static int iSecureStart=0; // secure start counter
 //
 
 
-static inline void InterpolateUp(int ch)
+inline void PS2SPU::InterpolateUp(int ch)
 {
  if(s_chan[ch].SB[32]==1)                              // flag == 1? calc step and set flag... and don't change the value in this pass
   {
@@ -267,7 +213,7 @@ static inline void InterpolateUp(int ch)
 // even easier interpolation on downsampling, also no special filter, again just "Pete's common sense" tm
 //
 
-static inline void InterpolateDown(int ch)
+inline void PS2SPU::InterpolateDown(int ch)
 {
  if(s_chan[ch].sinc>=0x20000L)                                 // we would skip at least one val?
   {
@@ -293,7 +239,7 @@ static inline void InterpolateDown(int ch)
 // START SOUND... called by main thread to setup a new sound on a channel
 ////////////////////////////////////////////////////////////////////////
 
-static inline void StartSound(int ch)
+inline void PS2SPU::StartSound(int ch)
 {
  dwNewChannel2[ch/24]&=~(1<<(ch%24));                  // clear new channel bit
  dwEndChannel2[ch/24]&=~(1<<(ch%24));                  // clear end channel bit
@@ -325,26 +271,20 @@ static inline void StartSound(int ch)
 // basically the whole sound processing is done in this fat func!
 ////////////////////////////////////////////////////////////////////////
 
-static u32 sampcount;
-static u32 decaybegin;
-static u32 decayend;
-
-static u32 seektime;
-int psf2_seek(u32 t)
+int PS2SPU::psf2_seek(u32 t)
 {
  seektime=t*441/10;
  if(seektime>=sampcount) return(1);
  return(0);
 }
 
-static int endless;
-void setendless2(int e)
+void PS2SPU::setendless2(int e)
 {
  endless=e;
 }
 
 // Counting to 65536 results in full volume offage.
-void setlength2(s32 stop, s32 fade)
+void PS2SPU::setlength2(s32 stop, s32 fade)
 {
  if(stop==~0 || endless)
  {
@@ -368,9 +308,7 @@ void setlength2(s32 stop, s32 fade)
 
 ////////////////////////////////////////////////////////////////////////
 
-int iSpuAsyncWait=0;
-
-static void *MAINThread(void (*update)(const void *, int))
+void *PS2SPU::MAINThread(void (*update)(const void *, int, void *), void *user)
 {
  int s_1,s_2,fa;
  unsigned char * start;unsigned int nSample;
@@ -754,7 +692,7 @@ ENDX:   ;
        {
         if(sampcount>=decayend)
          {
-          update(nullptr, 0);
+          update(nullptr, 0, user);
           return(0);
          }
 
@@ -792,7 +730,7 @@ ENDX:   ;
      }
 
     if(iSilenceCount < 20)
-     update((u8*)pSpuBuffer,(u8*)pS-(u8*)pSpuBuffer);
+     update((u8*)pSpuBuffer,(u8*)pS-(u8*)pSpuBuffer,user);
 
     pS=(short *)pSpuBuffer;
    }
@@ -814,7 +752,7 @@ ENDX:   ;
 //  1 time every 'cycle' cycles... harhar
 ////////////////////////////////////////////////////////////////////////
 
-EXPORT_GCC void CALLBACK SPU2async(void (*update)(const void *, int))
+EXPORT_GCC void CALLBACK PS2SPU::SPU2async(void (*update)(const void *, int, void *), void *user)
 {
  if(iSpuAsyncWait)
   {
@@ -822,7 +760,7 @@ EXPORT_GCC void CALLBACK SPU2async(void (*update)(const void *, int))
    if(iSpuAsyncWait<=64) return;
    iSpuAsyncWait=0;
   }
- MAINThread(update);                                      // -> linux high-compat mode
+ MAINThread(update, user);                                // -> linux high-compat mode
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -834,7 +772,7 @@ EXPORT_GCC void CALLBACK SPU2async(void (*update)(const void *, int))
 ////////////////////////////////////////////////////////////////////////
 
 
-EXPORT_GCC long CALLBACK SPU2init(void)
+EXPORT_GCC long CALLBACK PS2SPU::SPU2init(void)
 {
  spuMemC=(unsigned char *)spuMem;                      // just small setup
  memset((void *)s_chan,0,MAXCHAN*sizeof(SPUCHAN2));
@@ -852,7 +790,7 @@ EXPORT_GCC long CALLBACK SPU2init(void)
 // SETUPTIMER: init of certain buffers and threads/timers
 ////////////////////////////////////////////////////////////////////////
 
-static void SetupTimer(void)
+void PS2SPU::SetupTimer(void)
 {
  memset(SSumR,0,NSSIZE*sizeof(int));                   // init some mixing buffers
  memset(SSumL,0,NSSIZE*sizeof(int));
@@ -867,7 +805,7 @@ static void SetupTimer(void)
 // REMOVETIMER: kill threads/timers
 ////////////////////////////////////////////////////////////////////////
 
-static void RemoveTimer(void)
+void PS2SPU::RemoveTimer(void)
 {
  bEndThread=1;                                         // raise flag to end thread
  bThreadEnded=0;                                       // no more spu is running
@@ -878,7 +816,7 @@ static void RemoveTimer(void)
 // SETUPSTREAMS: init most of the spu buffers
 ////////////////////////////////////////////////////////////////////////
 
-static void SetupStreams(void)
+void PS2SPU::SetupStreams(void)
 {
  int i;
 
@@ -913,7 +851,7 @@ static void SetupStreams(void)
 // REMOVESTREAMS: free most buffer
 ////////////////////////////////////////////////////////////////////////
 
-static void RemoveStreams(void)
+void PS2SPU::RemoveStreams(void)
 {
  free(pSpuBuffer);                                     // free mixing buffer
  pSpuBuffer=nullptr;
@@ -939,7 +877,7 @@ static void RemoveStreams(void)
 // SPUOPEN: called by main emu after init
 ////////////////////////////////////////////////////////////////////////
 
-EXPORT_GCC long CALLBACK SPU2open(void *pDsp)
+EXPORT_GCC long CALLBACK PS2SPU::SPU2open(void *pDsp)
 {
  if(bSPUIsOpen) return 0;                              // security for some stupid main emus
 
@@ -987,7 +925,7 @@ EXPORT_GCC long CALLBACK SPU2open(void *pDsp)
 // SPUCLOSE: called before shutdown
 ////////////////////////////////////////////////////////////////////////
 
-EXPORT_GCC void CALLBACK SPU2close(void)
+EXPORT_GCC void CALLBACK PS2SPU::SPU2close(void)
 {
  if(!bSPUIsOpen) return;                               // some security
 
@@ -1043,3 +981,38 @@ EXPORT_GCC void CALLBACK SPU2registerCDDAVolume(void (CALLBACK *CDDAVcallback)(u
  cddavCallback = CDDAVcallback;
 }
 #endif
+
+////////////////////////////////////////////////////////////////////////
+// INTERFACE: the functions above, for a given instance
+////////////////////////////////////////////////////////////////////////
+
+PS2SPU *SPU2create(PSXMachine *machine)
+{
+ return new PS2SPU(machine);
+}
+
+void SPU2destroy(PS2SPU *spu)
+{
+ spu->SPU2close();                                     // frees the buffers if still open
+ delete spu;
+}
+
+int psf2_seek(PS2SPU *spu, u32 t) { return spu->psf2_seek(t); }
+void setendless2(PS2SPU *spu, int e) { spu->setendless2(e); }
+void setlength2(PS2SPU *spu, s32 stop, s32 fade) { spu->setlength2(stop, fade); }
+
+long SPU2init(PS2SPU *spu) { return spu->SPU2init(); }
+long SPU2open(PS2SPU *spu, void *pDsp) { return spu->SPU2open(pDsp); }
+void SPU2async(PS2SPU *spu, void (*update)(const void *, int, void *), void *user)
+ { spu->SPU2async(update, user); }
+void SPU2close(PS2SPU *spu) { spu->SPU2close(); }
+
+unsigned short SPU2read(PS2SPU *spu, unsigned long reg) { return spu->SPU2read(reg); }
+void SPU2write(PS2SPU *spu, unsigned long reg, unsigned short val) { spu->SPU2write(reg, val); }
+
+void SPU2readDMA4Mem(PS2SPU *spu, u32 usPSXMem, int iSize) { spu->SPU2readDMA4Mem(usPSXMem, iSize); }
+void SPU2writeDMA4Mem(PS2SPU *spu, u32 usPSXMem, int iSize) { spu->SPU2writeDMA4Mem(usPSXMem, iSize); }
+void SPU2readDMA7Mem(PS2SPU *spu, u32 usPSXMem, int iSize) { spu->SPU2readDMA7Mem(usPSXMem, iSize); }
+void SPU2writeDMA7Mem(PS2SPU *spu, u32 usPSXMem, int iSize) { spu->SPU2writeDMA7Mem(usPSXMem, iSize); }
+void SPU2interruptDMA4(PS2SPU *spu) { spu->SPU2interruptDMA4(); }
+void SPU2interruptDMA7(PS2SPU *spu) { spu->SPU2interruptDMA7(); }
@@ -27,12 +27,25 @@
 //
 //*************************************************************************//
 
-void setendless2(int e);
-void setlength2(int32_t stop, int32_t fade);
+#ifndef PEOPS2_SPU_H
+#define PEOPS2_SPU_H
 
-long SPU2init(void);
-long SPU2open(void *pDsp);
-void SPU2async(void (*update)(const void *, int));
-void SPU2close(void);
+#include <stdint.h>
 
-int psf2_seek(uint32_t t);
+class PSXMachine;
+class PS2SPU;
+
+PS2SPU *SPU2create(PSXMachine *machine);
+void SPU2destroy(PS2SPU *spu);
+
+void setendless2(PS2SPU *spu, int e);
+void setlength2(PS2SPU *spu, int32_t stop, int32_t fade);
+
+long SPU2init(PS2SPU *spu);
+long SPU2open(PS2SPU *spu, void *pDsp);
+void SPU2async(PS2SPU *spu, void (*update)(const void *, int, void *), void *user);
+void SPU2close(PS2SPU *spu);
+
+int psf2_seek(PS2SPU *spu, uint32_t t);
+
+#endif
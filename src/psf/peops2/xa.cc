@@ -34,26 +34,6 @@
 // will be included from spu.c
 #ifdef _IN_SPU
 
-////////////////////////////////////////////////////////////////////////
-// XA GLOBALS
-////////////////////////////////////////////////////////////////////////
-
-xa_decode_t   * xapGlobal=0;
-
-unsigned long * XAFeed  = nullptr;
-unsigned long * XAPlay  = nullptr;
-unsigned long * XAStart = nullptr;
-unsigned long * XAEnd   = nullptr;
-
-unsigned long   XARepeat  = 0;
-unsigned long   XALastVal = 0;
-
-int             iLeftXAVol  = 32767;
-int             iRightXAVol = 32767;
-
-static int gauss_ptr = 0;
-static int gauss_window[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-
 #define gvall0 gauss_window[gauss_ptr]
 #define gvall(x) gauss_window[(gauss_ptr+x)&3]
 #define gvalr0 gauss_window[4+gauss_ptr]
@@ -63,7 +43,7 @@ static int gauss_window[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 // MIX XA
 ////////////////////////////////////////////////////////////////////////
 
-inline void MixXA(void)
+inline void PS2SPU::MixXA(void)
 {
  int ns;
 
@@ -90,7 +70,7 @@ inline void MixXA(void)
 // FEED XA
 ////////////////////////////////////////////////////////////////////////
 
-inline void FeedXA(xa_decode_t *xap)
+inline void PS2SPU::FeedXA(xa_decode_t *xap)
 {
  int sinc,spos,i,iSize,iPlace,vl,vr;
 
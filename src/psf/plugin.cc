@@ -37,8 +37,7 @@
 #include "corlett.h"
 #include "psx.h"
 
-#include "peops/spu.h"
-#include "peops2/spu.h"
+#include "../render-cache-common/rendercache.h"
 
 class PSFPlugin : public InputPlugin
 {
@@ -59,13 +58,14 @@ public:
         .with_exts(exts)) {}
 
     bool init() override;
+    void cleanup() override;
 
     bool is_our_file(const char *filename, VFSFile &file) override;
     bool read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *image) override;
     bool play(const char *filename, VFSFile &file) override;
 
 protected:
-    static void update(const void *data, int bytes);
+    static void update(const void *data, int bytes, void *user);
 };
 
 EXPORT PSFPlugin aud_plugin_instance;
@@ -79,17 +79,17 @@ typedef enum {
 } PSFEngine;
 
 typedef struct {
-    int32_t (*start)(uint8_t *buffer, uint32_t length);
-    int32_t (*stop)(void);
-    int32_t (*seek)(uint32_t);
-    int32_t (*execute)(void (*update)(const void *, int));
+    int32_t (PSXMachine::*start)(uint8_t *buffer, uint32_t length);
+    int32_t (PSXMachine::*stop)(void);
+    int32_t (PSXMachine::*seek)(uint32_t);
+    int32_t (PSXMachine::*execute)(void (*update)(const void *, int, void *), void *user);
 } PSFEngineFunctors;
 
-static PSFEngineFunctors psf_functor_map[ENG_COUNT] = {
+static const PSFEngineFunctors psf_functor_map[ENG_COUNT] = {
     {nullptr, nullptr, nullptr, nullptr},
-    {psf_start, psf_stop, psf_seek, psf_execute},
-    {psf2_start, psf2_stop, psf2_seek, psf2_execute},
-    {spx_start, spx_stop, psf_seek, spx_execute},
+    {&PSXMachine::psf_start, &PSXMachine::psf_stop, &PSXMachine::psf_seek, &PSXMachine::psf_execute},
+    {&PSXMachine::psf2_start, &PSXMachine::psf2_stop, &PSXMachine::psf2_seek, &PSXMachine::psf2_execute},
+    {&PSXMachine::spx_start, &PSXMachine::spx_stop, &PSXMachine::psf_seek, &PSXMachine::spx_execute},
 };
 
 const char* const PSFPlugin::defaults[] =
@@ -101,18 +101,31 @@ const char* const PSFPlugin::defaults[] =
 bool PSFPlugin::init()
 {
     aud_config_set_defaults("psf", defaults);
+    render_cache_init();
     return true;
 }
 
-static PSFEngineFunctors *f;
-static String dirpath;
+void PSFPlugin::cleanup()
+{
+    render_cache_cleanup();
+}
+
+/* The state of a song being played.  Like the emulated machine, it belongs to
+ * the call to play(), so that songs can be played (or rendered) on several
+ * threads at once. */
+struct PSFPlayback
+{
+    const PSFEngineFunctors *f;
+    PSXMachine *machine;
 
-bool stop_flag = false;
+    /* The emulation engine can only seek forward, not back.  This is set to a
+     * non-negative time (milliseconds) when the song is to be restarted in
+     * order to seek backward. */
+    int reverse_seek;
 
-/* The emulation engine can only seek forward, not back.  This variable is set
- * a non-negative time (milliseconds) when the song is to be restarted in order
- * to seek backward. */
-static int reverse_seek;
+    /* Set while a song is being recorded into the render cache as it plays. */
+    RenderCacheWriter *recorder;
+};
 
 static PSFEngine psf_probe(const char *buf, int len)
 {
@@ -135,12 +148,130 @@ static PSFEngine psf_probe(const char *buf, int len)
 }
 
 /* ao_get_lib: called to load secondary files */
-Index<char> ao_get_lib(char *filename)
+Index<char> ao_get_lib(const char *dirpath, char *filename)
 {
     VFSFile file(filename_build({dirpath, filename}), "r");
     return file ? file.read_all() : Index<char>();
 }
 
+static String dir_of(const char *filename)
+{
+    const char * slash = strrchr (filename, '/');
+    return slash ? String (str_copy (filename, slash + 1 - filename)) : String ();
+}
+
+/* the PSX/PS2 cores and the SPU in this directory */
+static const char engine_version[] = "openpsf-1";
+
+/* The render cache key covers the libraries as well as the file itself, since
+ * a minipsf is often little more than a track number.  Songs without a length
+ * (or played with the length ignored) never end, so they are not cached. */
+static String cache_key(const char *dirpath, Index<char> &buf)
+{
+    if (!render_cache_enabled() || aud_get_bool("psf", "ignore_length"))
+        return String();
+
+    corlett_t *c;
+    if (corlett_decode((uint8_t *)buf.begin(), buf.len(), nullptr, nullptr, &c) != AO_SUCCESS)
+        return String();
+
+    String key;
+
+    if (psfTimeToMS(c->inf_length) > 0)
+    {
+        Index<char> data;
+        data.insert(buf.begin(), 0, buf.len());
+
+        auto add_lib = [&data, dirpath](char *name) {
+            if (name[0])
+            {
+                Index<char> lib = ao_get_lib(dirpath, name);
+                data.move_from(lib, 0, -1, -1, true, false);
+            }
+        };
+
+        add_lib(c->lib);
+        for (auto &lib : c->libaux)
+            add_lib(lib);
+
+        key = render_cache_key("psf", engine_version, data, "");
+    }
+
+    free(c);
+    return key;
+}
+
+/* Creates a machine, ready to start the given engine. */
+static SmartPtr<PSXMachine> new_machine(PSFEngine eng, const String &dir, bool endless)
+{
+    SmartPtr<PSXMachine> machine = SmartNew<PSXMachine>();
+    machine->dirpath = dir;
+
+    if(eng == ENG_PSF1 || eng == ENG_SPX)
+        machine->setendless(endless);
+
+    if(eng == ENG_PSF2)
+        machine->setendless2(endless);
+
+    return machine;
+}
+
+/* The job emulates a machine of its own, so it does not disturb playback. */
+class PSFRenderJob : public RenderCacheJob
+{
+public:
+    PSFRenderJob(PSFEngine eng, const String &dir, Index<char> &&buf) :
+        m_eng(eng), m_dir(dir), m_buf(std::move(buf)) {}
+
+    bool render(RenderCacheWriter &writer) override;
+
+private:
+    static void update(const void *data, int bytes, void *user);
+
+    PSFEngine m_eng;
+    String m_dir;
+    Index<char> m_buf;
+
+    PSXMachine *m_machine = nullptr;
+    RenderCacheWriter *m_writer = nullptr;
+};
+
+bool PSFRenderJob::render(RenderCacheWriter &writer)
+{
+    const PSFEngineFunctors *engine = &psf_functor_map[m_eng];
+    SmartPtr<PSXMachine> machine = new_machine(m_eng, m_dir, false);
+
+    bool success = false;
+
+    if ((machine.get()->*engine->start)((uint8_t *)m_buf.begin(), m_buf.len()) == AO_SUCCESS)
+    {
+        m_machine = machine.get();
+        m_writer = &writer;
+
+        (machine.get()->*engine->execute)(update, this);
+        (machine.get()->*engine->stop)();
+
+        m_machine = nullptr;
+        m_writer = nullptr;
+        success = !RenderCacheWriter::cancelled();
+    }
+
+    return success;
+}
+
+void PSFRenderJob::update(const void *data, int bytes, void *user)
+{
+    auto job = (PSFRenderJob *)user;
+
+    if (!data || RenderCacheWriter::cancelled())
+    {
+        job->m_machine->stop_flag = true;
+        return;
+    }
+
+    job->m_writer->write((const int16_t *)data, bytes / 4);
+}
+
 bool PSFPlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *image)
 {
     Index<char> buf = file.read_all ();
@@ -165,75 +296,101 @@ bool PSFPlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Inde
     return true;
 }
 
+static void prerender_add(const char *filename)
+{
+    VFSFile file(filename, "r");
+    if (!file)
+        return;
+
+    Index<char> buf = file.read_all();
+
+    PSFEngine eng = psf_probe(buf.begin(), buf.len());
+    if (eng == ENG_NONE || eng == ENG_COUNT)
+        return;
+
+    String key = cache_key(dir_of(filename), buf);
+    if (key)
+        render_cache_prerender(key, 2, 44100,
+         new PSFRenderJob(eng, dir_of(filename), std::move(buf)));
+}
+
 bool PSFPlugin::play(const char *filename, VFSFile &file)
 {
     bool error = false;
+    RenderCacheWriter writer;
+    PSFPlayback playback;
 
-    const char * slash = strrchr (filename, '/');
-    if (! slash)
+    if (! strrchr (filename, '/'))
         return false;
 
-    dirpath = String (str_copy (filename, slash + 1 - filename));
+    String dirpath = dir_of (filename);
 
     Index<char> buf = file.read_all ();
+    String key = cache_key(dirpath, buf);
 
     bool ignore_len = aud_get_bool("psf", "ignore_length");
 
     PSFEngine eng = psf_probe(buf.begin(), buf.len());
     if (eng == ENG_NONE || eng == ENG_COUNT)
-    {
-        error = true;
-        goto cleanup;
-    }
+        return false;
 
-    if(eng == ENG_PSF1 || eng == ENG_SPX)
-        setendless(ignore_len);
+    render_cache_prerender_next(this, filename, prerender_add);
 
-    if(eng == ENG_PSF2)
-        setendless2(ignore_len);
+    if (key)
+    {
+        if (render_cache_play(key, 2, 44100))
+            return true;
 
-    f = &psf_functor_map[eng];
+        writer.open(key, 2, 44100);
+    }
+
+    playback.f = &psf_functor_map[eng];
+    playback.recorder = writer.is_open() ? &writer : nullptr;
+    playback.reverse_seek = -1;
 
     set_stream_bitrate(44100*2*2*8);
     open_audio(FMT_S16_NE, 44100, 2);
 
-    reverse_seek = -1;
-
     /* This loop will restart playback from the beginning when necessary to seek
-     * backwards in the file (reverse_seek >= 0). */
+     * backwards in the file (reverse_seek >= 0).  Each pass gets a new machine,
+     * which is freed when the pass ends. */
     do
     {
-        if (f->start((uint8_t *)buf.begin(), buf.len()) != AO_SUCCESS)
+        SmartPtr<PSXMachine> machine = new_machine(eng, dirpath, ignore_len);
+        playback.machine = machine.get();
+
+        if ((machine.get()->*playback.f->start)((uint8_t *)buf.begin(), buf.len()) != AO_SUCCESS)
         {
             error = true;
-            goto cleanup;
+            break;
         }
 
-        if (reverse_seek >= 0)
+        if (playback.reverse_seek >= 0)
         {
-            f->seek(reverse_seek); /* should never fail here */
-            reverse_seek = -1;
+            (machine.get()->*playback.f->seek)(playback.reverse_seek); /* should never fail here */
+            playback.reverse_seek = -1;
         }
 
-        stop_flag = false;
-
-        f->execute(update);
-        f->stop();
+        (machine.get()->*playback.f->execute)(update, &playback);
+        (machine.get()->*playback.f->stop)();
     }
-    while (reverse_seek >= 0);
-
-cleanup:
-    f = nullptr;
-    dirpath = String ();
+    while (playback.reverse_seek >= 0);
 
     return ! error;
 }
 
-void PSFPlugin::update(const void *data, int bytes)
+void PSFPlugin::update(const void *data, int bytes, void *user)
 {
+    auto playback = (PSFPlayback *)user;
+
     if (!data || check_stop())
     {
-        stop_flag = true;
+        /* only a song played to the end goes into the cache */
+        if (playback->recorder && !data)
+            playback->recorder->finish();
+
+        playback->recorder = nullptr;
+        playback->machine->stop_flag = true;
         return;
     }
 
@@ -241,16 +398,21 @@ void PSFPlugin::update(const void *data, int bytes)
 
     if (seek >= 0)
     {
-        if (!f->seek(seek))
+        playback->recorder = nullptr;
+
+        if (!(playback->machine->*playback->f->seek)(seek))
         {
-            reverse_seek = seek;
-            stop_flag = true;
+            playback->reverse_seek = seek;
+            playback->machine->stop_flag = true;
         }
 
         return;
     }
 
     write_audio(data, bytes);
+
+    if (playback->recorder)
+        playback->recorder->write((const int16_t *)data, bytes / 4);
 }
 
 bool PSFPlugin::is_our_file(const char *filename, VFSFile &file)
@@ -267,6 +429,7 @@ const char *const PSFPlugin::exts[] = { "psf", "minipsf", "psf2", "minipsf2", "s
 const PreferencesWidget PSFPlugin::widgets[] = {
     WidgetLabel(N_("<b>OpenPSF Configuration</b>")),
     WidgetCheck(N_("Ignore length from file"), WidgetBool("psf", "ignore_length")),
+    WidgetBox({{render_cache_widgets}})
 };
 
 const PluginPreferences PSFPlugin::prefs = {{widgets}};
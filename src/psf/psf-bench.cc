@@ -0,0 +1,200 @@
+/*
+ * PSF/PSF2 Emulation Benchmark
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Emulates a fixed amount of audio from each file of a corpus and reports how
+ * much faster than real time the engine runs.  The files are given on the
+ * command line or found in the directory named by PSF_BENCH_DIR, so that
+ * "meson test --benchmark" can be pointed at a local collection. */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/objects.h>
+
+#include "ao.h"
+#include "psx.h"
+
+#define SECONDS 60
+#define BYTES_PER_SECOND (44100 * 2 * 2)
+
+static int64_t bytes_done;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static Index<char> read_file(const char *path)
+{
+    Index<char> buf;
+    FILE *handle = fopen(path, "rb");
+    if (!handle)
+        return buf;
+
+    fseek(handle, 0, SEEK_END);
+    long len = ftell(handle);
+    fseek(handle, 0, SEEK_SET);
+
+    buf.resize(len);
+    if (fread(buf.begin(), 1, len, handle) != (size_t)len)
+        buf.clear();
+
+    fclose(handle);
+    return buf;
+}
+
+/* ao_get_lib: called to load secondary files */
+Index<char> ao_get_lib(const char *dirpath, char *filename)
+{
+    char path[8192];
+    snprintf(path, sizeof path, "%s%s", dirpath, filename);
+    return read_file(path);
+}
+
+static void update(const void *data, int bytes, void *user)
+{
+    auto machine = (PSXMachine *)user;
+
+    if (!data)
+    {
+        machine->stop_flag = true;
+        return;
+    }
+
+    bytes_done += bytes;
+    if (bytes_done >= (int64_t)SECONDS * BYTES_PER_SECOND)
+        machine->stop_flag = true;
+}
+
+/* returns the emulated time in seconds, or -1 */
+static double run(const char *path, double &elapsed)
+{
+    Index<char> buf = read_file(path);
+    if (buf.len() < 4)
+        return -1;
+
+    SmartPtr<PSXMachine> machine = SmartNew<PSXMachine>();
+
+    const char *slash = strrchr(path, '/');
+    int dirlen = slash ? slash + 1 - path : 0;
+    machine->dirpath = String(str_copy(path, dirlen));
+
+    int32_t (PSXMachine::*start)(uint8_t *, uint32_t);
+    int32_t (PSXMachine::*execute)(void (*)(const void *, int, void *), void *);
+    int32_t (PSXMachine::*stop)(void);
+
+    if (!memcmp(buf.begin(), "PSF\x01", 4))
+    {
+        start = &PSXMachine::psf_start, execute = &PSXMachine::psf_execute, stop = &PSXMachine::psf_stop;
+        machine->setendless(true);
+    }
+    else if (!memcmp(buf.begin(), "PSF\x02", 4))
+    {
+        start = &PSXMachine::psf2_start, execute = &PSXMachine::psf2_execute, stop = &PSXMachine::psf2_stop;
+        machine->setendless2(true);
+    }
+    else
+        return -1;
+
+    if ((machine.get()->*start)((uint8_t *)buf.begin(), buf.len()) != AO_SUCCESS)
+        return -1;
+
+    bytes_done = 0;
+
+    double begin = now();
+    (machine.get()->*execute)(update, machine.get());
+    elapsed = now() - begin;
+
+    (machine.get()->*stop)();
+
+    return (double)bytes_done / BYTES_PER_SECOND;
+}
+
+static bool is_psf(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    return ext && (!strcmp(ext, ".psf") || !strcmp(ext, ".minipsf") ||
+                   !strcmp(ext, ".psf2") || !strcmp(ext, ".minipsf2"));
+}
+
+int main(int argc, char **argv)
+{
+    Index<String> files;
+
+    for (int i = 1; i < argc; i++)
+        files.append(String(argv[i]));
+
+    const char *dir = getenv("PSF_BENCH_DIR");
+    DIR *handle = (!files.len() && dir) ? opendir(dir) : nullptr;
+
+    if (handle)
+    {
+        struct dirent *entry;
+        while ((entry = readdir(handle)))
+        {
+            if (is_psf(entry->d_name))
+                files.append(String(str_printf("%s/%s", dir, entry->d_name)));
+        }
+
+        closedir(handle);
+    }
+
+    if (!files.len())
+    {
+        printf("No files given; pass PSF/PSF2 files or set PSF_BENCH_DIR.\n");
+        return 77; /* skipped */
+    }
+
+    double total_audio = 0, total_elapsed = 0;
+
+    printf("%-40s %10s %10s %8s\n", "file", "audio", "cpu", "speed");
+
+    for (const String &file : files)
+    {
+        double elapsed = 0;
+        double audio = run(file, elapsed);
+
+        const char *name = strrchr(file, '/');
+        name = name ? name + 1 : (const char *)file;
+
+        if (audio < 0)
+        {
+            printf("%-40.40s failed to load\n", name);
+            continue;
+        }
+
+        printf("%-40.40s %8.1f s %8.2f s %7.1fx\n", name, audio, elapsed,
+               audio / elapsed);
+
+        total_audio += audio;
+        total_elapsed += elapsed;
+    }
+
+    if (total_elapsed > 0)
+        printf("%-40s %8.1f s %8.2f s %7.1fx\n", "total", total_audio,
+               total_elapsed, total_audio / total_elapsed);
+
+    return 0;
+}
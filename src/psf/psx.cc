@@ -147,26 +147,6 @@ static uint8_t mips_win_layout[] = {
 
 #define REGPC ( 32 )
 
-typedef struct
-{
-	uint32_t op;
-	uint32_t pc;
-	uint32_t prevpc;
-	uint32_t delayv;
-	uint32_t delayr;
-	uint32_t hi;
-	uint32_t lo;
-	uint32_t r[ 32 ];
-	uint32_t cp0r[ 32 ];
-	PAIR cp2cr[ 32 ];
-	PAIR cp2dr[ 32 ];
-	int (*irq_callback)(int irqline);
-} mips_cpu_context;
-
-static mips_cpu_context mipscpu;
-
-static int mips_ICount = 0;
-
 static uint32_t mips_mtc0_writemask[]=
 {
 	0xffffffff, /* INDEX */
@@ -204,7 +184,7 @@ static uint32_t mips_mtc0_writemask[]=
 };
 
 #if 1
-static void GTELOG(const char *a,...)
+void PSXMachine::GTELOG(const char *a,...)
 {
 	va_list va;
 	char s_text[ 1024 ];
@@ -214,16 +194,9 @@ static void GTELOG(const char *a,...)
 	logerror( "%08x: GTE: %08x %s\n", mipscpu.pc, INS_COFUN( mipscpu.op ), s_text );
 }
 #else
-static inline void GTELOG(const char *a, ...) {}
+void PSXMachine::GTELOG(const char *a, ...) {}
 #endif
 
-static uint32_t getcp2dr( int n_reg );
-static void setcp2dr( int n_reg, uint32_t n_value );
-static uint32_t getcp2cr( int n_reg );
-static void setcp2cr( int n_reg, uint32_t n_value );
-static void docop2( int gteop );
-static void mips_exception( int exception );
-
 static void mips_stop( void )
 {
 #ifdef MAME_DEBUG
@@ -233,7 +206,7 @@ static void mips_stop( void )
 #endif
 }
 
-static inline void mips_set_cp0r( int reg, uint32_t value )
+void PSXMachine::mips_set_cp0r( int reg, uint32_t value )
 {
 	mipscpu.cp0r[ reg ] = value;
 	if( reg == CP0_SR || reg == CP0_CAUSE )
@@ -250,7 +223,7 @@ static inline void mips_set_cp0r( int reg, uint32_t value )
 	}
 }
 
-static inline void mips_commit_delayed_load( void )
+void PSXMachine::mips_commit_delayed_load( void )
 {
 	if( mipscpu.delayr != 0 )
 	{
@@ -260,7 +233,7 @@ static inline void mips_commit_delayed_load( void )
 	}
 }
 
-static inline void mips_delayed_branch( uint32_t n_adr )
+void PSXMachine::mips_delayed_branch( uint32_t n_adr )
 {
 	if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 3 ) ) != 0 )
 	{
@@ -276,7 +249,7 @@ static inline void mips_delayed_branch( uint32_t n_adr )
 	}
 }
 
-static inline void mips_set_pc( unsigned val )
+void PSXMachine::mips_set_pc( unsigned val )
 {
 	mipscpu.pc = val;
 	change_pc( val );
@@ -284,7 +257,7 @@ static inline void mips_set_pc( unsigned val )
 	mipscpu.delayv = 0;
 }
 
-static inline void mips_advance_pc( void )
+void PSXMachine::mips_advance_pc( void )
 {
 	if( mipscpu.delayr == REGPC )
 	{
@@ -297,7 +270,7 @@ static inline void mips_advance_pc( void )
 	}
 }
 
-static inline void mips_load( uint32_t n_r, uint32_t n_v )
+void PSXMachine::mips_load( uint32_t n_r, uint32_t n_v )
 {
 	mips_advance_pc();
 	if( n_r != 0 )
@@ -306,7 +279,7 @@ static inline void mips_load( uint32_t n_r, uint32_t n_v )
 	}
 }
 
-static inline void mips_delayed_load( uint32_t n_r, uint32_t n_v )
+void PSXMachine::mips_delayed_load( uint32_t n_r, uint32_t n_v )
 {
 	if( mipscpu.delayr == REGPC )
 	{
@@ -325,7 +298,7 @@ static inline void mips_delayed_load( uint32_t n_r, uint32_t n_v )
 	}
 }
 
-static void mips_exception( int exception )
+void PSXMachine::mips_exception( int exception )
 {
 	mips_set_cp0r( CP0_SR, ( mipscpu.cp0r[ CP0_SR ] & ~0x3f ) | ( ( mipscpu.cp0r[ CP0_SR ] << 2 ) & 0x3f ) );
 	if( mipscpu.delayr == REGPC )
@@ -349,7 +322,81 @@ static void mips_exception( int exception )
 	}
 }
 
-void mips_init( void )
+#define LE32(x) FROM_LE32(x)
+
+/* Main RAM (2 MB, mirrored through the first 8 MB of KUSEG and KSEG0) holds
+ * nearly all code and data, so the CPU accesses it directly and only goes
+ * through the psx_hw handlers for everything else.  This includes every
+ * instruction fetch. */
+#define IS_RAM( address ) ( ( ( address ) & 0x7f800000 ) == 0 )
+#define RAM_WORD( address ) psx_ram[ ( ( address ) & 0x1fffff ) >> 2 ]
+
+uint8_t PSXMachine::mips_read_byte( offs_t address )
+{
+	if( IS_RAM( address ) )
+	{
+		return LE32( RAM_WORD( address ) ) >> ( ( address & 3 ) * 8 );
+	}
+	return program_read_byte_32le( address );
+}
+
+uint16_t PSXMachine::mips_read_word( offs_t address )
+{
+	if( IS_RAM( address ) )
+	{
+		return LE32( RAM_WORD( address ) ) >> ( ( address & 2 ) * 8 );
+	}
+	return program_read_word_32le( address );
+}
+
+uint32_t PSXMachine::mips_read_dword( offs_t address )
+{
+	if( IS_RAM( address ) )
+	{
+		return LE32( RAM_WORD( address ) );
+	}
+	return program_read_dword_32le( address );
+}
+
+void PSXMachine::mips_write_masked( offs_t address, uint32_t data, uint32_t mem_mask )
+{
+	uint32_t *word = &RAM_WORD( address );
+	*word = ( *word & LE32( mem_mask ) ) | LE32( data );
+}
+
+void PSXMachine::mips_write_byte( offs_t address, uint8_t data )
+{
+	if( IS_RAM( address ) )
+	{
+		int shift = ( address & 3 ) * 8;
+		mips_write_masked( address, (uint32_t)data << shift, ~( 0xffU << shift ) );
+		return;
+	}
+	program_write_byte_32le( address, data );
+}
+
+void PSXMachine::mips_write_word( offs_t address, uint16_t data )
+{
+	if( IS_RAM( address ) )
+	{
+		int shift = ( address & 2 ) * 8;
+		mips_write_masked( address, (uint32_t)data << shift, ~( 0xffffU << shift ) );
+		return;
+	}
+	program_write_word_32le( address, data );
+}
+
+void PSXMachine::mips_write_dword( offs_t address, uint32_t data )
+{
+	if( IS_RAM( address ) )
+	{
+		RAM_WORD( address ) = LE32( data );
+		return;
+	}
+	program_write_dword_32le( address, data );
+}
+
+void PSXMachine::mips_init( void )
 {
 #if 0
 	int cpu = cpu_getactivecpu();
@@ -367,7 +414,7 @@ void mips_init( void )
 #endif
 }
 
-void mips_reset( void *param )
+void PSXMachine::mips_reset( void *param )
 {
 	mips_set_cp0r( CP0_SR, ( mipscpu.cp0r[ CP0_SR ] & ~( SR_TS | SR_SWC | SR_KUC | SR_IEC ) ) | SR_BEV );
 	mips_set_cp0r( CP0_RANDOM, 63 ); /* todo: */
@@ -376,458 +423,437 @@ void mips_reset( void *param )
 	mipscpu.prevpc = 0xffffffff;
 }
 
-static void mips_exit( void )
-{
-}
-
-void mips_shorten_frame(void)
+void PSXMachine::mips_shorten_frame(void)
 {
 	mips_ICount = 0;
 }
 
-void psx_hw_runcounters(void);
-
-int psxcpu_verbose = 0;
-
-int mips_execute( int cycles )
+/* executes mipscpu.op, the instruction at mipscpu.pc */
+void PSXMachine::mips_interpret( void )
 {
 	uint32_t n_res;
 
-	mips_ICount = cycles;
-	do
+	switch( INS_OP( mipscpu.op ) )
 	{
-//		CALL_MAME_DEBUG;
-
-//		psx_hw_runcounters();
-
-		mipscpu.op = cpu_readop32( mipscpu.pc );
-
-#if 0
-		while (mipscpu.prevpc == mipscpu.pc)
-		{
-			psx_hw_runcounters();
-			mips_ICount--;
-
-			if (mips_ICount == 0) return cycles;
-		}
-#endif
-
-		// if we're not in a delay slot, update
-		// if we're in a delay slot and the delay instruction is not NOP, update
-		if (( mipscpu.delayr == 0 ) || ((mipscpu.delayr != 0) && (mipscpu.op != 0)))
+	case OP_SPECIAL:
+		switch( INS_FUNCT( mipscpu.op ) )
 		{
-			mipscpu.prevpc = mipscpu.pc;
-		}
-#if 0
-		if (1) //psxcpu_verbose)
-		{
-			printf("[%08x: %08x] [SP %08x RA %08x V0 %08x V1 %08x A0 %08x S0 %08x S1 %08x]\n", mipscpu.pc, mipscpu.op, mipscpu.r[29], mipscpu.r[31], mipscpu.r[2], mipscpu.r[3], mipscpu.r[4], mipscpu.r[ 16 ], mipscpu.r[ 17 ]);
-//			psxcpu_verbose--;
-		}
-#endif
-		switch( INS_OP( mipscpu.op ) )
-		{
-		case OP_SPECIAL:
-			switch( INS_FUNCT( mipscpu.op ) )
-			{
-			case FUNCT_HLECALL:
+		case FUNCT_HLECALL:
 //				printf("HLECALL, PC = %08x\n", mipscpu.pc);
-				psx_bios_hle(mipscpu.pc);
-				break;
-			case FUNCT_SLL:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] << INS_SHAMT( mipscpu.op ) );
-				break;
-			case FUNCT_SRL:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] >> INS_SHAMT( mipscpu.op ) );
-				break;
-			case FUNCT_SRA:
-				mips_load( INS_RD( mipscpu.op ), (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ] >> INS_SHAMT( mipscpu.op ) );
-				break;
-			case FUNCT_SLLV:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] << ( mipscpu.r[ INS_RS( mipscpu.op ) ] & 31 ) );
-				break;
-			case FUNCT_SRLV:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] >> ( mipscpu.r[ INS_RS( mipscpu.op ) ] & 31 ) );
-				break;
-			case FUNCT_SRAV:
-				mips_load( INS_RD( mipscpu.op ), (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ] >> ( mipscpu.r[ INS_RS( mipscpu.op ) ] & 31 ) );
-				break;
-			case FUNCT_JR:
-				if( INS_RD( mipscpu.op ) != 0 )
-				{
-					mips_exception( EXC_RI );
-				}
-				else
-				{
-					mips_delayed_branch( mipscpu.r[ INS_RS( mipscpu.op ) ] );
-				}
-				break;
-			case FUNCT_JALR:
-				n_res = mipscpu.pc + 8;
-				mips_delayed_branch( mipscpu.r[ INS_RS( mipscpu.op ) ] );
-				if( INS_RD( mipscpu.op ) != 0 )
-				{
-					mipscpu.r[ INS_RD( mipscpu.op ) ] = n_res;
-				}
-				break;
-			case FUNCT_SYSCALL:
-				mips_exception( EXC_SYS );
-				break;
-			case FUNCT_BREAK:
-				printf("BREAK!\n");
-				exit(-1);
-//				mips_exception( EXC_BP );
-				mips_advance_pc();
-				break;
-			case FUNCT_MFHI:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.hi );
-				break;
-			case FUNCT_MTHI:
-				if( INS_RD( mipscpu.op ) != 0 )
-				{
-					mips_exception( EXC_RI );
-				}
-				else
-				{
-					mips_advance_pc();
-					mipscpu.hi = mipscpu.r[ INS_RS( mipscpu.op ) ];
-				}
-				break;
-			case FUNCT_MFLO:
-				mips_load( INS_RD( mipscpu.op ),  mipscpu.lo );
-				break;
-			case FUNCT_MTLO:
-				if( INS_RD( mipscpu.op ) != 0 )
-				{
-					mips_exception( EXC_RI );
-				}
-				else
-				{
-					mips_advance_pc();
-					mipscpu.lo = mipscpu.r[ INS_RS( mipscpu.op ) ];
-				}
-				break;
-			case FUNCT_MULT:
-				if( INS_RD( mipscpu.op ) != 0 )
-				{
-					mips_exception( EXC_RI );
-				}
-				else
-				{
-					int64_t n_res64;
-					n_res64 = MUL_64_32_32( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ], (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ] );
-					mips_advance_pc();
-					mipscpu.lo = LO32_32_64( n_res64 );
-					mipscpu.hi = HI32_32_64( n_res64 );
-				}
-				break;
-			case FUNCT_MULTU:
-				if( INS_RD( mipscpu.op ) != 0 )
-				{
-					mips_exception( EXC_RI );
-				}
-				else
-				{
-					uint64_t n_res64;
-					n_res64 = MUL_U64_U32_U32( mipscpu.r[ INS_RS( mipscpu.op ) ], mipscpu.r[ INS_RT( mipscpu.op ) ] );
-					mips_advance_pc();
-					mipscpu.lo = LO32_U32_U64( n_res64 );
-					mipscpu.hi = HI32_U32_U64( n_res64 );
-				}
-				break;
-			case FUNCT_DIV:
-				if( INS_RD( mipscpu.op ) != 0 )
-				{
-					mips_exception( EXC_RI );
-				}
-				else
-				{
-					uint32_t n_div;
-					uint32_t n_mod;
-					if( mipscpu.r[ INS_RT( mipscpu.op ) ] != 0 )
-					{
-						n_div = (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] / (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ];
-						n_mod = (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] % (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ];
-						mips_advance_pc();
-						mipscpu.lo = n_div;
-						mipscpu.hi = n_mod;
-					}
-					else
-					{
-						mips_advance_pc();
-					}
-				}
-				break;
-			case FUNCT_DIVU:
-				if( INS_RD( mipscpu.op ) != 0 )
-				{
-					mips_exception( EXC_RI );
-				}
-				else
-				{
-					uint32_t n_div;
-					uint32_t n_mod;
-					if( mipscpu.r[ INS_RT( mipscpu.op ) ] != 0 )
-					{
-						n_div = mipscpu.r[ INS_RS( mipscpu.op ) ] / mipscpu.r[ INS_RT( mipscpu.op ) ];
-						n_mod = mipscpu.r[ INS_RS( mipscpu.op ) ] % mipscpu.r[ INS_RT( mipscpu.op ) ];
-						mips_advance_pc();
-						mipscpu.lo = n_div;
-						mipscpu.hi = n_mod;
-					}
-					else
-					{
-						mips_advance_pc();
-					}
-				}
-				break;
-			case FUNCT_ADD:
-				{
-					n_res = mipscpu.r[ INS_RS( mipscpu.op ) ] + mipscpu.r[ INS_RT( mipscpu.op ) ];
-					if( (int32_t)( ~( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ mipscpu.r[ INS_RT( mipscpu.op ) ] ) & ( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ n_res ) ) < 0 )
-					{
-						mips_exception( EXC_OVF );
-					}
-					else
-					{
-						mips_load( INS_RD( mipscpu.op ), n_res );
-					}
-				}
-				break;
-			case FUNCT_ADDU:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] + mipscpu.r[ INS_RT( mipscpu.op ) ] );
-				break;
-			case FUNCT_SUB:
-				n_res = mipscpu.r[ INS_RS( mipscpu.op ) ] - mipscpu.r[ INS_RT( mipscpu.op ) ];
-				if( (int32_t)( ( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ mipscpu.r[ INS_RT( mipscpu.op ) ] ) & ( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ n_res ) ) < 0 )
-				{
-					mips_exception( EXC_OVF );
-				}
-				else
-				{
-					mips_load( INS_RD( mipscpu.op ), n_res );
-				}
-				break;
-			case FUNCT_SUBU:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] - mipscpu.r[ INS_RT( mipscpu.op ) ] );
-				break;
-			case FUNCT_AND:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] & mipscpu.r[ INS_RT( mipscpu.op ) ] );
-				break;
-			case FUNCT_OR:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] | mipscpu.r[ INS_RT( mipscpu.op ) ] );
-				break;
-			case FUNCT_XOR:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] ^ mipscpu.r[ INS_RT( mipscpu.op ) ] );
-				break;
-			case FUNCT_NOR:
-				mips_load( INS_RD( mipscpu.op ), ~( mipscpu.r[ INS_RS( mipscpu.op ) ] | mipscpu.r[ INS_RT( mipscpu.op ) ] ) );
-				break;
-			case FUNCT_SLT:
-				mips_load( INS_RD( mipscpu.op ), (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] < (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ] );
-				break;
-			case FUNCT_SLTU:
-				mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] < mipscpu.r[ INS_RT( mipscpu.op ) ] );
-				break;
-			default:
+			psx_bios_hle(mipscpu.pc);
+			break;
+		case FUNCT_SLL:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] << INS_SHAMT( mipscpu.op ) );
+			break;
+		case FUNCT_SRL:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] >> INS_SHAMT( mipscpu.op ) );
+			break;
+		case FUNCT_SRA:
+			mips_load( INS_RD( mipscpu.op ), (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ] >> INS_SHAMT( mipscpu.op ) );
+			break;
+		case FUNCT_SLLV:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] << ( mipscpu.r[ INS_RS( mipscpu.op ) ] & 31 ) );
+			break;
+		case FUNCT_SRLV:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] >> ( mipscpu.r[ INS_RS( mipscpu.op ) ] & 31 ) );
+			break;
+		case FUNCT_SRAV:
+			mips_load( INS_RD( mipscpu.op ), (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ] >> ( mipscpu.r[ INS_RS( mipscpu.op ) ] & 31 ) );
+			break;
+		case FUNCT_JR:
+			if( INS_RD( mipscpu.op ) != 0 )
+			{
 				mips_exception( EXC_RI );
-				break;
+			}
+			else
+			{
+				mips_delayed_branch( mipscpu.r[ INS_RS( mipscpu.op ) ] );
 			}
 			break;
-		case OP_REGIMM:
-			switch( INS_RT( mipscpu.op ) )
+		case FUNCT_JALR:
+			n_res = mipscpu.pc + 8;
+			mips_delayed_branch( mipscpu.r[ INS_RS( mipscpu.op ) ] );
+			if( INS_RD( mipscpu.op ) != 0 )
 			{
-			case RT_BLTZ:
-				if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] < 0 )
-				{
-					mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
-				}
-				else
-				{
-					mips_advance_pc();
-				}
-				break;
-			case RT_BGEZ:
-				if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] >= 0 )
-				{
-					mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
-				}
-				else
-				{
-					mips_advance_pc();
-				}
-				break;
-			case RT_BLTZAL:
-				n_res = mipscpu.pc + 8;
-				if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] < 0 )
-				{
-					mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
-				}
-				else
-				{
-					mips_advance_pc();
-				}
-				mipscpu.r[ 31 ] = n_res;
-				break;
-			case RT_BGEZAL:
-				n_res = mipscpu.pc + 8;
-				if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] >= 0 )
-				{
-					mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
-				}
-				else
-				{
-					mips_advance_pc();
-				}
-				mipscpu.r[ 31 ] = n_res;
-				break;
+				mipscpu.r[ INS_RD( mipscpu.op ) ] = n_res;
 			}
 			break;
-		case OP_J:
-			mips_delayed_branch( ( ( mipscpu.pc + 4 ) & 0xf0000000 ) + ( INS_TARGET( mipscpu.op ) << 2 ) );
+		case FUNCT_SYSCALL:
+			mips_exception( EXC_SYS );
 			break;
-		case OP_JAL:
-			n_res = mipscpu.pc + 8;
-			mips_delayed_branch( ( ( mipscpu.pc + 4 ) & 0xf0000000 ) + ( INS_TARGET( mipscpu.op ) << 2 ) );
-			mipscpu.r[ 31 ] = n_res;
+		case FUNCT_BREAK:
+			printf("BREAK!\n");
+			exit(-1);
+//				mips_exception( EXC_BP );
+			mips_advance_pc();
 			break;
-		case OP_BEQ:
-			if( mipscpu.r[ INS_RS( mipscpu.op ) ] == mipscpu.r[ INS_RT( mipscpu.op ) ] )
+		case FUNCT_MFHI:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.hi );
+			break;
+		case FUNCT_MTHI:
+			if( INS_RD( mipscpu.op ) != 0 )
 			{
-				mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+				mips_exception( EXC_RI );
 			}
 			else
 			{
 				mips_advance_pc();
+				mipscpu.hi = mipscpu.r[ INS_RS( mipscpu.op ) ];
 			}
 			break;
-		case OP_BNE:
-			if( mipscpu.r[ INS_RS( mipscpu.op ) ] != mipscpu.r[ INS_RT( mipscpu.op ) ] )
+		case FUNCT_MFLO:
+			mips_load( INS_RD( mipscpu.op ),  mipscpu.lo );
+			break;
+		case FUNCT_MTLO:
+			if( INS_RD( mipscpu.op ) != 0 )
 			{
-				mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+				mips_exception( EXC_RI );
 			}
 			else
 			{
 				mips_advance_pc();
+				mipscpu.lo = mipscpu.r[ INS_RS( mipscpu.op ) ];
 			}
 			break;
-		case OP_BLEZ:
-			if( INS_RT( mipscpu.op ) != 0 )
+		case FUNCT_MULT:
+			if( INS_RD( mipscpu.op ) != 0 )
 			{
 				mips_exception( EXC_RI );
 			}
-			else if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] <= 0 )
+			else
 			{
-				mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+				int64_t n_res64;
+				n_res64 = MUL_64_32_32( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ], (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ] );
+				mips_advance_pc();
+				mipscpu.lo = LO32_32_64( n_res64 );
+				mipscpu.hi = HI32_32_64( n_res64 );
+			}
+			break;
+		case FUNCT_MULTU:
+			if( INS_RD( mipscpu.op ) != 0 )
+			{
+				mips_exception( EXC_RI );
 			}
 			else
 			{
+				uint64_t n_res64;
+				n_res64 = MUL_U64_U32_U32( mipscpu.r[ INS_RS( mipscpu.op ) ], mipscpu.r[ INS_RT( mipscpu.op ) ] );
 				mips_advance_pc();
+				mipscpu.lo = LO32_U32_U64( n_res64 );
+				mipscpu.hi = HI32_U32_U64( n_res64 );
 			}
 			break;
-		case OP_BGTZ:
-			if( INS_RT( mipscpu.op ) != 0 )
+		case FUNCT_DIV:
+			if( INS_RD( mipscpu.op ) != 0 )
 			{
 				mips_exception( EXC_RI );
 			}
-			else if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] > 0 )
+			else
 			{
-				mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+				uint32_t n_div;
+				uint32_t n_mod;
+				if( mipscpu.r[ INS_RT( mipscpu.op ) ] != 0 )
+				{
+					n_div = (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] / (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ];
+					n_mod = (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] % (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ];
+					mips_advance_pc();
+					mipscpu.lo = n_div;
+					mipscpu.hi = n_mod;
+				}
+				else
+				{
+					mips_advance_pc();
+				}
+			}
+			break;
+		case FUNCT_DIVU:
+			if( INS_RD( mipscpu.op ) != 0 )
+			{
+				mips_exception( EXC_RI );
 			}
 			else
 			{
-				mips_advance_pc();
+				uint32_t n_div;
+				uint32_t n_mod;
+				if( mipscpu.r[ INS_RT( mipscpu.op ) ] != 0 )
+				{
+					n_div = mipscpu.r[ INS_RS( mipscpu.op ) ] / mipscpu.r[ INS_RT( mipscpu.op ) ];
+					n_mod = mipscpu.r[ INS_RS( mipscpu.op ) ] % mipscpu.r[ INS_RT( mipscpu.op ) ];
+					mips_advance_pc();
+					mipscpu.lo = n_div;
+					mipscpu.hi = n_mod;
+				}
+				else
+				{
+					mips_advance_pc();
+				}
 			}
 			break;
-		case OP_ADDI:
+		case FUNCT_ADD:
 			{
-				uint32_t n_imm;
-				n_imm = MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				n_res = mipscpu.r[ INS_RS( mipscpu.op ) ] + n_imm;
-				if( (int32_t)( ~( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ n_imm ) & ( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ n_res ) ) < 0 )
+				n_res = mipscpu.r[ INS_RS( mipscpu.op ) ] + mipscpu.r[ INS_RT( mipscpu.op ) ];
+				if( (int32_t)( ~( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ mipscpu.r[ INS_RT( mipscpu.op ) ] ) & ( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ n_res ) ) < 0 )
 				{
 					mips_exception( EXC_OVF );
 				}
 				else
 				{
-					mips_load( INS_RT( mipscpu.op ), n_res );
+					mips_load( INS_RD( mipscpu.op ), n_res );
 				}
 			}
 			break;
-		case OP_ADDIU:
-			if (INS_RT( mipscpu.op ) == 0)
+		case FUNCT_ADDU:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] + mipscpu.r[ INS_RT( mipscpu.op ) ] );
+			break;
+		case FUNCT_SUB:
+			n_res = mipscpu.r[ INS_RS( mipscpu.op ) ] - mipscpu.r[ INS_RT( mipscpu.op ) ];
+			if( (int32_t)( ( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ mipscpu.r[ INS_RT( mipscpu.op ) ] ) & ( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ n_res ) ) < 0 )
 			{
-				psx_iop_call(mipscpu.pc, INS_IMMEDIATE(mipscpu.op));
-				mips_advance_pc();
+				mips_exception( EXC_OVF );
 			}
 			else
 			{
-				mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) );
+				mips_load( INS_RD( mipscpu.op ), n_res );
 			}
 			break;
-		case OP_SLTI:
-			mips_load( INS_RT( mipscpu.op ), (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] < MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) );
+		case FUNCT_SUBU:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] - mipscpu.r[ INS_RT( mipscpu.op ) ] );
+			break;
+		case FUNCT_AND:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] & mipscpu.r[ INS_RT( mipscpu.op ) ] );
 			break;
-		case OP_SLTIU:
-			mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] < (uint32_t)MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) );
+		case FUNCT_OR:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] | mipscpu.r[ INS_RT( mipscpu.op ) ] );
 			break;
-		case OP_ANDI:
-			mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] & INS_IMMEDIATE( mipscpu.op ) );
+		case FUNCT_XOR:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] ^ mipscpu.r[ INS_RT( mipscpu.op ) ] );
 			break;
-		case OP_ORI:
-			mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] | INS_IMMEDIATE( mipscpu.op ) );
+		case FUNCT_NOR:
+			mips_load( INS_RD( mipscpu.op ), ~( mipscpu.r[ INS_RS( mipscpu.op ) ] | mipscpu.r[ INS_RT( mipscpu.op ) ] ) );
 			break;
-		case OP_XORI:
-			mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] ^ INS_IMMEDIATE( mipscpu.op ) );
+		case FUNCT_SLT:
+			mips_load( INS_RD( mipscpu.op ), (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] < (int32_t)mipscpu.r[ INS_RT( mipscpu.op ) ] );
 			break;
-		case OP_LUI:
-			mips_load( INS_RT( mipscpu.op ), INS_IMMEDIATE( mipscpu.op ) << 16 );
+		case FUNCT_SLTU:
+			mips_load( INS_RD( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] < mipscpu.r[ INS_RT( mipscpu.op ) ] );
+			break;
+		default:
+			mips_exception( EXC_RI );
 			break;
-		case OP_COP0:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) != 0 && ( mipscpu.cp0r[ CP0_SR ] & SR_CU0 ) == 0 )
+		}
+		break;
+	case OP_REGIMM:
+		switch( INS_RT( mipscpu.op ) )
+		{
+		case RT_BLTZ:
+			if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] < 0 )
 			{
-				mips_exception( EXC_CPU );
-				mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE0 );
+				mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
 			}
 			else
 			{
-				switch( INS_RS( mipscpu.op ) )
-				{
-				case RS_MFC:
-					mips_delayed_load( INS_RT( mipscpu.op ), mipscpu.cp0r[ INS_RD( mipscpu.op ) ] );
-					break;
-				case RS_CFC:
-					/* todo: */
-					logerror( "%08x: COP0 CFC not supported\n", mipscpu.pc );
+				mips_advance_pc();
+			}
+			break;
+		case RT_BGEZ:
+			if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] >= 0 )
+			{
+				mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+			}
+			else
+			{
+				mips_advance_pc();
+			}
+			break;
+		case RT_BLTZAL:
+			n_res = mipscpu.pc + 8;
+			if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] < 0 )
+			{
+				mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+			}
+			else
+			{
+				mips_advance_pc();
+			}
+			mipscpu.r[ 31 ] = n_res;
+			break;
+		case RT_BGEZAL:
+			n_res = mipscpu.pc + 8;
+			if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] >= 0 )
+			{
+				mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+			}
+			else
+			{
+				mips_advance_pc();
+			}
+			mipscpu.r[ 31 ] = n_res;
+			break;
+		}
+		break;
+	case OP_J:
+		mips_delayed_branch( ( ( mipscpu.pc + 4 ) & 0xf0000000 ) + ( INS_TARGET( mipscpu.op ) << 2 ) );
+		break;
+	case OP_JAL:
+		n_res = mipscpu.pc + 8;
+		mips_delayed_branch( ( ( mipscpu.pc + 4 ) & 0xf0000000 ) + ( INS_TARGET( mipscpu.op ) << 2 ) );
+		mipscpu.r[ 31 ] = n_res;
+		break;
+	case OP_BEQ:
+		if( mipscpu.r[ INS_RS( mipscpu.op ) ] == mipscpu.r[ INS_RT( mipscpu.op ) ] )
+		{
+			mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+		}
+		else
+		{
+			mips_advance_pc();
+		}
+		break;
+	case OP_BNE:
+		if( mipscpu.r[ INS_RS( mipscpu.op ) ] != mipscpu.r[ INS_RT( mipscpu.op ) ] )
+		{
+			mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+		}
+		else
+		{
+			mips_advance_pc();
+		}
+		break;
+	case OP_BLEZ:
+		if( INS_RT( mipscpu.op ) != 0 )
+		{
+			mips_exception( EXC_RI );
+		}
+		else if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] <= 0 )
+		{
+			mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+		}
+		else
+		{
+			mips_advance_pc();
+		}
+		break;
+	case OP_BGTZ:
+		if( INS_RT( mipscpu.op ) != 0 )
+		{
+			mips_exception( EXC_RI );
+		}
+		else if( (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] > 0 )
+		{
+			mips_delayed_branch( mipscpu.pc + 4 + ( MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) << 2 ) );
+		}
+		else
+		{
+			mips_advance_pc();
+		}
+		break;
+	case OP_ADDI:
+		{
+			uint32_t n_imm;
+			n_imm = MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			n_res = mipscpu.r[ INS_RS( mipscpu.op ) ] + n_imm;
+			if( (int32_t)( ~( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ n_imm ) & ( mipscpu.r[ INS_RS( mipscpu.op ) ] ^ n_res ) ) < 0 )
+			{
+				mips_exception( EXC_OVF );
+			}
+			else
+			{
+				mips_load( INS_RT( mipscpu.op ), n_res );
+			}
+		}
+		break;
+	case OP_ADDIU:
+		if (INS_RT( mipscpu.op ) == 0)
+		{
+			psx_iop_call(mipscpu.pc, INS_IMMEDIATE(mipscpu.op));
+			mips_advance_pc();
+		}
+		else
+		{
+			mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) );
+		}
+		break;
+	case OP_SLTI:
+		mips_load( INS_RT( mipscpu.op ), (int32_t)mipscpu.r[ INS_RS( mipscpu.op ) ] < MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) );
+		break;
+	case OP_SLTIU:
+		mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] < (uint32_t)MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) ) );
+		break;
+	case OP_ANDI:
+		mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] & INS_IMMEDIATE( mipscpu.op ) );
+		break;
+	case OP_ORI:
+		mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] | INS_IMMEDIATE( mipscpu.op ) );
+		break;
+	case OP_XORI:
+		mips_load( INS_RT( mipscpu.op ), mipscpu.r[ INS_RS( mipscpu.op ) ] ^ INS_IMMEDIATE( mipscpu.op ) );
+		break;
+	case OP_LUI:
+		mips_load( INS_RT( mipscpu.op ), INS_IMMEDIATE( mipscpu.op ) << 16 );
+		break;
+	case OP_COP0:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) != 0 && ( mipscpu.cp0r[ CP0_SR ] & SR_CU0 ) == 0 )
+		{
+			mips_exception( EXC_CPU );
+			mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE0 );
+		}
+		else
+		{
+			switch( INS_RS( mipscpu.op ) )
+			{
+			case RS_MFC:
+				mips_delayed_load( INS_RT( mipscpu.op ), mipscpu.cp0r[ INS_RD( mipscpu.op ) ] );
+				break;
+			case RS_CFC:
+				/* todo: */
+				logerror( "%08x: COP0 CFC not supported\n", mipscpu.pc );
+				mips_stop();
+				mips_advance_pc();
+				break;
+			case RS_MTC:
+				n_res = ( mipscpu.cp0r[ INS_RD( mipscpu.op ) ] & ~mips_mtc0_writemask[ INS_RD( mipscpu.op ) ] ) |
+					( mipscpu.r[ INS_RT( mipscpu.op ) ] & mips_mtc0_writemask[ INS_RD( mipscpu.op ) ] );
+				mips_advance_pc();
+				mips_set_cp0r( INS_RD( mipscpu.op ), n_res );
+				break;
+			case RS_CTC:
+				/* todo: */
+				logerror( "%08x: COP0 CTC not supported\n", mipscpu.pc );
+				mips_stop();
+				mips_advance_pc();
+				break;
+			case RS_BC:
+				switch( INS_RT( mipscpu.op ) )
+				{
+				case RT_BCF:
+					/* todo: */
+					logerror( "%08x: COP0 BCF not supported\n", mipscpu.pc );
 					mips_stop();
 					mips_advance_pc();
 					break;
-				case RS_MTC:
-					n_res = ( mipscpu.cp0r[ INS_RD( mipscpu.op ) ] & ~mips_mtc0_writemask[ INS_RD( mipscpu.op ) ] ) |
-						( mipscpu.r[ INS_RT( mipscpu.op ) ] & mips_mtc0_writemask[ INS_RD( mipscpu.op ) ] );
+				case RT_BCT:
+					/* todo: */
+					logerror( "%08x: COP0 BCT not supported\n", mipscpu.pc );
+					mips_stop();
 					mips_advance_pc();
-					mips_set_cp0r( INS_RD( mipscpu.op ), n_res );
 					break;
-				case RS_CTC:
+				default:
 					/* todo: */
-					logerror( "%08x: COP0 CTC not supported\n", mipscpu.pc );
+					logerror( "%08x: COP0 unknown command %08x\n", mipscpu.pc, mipscpu.op );
 					mips_stop();
 					mips_advance_pc();
 					break;
-				case RS_BC:
-					switch( INS_RT( mipscpu.op ) )
+				}
+				break;
+			default:
+				switch( INS_CO( mipscpu.op ) )
+				{
+				case 1:
+					switch( INS_CF( mipscpu.op ) )
 					{
-					case RT_BCF:
-						/* todo: */
-						logerror( "%08x: COP0 BCF not supported\n", mipscpu.pc );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					case RT_BCT:
-						/* todo: */
-						logerror( "%08x: COP0 BCT not supported\n", mipscpu.pc );
-						mips_stop();
+					case CF_RFE:
 						mips_advance_pc();
+						mips_set_cp0r( CP0_SR, ( mipscpu.cp0r[ CP0_SR ] & ~0xf ) | ( ( mipscpu.cp0r[ CP0_SR ] >> 2 ) & 0xf ) );
 						break;
 					default:
 						/* todo: */
@@ -838,830 +864,1211 @@ int mips_execute( int cycles )
 					}
 					break;
 				default:
-					switch( INS_CO( mipscpu.op ) )
-					{
-					case 1:
-						switch( INS_CF( mipscpu.op ) )
-						{
-						case CF_RFE:
-							mips_advance_pc();
-							mips_set_cp0r( CP0_SR, ( mipscpu.cp0r[ CP0_SR ] & ~0xf ) | ( ( mipscpu.cp0r[ CP0_SR ] >> 2 ) & 0xf ) );
-							break;
-						default:
-							/* todo: */
-							logerror( "%08x: COP0 unknown command %08x\n", mipscpu.pc, mipscpu.op );
-							mips_stop();
-							mips_advance_pc();
-							break;
-						}
-						break;
-					default:
-						/* todo: */
-						logerror( "%08x: COP0 unknown command %08x\n", mipscpu.pc, mipscpu.op );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					}
+					/* todo: */
+					logerror( "%08x: COP0 unknown command %08x\n", mipscpu.pc, mipscpu.op );
+					mips_stop();
+					mips_advance_pc();
 					break;
 				}
+				break;
 			}
-			break;
-		case OP_COP1:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_CU1 ) == 0 )
-			{
-				mips_exception( EXC_CPU );
-				mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE1 );
-			}
-			else
+		}
+		break;
+	case OP_COP1:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_CU1 ) == 0 )
+		{
+			mips_exception( EXC_CPU );
+			mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE1 );
+		}
+		else
+		{
+			switch( INS_RS( mipscpu.op ) )
 			{
-				switch( INS_RS( mipscpu.op ) )
+			case RS_MFC:
+				/* todo: */
+				logerror( "%08x: COP1 BCT not supported\n", mipscpu.pc );
+				mips_stop();
+				mips_advance_pc();
+				break;
+			case RS_CFC:
+				/* todo: */
+				logerror( "%08x: COP1 CFC not supported\n", mipscpu.pc );
+				mips_stop();
+				mips_advance_pc();
+				break;
+			case RS_MTC:
+				/* todo: */
+				logerror( "%08x: COP1 MTC not supported\n", mipscpu.pc );
+				mips_stop();
+				mips_advance_pc();
+				break;
+			case RS_CTC:
+				/* todo: */
+				logerror( "%08x: COP1 CTC not supported\n", mipscpu.pc );
+				mips_stop();
+				mips_advance_pc();
+				break;
+			case RS_BC:
+				switch( INS_RT( mipscpu.op ) )
 				{
-				case RS_MFC:
+				case RT_BCF:
 					/* todo: */
-					logerror( "%08x: COP1 BCT not supported\n", mipscpu.pc );
+					logerror( "%08x: COP1 BCF not supported\n", mipscpu.pc );
 					mips_stop();
 					mips_advance_pc();
 					break;
-				case RS_CFC:
+				case RT_BCT:
 					/* todo: */
-					logerror( "%08x: COP1 CFC not supported\n", mipscpu.pc );
+					logerror( "%08x: COP1 BCT not supported\n", mipscpu.pc );
 					mips_stop();
 					mips_advance_pc();
 					break;
-				case RS_MTC:
+				default:
 					/* todo: */
-					logerror( "%08x: COP1 MTC not supported\n", mipscpu.pc );
+					logerror( "%08x: COP1 unknown command %08x\n", mipscpu.pc, mipscpu.op );
 					mips_stop();
 					mips_advance_pc();
 					break;
-				case RS_CTC:
+				}
+				break;
+			default:
+				switch( INS_CO( mipscpu.op ) )
+				{
+				case 1:
 					/* todo: */
-					logerror( "%08x: COP1 CTC not supported\n", mipscpu.pc );
+					logerror( "%08x: COP1 unknown command %08x\n", mipscpu.pc, mipscpu.op );
 					mips_stop();
 					mips_advance_pc();
 					break;
-				case RS_BC:
-					switch( INS_RT( mipscpu.op ) )
-					{
-					case RT_BCF:
-						/* todo: */
-						logerror( "%08x: COP1 BCF not supported\n", mipscpu.pc );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					case RT_BCT:
-						/* todo: */
-						logerror( "%08x: COP1 BCT not supported\n", mipscpu.pc );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					default:
-						/* todo: */
-						logerror( "%08x: COP1 unknown command %08x\n", mipscpu.pc, mipscpu.op );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					}
-					break;
 				default:
-					switch( INS_CO( mipscpu.op ) )
-					{
-					case 1:
-						/* todo: */
-						logerror( "%08x: COP1 unknown command %08x\n", mipscpu.pc, mipscpu.op );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					default:
-						/* todo: */
-						logerror( "%08x: COP1 unknown command %08x\n", mipscpu.pc, mipscpu.op );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					}
+					/* todo: */
+					logerror( "%08x: COP1 unknown command %08x\n", mipscpu.pc, mipscpu.op );
+					mips_stop();
+					mips_advance_pc();
 					break;
 				}
+				break;
 			}
-			break;
-		case OP_COP2:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_CU2 ) == 0 )
-			{
-				mips_exception( EXC_CPU );
-				mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE2 );
-			}
-			else
+		}
+		break;
+	case OP_COP2:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_CU2 ) == 0 )
+		{
+			mips_exception( EXC_CPU );
+			mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE2 );
+		}
+		else
+		{
+			switch( INS_RS( mipscpu.op ) )
 			{
-				switch( INS_RS( mipscpu.op ) )
+			case RS_MFC:
+				mips_delayed_load( INS_RT( mipscpu.op ), getcp2dr( INS_RD( mipscpu.op ) ) );
+				break;
+			case RS_CFC:
+				mips_delayed_load( INS_RT( mipscpu.op ), getcp2cr( INS_RD( mipscpu.op ) ) );
+				break;
+			case RS_MTC:
+				setcp2dr( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] );
+				mips_advance_pc();
+				break;
+			case RS_CTC:
+				setcp2cr( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] );
+				mips_advance_pc();
+				break;
+			case RS_BC:
+				switch( INS_RT( mipscpu.op ) )
 				{
-				case RS_MFC:
-					mips_delayed_load( INS_RT( mipscpu.op ), getcp2dr( INS_RD( mipscpu.op ) ) );
-					break;
-				case RS_CFC:
-					mips_delayed_load( INS_RT( mipscpu.op ), getcp2cr( INS_RD( mipscpu.op ) ) );
+				case RT_BCF:
+					/* todo: */
+					logerror( "%08x: COP2 BCF not supported\n", mipscpu.pc );
+					mips_stop();
+					mips_advance_pc();
 					break;
-				case RS_MTC:
-					setcp2dr( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] );
+				case RT_BCT:
+					/* todo: */
+					logerror( "%08x: COP2 BCT not supported\n", mipscpu.pc );
+					mips_stop();
 					mips_advance_pc();
 					break;
-				case RS_CTC:
-					setcp2cr( INS_RD( mipscpu.op ), mipscpu.r[ INS_RT( mipscpu.op ) ] );
+				default:
+					/* todo: */
+					logerror( "%08x: COP2 unknown command %08x\n", mipscpu.pc, mipscpu.op );
+					mips_stop();
 					mips_advance_pc();
 					break;
-				case RS_BC:
-					switch( INS_RT( mipscpu.op ) )
-					{
-					case RT_BCF:
-						/* todo: */
-						logerror( "%08x: COP2 BCF not supported\n", mipscpu.pc );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					case RT_BCT:
-						/* todo: */
-						logerror( "%08x: COP2 BCT not supported\n", mipscpu.pc );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					default:
-						/* todo: */
-						logerror( "%08x: COP2 unknown command %08x\n", mipscpu.pc, mipscpu.op );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					}
+				}
+				break;
+			default:
+				switch( INS_CO( mipscpu.op ) )
+				{
+				case 1:
+					docop2( INS_COFUN( mipscpu.op ) );
+					mips_advance_pc();
 					break;
 				default:
-					switch( INS_CO( mipscpu.op ) )
-					{
-					case 1:
-						docop2( INS_COFUN( mipscpu.op ) );
-						mips_advance_pc();
-						break;
-					default:
-						/* todo: */
-						logerror( "%08x: COP2 unknown command %08x\n", mipscpu.pc, mipscpu.op );
-						mips_stop();
-						mips_advance_pc();
-						break;
-					}
+					/* todo: */
+					logerror( "%08x: COP2 unknown command %08x\n", mipscpu.pc, mipscpu.op );
+					mips_stop();
+					mips_advance_pc();
 					break;
 				}
+				break;
 			}
-			break;
-		case OP_LB:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		}
+		break;
+	case OP_LB:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: LB SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
 			{
-				/* todo: */
-				logerror( "%08x: LB SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					mips_delayed_load( INS_RT( mipscpu.op ), MIPS_BYTE_EXTEND( program_read_byte_32le( n_adr ^ 3 ) ) );
-				}
+				mips_delayed_load( INS_RT( mipscpu.op ), MIPS_BYTE_EXTEND( mips_read_byte( n_adr ^ 3 ) ) );
+			}
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
+			{
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					mips_delayed_load( INS_RT( mipscpu.op ), MIPS_BYTE_EXTEND( program_read_byte_32le( n_adr ) ) );
-				}
+				mips_delayed_load( INS_RT( mipscpu.op ), MIPS_BYTE_EXTEND( mips_read_byte( n_adr ) ) );
+			}
+		}
+		break;
+	case OP_LH:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: LH SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
+			{
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			break;
-		case OP_LH:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+			else
 			{
-				/* todo: */
-				logerror( "%08x: LH SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				mips_delayed_load( INS_RT( mipscpu.op ), MIPS_WORD_EXTEND( mips_read_word( n_adr ^ 2 ) ) );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					mips_delayed_load( INS_RT( mipscpu.op ), MIPS_WORD_EXTEND( program_read_word_32le( n_adr ^ 2 ) ) );
-				}
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					mips_delayed_load( INS_RT( mipscpu.op ), MIPS_WORD_EXTEND( program_read_word_32le( n_adr ) ) );
-				}
+				mips_delayed_load( INS_RT( mipscpu.op ), MIPS_WORD_EXTEND( mips_read_word( n_adr ) ) );
 			}
-			break;
-		case OP_LWL:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		}
+		break;
+	case OP_LWL:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: LWL SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
 			{
-				/* todo: */
-				logerror( "%08x: LWL SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
+				switch( n_adr & 3 )
 				{
-					switch( n_adr & 3 )
-					{
-					case 0:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x00ffffff ) | ( (uint32_t)program_read_byte_32le( n_adr + 3 ) << 24 );
-						break;
-					case 1:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x0000ffff ) | ( (uint32_t)program_read_word_32le( n_adr + 1 ) << 16 );
-						break;
-					case 2:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x000000ff ) | ( (uint32_t)program_read_byte_32le( n_adr - 1 ) << 8 ) | ( (uint32_t)program_read_word_32le( n_adr ) << 16 );
-						break;
-					default:
-						n_res = program_read_dword_32le( n_adr - 3 );
-						break;
-					}
-					mips_delayed_load( INS_RT( mipscpu.op ), n_res );
+				case 0:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x00ffffff ) | ( (uint32_t)mips_read_byte( n_adr + 3 ) << 24 );
+					break;
+				case 1:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x0000ffff ) | ( (uint32_t)mips_read_word( n_adr + 1 ) << 16 );
+					break;
+				case 2:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x000000ff ) | ( (uint32_t)mips_read_byte( n_adr - 1 ) << 8 ) | ( (uint32_t)mips_read_word( n_adr ) << 16 );
+					break;
+				default:
+					n_res = mips_read_dword( n_adr - 3 );
+					break;
 				}
+				mips_delayed_load( INS_RT( mipscpu.op ), n_res );
+			}
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
+			{
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
+				switch( n_adr & 3 )
 				{
-					switch( n_adr & 3 )
-					{
-					case 0:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x00ffffff ) | ( (uint32_t)program_read_byte_32le( n_adr ) << 24 );
-						break;
-					case 1:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x0000ffff ) | ( (uint32_t)program_read_word_32le( n_adr - 1 ) << 16 );
-						break;
-					case 2:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x000000ff ) | ( (uint32_t)program_read_word_32le( n_adr - 2 ) << 8 ) | ( (uint32_t)program_read_byte_32le( n_adr ) << 24 );
-						break;
-					default:
-						n_res = program_read_dword_32le( n_adr - 3 );
-						break;
-					}
-					mips_delayed_load( INS_RT( mipscpu.op ), n_res );
+				case 0:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x00ffffff ) | ( (uint32_t)mips_read_byte( n_adr ) << 24 );
+					break;
+				case 1:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x0000ffff ) | ( (uint32_t)mips_read_word( n_adr - 1 ) << 16 );
+					break;
+				case 2:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0x000000ff ) | ( (uint32_t)mips_read_word( n_adr - 2 ) << 8 ) | ( (uint32_t)mips_read_byte( n_adr ) << 24 );
+					break;
+				default:
+					n_res = mips_read_dword( n_adr - 3 );
+					break;
 				}
+				mips_delayed_load( INS_RT( mipscpu.op ), n_res );
 			}
-			break;
-		case OP_LW:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		}
+		break;
+	case OP_LW:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: LW SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+#if 0
+			if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 3 ) ) != 0 )
 			{
-				/* todo: */
-				logerror( "%08x: LW SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				printf("ADEL\n");
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
-			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-#if 0
-				if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 3 ) ) != 0 )
-				{
-					printf("ADEL\n");
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
 #endif
-				{
-					mips_delayed_load( INS_RT( mipscpu.op ), program_read_dword_32le( n_adr ) );
-				}
-			}
-			break;
-		case OP_LBU:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
 			{
-				/* todo: */
-				logerror( "%08x: LBU SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				mips_delayed_load( INS_RT( mipscpu.op ), mips_read_dword( n_adr ) );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		}
+		break;
+	case OP_LBU:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: LBU SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					mips_delayed_load( INS_RT( mipscpu.op ), program_read_byte_32le( n_adr ^ 3 ) );
-				}
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					mips_delayed_load( INS_RT( mipscpu.op ), program_read_byte_32le( n_adr ) );
-				}
+				mips_delayed_load( INS_RT( mipscpu.op ), mips_read_byte( n_adr ^ 3 ) );
 			}
-			break;
-		case OP_LHU:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
 			{
-				/* todo: */
-				logerror( "%08x: LHU SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					mips_delayed_load( INS_RT( mipscpu.op ), program_read_word_32le( n_adr ^ 2 ) );
-				}
+				mips_delayed_load( INS_RT( mipscpu.op ), mips_read_byte( n_adr ) );
 			}
-			else
+		}
+		break;
+	case OP_LHU:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: LHU SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					mips_delayed_load( INS_RT( mipscpu.op ), program_read_word_32le( n_adr ) );
-				}
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			break;
-		case OP_LWR:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+			else
 			{
-				/* todo: */
-				logerror( "%08x: LWR SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				mips_delayed_load( INS_RT( mipscpu.op ), mips_read_word( n_adr ^ 2 ) );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					switch( n_adr & 3 )
-					{
-					case 3:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xffffff00 ) | program_read_byte_32le( n_adr - 3 );
-						break;
-					case 2:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xffff0000 ) | program_read_word_32le( n_adr - 2 );
-						break;
-					case 1:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xff000000 ) | program_read_word_32le( n_adr - 1 ) | ( (uint32_t)program_read_byte_32le( n_adr + 1 ) << 16 );
-						break;
-					default:
-						n_res = program_read_dword_32le( n_adr );
-						break;
-					}
-					mips_delayed_load( INS_RT( mipscpu.op ), n_res );
-				}
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					switch( n_adr & 3 )
-					{
-					case 3:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xffffff00 ) | program_read_byte_32le( n_adr );
-						break;
-					case 2:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xffff0000 ) | program_read_word_32le( n_adr );
-						break;
-					case 1:
-						n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xff000000 ) | program_read_byte_32le( n_adr ) | ( (uint32_t)program_read_word_32le( n_adr + 1 ) << 8 );
-						break;
-					default:
-						n_res = program_read_dword_32le( n_adr );
-						break;
-					}
-					mips_delayed_load( INS_RT( mipscpu.op ), n_res );
-				}
+				mips_delayed_load( INS_RT( mipscpu.op ), mips_read_word( n_adr ) );
 			}
-			break;
-		case OP_SB:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		}
+		break;
+	case OP_LWR:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: LWR SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
 			{
-				/* todo: */
-				logerror( "%08x: SB SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
+				switch( n_adr & 3 )
 				{
-					program_write_byte_32le( n_adr ^ 3, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-					mips_advance_pc();
+				case 3:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xffffff00 ) | mips_read_byte( n_adr - 3 );
+					break;
+				case 2:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xffff0000 ) | mips_read_word( n_adr - 2 );
+					break;
+				case 1:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xff000000 ) | mips_read_word( n_adr - 1 ) | ( (uint32_t)mips_read_byte( n_adr + 1 ) << 16 );
+					break;
+				default:
+					n_res = mips_read_dword( n_adr );
+					break;
 				}
+				mips_delayed_load( INS_RT( mipscpu.op ), n_res );
+			}
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
+			{
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
+				switch( n_adr & 3 )
 				{
-					program_write_byte_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-					mips_advance_pc();
+				case 3:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xffffff00 ) | mips_read_byte( n_adr );
+					break;
+				case 2:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xffff0000 ) | mips_read_word( n_adr );
+					break;
+				case 1:
+					n_res = ( mipscpu.r[ INS_RT( mipscpu.op ) ] & 0xff000000 ) | mips_read_byte( n_adr ) | ( (uint32_t)mips_read_word( n_adr + 1 ) << 8 );
+					break;
+				default:
+					n_res = mips_read_dword( n_adr );
+					break;
 				}
+				mips_delayed_load( INS_RT( mipscpu.op ), n_res );
 			}
-			break;
-		case OP_SH:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		}
+		break;
+	case OP_SB:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: SB SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
 			{
-				/* todo: */
-				logerror( "%08x: SH SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
-				{
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					program_write_word_32le( n_adr ^ 2, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-					mips_advance_pc();
-				}
+				mips_write_byte( n_adr ^ 3, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+				mips_advance_pc();
 			}
-			else
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
-				{
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					program_write_word_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-					mips_advance_pc();
-				}
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			break;
-		case OP_SWL:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+			else
 			{
-				/* todo: */
-				printf("SR_ISC not supported\n");
-				logerror( "%08x: SWL SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
+				mips_write_byte( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
 				mips_advance_pc();
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
-			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					printf("permission violation?\n");
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					switch( n_adr & 3 )
-					{
-					case 0:
-						program_write_byte_32le( n_adr + 3, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 24 );
-						break;
-					case 1:
-						program_write_word_32le( n_adr + 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 16 );
-						break;
-					case 2:
-						program_write_byte_32le( n_adr - 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 8 );
-						program_write_word_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 16 );
-						break;
-					case 3:
-						program_write_dword_32le( n_adr - 3, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						break;
-					}
-					mips_advance_pc();
-				}
+		}
+		break;
+	case OP_SH:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: SH SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
+			{
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					printf("permission violation 2\n");
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					switch( n_adr & 3 )
-					{
-					case 0:
-						program_write_byte_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 24 );
-						break;
-					case 1:
-						program_write_word_32le( n_adr - 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 16 );
-						break;
-					case 2:
-						program_write_word_32le( n_adr - 2, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 8 );
-						program_write_byte_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 24 );
-						break;
-					case 3:
-						program_write_dword_32le( n_adr - 3, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						break;
-					}
-					mips_advance_pc();
-				}
+				mips_write_word( n_adr ^ 2, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+				mips_advance_pc();
 			}
-			break;
-		case OP_SW:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 1 ) ) != 0 )
 			{
-				/* todo: */
-/* used by bootstrap
-				logerror( "%08x: SW SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-*/
-				mips_advance_pc();
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if(0) // ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 3 ) ) != 0 )
-				{
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					program_write_dword_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-					mips_advance_pc();
-				}
+				mips_write_word( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+				mips_advance_pc();
 			}
-			break;
-		case OP_SWR:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		}
+		break;
+	case OP_SWL:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			printf("SR_ISC not supported\n");
+			logerror( "%08x: SWL SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
 			{
-				/* todo: */
-				logerror( "%08x: SWR SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
-				mips_advance_pc();
+				printf("permission violation?\n");
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
+				switch( n_adr & 3 )
 				{
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					switch( n_adr & 3 )
-					{
-					case 0:
-						program_write_dword_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						break;
-					case 1:
-						program_write_word_32le( n_adr - 1, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						program_write_byte_32le( n_adr + 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 16 );
-						break;
-					case 2:
-						program_write_word_32le( n_adr - 2, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						break;
-					case 3:
-						program_write_byte_32le( n_adr - 3, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						break;
-					}
-					mips_advance_pc();
+				case 0:
+					mips_write_byte( n_adr + 3, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 24 );
+					break;
+				case 1:
+					mips_write_word( n_adr + 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 16 );
+					break;
+				case 2:
+					mips_write_byte( n_adr - 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 8 );
+					mips_write_word( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 16 );
+					break;
+				case 3:
+					mips_write_dword( n_adr - 3, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					break;
 				}
+				mips_advance_pc();
+			}
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
+			{
+				printf("permission violation 2\n");
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
-				{
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
+				switch( n_adr & 3 )
 				{
-					switch( n_adr & 3 )
-					{
-					case 0:
-						program_write_dword_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						break;
-					case 1:
-						program_write_byte_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						program_write_word_32le( n_adr + 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 8 );
-						break;
-					case 2:
-						program_write_word_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						break;
-					case 3:
-						program_write_byte_32le( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
-						break;
-					}
-					mips_advance_pc();
+				case 0:
+					mips_write_byte( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 24 );
+					break;
+				case 1:
+					mips_write_word( n_adr - 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 16 );
+					break;
+				case 2:
+					mips_write_word( n_adr - 2, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 8 );
+					mips_write_byte( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 24 );
+					break;
+				case 3:
+					mips_write_dword( n_adr - 3, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					break;
 				}
+				mips_advance_pc();
 			}
-			break;
-		case OP_LWC1:
+		}
+		break;
+	case OP_SW:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
 			/* todo: */
-			logerror( "%08x: COP1 LWC not supported\n", mipscpu.pc );
+/* used by bootstrap
+			logerror( "%08x: SW SR_ISC not supported\n", mipscpu.pc );
 			mips_stop();
+*/
 			mips_advance_pc();
-			break;
-		case OP_LWC2:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_CU2 ) == 0 )
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if(0) // ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 3 ) ) != 0 )
 			{
-				mips_exception( EXC_CPU );
-				mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE2 );
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+			else
 			{
-				/* todo: */
-				logerror( "%08x: LWC2 SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
+				mips_write_dword( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
 				mips_advance_pc();
 			}
+		}
+		break;
+	case OP_SWR:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: SWR SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & ( SR_RE | SR_KUC ) ) == ( SR_RE | SR_KUC ) )
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
+			{
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
+			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 3 ) ) != 0 )
+				switch( n_adr & 3 )
 				{
-					mips_exception( EXC_ADEL );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
+				case 0:
+					mips_write_dword( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					break;
+				case 1:
+					mips_write_word( n_adr - 1, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					mips_write_byte( n_adr + 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 16 );
+					break;
+				case 2:
+					mips_write_word( n_adr - 2, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					break;
+				case 3:
+					mips_write_byte( n_adr - 3, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					break;
 				}
-				else
+				mips_advance_pc();
+			}
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) ) != 0 )
+			{
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
+			}
+			else
+			{
+				switch( n_adr & 3 )
 				{
-					/* todo: delay? */
-					setcp2dr( INS_RT( mipscpu.op ), program_read_dword_32le( n_adr ) );
-					mips_advance_pc();
+				case 0:
+					mips_write_dword( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					break;
+				case 1:
+					mips_write_byte( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					mips_write_word( n_adr + 1, mipscpu.r[ INS_RT( mipscpu.op ) ] >> 8 );
+					break;
+				case 2:
+					mips_write_word( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					break;
+				case 3:
+					mips_write_byte( n_adr, mipscpu.r[ INS_RT( mipscpu.op ) ] );
+					break;
 				}
+				mips_advance_pc();
 			}
-			break;
-		case OP_SWC1:
+		}
+		break;
+	case OP_LWC1:
+		/* todo: */
+		logerror( "%08x: COP1 LWC not supported\n", mipscpu.pc );
+		mips_stop();
+		mips_advance_pc();
+		break;
+	case OP_LWC2:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_CU2 ) == 0 )
+		{
+			mips_exception( EXC_CPU );
+			mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE2 );
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
 			/* todo: */
-			logerror( "%08x: COP1 SWC not supported\n", mipscpu.pc );
+			logerror( "%08x: LWC2 SR_ISC not supported\n", mipscpu.pc );
 			mips_stop();
 			mips_advance_pc();
-			break;
-		case OP_SWC2:
-			if( ( mipscpu.cp0r[ CP0_SR ] & SR_CU2 ) == 0 )
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 3 ) ) != 0 )
 			{
-				mips_exception( EXC_CPU );
-				mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE2 );
+				mips_exception( EXC_ADEL );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
 			}
-			else if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+			else
 			{
-				/* todo: */
-				logerror( "%08x: SWC2 SR_ISC not supported\n", mipscpu.pc );
-				mips_stop();
+				/* todo: delay? */
+				setcp2dr( INS_RT( mipscpu.op ), mips_read_dword( n_adr ) );
 				mips_advance_pc();
 			}
+		}
+		break;
+	case OP_SWC1:
+		/* todo: */
+		logerror( "%08x: COP1 SWC not supported\n", mipscpu.pc );
+		mips_stop();
+		mips_advance_pc();
+		break;
+	case OP_SWC2:
+		if( ( mipscpu.cp0r[ CP0_SR ] & SR_CU2 ) == 0 )
+		{
+			mips_exception( EXC_CPU );
+			mips_set_cp0r( CP0_CAUSE, ( mipscpu.cp0r[ CP0_CAUSE ] & ~CAUSE_CE ) | CAUSE_CE2 );
+		}
+		else if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+		{
+			/* todo: */
+			logerror( "%08x: SWC2 SR_ISC not supported\n", mipscpu.pc );
+			mips_stop();
+			mips_advance_pc();
+		}
+		else
+		{
+			uint32_t n_adr;
+			n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
+			if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 3 ) ) != 0 )
+			{
+				mips_exception( EXC_ADES );
+				mips_set_cp0r( CP0_BADVADDR, n_adr );
+			}
 			else
 			{
-				uint32_t n_adr;
-				n_adr = mipscpu.r[ INS_RS( mipscpu.op ) ] + MIPS_WORD_EXTEND( INS_IMMEDIATE( mipscpu.op ) );
-				if( ( n_adr & ( ( ( mipscpu.cp0r[ CP0_SR ] & SR_KUC ) << 30 ) | 3 ) ) != 0 )
-				{
-					mips_exception( EXC_ADES );
-					mips_set_cp0r( CP0_BADVADDR, n_adr );
-				}
-				else
-				{
-					program_write_dword_32le( n_adr, getcp2dr( INS_RT( mipscpu.op ) ) );
-					mips_advance_pc();
-				}
+				mips_write_dword( n_adr, getcp2dr( INS_RT( mipscpu.op ) ) );
+				mips_advance_pc();
 			}
-			break;
-		default:
-			printf( "%08x: unknown opcode %08x (prev %08x, RA %08x)\n", mipscpu.pc, mipscpu.op, mipscpu.prevpc,  mipscpu.r[31] );
-			mips_stop();
-			mips_exception( EXC_RI );
+		}
+		break;
+	default:
+		printf( "%08x: unknown opcode %08x (prev %08x, RA %08x)\n", mipscpu.pc, mipscpu.op, mipscpu.prevpc,  mipscpu.r[31] );
+		mips_stop();
+		mips_exception( EXC_RI );
   			break;
+	}
+}
+
+/* Decoded instruction cache.  Each word of main RAM that gets executed has an
+ * entry holding its opcode already split into the fields its handler needs,
+ * and mips_execute() jumps straight from one handler to the next.  Entries are
+ * compared with the opcode in RAM on every fetch and decoded again when it has
+ * changed, so code written by the loaders, DMA or the program itself needs no
+ * write tracking.  Instructions that are rare, or that only take their common
+ * path in some CPU modes, go through mips_interpret(). */
+
+enum
+{
+	MIPS_SLL,	/* must be 0: a zeroed entry is the decoded opcode 0 (nop) */
+	MIPS_SRL, MIPS_SRA, MIPS_SLLV, MIPS_SRLV, MIPS_SRAV,
+	MIPS_JR, MIPS_JALR, MIPS_MFHI, MIPS_MFLO, MIPS_MULT, MIPS_MULTU,
+	MIPS_ADDU, MIPS_SUBU, MIPS_AND, MIPS_OR, MIPS_XOR, MIPS_NOR, MIPS_SLT, MIPS_SLTU,
+	MIPS_BLTZ, MIPS_BGEZ, MIPS_J, MIPS_JAL, MIPS_BEQ, MIPS_BNE, MIPS_BLEZ, MIPS_BGTZ,
+	MIPS_ADDIU, MIPS_SLTI, MIPS_SLTIU, MIPS_ANDI, MIPS_ORI, MIPS_XORI, MIPS_LUI,
+	MIPS_LB, MIPS_LH, MIPS_LW, MIPS_LBU, MIPS_LHU, MIPS_SB, MIPS_SH, MIPS_SW,
+	MIPS_INTERPRET,
+	MIPS_HANDLERS
+};
+
+/* fetched from outside main RAM */
+static const mips_decoded mips_uncached = { 0, MIPS_INTERPRET };
+
+/* (re)decodes the instruction at pc, which is in main RAM */
+mips_decoded *PSXMachine::mips_decode( uint32_t pc, uint32_t op )
+{
+	SmartPtr<mips_code_page> &page = mips_code[ ( pc & 0x1fffff ) >> 12 ];
+	if( !page )
+	{
+		page = SmartNew<mips_code_page>();
+	}
+
+	mips_decoded *d = &page->ops[ ( pc & 0xfff ) >> 2 ];
+	int handler = MIPS_INTERPRET;
+	uint32_t simm = MIPS_WORD_EXTEND( INS_IMMEDIATE( op ) );
+
+	d->op = op;
+	d->rs = INS_RS( op );
+	d->rt = INS_RT( op );
+	d->rd = INS_RD( op );
+	d->imm = simm;
+
+	switch( INS_OP( op ) )
+	{
+	case OP_SPECIAL:
+		switch( INS_FUNCT( op ) )
+		{
+		case FUNCT_SLL: handler = MIPS_SLL; d->imm = INS_SHAMT( op ); break;
+		case FUNCT_SRL: handler = MIPS_SRL; d->imm = INS_SHAMT( op ); break;
+		case FUNCT_SRA: handler = MIPS_SRA; d->imm = INS_SHAMT( op ); break;
+		case FUNCT_SLLV: handler = MIPS_SLLV; break;
+		case FUNCT_SRLV: handler = MIPS_SRLV; break;
+		case FUNCT_SRAV: handler = MIPS_SRAV; break;
+		case FUNCT_JR: if( d->rd == 0 ) handler = MIPS_JR; break;
+		case FUNCT_JALR: handler = MIPS_JALR; break;
+		case FUNCT_MFHI: handler = MIPS_MFHI; break;
+		case FUNCT_MFLO: handler = MIPS_MFLO; break;
+		case FUNCT_MULT: if( d->rd == 0 ) handler = MIPS_MULT; break;
+		case FUNCT_MULTU: if( d->rd == 0 ) handler = MIPS_MULTU; break;
+		case FUNCT_ADDU: handler = MIPS_ADDU; break;
+		case FUNCT_SUBU: handler = MIPS_SUBU; break;
+		case FUNCT_AND: handler = MIPS_AND; break;
+		case FUNCT_OR: handler = MIPS_OR; break;
+		case FUNCT_XOR: handler = MIPS_XOR; break;
+		case FUNCT_NOR: handler = MIPS_NOR; break;
+		case FUNCT_SLT: handler = MIPS_SLT; break;
+		case FUNCT_SLTU: handler = MIPS_SLTU; break;
+		}
+		break;
+	case OP_REGIMM:
+		/* branches are stored as the offset from the branch */
+		d->imm = 4 + ( simm << 2 );
+		switch( INS_RT( op ) )
+		{
+		case RT_BLTZ: handler = MIPS_BLTZ; break;
+		case RT_BGEZ: handler = MIPS_BGEZ; break;
 		}
-		mips_ICount--;
-	} while( mips_ICount > 0 );
+		break;
+	case OP_J: handler = MIPS_J; d->imm = INS_TARGET( op ) << 2; break;
+	case OP_JAL: handler = MIPS_JAL; d->imm = INS_TARGET( op ) << 2; break;
+	case OP_BEQ: handler = MIPS_BEQ; d->imm = 4 + ( simm << 2 ); break;
+	case OP_BNE: handler = MIPS_BNE; d->imm = 4 + ( simm << 2 ); break;
+	case OP_BLEZ: if( d->rt == 0 ) handler = MIPS_BLEZ; d->imm = 4 + ( simm << 2 ); break;
+	case OP_BGTZ: if( d->rt == 0 ) handler = MIPS_BGTZ; d->imm = 4 + ( simm << 2 ); break;
+	case OP_ADDIU: if( d->rt != 0 ) handler = MIPS_ADDIU; break;	/* rt == 0 is an IOP call */
+	case OP_SLTI: handler = MIPS_SLTI; break;
+	case OP_SLTIU: handler = MIPS_SLTIU; break;
+	case OP_ANDI: handler = MIPS_ANDI; d->imm = INS_IMMEDIATE( op ); break;
+	case OP_ORI: handler = MIPS_ORI; d->imm = INS_IMMEDIATE( op ); break;
+	case OP_XORI: handler = MIPS_XORI; d->imm = INS_IMMEDIATE( op ); break;
+	case OP_LUI: handler = MIPS_LUI; d->imm = INS_IMMEDIATE( op ) << 16; break;
+	case OP_LB: handler = MIPS_LB; break;
+	case OP_LH: handler = MIPS_LH; break;
+	case OP_LW: handler = MIPS_LW; break;
+	case OP_LBU: handler = MIPS_LBU; break;
+	case OP_LHU: handler = MIPS_LHU; break;
+	case OP_SB: handler = MIPS_SB; break;
+	case OP_SH: handler = MIPS_SH; break;
+	case OP_SW: handler = MIPS_SW; break;
+	}
 
-	return cycles - mips_ICount;
+	d->handler = handler;
+	return d;
 }
 
-static void mips_get_context( void *dst )
+/* sets mipscpu.op to the instruction at mipscpu.pc and returns its entry */
+const mips_decoded *PSXMachine::mips_fetch( void )
 {
-	if( dst )
+	uint32_t pc = mipscpu.pc;
+	const mips_decoded *d;
+
+	if( IS_RAM( pc ) )
+	{
+		uint32_t op = LE32( RAM_WORD( pc ) );
+		mips_code_page *page = mips_code[ ( pc & 0x1fffff ) >> 12 ].get();
+		mips_decoded *entry = page ? &page->ops[ ( pc & 0xfff ) >> 2 ] : nullptr;
+
+		if( !entry || entry->op != op )
+		{
+			entry = mips_decode( pc, op );
+		}
+
+		mipscpu.op = op;
+		d = entry;
+	}
+	else
 	{
-		*(mips_cpu_context *)dst = mipscpu;
+		mipscpu.op = mips_read_dword( pc );
+		d = &mips_uncached;
 	}
+
+	// if we're not in a delay slot, update
+	// if we're in a delay slot and the delay instruction is not NOP, update
+	if( ( mipscpu.delayr == 0 ) || ( mipscpu.op != 0 ) )
+	{
+		mipscpu.prevpc = pc;
+	}
+
+	return d;
 }
 
-static void mips_set_context( void *src )
+/* ends every handler: counts the cycle and jumps to the next handler */
+#define MIPS_NEXT \
+	do \
+	{ \
+		if( --mips_ICount <= 0 ) \
+		{ \
+			return cycles - mips_ICount; \
+		} \
+		d = mips_fetch(); \
+		goto *handlers[ d->handler ]; \
+	} while( 0 )
+
+/* the ISC, RE and KUC status bits change how loads and stores behave */
+#define MIPS_PLAIN_MEMORY ( ( mipscpu.cp0r[ CP0_SR ] & ( SR_ISC | SR_KUC ) ) == 0 )
+
+int PSXMachine::mips_execute( int cycles )
 {
-	if( src )
+	static const void * const handlers[ MIPS_HANDLERS ] =
 	{
-		mipscpu = *(mips_cpu_context *)src;
-		change_pc( mipscpu.pc );
+		&&op_sll, &&op_srl, &&op_sra, &&op_sllv, &&op_srlv, &&op_srav,
+		&&op_jr, &&op_jalr, &&op_mfhi, &&op_mflo, &&op_mult, &&op_multu,
+		&&op_addu, &&op_subu, &&op_and, &&op_or, &&op_xor, &&op_nor, &&op_slt, &&op_sltu,
+		&&op_bltz, &&op_bgez, &&op_j, &&op_jal, &&op_beq, &&op_bne, &&op_blez, &&op_bgtz,
+		&&op_addiu, &&op_slti, &&op_sltiu, &&op_andi, &&op_ori, &&op_xori, &&op_lui,
+		&&op_lb, &&op_lh, &&op_lw, &&op_lbu, &&op_lhu, &&op_sb, &&op_sh, &&op_sw,
+		&&op_interpret
+	};
+
+	const mips_decoded *d;
+	uint32_t n_adr, n_res;
+
+	mips_ICount = cycles;
+	d = mips_fetch();
+	goto *handlers[ d->handler ];
+
+op_interpret:
+	mips_interpret();
+	MIPS_NEXT;
+
+op_sll:
+	mips_load( d->rd, mipscpu.r[ d->rt ] << d->imm );
+	MIPS_NEXT;
+op_srl:
+	mips_load( d->rd, mipscpu.r[ d->rt ] >> d->imm );
+	MIPS_NEXT;
+op_sra:
+	mips_load( d->rd, (int32_t)mipscpu.r[ d->rt ] >> d->imm );
+	MIPS_NEXT;
+op_sllv:
+	mips_load( d->rd, mipscpu.r[ d->rt ] << ( mipscpu.r[ d->rs ] & 31 ) );
+	MIPS_NEXT;
+op_srlv:
+	mips_load( d->rd, mipscpu.r[ d->rt ] >> ( mipscpu.r[ d->rs ] & 31 ) );
+	MIPS_NEXT;
+op_srav:
+	mips_load( d->rd, (int32_t)mipscpu.r[ d->rt ] >> ( mipscpu.r[ d->rs ] & 31 ) );
+	MIPS_NEXT;
+op_jr:
+	mips_delayed_branch( mipscpu.r[ d->rs ] );
+	MIPS_NEXT;
+op_jalr:
+	n_res = mipscpu.pc + 8;
+	mips_delayed_branch( mipscpu.r[ d->rs ] );
+	if( d->rd != 0 )
+	{
+		mipscpu.r[ d->rd ] = n_res;
+	}
+	MIPS_NEXT;
+op_mfhi:
+	mips_load( d->rd, mipscpu.hi );
+	MIPS_NEXT;
+op_mflo:
+	mips_load( d->rd, mipscpu.lo );
+	MIPS_NEXT;
+op_mult:
+	{
+		int64_t n_res64 = MUL_64_32_32( (int32_t)mipscpu.r[ d->rs ], (int32_t)mipscpu.r[ d->rt ] );
+		mips_advance_pc();
+		mipscpu.lo = LO32_32_64( n_res64 );
+		mipscpu.hi = HI32_32_64( n_res64 );
+	}
+	MIPS_NEXT;
+op_multu:
+	{
+		uint64_t n_res64 = MUL_U64_U32_U32( mipscpu.r[ d->rs ], mipscpu.r[ d->rt ] );
+		mips_advance_pc();
+		mipscpu.lo = LO32_U32_U64( n_res64 );
+		mipscpu.hi = HI32_U32_U64( n_res64 );
+	}
+	MIPS_NEXT;
+op_addu:
+	mips_load( d->rd, mipscpu.r[ d->rs ] + mipscpu.r[ d->rt ] );
+	MIPS_NEXT;
+op_subu:
+	mips_load( d->rd, mipscpu.r[ d->rs ] - mipscpu.r[ d->rt ] );
+	MIPS_NEXT;
+op_and:
+	mips_load( d->rd, mipscpu.r[ d->rs ] & mipscpu.r[ d->rt ] );
+	MIPS_NEXT;
+op_or:
+	mips_load( d->rd, mipscpu.r[ d->rs ] | mipscpu.r[ d->rt ] );
+	MIPS_NEXT;
+op_xor:
+	mips_load( d->rd, mipscpu.r[ d->rs ] ^ mipscpu.r[ d->rt ] );
+	MIPS_NEXT;
+op_nor:
+	mips_load( d->rd, ~( mipscpu.r[ d->rs ] | mipscpu.r[ d->rt ] ) );
+	MIPS_NEXT;
+op_slt:
+	mips_load( d->rd, (int32_t)mipscpu.r[ d->rs ] < (int32_t)mipscpu.r[ d->rt ] );
+	MIPS_NEXT;
+op_sltu:
+	mips_load( d->rd, mipscpu.r[ d->rs ] < mipscpu.r[ d->rt ] );
+	MIPS_NEXT;
+
+op_bltz:
+	if( (int32_t)mipscpu.r[ d->rs ] < 0 )
+	{
+		mips_delayed_branch( mipscpu.pc + d->imm );
+	}
+	else
+	{
+		mips_advance_pc();
+	}
+	MIPS_NEXT;
+op_bgez:
+	if( (int32_t)mipscpu.r[ d->rs ] >= 0 )
+	{
+		mips_delayed_branch( mipscpu.pc + d->imm );
+	}
+	else
+	{
+		mips_advance_pc();
+	}
+	MIPS_NEXT;
+op_j:
+	mips_delayed_branch( ( ( mipscpu.pc + 4 ) & 0xf0000000 ) + d->imm );
+	MIPS_NEXT;
+op_jal:
+	n_res = mipscpu.pc + 8;
+	mips_delayed_branch( ( ( mipscpu.pc + 4 ) & 0xf0000000 ) + d->imm );
+	mipscpu.r[ 31 ] = n_res;
+	MIPS_NEXT;
+op_beq:
+	if( mipscpu.r[ d->rs ] == mipscpu.r[ d->rt ] )
+	{
+		mips_delayed_branch( mipscpu.pc + d->imm );
+	}
+	else
+	{
+		mips_advance_pc();
+	}
+	MIPS_NEXT;
+op_bne:
+	if( mipscpu.r[ d->rs ] != mipscpu.r[ d->rt ] )
+	{
+		mips_delayed_branch( mipscpu.pc + d->imm );
+	}
+	else
+	{
+		mips_advance_pc();
+	}
+	MIPS_NEXT;
+op_blez:
+	if( (int32_t)mipscpu.r[ d->rs ] <= 0 )
+	{
+		mips_delayed_branch( mipscpu.pc + d->imm );
+	}
+	else
+	{
+		mips_advance_pc();
 	}
+	MIPS_NEXT;
+op_bgtz:
+	if( (int32_t)mipscpu.r[ d->rs ] > 0 )
+	{
+		mips_delayed_branch( mipscpu.pc + d->imm );
+	}
+	else
+	{
+		mips_advance_pc();
+	}
+	MIPS_NEXT;
+
+op_addiu:
+	mips_load( d->rt, mipscpu.r[ d->rs ] + d->imm );
+	MIPS_NEXT;
+op_slti:
+	mips_load( d->rt, (int32_t)mipscpu.r[ d->rs ] < (int32_t)d->imm );
+	MIPS_NEXT;
+op_sltiu:
+	mips_load( d->rt, mipscpu.r[ d->rs ] < d->imm );
+	MIPS_NEXT;
+op_andi:
+	mips_load( d->rt, mipscpu.r[ d->rs ] & d->imm );
+	MIPS_NEXT;
+op_ori:
+	mips_load( d->rt, mipscpu.r[ d->rs ] | d->imm );
+	MIPS_NEXT;
+op_xori:
+	mips_load( d->rt, mipscpu.r[ d->rs ] ^ d->imm );
+	MIPS_NEXT;
+op_lui:
+	mips_load( d->rt, d->imm );
+	MIPS_NEXT;
+
+op_lb:
+	if( !MIPS_PLAIN_MEMORY )
+	{
+		goto op_interpret;
+	}
+	n_adr = mipscpu.r[ d->rs ] + d->imm;
+	mips_delayed_load( d->rt, MIPS_BYTE_EXTEND( mips_read_byte( n_adr ) ) );
+	MIPS_NEXT;
+op_lh:
+	n_adr = mipscpu.r[ d->rs ] + d->imm;
+	if( !MIPS_PLAIN_MEMORY || ( n_adr & 1 ) != 0 )
+	{
+		goto op_interpret;
+	}
+	mips_delayed_load( d->rt, MIPS_WORD_EXTEND( mips_read_word( n_adr ) ) );
+	MIPS_NEXT;
+op_lw:
+	if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+	{
+		goto op_interpret;
+	}
+	n_adr = mipscpu.r[ d->rs ] + d->imm;
+	mips_delayed_load( d->rt, mips_read_dword( n_adr ) );
+	MIPS_NEXT;
+op_lbu:
+	if( !MIPS_PLAIN_MEMORY )
+	{
+		goto op_interpret;
+	}
+	n_adr = mipscpu.r[ d->rs ] + d->imm;
+	mips_delayed_load( d->rt, mips_read_byte( n_adr ) );
+	MIPS_NEXT;
+op_lhu:
+	n_adr = mipscpu.r[ d->rs ] + d->imm;
+	if( !MIPS_PLAIN_MEMORY || ( n_adr & 1 ) != 0 )
+	{
+		goto op_interpret;
+	}
+	mips_delayed_load( d->rt, mips_read_word( n_adr ) );
+	MIPS_NEXT;
+op_sb:
+	if( !MIPS_PLAIN_MEMORY )
+	{
+		goto op_interpret;
+	}
+	n_adr = mipscpu.r[ d->rs ] + d->imm;
+	mips_write_byte( n_adr, mipscpu.r[ d->rt ] );
+	mips_advance_pc();
+	MIPS_NEXT;
+op_sh:
+	n_adr = mipscpu.r[ d->rs ] + d->imm;
+	if( !MIPS_PLAIN_MEMORY || ( n_adr & 1 ) != 0 )
+	{
+		goto op_interpret;
+	}
+	mips_write_word( n_adr, mipscpu.r[ d->rt ] );
+	mips_advance_pc();
+	MIPS_NEXT;
+op_sw:
+	if( ( mipscpu.cp0r[ CP0_SR ] & SR_ISC ) != 0 )
+	{
+		goto op_interpret;
+	}
+	n_adr = mipscpu.r[ d->rs ] + d->imm;
+	mips_write_dword( n_adr, mipscpu.r[ d->rt ] );
+	mips_advance_pc();
+	MIPS_NEXT;
 }
 
-static void set_irq_line( int irqline, int state )
+#undef MIPS_NEXT
+#undef MIPS_PLAIN_MEMORY
+
+void PSXMachine::set_irq_line( int irqline, int state )
 {
 	uint32_t ip;
 
@@ -1710,24 +2117,6 @@ static void set_irq_line( int irqline, int state )
 	}
 }
 
-/****************************************************************************
- * Return a formatted string for a register
- ****************************************************************************/
-
-static offs_t mips_dasm( char *buffer, offs_t pc )
-{
-	offs_t ret;
-	change_pc( pc );
-#ifdef MAME_DEBUG
-	ret = DasmMIPS( buffer, pc );
-#else
-	snprintf( buffer, 10, "$%08x", cpu_readop32( pc ) );
-	ret = 4;
-#endif
-	change_pc( mipscpu.pc );
-	return ret;
-}
-
 /* preliminary gte code */
 
 #define VXY0 ( mipscpu.cp2dr[ 0 ].d )
@@ -1841,7 +2230,7 @@ static offs_t mips_dasm( char *buffer, offs_t pc )
 #define ZSF4 ( mipscpu.cp2cr[ 30 ].w.l )
 #define FLAG ( mipscpu.cp2cr[ 31 ].d )
 
-static uint32_t getcp2dr( int n_reg )
+uint32_t PSXMachine::getcp2dr( int n_reg )
 {
 	if( n_reg == 1 || n_reg == 3 || n_reg == 5 || n_reg == 8 || n_reg == 9 || n_reg == 10 || n_reg == 11 )
 	{
@@ -1859,7 +2248,7 @@ static uint32_t getcp2dr( int n_reg )
 	return mipscpu.cp2dr[ n_reg ].d;
 }
 
-static void setcp2dr( int n_reg, uint32_t n_value )
+void PSXMachine::setcp2dr( int n_reg, uint32_t n_value )
 {
 	GTELOG( "set CP2DR%u=%08x", n_reg, n_value );
 	mipscpu.cp2dr[ n_reg ].d = n_value;
@@ -1894,19 +2283,19 @@ static void setcp2dr( int n_reg, uint32_t n_value )
 	}
 }
 
-static uint32_t getcp2cr( int n_reg )
+uint32_t PSXMachine::getcp2cr( int n_reg )
 {
 	GTELOG( "get CP2CR%u=%08x", n_reg, mipscpu.cp2cr[ n_reg ].d );
 	return mipscpu.cp2cr[ n_reg ].d;
 }
 
-static void setcp2cr( int n_reg, uint32_t n_value )
+void PSXMachine::setcp2cr( int n_reg, uint32_t n_value )
 {
 	GTELOG( "set CP2CR%u=%08x", n_reg, n_value );
 	mipscpu.cp2cr[ n_reg ].d = n_value;
 }
 
-static inline int32_t LIM( int32_t n_value, int32_t n_max, int32_t n_min, uint32_t n_flag )
+int32_t PSXMachine::LIM( int32_t n_value, int32_t n_max, int32_t n_min, uint32_t n_flag )
 {
 	if( n_value > n_max )
 	{
@@ -1921,7 +2310,7 @@ static inline int32_t LIM( int32_t n_value, int32_t n_max, int32_t n_min, uint32
 	return n_value;
 }
 
-static inline int64_t BOUNDS( int64_t n_value, int64_t n_max, int n_maxflag, int64_t n_min, int n_minflag )
+int64_t PSXMachine::BOUNDS( int64_t n_value, int64_t n_max, int n_maxflag, int64_t n_min, int n_minflag )
 {
 	if( n_value > n_max )
 	{
@@ -1945,7 +2334,7 @@ static inline int64_t BOUNDS( int64_t n_value, int64_t n_max, int n_maxflag, int
 #define Lm_C3( a ) LIM( ( a ), 0x00ff, 0x0000, ( 1 << 19 ) )
 #define Lm_D( a ) LIM( ( a ), 0xffff, 0x0000, ( 1 << 31 ) | ( 1 << 18 ) )
 
-static inline uint32_t Lm_E( uint32_t n_z )
+uint32_t PSXMachine::Lm_E( uint32_t n_z )
 {
 	if( n_z <= H / 2 )
 	{
@@ -1964,7 +2353,7 @@ static inline uint32_t Lm_E( uint32_t n_z )
 #define Lm_G2( a ) LIM( ( a ), 0x3ff, -0x400, ( 1 << 31 ) | ( 1 << 13 ) )
 #define Lm_H( a ) LIM( ( a ), 0xfff, 0x000, ( 1 << 12 ) )
 
-static void docop2( int gteop )
+void PSXMachine::docop2( int gteop )
 {
 	int n_sf;
 	int n_v;
@@ -1977,19 +2366,19 @@ static void docop2( int gteop )
 	const uint32_t **p_n_cv;
 	static const uint16_t n_zm = 0;
 	static const uint32_t n_zc = 0;
-	static const uint16_t *p_n_vx[] = { &VX0, &VX1, &VX2 };
-	static const uint16_t *p_n_vy[] = { &VY0, &VY1, &VY2 };
-	static const uint16_t *p_n_vz[] = { &VZ0, &VZ1, &VZ2 };
-	static const uint16_t *p_n_rm[] = { &R11, &R12, &R13, &R21, &R22, &R23, &R31, &R32, &R33 };
-	static const uint16_t *p_n_lm[] = { &L11, &L12, &L13, &L21, &L22, &L23, &L31, &L32, &L33 };
-	static const uint16_t *p_n_cm[] = { &LR1, &LR2, &LR3, &LG1, &LG2, &LG3, &LB1, &LB2, &LB3 };
+	const uint16_t *p_n_vx[] = { &VX0, &VX1, &VX2 };
+	const uint16_t *p_n_vy[] = { &VY0, &VY1, &VY2 };
+	const uint16_t *p_n_vz[] = { &VZ0, &VZ1, &VZ2 };
+	const uint16_t *p_n_rm[] = { &R11, &R12, &R13, &R21, &R22, &R23, &R31, &R32, &R33 };
+	const uint16_t *p_n_lm[] = { &L11, &L12, &L13, &L21, &L22, &L23, &L31, &L32, &L33 };
+	const uint16_t *p_n_cm[] = { &LR1, &LR2, &LR3, &LG1, &LG2, &LG3, &LB1, &LB2, &LB3 };
 	static const uint16_t *p_n_zm[] = { &n_zm, &n_zm, &n_zm, &n_zm, &n_zm, &n_zm, &n_zm, &n_zm, &n_zm };
-	static const uint16_t **p_p_n_mx[] = { p_n_rm, p_n_lm, p_n_cm, p_n_zm };
-	static const uint32_t *p_n_tr[] = { &TRX, &TRY, &TRZ };
-	static const uint32_t *p_n_bk[] = { &RBK, &GBK, &BBK };
-	static const uint32_t *p_n_fc[] = { &RFC, &GFC, &BFC };
+	const uint16_t **p_p_n_mx[] = { p_n_rm, p_n_lm, p_n_cm, p_n_zm };
+	const uint32_t *p_n_tr[] = { &TRX, &TRY, &TRZ };
+	const uint32_t *p_n_bk[] = { &RBK, &GBK, &BBK };
+	const uint32_t *p_n_fc[] = { &RFC, &GFC, &BFC };
 	static const uint32_t *p_n_zc[] = { &n_zc, &n_zc, &n_zc };
-	static const uint32_t **p_p_n_cv[] = { p_n_tr, p_n_bk, p_n_fc, p_n_zc };
+	const uint32_t **p_p_n_cv[] = { p_n_tr, p_n_bk, p_n_fc, p_n_zc };
 
 	switch( GTE_FUNCT( gteop ) )
 	{
@@ -2595,7 +2984,7 @@ static void docop2( int gteop )
  * Generic set_info
  **************************************************************************/
 
-void mips_set_info(uint32_t state, union cpuinfo *info)
+void PSXMachine::mips_set_info(uint32_t state, union cpuinfo *info)
 {
 	switch (state)
 	{
@@ -2754,7 +3143,7 @@ void mips_set_info(uint32_t state, union cpuinfo *info)
  * Generic get_info
  **************************************************************************/
 
-void mips_get_info(uint32_t state, union cpuinfo *info)
+void PSXMachine::mips_get_info(uint32_t state, union cpuinfo *info)
 {
 	switch (state)
 	{
@@ -2929,15 +3318,7 @@ void mips_get_info(uint32_t state, union cpuinfo *info)
 		case CPUINFO_INT_REGISTER + MIPS_CP2CR31:		info->i = mipscpu.cp2cr[ 31 ].d;		break;
 
 		/* --- the following bits of info are returned as pointers to data or functions --- */
-		case CPUINFO_PTR_SET_INFO:						info->setinfo = mips_set_info;			break;
-		case CPUINFO_PTR_GET_CONTEXT:					info->getcontext = mips_get_context;	break;
-		case CPUINFO_PTR_SET_CONTEXT:					info->setcontext = mips_set_context;	break;
-		case CPUINFO_PTR_INIT:							info->init = mips_init;					break;
-		case CPUINFO_PTR_RESET:							info->reset = mips_reset;				break;
-		case CPUINFO_PTR_EXIT:							info->exit = mips_exit;					break;
-		case CPUINFO_PTR_EXECUTE:						info->execute = mips_execute;			break;
 		case CPUINFO_PTR_BURN:							info->burn = nullptr;						break;
-		case CPUINFO_PTR_DISASSEMBLE:					info->disassemble = mips_dasm;			break;
 		case CPUINFO_PTR_IRQ_CALLBACK:					info->irqcallback = mipscpu.irq_callback; break;
 		case CPUINFO_PTR_INSTRUCTION_COUNTER:			info->icount = &mips_ICount;			break;
 		case CPUINFO_PTR_REGISTER_LAYOUT:				info->p = mips_reg_layout;				break;
@@ -2945,32 +3326,32 @@ void mips_get_info(uint32_t state, union cpuinfo *info)
 	}
 }
 
-uint32_t mips_get_cause(void)
+uint32_t PSXMachine::mips_get_cause(void)
 {
 	return mipscpu.cp0r[ CP0_CAUSE ];
 }
 
-uint32_t mips_get_status(void)
+uint32_t PSXMachine::mips_get_status(void)
 {
 	return mipscpu.cp0r[ CP0_SR ];
 }
 
-void mips_set_status(uint32_t status)
+void PSXMachine::mips_set_status(uint32_t status)
 {
 	mipscpu.cp0r[ CP0_SR ] = status;
 }
 
-uint32_t mips_get_ePC(void)
+uint32_t PSXMachine::mips_get_ePC(void)
 {
 	return mipscpu.cp0r[ CP0_EPC ];
 }
 
-int mips_get_icount(void)
+int PSXMachine::mips_get_icount(void)
 {
 	return mips_ICount;
 }
 
-void mips_set_icount(int count)
+void PSXMachine::mips_set_icount(int count)
 {
 	mips_ICount = count;
 }
@@ -2981,7 +3362,7 @@ void mips_set_icount(int count)
  * CPU-specific set_info
  **************************************************************************/
 
-void psxcpu_get_info(uint32_t state, union cpuinfo *info)
+void PSXMachine::psxcpu_get_info(uint32_t state, union cpuinfo *info)
 {
 	switch (state)
 	{
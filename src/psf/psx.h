@@ -1,9 +1,16 @@
 #ifndef _MIPS_H
 #define _MIPS_H
 
+#include <libaudcore/objects.h>
+
 #include "ao.h"
+#include "corlett.h"
+#include "osd_cpu.h"
 //#include "driver.h"
 
+#include "peops/spu.h"
+#include "peops2/spu.h"
+
 typedef void genf(void);
 typedef uint32_t offs_t;
 
@@ -281,72 +288,345 @@ enum
 extern unsigned DasmMIPS(char *buff, unsigned _pc);
 #endif
 
+#define MAX_FILE_SLOTS	(32)
+#define SEMA_MAX	(64)
+#define MAX_FS		(32)	// maximum # of filesystems (libs and subdirectories)
+
+typedef struct
+{
+	uint32_t op;
+	uint32_t pc;
+	uint32_t prevpc;
+	uint32_t delayv;
+	uint32_t delayr;
+	uint32_t hi;
+	uint32_t lo;
+	uint32_t r[ 32 ];
+	uint32_t cp0r[ 32 ];
+	PAIR cp2cr[ 32 ];
+	PAIR cp2dr[ 32 ];
+	int (*irq_callback)(int irqline);
+} mips_cpu_context;
+
+/* an instruction in the decoded instruction cache (see psx.cc) */
+typedef struct
+{
+	uint32_t op;		/* the opcode this was decoded from */
+	uint8_t handler;
+	uint8_t rs, rt, rd;
+	uint32_t imm;		/* immediate, shift amount, jump target or branch offset */
+} mips_decoded;
+
+/* one 4 KB page of main RAM */
+typedef struct
+{
+	mips_decoded ops[ 1024 ];
+} mips_code_page;
+
+/* One emulated machine: the CPU, the PSX/IOP hardware, the SPU (or SPU2) and
+ * whatever the file loaders keep around.  The player allocates one per song
+ * and passes it to every engine call, so any number of songs can be emulated
+ * at the same time, on any threads.  All state starts out zeroed, except
+ * where noted.  New state must go in here rather than in globals. */
+
+class PSXMachine
+{
+public:
+	/* eng_psf.cc */
+	int32_t psf_start(uint8_t *buffer, uint32_t length);
+	int32_t psf_execute(void (*update)(const void *, int, void *), void *user);
+	int32_t psf_stop(void);
+	int32_t psf_seek(uint32_t t) { return ::psf_seek(spu(), t); }
+	void setendless(int e) { ::setendless(spu(), e); }
+
+	/* eng_psf2.cc */
+	int32_t psf2_start(uint8_t *buffer, uint32_t length);
+	int32_t psf2_execute(void (*update)(const void *, int, void *), void *user);
+	int32_t psf2_stop(void);
+	int32_t psf2_command(int32_t, int32_t);
+	int32_t psf2_seek(uint32_t t) { return ::psf2_seek(spu2(), t); }
+	void setendless2(int e) { ::setendless2(spu2(), e); }
+
+	/* eng_spx.cc */
+	int32_t spx_start(uint8_t *buffer, uint32_t length);
+	int32_t spx_execute(void (*update)(const void *, int, void *), void *user);
+	int32_t spx_stop(void);
+
+	/* psx_hw.cc, called by the SPU */
+	void SPUirq(void);
+
+	/* set to end an engine's execute loop */
+	bool stop_flag = false;
+
+	/* where ao_get_lib() looks for libraries */
+	String dirpath;
+
+	/* PSX main RAM, also read by the SPU DMA */
+	uint32_t psx_ram[((2*1024*1024)/4)+4] {};
+	uint32_t psx_scratch[0x400] {};
+	/* backup image to restart songs */
+	uint32_t initial_ram[((2*1024*1024)/4)+4] {};
+	uint32_t initial_scratch[0x400] {};
+
+private:
+	/* the SPUs are created on first use */
+	PSXSPU *spu()
+	{
+		if (!m_spu)
+			m_spu.capture(SPUcreate(this));
+		return m_spu.get();
+	}
+
+	PS2SPU *spu2()
+	{
+		if (!m_spu2)
+			m_spu2.capture(SPU2create(this));
+		return m_spu2.get();
+	}
+
+	SmartPtr<PSXSPU, SPUdestroy> m_spu;
+	SmartPtr<PS2SPU, SPU2destroy> m_spu2;
+
+	/* psx.cc */
+	void GTELOG(const char *a,...);
+	inline void mips_set_cp0r( int reg, uint32_t value );
+	inline void mips_commit_delayed_load( void );
+	inline void mips_delayed_branch( uint32_t n_adr );
+	inline void mips_set_pc( unsigned val );
+	inline void mips_advance_pc( void );
+	inline void mips_load( uint32_t n_r, uint32_t n_v );
+	inline void mips_delayed_load( uint32_t n_r, uint32_t n_v );
+	void mips_exception( int exception );
+	inline uint8_t mips_read_byte( offs_t address );
+	inline uint16_t mips_read_word( offs_t address );
+	inline uint32_t mips_read_dword( offs_t address );
+	inline void mips_write_masked( offs_t address, uint32_t data, uint32_t mem_mask );
+	inline void mips_write_byte( offs_t address, uint8_t data );
+	inline void mips_write_word( offs_t address, uint16_t data );
+	inline void mips_write_dword( offs_t address, uint32_t data );
+	void set_irq_line( int irqline, int state );
+	uint32_t getcp2dr( int n_reg );
+	void setcp2dr( int n_reg, uint32_t n_value );
+	uint32_t getcp2cr( int n_reg );
+	void setcp2cr( int n_reg, uint32_t n_value );
+	inline int32_t LIM( int32_t n_value, int32_t n_max, int32_t n_min, uint32_t n_flag );
+	inline int64_t BOUNDS( int64_t n_value, int64_t n_max, int n_maxflag, int64_t n_min, int n_minflag );
+	inline uint32_t Lm_E( uint32_t n_z );
+	void docop2( int gteop );
+	void mips_interpret( void );
+	mips_decoded *mips_decode( uint32_t pc, uint32_t op );
+	inline __attribute__((always_inline)) const mips_decoded *mips_fetch( void );
+
+	void mips_init(void);
+	void mips_reset(void *param);
+	void mips_shorten_frame(void);
+	int mips_execute(int cycles);
+	void mips_set_info(uint32_t state, union cpuinfo *info);
+	void mips_get_info(uint32_t state, union cpuinfo *info);
+	uint32_t mips_get_cause(void);
+	uint32_t mips_get_status(void);
+	void mips_set_status(uint32_t status);
+	uint32_t mips_get_ePC(void);
+	int mips_get_icount(void);
+	void mips_set_icount(int count);
 #if (HAS_PSXCPU)
-extern void psxcpu_get_info(uint32_t state, union cpuinfo *info);
+	void psxcpu_get_info(uint32_t state, union cpuinfo *info);
 #endif
 
-/* eng_psf.cc */
-extern int psf_refresh;
-
-int32_t psf_start(uint8_t *buffer, uint32_t length);
-int32_t psf_execute(void (*update)(const void *, int));
-int32_t psf_stop(void);
-
-/* eng_psf2.cc */
-uint32_t psf2_load_elf(uint8_t *start, uint32_t len);
-uint32_t psf2_load_file(const char *file, uint8_t *buf, uint32_t buflen);
-int32_t psf2_start(uint8_t *, uint32_t length);
-int32_t psf2_execute(void (*update)(const void *, int));
-int32_t psf2_stop(void);
-int32_t psf2_command(int32_t, int32_t);
-uint32_t psf2_get_loadaddr(void);
-void psf2_set_loadaddr(uint32_t addr);
-
-/* eng_spx.cc */
-int32_t spx_start(uint8_t *buffer, uint32_t length);
-int32_t spx_execute(void (*update)(const void *, int));
-int32_t spx_stop(void);
-
-/* plugin.cc */
-extern bool stop_flag;
-
-/* psx.cc */
-void mips_init(void);
-void mips_reset(void *param);
-void mips_shorten_frame(void);
-int mips_execute(int cycles);
-void mips_set_info(uint32_t state, union cpuinfo *info);
-void mips_get_info(uint32_t state, union cpuinfo *info);
-uint32_t mips_get_cause(void);
-uint32_t mips_get_status(void);
-void mips_set_status(uint32_t status);
-uint32_t mips_get_ePC(void);
-int mips_get_icount(void);
-void mips_set_icount(int count);
-
-/* psx_hw.cc */
-extern uint32_t psx_ram[((2*1024*1024)/4)+4];
-extern uint32_t psx_scratch[0x400];
-extern uint32_t initial_ram[((2*1024*1024)/4)+4];
-extern uint32_t initial_scratch[0x400];
-
-void psx_hw_slice(void);
-void ps2_hw_slice(void);
-void psx_hw_frame(void);
-void ps2_hw_frame(void);
-
-void psx_hw_init(void);
-void psx_bios_hle(uint32_t pc);
-void psx_hw_runcounters(void);
-
-uint8_t program_read_byte_32le(offs_t address);
-uint16_t program_read_word_32le(offs_t address);
-uint32_t program_read_dword_32le(offs_t address);
-
-void program_write_byte_32le(offs_t address, uint8_t data);
-void program_write_word_32le(offs_t address, uint16_t data);
-void program_write_dword_32le(offs_t address, uint32_t data);
-
-void psx_iop_call(uint32_t pc, uint32_t callnum);
+	mips_cpu_context mipscpu {};
+	int mips_ICount = 0;
+
+	/* decoded instruction cache, a page is allocated when first executed */
+	SmartPtr<mips_code_page> mips_code[ ( 2 * 1024 * 1024 ) / 4096 ];
+
+	/* psx_hw.cc */
+	typedef struct
+	{
+		char name[10];
+		uint32_t dispatch;
+	} ExternLibEntries;
+
+	typedef struct
+	{
+		uint32_t type;
+		uint32_t value;
+		uint32_t param;
+		int    inUse;
+	} EventFlag;
+
+	typedef struct
+	{
+		uint32_t attr;
+		uint32_t option;
+		int32_t init;
+		int32_t current;
+		int32_t max;
+		int32_t threadsWaiting;
+		int32_t inuse;
+	} Semaphore;
+
+	// thread states
+	enum
+	{
+		TS_RUNNING = 0,		// now running
+		TS_READY,		// ready to run
+		TS_WAITEVFLAG,		// waiting on an event flag
+		TS_WAITSEMA,		// waiting on a semaphore
+		TS_WAITDELAY,		// waiting on a time delay
+		TS_SLEEPING,		// sleeping
+		TS_CREATED,		// newly created, hasn't run yet
+
+		TS_MAXSTATE
+	};
+
+	typedef struct
+	{
+		int32_t  iState;		// state of thread
+
+		uint32_t flags;		// flags
+		uint32_t routine;		// start of code for the thread
+		uint32_t stackloc;	// stack location in IOP RAM
+		uint32_t stacksize;	// stack size
+		uint32_t refCon;		// user value passed in at CreateThread time
+
+		uint32_t waitparm;	// what we're waiting on if in one the TS_WAIT* states
+
+		uint32_t save_regs[37];	// CPU registers belonging to this thread
+	} Thread;
+
+	typedef struct
+	{
+		int32_t  iActive;
+		uint32_t count;
+		uint32_t target;
+		uint32_t source;
+		uint32_t prescale;
+		uint32_t handler;
+		uint32_t hparam;
+		uint32_t mode;
+	} IOPTimer;
+
+	typedef struct
+	{
+		uint32_t count;
+		uint32_t mode;
+		uint32_t target;
+		uint32_t sysclock;
+		uint32_t interrupt;
+	} Counter;
+
+	typedef struct
+	{
+		uint32_t desc;
+		int32_t status;
+		int32_t mode;
+		uint32_t fhandler;
+	} EvtCtrlBlk[32];
+
+	void FreezeThread(int32_t iThread, int flag);
+	void ThawThread(int32_t iThread);
+	void ps2_reschedule(void);
+	void psx_irq_update(void);
+	void psx_irq_set(uint32_t irq);
+	uint32_t psx_hw_read(offs_t offset, uint32_t mem_mask);
+	void psx_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr);
+	void ps2_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr);
+	void ps2_dma7(uint32_t madr, uint32_t bcr, uint32_t chcr);
+	void psx_hw_write(offs_t offset, uint32_t data, uint32_t mem_mask);
+	void call_irq_routine(uint32_t routine, uint32_t parameter);
+	void psx_bios_exception(uint32_t pc);
+	void iop_sprintf(char *out, char *fmt, uint32_t pstart);
+
+	void psx_hw_slice(void);
+	void ps2_hw_slice(void);
+	void psx_hw_frame(void);
+	void ps2_hw_frame(void);
+
+	void psx_hw_init(void);
+	void psx_bios_hle(uint32_t pc);
+	void psx_hw_runcounters(void);
+
+	uint8_t program_read_byte_32le(offs_t address);
+	uint16_t program_read_word_32le(offs_t address);
+	uint32_t program_read_dword_32le(offs_t address);
+
+	void program_write_byte_32le(offs_t address, uint8_t data);
+	void program_write_word_32le(offs_t address, uint16_t data);
+	void program_write_dword_32le(offs_t address, uint32_t data);
+
+	void psx_iop_call(uint32_t pc, uint32_t callnum);
+
+	volatile int softcall_target = 0;
+	int filestat[MAX_FILE_SLOTS] {};
+	uint8_t *filedata[MAX_FILE_SLOTS] {};
+	uint32_t filesize[MAX_FILE_SLOTS] {}, filepos[MAX_FILE_SLOTS] {};
+	int intr_susp = 0;
+
+	uint64_t sys_time = 0;
+	int timerexp = 0;
+
+	int32_t iNumLibs = 0;
+	ExternLibEntries reglibs[32] {};
+
+	int32_t iNumFlags = 0;
+	EventFlag evflags[32] {};
+
+	int32_t iNumSema = 0;
+	Semaphore semaphores[SEMA_MAX] {};
+
+	int32_t iNumThreads = 0, iCurThread = 0;
+	Thread threads[32] {};
+
+	IOPTimer iop_timers[8] {};
+	int32_t iNumTimers = 0;
+
+	Counter root_cnts[4] {};	// 4 of the bastards
+
+	EvtCtrlBlk *Event = nullptr;
+	EvtCtrlBlk *CounterEvent = nullptr;
+
+	uint32_t spu_delay = 0, dma_icr = 0, irq_data = 0, irq_mask = 0, dma_timer = 0, WAI = 0;
+	uint32_t dma4_madr = 0, dma4_bcr = 0, dma4_chcr = 0, dma4_delay = 0;
+	uint32_t dma7_madr = 0, dma7_bcr = 0, dma7_chcr = 0, dma7_delay = 0;
+	uint32_t dma4_cb = 0, dma7_cb = 0, dma4_fval = 0, dma4_flag = 0, dma7_fval = 0, dma7_flag = 0;
+	uint32_t irq9_cb = 0, irq9_fval = 0, irq9_flag = 0;
+
+	uint32_t gpu_stat = 0;
+	int fcnt = 0;
+
+	uint32_t heap_addr = 0, entry_int = 0;
+	uint32_t irq_regs[37] {};
+	int irq_mutex = 0;
+
+	/* eng_psf.cc, eng_psf2.cc */
+	corlett_t *c = nullptr;
+	char psfby[256] {};
+	int psf_refresh = -1;
+	uint32_t initialPC = 0, initialGP = 0, initialSP = 0;
+
+	/* eng_psf2.cc */
+	uint32_t psf2_load_elf(uint8_t *start, uint32_t len);
+	uint32_t load_file(int fs, const char *file, uint8_t *buf, uint32_t buflen);
+	uint32_t psf2_load_file(const char *file, uint8_t *buf, uint32_t buflen);
+	uint32_t psf2_get_loadaddr(void);
+	void psf2_set_loadaddr(uint32_t addr);
+
+	uint32_t loadAddr = 0, lengthMS = 0, fadeMS = 0;
+
+	uint8_t *filesys[MAX_FS] {};
+	Index<char> lib_raw_file;
+	uint32_t fssize[MAX_FS] {};
+	int num_fs = 0;
+
+	uint32_t hi16offs = 0, hi16target = 0;	// carried between REL records
+
+	/* eng_spx.cc */
+	void spx_tick(void);
+
+	uint8_t *start_of_file = nullptr, *song_ptr = nullptr;
+	uint32_t cur_tick = 0, cur_event = 0, num_events = 0, next_tick = 0, end_tick = 0;
+	int old_fmt = 0;
+	char name[128] {}, song[128] {}, company[128] {};
+};
 
 #endif
@@ -67,120 +67,14 @@
 
 #define LE32(x) FROM_LE32(x)
 
-#define MAX_FILE_SLOTS	(32)
-
-static volatile int softcall_target = 0;
-static int filestat[MAX_FILE_SLOTS];
-static uint8_t *filedata[MAX_FILE_SLOTS];
-static uint32_t filesize[MAX_FILE_SLOTS], filepos[MAX_FILE_SLOTS];
-static void call_irq_routine(uint32_t routine, uint32_t parameter);
-static int intr_susp = 0;
-
-static uint64_t sys_time;
-static int timerexp = 0;
-
-typedef struct
-{
-	char name[10];
-	uint32_t dispatch;
-} ExternLibEntries;
-
-static int32_t iNumLibs;
-static ExternLibEntries	reglibs[32];
-
-typedef struct
-{
-	uint32_t type;
-	uint32_t value;
-	uint32_t param;
-	int    inUse;
-} EventFlag;
-
-static int32_t iNumFlags;
-static EventFlag evflags[32];
-
-typedef struct
-{
-	uint32_t attr;
-	uint32_t option;
-	int32_t init;
-	int32_t current;
-	int32_t max;
-	int32_t threadsWaiting;
-	int32_t inuse;
-} Semaphore;
-
-#define SEMA_MAX	(64)
-
-static int32_t iNumSema;
-static Semaphore semaphores[SEMA_MAX];
-
-// thread states
-enum
-{
-	TS_RUNNING = 0,		// now running
-	TS_READY,		// ready to run
-	TS_WAITEVFLAG,		// waiting on an event flag
-	TS_WAITSEMA,		// waiting on a semaphore
-	TS_WAITDELAY,		// waiting on a time delay
-	TS_SLEEPING,		// sleeping
-	TS_CREATED,		// newly created, hasn't run yet
-
-	TS_MAXSTATE
-};
-
-typedef struct
-{
-	int32_t  iState;		// state of thread
-
-	uint32_t flags;		// flags
-	uint32_t routine;		// start of code for the thread
-	uint32_t stackloc;	// stack location in IOP RAM
-	uint32_t stacksize;	// stack size
-	uint32_t refCon;		// user value passed in at CreateThread time
-
-	uint32_t waitparm;	// what we're waiting on if in one the TS_WAIT* states
-
-	uint32_t save_regs[37];	// CPU registers belonging to this thread
-} Thread;
-
-static int32_t iNumThreads, iCurThread;
-static Thread threads[32];
-
 #if DEBUG_THREADING
-static char *_ThreadStateNames[TS_MAXSTATE] = { "RUNNING", "READY", "WAITEVFLAG", "WAITSEMA", "WAITDELAY", "SLEEPING", "CREATED" };
+static char *_ThreadStateNames[] = { "RUNNING", "READY", "WAITEVFLAG", "WAITSEMA", "WAITDELAY", "SLEEPING", "CREATED" };
 #endif
 
 #if DEBUG_HLE_IOP
 static char *seek_types[3] = { "SEEK_SET", "SEEK_CUR", "SEEK_END" };
 #endif
 
-typedef struct
-{
-	int32_t  iActive;
-	uint32_t count;
-	uint32_t target;
-	uint32_t source;
-	uint32_t prescale;
-	uint32_t handler;
-	uint32_t hparam;
-	uint32_t mode;
-} IOPTimer;
-
-static IOPTimer iop_timers[8];
-static int32_t iNumTimers;
-
-typedef struct
-{
-	uint32_t count;
-	uint32_t mode;
-	uint32_t target;
-	uint32_t sysclock;
-	uint32_t interrupt;
-} Counter;
-
-static Counter root_cnts[4];	// 4 of the bastards
-
 #define CLOCK_DIV	(8)	// 33 MHz / this = what we run the R3000 at to keep the CPU usage not insane
 
 // counter modes
@@ -191,17 +85,6 @@ static Counter root_cnts[4];	// 4 of the bastards
 #define RC_CLC		(0x0100)	// counter uses direct system clock
 #define RC_DIV8		(0x0200)	// (counter 2 only) system clock/8
 
-typedef struct
-{
-	uint32_t desc;
-	int32_t status;
-	int32_t mode;
-	uint32_t fhandler;
-} EvtCtrlBlk[32];
-
-static EvtCtrlBlk *Event;
-static EvtCtrlBlk *CounterEvent;
-
 // Sony event states
 #define EvStUNUSED	0x0000
 #define EvStWAIT	0x1000
@@ -212,21 +95,8 @@ static EvtCtrlBlk *CounterEvent;
 #define EvMdINTR	0x1000
 #define EvMdNOINTR	0x2000
 
-// PSX main RAM
-uint32_t psx_ram[(2*1024*1024)/4+4];
-uint32_t psx_scratch[0x400];
-// backup image to restart songs
-uint32_t initial_ram[(2*1024*1024)/4+4];
-uint32_t initial_scratch[0x400];
-
-static uint32_t spu_delay, dma_icr, irq_data, irq_mask, dma_timer, WAI;
-static uint32_t dma4_madr, dma4_bcr, dma4_chcr, dma4_delay;
-static uint32_t dma7_madr, dma7_bcr, dma7_chcr, dma7_delay;
-static uint32_t dma4_cb, dma7_cb, dma4_fval, dma4_flag, dma7_fval, dma7_flag;
-static uint32_t irq9_cb, irq9_fval, irq9_flag;
-
 // take a snapshot of the CPU state for a thread
-static void FreezeThread(int32_t iThread, int flag)
+void PSXMachine::FreezeThread(int32_t iThread, int flag)
 {
 	int i;
 	union cpuinfo mipsinfo;
@@ -280,7 +150,7 @@ static void FreezeThread(int32_t iThread, int flag)
 }
 
 // restore the CPU state from a thread's snapshot
-static void ThawThread(int32_t iThread)
+void PSXMachine::ThawThread(int32_t iThread)
 {
 	int i;
 	union cpuinfo mipsinfo;
@@ -334,7 +204,7 @@ static void ThawThread(int32_t iThread)
 }
 
 // find a new thread to run
-static void ps2_reschedule(void)
+void PSXMachine::ps2_reschedule(void)
 {
 	int i, starti, iNextThread;
 
@@ -427,7 +297,7 @@ static void ps2_reschedule(void)
 	}
 }
 
-static void psx_irq_update(void)
+void PSXMachine::psx_irq_update(void)
 {
 	union cpuinfo mipsinfo;
 
@@ -445,16 +315,14 @@ static void psx_irq_update(void)
 	}
 }
 
-static void psx_irq_set(uint32_t irq)
+void PSXMachine::psx_irq_set(uint32_t irq)
 {
 	irq_data |= irq;
 
 	psx_irq_update();
 }
 
-static uint32_t gpu_stat = 0;
-
-static uint32_t psx_hw_read(offs_t offset, uint32_t mem_mask)
+uint32_t PSXMachine::psx_hw_read(offs_t offset, uint32_t mem_mask)
 {
 	if (offset <= 0x007fffff)
 	{
@@ -496,14 +364,14 @@ static uint32_t psx_hw_read(offs_t offset, uint32_t mem_mask)
 			#if DEBUG_SPU
 			printf("SPU: readRegister(%x)\n", offset);
 			#endif
-			return SPUreadRegister(offset) & ~mem_mask;
+			return SPUreadRegister(spu(), offset) & ~mem_mask;
 		}
 		else if (mem_mask == 0x0000ffff)
 		{
 			#if DEBUG_SPU
 			printf("SPU: readRegister(%x)\n", offset);
 			#endif
-			return SPUreadRegister(offset)<<16;
+			return SPUreadRegister(spu(), offset)<<16;
 		}
 		else printf("SPU: read unknown mask %08x\n", mem_mask);
 	}
@@ -512,15 +380,15 @@ static uint32_t psx_hw_read(offs_t offset, uint32_t mem_mask)
 	{
 		if ((mem_mask == 0xffff0000) || (mem_mask == 0xffffff00))
 		{
-			return SPU2read(offset) & ~mem_mask;
+			return SPU2read(spu2(), offset) & ~mem_mask;
 		}
 		else if (mem_mask == 0x0000ffff)
 		{
-			return SPU2read(offset)<<16;
+			return SPU2read(spu2(), offset)<<16;
 		}
 		else if (mem_mask == 0)
 		{
-			return SPU2read(offset) | SPU2read(offset+2)<<16;
+			return SPU2read(spu2(), offset) | SPU2read(spu2(), offset+2)<<16;
 		}
 		else printf("SPU2: read unknown mask %08x\n", mem_mask);
 	}
@@ -583,7 +451,7 @@ static uint32_t psx_hw_read(offs_t offset, uint32_t mem_mask)
 	return 0;
 }
 
-static void psx_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr)
+void PSXMachine::psx_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr)
 {
 	if (chcr == 0x01000201)	// cpu to SPU
 	{
@@ -591,7 +459,7 @@ static void psx_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr)
 		printf("DMA4: RAM %08x to SPU\n", madr);
 		#endif
 		bcr = (bcr>>16) * (bcr & 0xffff) * 2;
-		SPUwriteDMAMem(madr&0x1fffff, bcr);
+		SPUwriteDMAMem(spu(), madr&0x1fffff, bcr);
 	}
 	else
 	{
@@ -599,11 +467,11 @@ static void psx_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr)
 		printf("DMA4: SPU to RAM %08x\n", madr);
 		#endif
 		bcr = (bcr>>16) * (bcr & 0xffff) * 2;
-		SPUreadDMAMem(madr&0x1fffff, bcr);
+		SPUreadDMAMem(spu(), madr&0x1fffff, bcr);
 	}
 }
 
-static void ps2_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr)
+void PSXMachine::ps2_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr)
 {
 	if (chcr == 0x01000201)	// cpu to SPU2
 	{
@@ -611,7 +479,7 @@ static void ps2_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr)
 		printf("DMA4: RAM %08x to SPU2\n", madr);
 		#endif
 		bcr = (bcr>>16) * (bcr & 0xffff) * 4;
-		SPU2writeDMA4Mem(madr&0x1fffff, bcr);
+		SPU2writeDMA4Mem(spu2(), madr&0x1fffff, bcr);
 	}
 	else
 	{
@@ -619,13 +487,13 @@ static void ps2_dma4(uint32_t madr, uint32_t bcr, uint32_t chcr)
 		printf("DMA4: SPU2 to RAM %08x\n", madr);
 		#endif
 		bcr = (bcr>>16) * (bcr & 0xffff) * 4;
-		SPU2readDMA4Mem(madr&0x1fffff, bcr);
+		SPU2readDMA4Mem(spu2(), madr&0x1fffff, bcr);
 	}
 
 	dma4_delay = 80;
 }
 
-static void ps2_dma7(uint32_t madr, uint32_t bcr, uint32_t chcr)
+void PSXMachine::ps2_dma7(uint32_t madr, uint32_t bcr, uint32_t chcr)
 {
 	if ((chcr == 0x01000201) || (chcr == 0x00100010) || (chcr == 0x000f0010) || (chcr == 0x00010010))	// cpu to SPU2
 	{
@@ -633,7 +501,7 @@ static void ps2_dma7(uint32_t madr, uint32_t bcr, uint32_t chcr)
 		printf("DMA7: RAM %08x to SPU2\n", madr);
 		#endif
 		bcr = (bcr>>16) * (bcr & 0xffff) * 4;
-		SPU2writeDMA7Mem(madr&0x1fffff, bcr);
+		SPU2writeDMA7Mem(spu2(), madr&0x1fffff, bcr);
 	}
 	else
 	{
@@ -641,23 +509,19 @@ static void ps2_dma7(uint32_t madr, uint32_t bcr, uint32_t chcr)
 		printf("DMA7: SPU2 to RAM %08x\n", madr);
 		#endif
 		bcr = (bcr>>16) * (bcr & 0xffff) * 4;
-//		SPU2readDMA7Mem(madr&0x1fffff, bcr);
+//		SPU2readDMA7Mem(spu2(), madr&0x1fffff, bcr);
 	}
 
 	dma7_delay = 80;
 }
 
-static void psx_hw_write(offs_t offset, uint32_t data, uint32_t mem_mask)
+void PSXMachine::psx_hw_write(offs_t offset, uint32_t data, uint32_t mem_mask)
 {
-	union cpuinfo mipsinfo;
-
 	if (offset <= 0x007fffff)
 	{
 		offset &= 0x1fffff;
 //		if (offset < 0x10000) printf("Write %x to kernel @ %x\n", data, offset);
 
-		mips_get_info(CPUINFO_INT_PC, &mipsinfo);
-
 		psx_ram[offset>>2] &= LE32(mem_mask);
 		psx_ram[offset>>2] |= LE32(data);
 		return;
@@ -667,7 +531,6 @@ static void psx_hw_write(offs_t offset, uint32_t data, uint32_t mem_mask)
 	{
 		offset &= 0x1fffff;
 //		if (offset < 0x10000) printf("Write %x to kernel @ %x\n", data, offset);
-		mips_get_info(CPUINFO_INT_PC, &mipsinfo);
 		psx_ram[offset>>2] &= LE32(mem_mask);
 		psx_ram[offset>>2] |= LE32(data);
 		return;
@@ -684,12 +547,12 @@ static void psx_hw_write(offs_t offset, uint32_t data, uint32_t mem_mask)
 	{
 		if (mem_mask == 0xffff0000)
 		{
-			SPUwriteRegister(offset, data);
+			SPUwriteRegister(spu(), offset, data);
 			return;
 		}
 		else if (mem_mask == 0x0000ffff)
 		{
-			SPUwriteRegister(offset, data>>16);
+			SPUwriteRegister(spu(), offset, data>>16);
 			return;
 		}
 		else printf("SPU: write unknown mask %08x\n", mem_mask);
@@ -699,18 +562,18 @@ static void psx_hw_write(offs_t offset, uint32_t data, uint32_t mem_mask)
 	{
 		if (mem_mask == 0xffff0000)
 		{
-			SPU2write(offset, data);
+			SPU2write(spu2(), offset, data);
 			return;
 		}
 		else if (mem_mask == 0x0000ffff)
 		{
-			SPU2write(offset, data>>16);
+			SPU2write(spu2(), offset, data>>16);
 			return;
 		}
 		else if (mem_mask == 0)
 		{
-			SPU2write(offset, data & 0xffff);
-			SPU2write(offset+2, data>>16);
+			SPU2write(spu2(), offset, data & 0xffff);
+			SPU2write(spu2(), offset+2, data>>16);
 			return;
 		}
 		else printf("SPU2: write unknown mask %08x\n", mem_mask);
@@ -845,7 +708,7 @@ static void psx_hw_write(offs_t offset, uint32_t data, uint32_t mem_mask)
 }
 
 // called per sample, 1/44100th of a second (768 clock cycles)
-void psx_hw_slice(void)
+void PSXMachine::psx_hw_slice(void)
 {
 	psx_hw_runcounters();
 
@@ -863,7 +726,7 @@ void psx_hw_slice(void)
 	}
 }
 
-void ps2_hw_slice(void)
+void PSXMachine::ps2_hw_slice(void)
 {
 	int i = 0;
 
@@ -889,9 +752,7 @@ void ps2_hw_slice(void)
 	}
 }
 
-static int fcnt = 0;
-
-void psx_hw_frame(void)
+void PSXMachine::psx_hw_frame(void)
 {
 	if (psf_refresh == 50)
 	{
@@ -912,7 +773,7 @@ void psx_hw_frame(void)
 	}
 }
 
-void ps2_hw_frame(void)
+void PSXMachine::ps2_hw_frame(void)
 {
 	ps2_reschedule();
 }
@@ -928,13 +789,7 @@ enum
 	BLK_BK = 12
 };
 
-static uint32_t heap_addr, entry_int = 0;
-
-static uint32_t irq_regs[37];
-
-static int irq_mutex = 0;
-
-static void call_irq_routine(uint32_t routine, uint32_t parameter)
+void PSXMachine::call_irq_routine(uint32_t routine, uint32_t parameter)
 {
 	int j, oldICount;
 	union cpuinfo mipsinfo;
@@ -1010,7 +865,7 @@ static void call_irq_routine(uint32_t routine, uint32_t parameter)
 	irq_mutex = 0;
 }
 
-static void psx_bios_exception(uint32_t pc)
+void PSXMachine::psx_bios_exception(uint32_t pc)
 {
 	uint32_t a0, status;
 	union cpuinfo mipsinfo;
@@ -1249,7 +1104,7 @@ static uint32_t calc_spec(uint32_t a1)
 	return spec;
 }
 
-void psx_hw_init(void)
+void PSXMachine::psx_hw_init(void)
 {
 	timerexp = 0;
 
@@ -1313,7 +1168,7 @@ void psx_hw_init(void)
 	root_cnts[3].interrupt = 1;
 }
 
-void psx_bios_hle(uint32_t pc)
+void PSXMachine::psx_bios_hle(uint32_t pc)
 {
 	uint32_t subcall, status;
 	union cpuinfo mipsinfo;
@@ -1835,7 +1690,7 @@ void psx_bios_hle(uint32_t pc)
 
 // root counters
 
-void psx_hw_runcounters(void)
+void PSXMachine::psx_hw_runcounters(void)
 {
 	int i;
 
@@ -1848,7 +1703,7 @@ void psx_hw_runcounters(void)
 
 			if (dma4_delay == 0)
 			{
-				SPU2interruptDMA4();
+				SPU2interruptDMA4(spu2());
 
 				if (dma4_cb)
 				{
@@ -1863,7 +1718,7 @@ void psx_hw_runcounters(void)
 
 			if (dma7_delay == 0)
 			{
-				SPU2interruptDMA7();
+				SPU2interruptDMA7(spu2());
 
 				if (dma7_cb)
 				{
@@ -1948,14 +1803,14 @@ void psx_hw_runcounters(void)
 
 // PEOpS callbacks
 
-void SPUirq(void)
+void PSXMachine::SPUirq(void)
 {
 //	psx_irq_set(0x200);
 }
 
 // PSXCPU callbacks
 
-uint8_t program_read_byte_32le(offs_t address)
+uint8_t PSXMachine::program_read_byte_32le(offs_t address)
 {
 	switch (address & 0x3)
 	{
@@ -1976,7 +1831,7 @@ uint8_t program_read_byte_32le(offs_t address)
 	return psx_hw_read(address, 0xffffff00);
 }
 
-uint16_t program_read_word_32le(offs_t address)
+uint16_t PSXMachine::program_read_word_32le(offs_t address)
 {
 	if (address & 2)
 		return psx_hw_read(address, 0x0000ffff)>>16;
@@ -1984,12 +1839,12 @@ uint16_t program_read_word_32le(offs_t address)
 	return psx_hw_read(address, 0xffff0000);
 }
 
-uint32_t program_read_dword_32le(offs_t address)
+uint32_t PSXMachine::program_read_dword_32le(offs_t address)
 {
 	return psx_hw_read(address, 0);
 }
 
-void program_write_byte_32le(offs_t address, uint8_t data)
+void PSXMachine::program_write_byte_32le(offs_t address, uint8_t data)
 {
 	switch (address & 0x3)
 	{
@@ -2008,7 +1863,7 @@ void program_write_byte_32le(offs_t address, uint8_t data)
 	}
 }
 
-void program_write_word_32le(offs_t address, uint16_t data)
+void PSXMachine::program_write_word_32le(offs_t address, uint16_t data)
 {
 	if (address & 2)
 	{
@@ -2019,13 +1874,13 @@ void program_write_word_32le(offs_t address, uint16_t data)
 	psx_hw_write(address, data, 0xffff0000);
 }
 
-void program_write_dword_32le(offs_t address, uint32_t data)
+void PSXMachine::program_write_dword_32le(offs_t address, uint32_t data)
 {
 	psx_hw_write(address, data, 0);
 }
 
 // sprintf replacement
-static void iop_sprintf(char *out, char *fmt, uint32_t pstart)
+void PSXMachine::iop_sprintf(char *out, char *fmt, uint32_t pstart)
 {
 	char temp[64], tfmt[64];
 	char *cf, *pstr;
@@ -2121,7 +1976,7 @@ static void iop_sprintf(char *out, char *fmt, uint32_t pstart)
 }
 
 // PS2 IOP callbacks
-void psx_iop_call(uint32_t pc, uint32_t callnum)
+void PSXMachine::psx_iop_call(uint32_t pc, uint32_t callnum)
 {
 	uint32_t scan;
 	char *mname, *str1, name[9], out[512];
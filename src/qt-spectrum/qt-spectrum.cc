@@ -30,11 +30,13 @@
 #include <libaudcore/plugin.h>
 #include <libaudqt/libaudqt.h>
 
+#include "../vis-common/bandmap.h"
+
 #define MAX_BANDS   (256)
 #define VIS_DELAY 2 /* delay before falloff in frames */
 #define VIS_FALLOFF 2 /* falloff in pixels per frame */
 
-static float xscale[MAX_BANDS + 1];
+static BandMapper mapper;
 static int bands;
 static int bars[MAX_BANDS + 1];
 static int delay[MAX_BANDS + 1];
@@ -88,7 +90,7 @@ void SpectrumWidget::resizeEvent (QResizeEvent * event)
 {
     bands = width () / 10;
     bands = aud::clamp(bands, 12, MAX_BANDS);
-    Visualizer::compute_log_xscale (xscale, bands);
+    mapper.init (bands);
     update ();
 }
 
@@ -126,10 +128,13 @@ void QtSpectrum::render_freq (const float * freq)
     if (! bands)
         return;
 
+    float db[MAX_BANDS];
+    mapper.compute_db (freq, db);
+
     for (int i = 0; i < bands; i ++)
     {
         /* 40 dB range */
-        int x = 40 + compute_freq_band (freq, xscale, i, bands);
+        int x = 40 + db[i];
         x = aud::clamp (x, 0, 40);
 
         bars[i] -= aud::max (0, VIS_FALLOFF - delay[i]);
@@ -27,9 +27,13 @@
 
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
+#include <libaudcore/runtime.h>
 
-#include <QOpenGLWidget>
+#include <QOpenGLContext>
 #include <QOpenGLFunctions_2_0>
+#include <QOpenGLWidget>
+
+#include "../vis-common/bandmap.h"
 
 #define NUM_BANDS 32
 #define DB_RANGE 40
@@ -69,12 +73,48 @@ public:
 
 EXPORT GLSpectrumQt aud_plugin_instance;
 
-static float logscale[NUM_BANDS + 1];
+static BandMapper mapper;
 static float colors[NUM_BANDS][NUM_BANDS][3];
 
 static int s_pos = 0;
 static float s_angle = 25, s_anglespeed = 0.05f;
-static float s_bars[NUM_BANDS][NUM_BANDS];
+
+/* ring of the last NUM_BANDS frames, newest first from s_pos; stored twice so
+ * that these rows are always contiguous and can be uploaded in one piece */
+static float s_bars[2 * NUM_BANDS][NUM_BANDS];
+static bool s_bars_dirty = true;
+
+/* retained-mode renderer: a single bar mesh drawn NUM_BANDS x NUM_BANDS times,
+ * with position and color per instance and height read from the s_bars ring */
+enum {
+    ATTR_CORNER,
+    ATTR_OFFSET,
+    ATTR_COLOR,
+    ATTR_HEIGHT
+};
+
+#define MESH_VERTICES 24
+
+static const char vertex_shader[] =
+ "#version 110\n"
+ "attribute vec4 corner;\n"  /* unit bar corner and shading factor */
+ "attribute vec2 offset;\n"
+ "attribute vec3 color;\n"
+ "attribute float height;\n"
+ "void main ()\n"
+ "{\n"
+ "    float h = 1.6 * height;\n"
+ "    gl_FrontColor = vec4 (color * (0.2 + 0.8 * h) * corner.w, 1.0);\n"
+ "    gl_Position = gl_ModelViewProjectionMatrix * vec4 (offset.x + corner.x,\n"
+ "     h * corner.y, offset.y + corner.z, 1.0);\n"
+ "}\n";
+
+static const char fragment_shader[] =
+ "#version 110\n"
+ "void main ()\n"
+ "{\n"
+ "    gl_FragColor = gl_Color;\n"
+ "}\n";
 
 class GLSpectrumWidget : public QOpenGLWidget, protected QOpenGLFunctions_2_0
 {
@@ -91,14 +131,25 @@ private:
     void draw_bar (float x, float z, float h, float r, float g, float b);
     void draw_rectangle (float x1, float y1, float z1, float x2, float y2,
                          float z2, float r, float g, float b);
+
+    void draw_instanced ();
+    GLuint compile_shader (GLenum type, const char * source);
+    bool create_program ();
+    void create_renderer ();
+    void destroy_renderer ();
+
+    PFNGLVERTEXATTRIBDIVISORPROC m_VertexAttribDivisor = nullptr;
+    PFNGLDRAWARRAYSINSTANCEDPROC m_DrawArraysInstanced = nullptr;
+
+    GLuint m_program = 0;
+    GLuint m_mesh_vbo = 0, m_instance_vbo = 0, m_height_vbo = 0;
 };
 
 GLSpectrumWidget * s_widget = nullptr;
 
 bool GLSpectrumQt::init ()
 {
-    for (int i = 0; i <= NUM_BANDS; i ++)
-        logscale[i] = powf (256, (float) i / NUM_BANDS) - 0.5f;
+    mapper.init (NUM_BANDS);
 
     for (int y = 0; y < NUM_BANDS; y ++)
     {
@@ -117,48 +168,12 @@ bool GLSpectrumQt::init ()
     return true;
 }
 
-/* stolen from the skins plugin */
-/* convert linear frequency graph to logarithmic one */
-static void make_log_graph (const float * freq, float * graph)
-{
-    for (int i = 0; i < NUM_BANDS; i ++)
-    {
-        /* sum up values in freq array between logscale[i] and logscale[i + 1],
-           including fractional parts */
-        int a = ceilf (logscale[i]);
-        int b = floorf (logscale[i + 1]);
-        float sum = 0;
-
-        if (b < a)
-            sum += freq[b] * (logscale[i + 1] - logscale[i]);
-        else
-        {
-            if (a > 0)
-                sum += freq[a - 1] * (a - logscale[i]);
-            for (; a < b; a ++)
-                sum += freq[a];
-            if (b < 256)
-                sum += freq[b] * (logscale[i + 1] - b);
-        }
-
-        /* fudge factor to make the graph have the same overall height as a
-           12-band one no matter how many bands there are */
-        sum *= (float) NUM_BANDS / 12;
-
-        /* convert to dB */
-        float val = 20 * log10f (sum);
-
-        /* scale (-DB_RANGE, 0.0) to (0.0, 1.0) */
-        val = 1 + val / DB_RANGE;
-
-        graph[i] = aud::clamp (val, 0.0f, 1.0f);
-    }
-}
-
 void GLSpectrumQt::render_freq (const float * freq)
 {
-    make_log_graph (freq, s_bars[s_pos]);
-    s_pos = (s_pos + 1) % NUM_BANDS;
+    s_pos = (s_pos + NUM_BANDS - 1) % NUM_BANDS;
+    mapper.compute_scaled (freq, DB_RANGE, s_bars[s_pos]);
+    memcpy (s_bars[s_pos + NUM_BANDS], s_bars[s_pos], sizeof s_bars[0]);
+    s_bars_dirty = true;
 
     s_angle += s_anglespeed;
     if (s_angle > 45 || s_angle < -45)
@@ -171,6 +186,7 @@ void GLSpectrumQt::render_freq (const float * freq)
 void GLSpectrumQt::clear ()
 {
     memset (s_bars, 0, sizeof s_bars);
+    s_bars_dirty = true;
 
     if (s_widget)
         s_widget->update ();
@@ -220,6 +236,52 @@ void GLSpectrumWidget::draw_bar (float x, float z, float h, float r, float g, fl
      r * (0.2f + 0.8f * h), g * (0.2f + 0.8f * h), b * (0.2f + 0.8f * h));
 }
 
+void GLSpectrumWidget::draw_instanced ()
+{
+    glUseProgram (m_program);
+
+    glBindBuffer (GL_ARRAY_BUFFER, m_mesh_vbo);
+    glVertexAttribPointer (ATTR_CORNER, 4, GL_FLOAT, false, 0, nullptr);
+
+    glBindBuffer (GL_ARRAY_BUFFER, m_instance_vbo);
+    glVertexAttribPointer (ATTR_OFFSET, 2, GL_FLOAT, false, 5 * sizeof (float), nullptr);
+    glVertexAttribPointer (ATTR_COLOR, 3, GL_FLOAT, false, 5 * sizeof (float),
+     (void *) (2 * sizeof (float)));
+
+    glBindBuffer (GL_ARRAY_BUFFER, m_height_vbo);
+
+    if (s_bars_dirty)
+    {
+        glBufferSubData (GL_ARRAY_BUFFER, 0, sizeof s_bars, s_bars);
+        s_bars_dirty = false;
+    }
+
+    glVertexAttribPointer (ATTR_HEIGHT, 1, GL_FLOAT, false, 0,
+     (void *) (s_pos * sizeof s_bars[0]));
+
+    for (int a = ATTR_CORNER; a <= ATTR_HEIGHT; a ++)
+    {
+        glEnableVertexAttribArray (a);
+        m_VertexAttribDivisor (a, (a == ATTR_CORNER) ? 0 : 1);
+    }
+
+    /* the mesh is wound clockwise, so culling drops the hidden side face */
+    glEnable (GL_CULL_FACE);
+    glFrontFace (GL_CW);
+    m_DrawArraysInstanced (GL_TRIANGLES, 0, MESH_VERTICES, NUM_BANDS * NUM_BANDS);
+    glFrontFace (GL_CCW);
+    glDisable (GL_CULL_FACE);
+
+    for (int a = ATTR_CORNER; a <= ATTR_HEIGHT; a ++)
+    {
+        m_VertexAttribDivisor (a, 0);
+        glDisableVertexAttribArray (a);
+    }
+
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glUseProgram (0);
+}
+
 void GLSpectrumWidget::draw_bars ()
 {
     glPushMatrix ();
@@ -228,15 +290,20 @@ void GLSpectrumWidget::draw_bars ()
     glRotatef (s_angle + 180.0f, 0.0f, 1.0f, 0.0f);
     glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
 
-    for (int i = 0; i < NUM_BANDS; i ++)
+    if (m_program)
+        draw_instanced ();
+    else
     {
-        float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
-
-        for (int j = 0; j < NUM_BANDS; j ++)
+        for (int i = 0; i < NUM_BANDS; i ++)
         {
-            draw_bar (1.6f - BAR_SPACING * j, z,
-             s_bars[(s_pos + i) % NUM_BANDS][j] * 1.6,
-             colors[i][j][0], colors[i][j][1], colors[i][j][2]);
+            float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+
+            for (int j = 0; j < NUM_BANDS; j ++)
+            {
+                draw_bar (1.6f - BAR_SPACING * j, z,
+                 s_bars[s_pos + NUM_BANDS - 1 - i][j] * 1.6,
+                 colors[i][j][0], colors[i][j][1], colors[i][j][2]);
+            }
         }
     }
 
@@ -244,6 +311,171 @@ void GLSpectrumWidget::draw_bars ()
     glPopMatrix ();
 }
 
+GLuint GLSpectrumWidget::compile_shader (GLenum type, const char * source)
+{
+    GLuint shader = glCreateShader (type);
+    glShaderSource (shader, 1, & source, nullptr);
+    glCompileShader (shader);
+
+    GLint ok = 0;
+    glGetShaderiv (shader, GL_COMPILE_STATUS, & ok);
+
+    if (! ok)
+    {
+        char log[512] = "";
+        glGetShaderInfoLog (shader, sizeof log, nullptr, log);
+        AUDERR ("Shader compilation failed: %s\n", log);
+        glDeleteShader (shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+bool GLSpectrumWidget::create_program ()
+{
+    GLuint vertex = compile_shader (GL_VERTEX_SHADER, vertex_shader);
+    GLuint fragment = compile_shader (GL_FRAGMENT_SHADER, fragment_shader);
+
+    if (vertex && fragment)
+    {
+        m_program = glCreateProgram ();
+        glAttachShader (m_program, vertex);
+        glAttachShader (m_program, fragment);
+
+        glBindAttribLocation (m_program, ATTR_CORNER, "corner");
+        glBindAttribLocation (m_program, ATTR_OFFSET, "offset");
+        glBindAttribLocation (m_program, ATTR_COLOR, "color");
+        glBindAttribLocation (m_program, ATTR_HEIGHT, "height");
+
+        glLinkProgram (m_program);
+
+        GLint ok = 0;
+        glGetProgramiv (m_program, GL_LINK_STATUS, & ok);
+
+        if (! ok)
+        {
+            char log[512] = "";
+            glGetProgramInfoLog (m_program, sizeof log, nullptr, log);
+            AUDERR ("Shader linking failed: %s\n", log);
+            glDeleteProgram (m_program);
+            m_program = 0;
+        }
+    }
+
+    if (vertex)
+        glDeleteShader (vertex);
+    if (fragment)
+        glDeleteShader (fragment);
+
+    return m_program != 0;
+}
+
+/* the four visible faces of a bar, with the shading used by draw_rectangle() */
+static void build_mesh (float mesh[MESH_VERTICES][4])
+{
+    static const float faces[4][4][3] = {
+        {{0, 1, 0}, {1, 1, 0}, {1, 1, 1}, {0, 1, 1}},  /* top */
+        {{0, 0, 0}, {0, 1, 0}, {0, 1, 1}, {0, 0, 1}},  /* left */
+        {{1, 1, 0}, {1, 0, 0}, {1, 0, 1}, {1, 1, 1}},  /* right */
+        {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}}   /* front */
+    };
+    static const float shades[4] = {1, 0.65f, 0.65f, 0.8f};
+    static const int corners[6] = {0, 1, 2, 0, 2, 3};
+
+    for (int f = 0; f < 4; f ++)
+    {
+        for (int c = 0; c < 6; c ++)
+        {
+            const float * v = faces[f][corners[c]];
+            float * out = mesh[6 * f + c];
+
+            out[0] = v[0] * BAR_WIDTH;
+            out[1] = v[1];
+            out[2] = v[2] * BAR_WIDTH;
+            out[3] = shades[f];
+        }
+    }
+}
+
+void GLSpectrumWidget::create_renderer ()
+{
+    QOpenGLContext * ctx = context ();
+    auto version = ctx->format ().version ();
+
+    if (ctx->isOpenGLES () || version < qMakePair (2, 0))
+        return;
+
+    if (version >= qMakePair (3, 3))
+    {
+        m_VertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)
+         ctx->getProcAddress ("glVertexAttribDivisor");
+        m_DrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)
+         ctx->getProcAddress ("glDrawArraysInstanced");
+    }
+    else if (ctx->hasExtension ("GL_ARB_instanced_arrays"))
+    {
+        m_VertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)
+         ctx->getProcAddress ("glVertexAttribDivisorARB");
+
+        if (version >= qMakePair (3, 1))
+            m_DrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)
+             ctx->getProcAddress ("glDrawArraysInstanced");
+        else if (ctx->hasExtension ("GL_ARB_draw_instanced"))
+            m_DrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)
+             ctx->getProcAddress ("glDrawArraysInstancedARB");
+    }
+
+    if (! m_VertexAttribDivisor || ! m_DrawArraysInstanced || ! create_program ())
+        return;
+
+    float mesh[MESH_VERTICES][4];
+    build_mesh (mesh);
+
+    /* instances follow the s_bars ring, nearest row first */
+    float instances[NUM_BANDS][NUM_BANDS][5];
+
+    for (int i = 0; i < NUM_BANDS; i ++)
+    {
+        for (int j = 0; j < NUM_BANDS; j ++)
+        {
+            float * inst = instances[NUM_BANDS - 1 - i][j];
+
+            inst[0] = 1.6f - BAR_SPACING * j;
+            inst[1] = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+            memcpy (inst + 2, colors[i][j], sizeof colors[i][j]);
+        }
+    }
+
+    glGenBuffers (1, & m_mesh_vbo);
+    glBindBuffer (GL_ARRAY_BUFFER, m_mesh_vbo);
+    glBufferData (GL_ARRAY_BUFFER, sizeof mesh, mesh, GL_STATIC_DRAW);
+
+    glGenBuffers (1, & m_instance_vbo);
+    glBindBuffer (GL_ARRAY_BUFFER, m_instance_vbo);
+    glBufferData (GL_ARRAY_BUFFER, sizeof instances, instances, GL_STATIC_DRAW);
+
+    glGenBuffers (1, & m_height_vbo);
+    glBindBuffer (GL_ARRAY_BUFFER, m_height_vbo);
+    glBufferData (GL_ARRAY_BUFFER, sizeof s_bars, s_bars, GL_STREAM_DRAW);
+    s_bars_dirty = false;
+
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+}
+
+void GLSpectrumWidget::destroy_renderer ()
+{
+    if (! m_program)
+        return;
+
+    GLuint buffers[] = {m_mesh_vbo, m_instance_vbo, m_height_vbo};
+    glDeleteBuffers (3, buffers);
+    glDeleteProgram (m_program);
+
+    m_mesh_vbo = m_instance_vbo = m_height_vbo = 0;
+    m_program = 0;
+}
+
 GLSpectrumWidget::GLSpectrumWidget (QWidget * parent) : QOpenGLWidget (parent)
 {
     QSurfaceFormat format;
@@ -254,6 +486,10 @@ GLSpectrumWidget::GLSpectrumWidget (QWidget * parent) : QOpenGLWidget (parent)
 
 GLSpectrumWidget::~GLSpectrumWidget ()
 {
+    makeCurrent ();
+    destroy_renderer ();
+    doneCurrent ();
+
     s_widget = nullptr;
 }
 
@@ -293,6 +529,10 @@ void GLSpectrumWidget::resizeGL (int w, int h)
 void GLSpectrumWidget::initializeGL ()
 {
     initializeOpenGLFunctions ();
+    create_renderer ();
+
+    if (! m_program)
+        AUDINFO ("Instanced rendering not available, using immediate mode.\n");
 }
 
 void * GLSpectrumQt::get_qt_widget ()
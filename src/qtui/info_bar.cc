@@ -18,6 +18,7 @@
  */
 
 #include "info_bar.h"
+#include "../vis-common/bandmap.h"
 
 #include <libaudcore/drct.h>
 #include <libaudcore/interface.h>
@@ -111,15 +112,18 @@ InfoVis::~InfoVis() { enable(false); }
 
 void InfoVis::render_freq(const float * freq)
 {
-    /* xscale[i] = pow (256, i / VIS_BANDS) - 0.5; */
-    const float xscale[VisBands + 1] = {0.5,    1.09,   2.02, 3.5,   5.85,
-                                        9.58,   15.5,   24.9, 39.82, 63.5,
-                                        101.09, 160.77, 255.5};
+    static BandMapper mapper;
+
+    if (!mapper.bands())
+        mapper.init(VisBands);
+
+    float db[VisBands];
+    mapper.compute_db(freq, db);
 
     for (int i = 0; i < VisBands; i++)
     {
         /* 40 dB range */
-        float x = 40 + compute_freq_band(freq, xscale, i, VisBands);
+        float x = 40 + db[i];
 
         m_bars[i] -= aud::max(0, VisFalloff - m_delay[i]);
 
@@ -0,0 +1,972 @@
+/*
+ * Render Cache for Emulated Formats
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "rendercache.h"
+
+#include <atomic>
+#include <chrono>
+#include <dirent.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <libaudcore/audio.h>
+#include <libaudcore/audstrings.h>
+#include <libaudcore/i18n.h>
+#include <libaudcore/playlist.h>
+#include <libaudcore/plugins.h>
+#include <libaudcore/runtime.h>
+
+/*
+ * File layout (native byte order):
+ *
+ *   header:  "AUDRC01\n", channels, rate, BLOCK_FRAMES, 0  (4 x int32)
+ *   blocks:  BLOCK_FRAMES frames each, the last one possibly shorter
+ *   index:   file offset of every block, plus the end of the last block
+ *   footer:  total frames (int64), number of blocks (uint32), "RCIX"
+ *
+ * Each block is coded on its own so that seeking only needs the index.  The
+ * channels are coded one after the other; with two channels the second one
+ * is stored as the difference from the first.  Every channel uses a fixed
+ * second-order predictor whose residuals are Rice coded with a parameter
+ * chosen per block, in the manner of FLAC's fixed subframes.  Residuals too
+ * large for the parameter are escaped and stored raw.
+ */
+
+#define MAGIC "AUDRC01\n"
+#define FOOTER_TAG "RCIX"
+#define BLOCK_FRAMES 4096
+#define MAX_CHANNELS 8
+#define MAX_RICE 20
+#define ESCAPE 32   /* unary length that introduces a raw value */
+#define RAW_BITS 24
+#define LOOKAHEAD 8 /* playlist entries */
+
+static const char * const defaults[] = {
+    "enabled", "FALSE",
+    "prerender", "TRUE",
+    "threads", "2",
+    "size_limit", "2048",  /* MiB */
+    nullptr
+};
+
+const PreferencesWidget render_cache_widgets[5] = {
+    WidgetLabel (N_("<b>Render Cache</b>")),
+    WidgetCheck (N_("Keep rendered audio on disk"),
+        WidgetBool ("render_cache", "enabled")),
+    WidgetCheck (N_("Render upcoming playlist entries in the background"),
+        WidgetBool ("render_cache", "prerender"),
+        WIDGET_CHILD),
+    WidgetSpin (N_("Background threads:"),
+        WidgetInt ("render_cache", "threads"),
+        {1, 16, 1},
+        WIDGET_CHILD),
+    WidgetSpin (N_("Size limit:"),
+        WidgetInt ("render_cache", "size_limit"),
+        {64, 65536, 64, N_("MiB")},
+        WIDGET_CHILD)
+};
+
+const PreferencesWidget render_cache_record_widgets[3] = {
+    WidgetLabel (N_("<b>Render Cache</b>")),
+    WidgetCheck (N_("Keep rendered audio on disk"),
+        WidgetBool ("render_cache", "enabled")),
+    WidgetSpin (N_("Size limit:"),
+        WidgetInt ("render_cache", "size_limit"),
+        {64, 65536, 64, N_("MiB")},
+        WIDGET_CHILD)
+};
+
+struct Header
+{
+    char magic[8];
+    int32_t channels, rate, block_frames, reserved;
+};
+
+struct Footer
+{
+    int64_t frames;
+    uint32_t blocks;
+    char tag[4];
+};
+
+void render_cache_init ()
+{
+    aud_config_set_defaults ("render_cache", defaults);
+}
+
+bool render_cache_enabled ()
+{
+    return aud_get_bool ("render_cache", "enabled");
+}
+
+bool render_cache_prerender_enabled ()
+{
+    return render_cache_enabled () && aud_get_bool ("render_cache", "prerender");
+}
+
+/* FNV-1a, 64 bits */
+static uint64_t hash_bytes (uint64_t hash, const void * data, int len)
+{
+    auto bytes = (const unsigned char *) data;
+    for (int i = 0; i < len; i ++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+
+    return hash;
+}
+
+String render_cache_key (const char * format, const char * version,
+ const Index<char> & data, const char * settings)
+{
+    if (! render_cache_enabled ())
+        return String ();
+
+    /* the file format is hashed too, so that a new one starts afresh */
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = hash_bytes (hash, MAGIC, strlen (MAGIC));
+    hash = hash_bytes (hash, version, strlen (version) + 1);
+    hash = hash_bytes (hash, data.begin (), data.len ());
+    hash = hash_bytes (hash, settings, strlen (settings));
+
+    return String (str_printf ("%s-%016llx", format, (unsigned long long) hash));
+}
+
+static StringBuf cache_dir ()
+{
+    return filename_build ({aud_get_path (AudPath::UserDir), "render-cache"});
+}
+
+static StringBuf cache_path (const char * key)
+{
+    return filename_build ({cache_dir (), str_concat ({key, ".rc"})});
+}
+
+static bool cache_exists (const char * key)
+{
+    struct stat st;
+    return ! stat (cache_path (key), & st);
+}
+
+/* ---- bit packing ---- */
+
+class BitWriter
+{
+public:
+    BitWriter (Index<unsigned char> & out) : m_out (out) {}
+
+    /* n <= 32 */
+    void put (uint32_t value, int n)
+    {
+        m_acc = (m_acc << n) | value;
+        m_bits += n;
+
+        while (m_bits >= 8)
+        {
+            m_bits -= 8;
+            m_out.append ((unsigned char) (m_acc >> m_bits));
+        }
+    }
+
+    void put_ones (int n)
+    {
+        for (; n > 32; n -= 32)
+            put (0xffffffff, 32);
+
+        put ((uint32_t) ((1ULL << n) - 1), n);
+    }
+
+    void flush ()
+    {
+        if (m_bits)
+            put (0, 8 - m_bits);
+    }
+
+private:
+    Index<unsigned char> & m_out;
+    uint64_t m_acc = 0;
+    int m_bits = 0;
+};
+
+class BitReader
+{
+public:
+    BitReader (const unsigned char * data, int len) :
+        m_data (data), m_end (data + len) {}
+
+    /* n <= 32; reads zeros past the end */
+    uint32_t get (int n)
+    {
+        if (! n)
+            return 0;
+
+        while (m_bits < n)
+        {
+            m_acc = (m_acc << 8) | (m_data < m_end ? * m_data ++ : 0);
+            m_bits += 8;
+        }
+
+        m_bits -= n;
+        return (uint32_t) (m_acc >> m_bits) & (uint32_t) ((1ULL << n) - 1);
+    }
+
+    /* counts ones up to a zero bit, at most <limit> */
+    int get_unary (int limit)
+    {
+        int n = 0;
+        while (n < limit && get (1))
+            n ++;
+
+        return n;
+    }
+
+private:
+    const unsigned char * m_data, * m_end;
+    uint64_t m_acc = 0;
+    int m_bits = 0;
+};
+
+/* ---- block codec ---- */
+
+static void encode_block (const int16_t * in, int frames, int channels,
+ Index<unsigned char> & out)
+{
+    int32_t residual[BLOCK_FRAMES];
+    BitWriter bits (out);
+
+    for (int c = 0; c < channels; c ++)
+    {
+        uint64_t sum = 0;
+        int32_t prev1 = 0, prev2 = 0;
+
+        for (int i = 0; i < frames; i ++)
+        {
+            int32_t s = in[i * channels + c];
+            if (channels == 2 && c == 1)
+                s -= in[i * channels];
+
+            int32_t predicted = (i == 0) ? 0 : (i == 1) ? prev1 : 2 * prev1 - prev2;
+            int32_t r = s - predicted;
+
+            residual[i] = (int32_t) (((uint32_t) r << 1) ^ (uint32_t) (r >> 31));
+            sum += (uint32_t) residual[i];
+
+            prev2 = prev1;
+            prev1 = s;
+        }
+
+        /* Rice parameter close to log2 of the mean residual */
+        int k = 0;
+        while (k < MAX_RICE && ((uint64_t) frames << (k + 1)) <= sum)
+            k ++;
+
+        bits.put (k, 5);
+
+        for (int i = 0; i < frames; i ++)
+        {
+            uint32_t u = residual[i];
+            uint32_t q = u >> k;
+
+            if (q < ESCAPE)
+            {
+                bits.put_ones (q);
+                bits.put (0, 1);
+                bits.put (u & ((1u << k) - 1), k);
+            }
+            else
+            {
+                bits.put_ones (ESCAPE);
+                bits.put (u, RAW_BITS);
+            }
+        }
+    }
+
+    bits.flush ();
+}
+
+static void decode_block (const unsigned char * data, int len, int frames,
+ int channels, int16_t * out)
+{
+    BitReader bits (data, len);
+
+    for (int c = 0; c < channels; c ++)
+    {
+        int k = aud::min ((int) bits.get (5), MAX_RICE);
+        int32_t prev1 = 0, prev2 = 0;
+
+        for (int i = 0; i < frames; i ++)
+        {
+            uint32_t u;
+            int q = bits.get_unary (ESCAPE);
+
+            if (q < ESCAPE)
+                u = ((uint32_t) q << k) | bits.get (k);
+            else
+                u = bits.get (RAW_BITS);
+
+            int32_t r = (int32_t) (u >> 1) ^ -(int32_t) (u & 1);
+            int32_t predicted = (i == 0) ? 0 : (i == 1) ? prev1 : 2 * prev1 - prev2;
+            int32_t s = predicted + r;
+
+            prev2 = prev1;
+            prev1 = s;
+
+            if (channels == 2 && c == 1)
+                s += out[i * channels];
+
+            out[i * channels + c] = (int16_t) s;
+        }
+    }
+}
+
+/* ---- size limit ---- */
+
+struct CacheFile
+{
+    String path;
+    time_t mtime;
+    int64_t size;
+};
+
+/* Deletes the least recently used entries until the cache fits within the
+ * size limit.  Temporary files left behind by a crash are removed once they
+ * are a day old. */
+static void enforce_limit ()
+{
+    StringBuf dir = cache_dir ();
+    DIR * handle = opendir (dir);
+    if (! handle)
+        return;
+
+    Index<CacheFile> files;
+    int64_t total = 0;
+    time_t now = time (nullptr);
+
+    struct dirent * entry;
+    while ((entry = readdir (handle)))
+    {
+        StringBuf path = filename_build ({dir, entry->d_name});
+        struct stat st;
+
+        if (stat (path, & st) || ! S_ISREG (st.st_mode))
+            continue;
+
+        if (strstr (entry->d_name, ".tmp"))
+        {
+            if (now - st.st_mtime > 24 * 3600)
+                remove (path);
+
+            continue;
+        }
+
+        if (! str_has_suffix_nocase (entry->d_name, ".rc"))
+            continue;
+
+        files.append (String (path), st.st_mtime, (int64_t) st.st_size);
+        total += st.st_size;
+    }
+
+    closedir (handle);
+
+    int64_t limit = (int64_t) aud_get_int ("render_cache", "size_limit") << 20;
+    if (total <= limit)
+        return;
+
+    files.sort ([] (const CacheFile & a, const CacheFile & b)
+        { return (a.mtime > b.mtime) - (a.mtime < b.mtime); });
+
+    for (const CacheFile & file : files)
+    {
+        if (total <= limit)
+            break;
+
+        AUDDBG ("Removing %s from the render cache.\n", (const char *) file.path);
+        remove (file.path);
+        total -= file.size;
+    }
+}
+
+static void queue_trim ();
+
+/* ---- writer ---- */
+
+static std::atomic<bool> s_cancel (false);
+
+bool RenderCacheWriter::cancelled ()
+{
+    return s_cancel.load ();
+}
+
+bool RenderCacheWriter::open (const char * key, int channels, int rate)
+{
+    discard ();
+
+    if (channels < 1 || channels > MAX_CHANNELS || rate < 1)
+        return false;
+
+    StringBuf dir = cache_dir ();
+#ifdef _WIN32
+    mkdir (dir);
+#else
+    mkdir (dir, 0755);
+#endif
+
+    /* unique per process and writer */
+    static std::atomic<int> s_serial (0);
+    m_temp = String (str_printf ("%s.tmp%d-%d", (const char *) cache_path (key),
+     (int) getpid (), s_serial ++));
+
+    m_file = fopen (m_temp, "wb");
+    if (! m_file)
+    {
+        AUDERR ("Cannot create %s.\n", (const char *) m_temp);
+        m_temp = String ();
+        return false;
+    }
+
+    m_key = String (key);
+    m_channels = channels;
+    m_rate = rate;
+    m_frames = 0;
+    m_error = false;
+
+    Header header = {{}, channels, rate, BLOCK_FRAMES, 0};
+    memcpy (header.magic, MAGIC, sizeof header.magic);
+
+    m_error = (fwrite (& header, sizeof header, 1, m_file) != 1);
+
+    m_block.resize (0);
+    m_offsets.resize (0);
+    m_offsets.append (sizeof header);
+
+    return true;
+}
+
+void RenderCacheWriter::write_block ()
+{
+    int frames = m_block.len () / m_channels;
+
+    m_coded.resize (0);
+    encode_block (m_block.begin (), frames, m_channels, m_coded);
+
+    if (fwrite (m_coded.begin (), 1, m_coded.len (), m_file) != (size_t) m_coded.len ())
+        m_error = true;
+
+    m_offsets.append (m_offsets[m_offsets.len () - 1] + m_coded.len ());
+    m_frames += frames;
+    m_block.resize (0);
+}
+
+void RenderCacheWriter::write (const int16_t * data, int frames)
+{
+    if (! m_file || m_error)
+        return;
+
+    int block_samples = BLOCK_FRAMES * m_channels;
+    int samples = frames * m_channels;
+
+    while (samples > 0)
+    {
+        int copy = aud::min (samples, block_samples - m_block.len ());
+        m_block.insert (data, -1, copy);
+
+        data += copy;
+        samples -= copy;
+
+        if (m_block.len () == block_samples)
+            write_block ();
+    }
+}
+
+bool RenderCacheWriter::finish ()
+{
+    if (! m_file)
+        return false;
+
+    if (m_block.len ())
+        write_block ();
+
+    Footer footer = {m_frames, (uint32_t) (m_offsets.len () - 1), {}};
+    memcpy (footer.tag, FOOTER_TAG, sizeof footer.tag);
+
+    if (! m_frames ||
+        fwrite (m_offsets.begin (), sizeof (uint64_t), m_offsets.len (), m_file) !=
+         (size_t) m_offsets.len () ||
+        fwrite (& footer, sizeof footer, 1, m_file) != 1)
+        m_error = true;
+
+    if (fclose (m_file))
+        m_error = true;
+
+    m_file = nullptr;
+
+    if (m_error)
+    {
+        remove (m_temp);
+        m_temp = String ();
+        return false;
+    }
+
+    StringBuf path = cache_path (m_key);
+#ifdef _WIN32
+    remove (path);
+#endif
+
+    bool success = ! rename (m_temp, path);
+    if (! success)
+    {
+        AUDERR ("Cannot rename %s.\n", (const char *) m_temp);
+        remove (m_temp);
+    }
+
+    m_temp = String ();
+
+    /* scanning the cache directory can take a while, so it is left to a
+     * render thread rather than holding up the next track */
+    if (success)
+        queue_trim ();
+
+    return success;
+}
+
+void RenderCacheWriter::discard ()
+{
+    if (m_file)
+    {
+        fclose (m_file);
+        m_file = nullptr;
+        remove (m_temp);
+        m_temp = String ();
+    }
+}
+
+/* ---- reader ---- */
+
+bool RenderCacheReader::open (const char * key)
+{
+    close ();
+
+    StringBuf path = cache_path (key);
+    m_file = fopen (path, "rb");
+    if (! m_file)
+        return false;
+
+    Header header;
+    Footer footer;
+    long size, index_pos;
+
+    if (fseek (m_file, 0, SEEK_END) || (size = ftell (m_file)) < 0 ||
+        fseek (m_file, 0, SEEK_SET) ||
+        fread (& header, sizeof header, 1, m_file) != 1 ||
+        memcmp (header.magic, MAGIC, sizeof header.magic) ||
+        header.channels < 1 || header.channels > MAX_CHANNELS ||
+        header.rate < 1 || header.block_frames != BLOCK_FRAMES ||
+        fseek (m_file, -(long) sizeof footer, SEEK_END) ||
+        fread (& footer, sizeof footer, 1, m_file) != 1 ||
+        memcmp (footer.tag, FOOTER_TAG, sizeof footer.tag) ||
+        ! footer.blocks || footer.frames < 1 ||
+        (int64_t) footer.blocks != (footer.frames - 1) / BLOCK_FRAMES + 1)
+        goto fail;
+
+    /* the index has to fit in the file before it is worth allocating */
+    if ((long) footer.blocks >= (size - (long) (sizeof header + sizeof footer)) /
+     (long) sizeof (uint64_t))
+        goto fail;
+
+    index_pos = size - sizeof footer - sizeof (uint64_t) * (footer.blocks + 1);
+    m_offsets.resize (footer.blocks + 1);
+
+    if (fseek (m_file, index_pos, SEEK_SET) ||
+        fread (m_offsets.begin (), sizeof (uint64_t), m_offsets.len (), m_file) !=
+         (size_t) m_offsets.len () ||
+        m_offsets[0] != sizeof header || m_offsets[footer.blocks] != (uint64_t) index_pos)
+        goto fail;
+
+    for (int i = 0; i < (int) footer.blocks; i ++)
+    {
+        if (m_offsets[i + 1] < m_offsets[i] ||
+            m_offsets[i + 1] - m_offsets[i] > (uint64_t) BLOCK_FRAMES * MAX_CHANNELS * 8)
+            goto fail;
+    }
+
+    m_channels = header.channels;
+    m_rate = header.rate;
+    m_frames = footer.frames;
+    m_block_num = -1;
+    m_block_pos = 0;
+
+    if (! load_block (0))
+        goto fail;
+
+    /* mark as recently used */
+    utime (path, nullptr);
+    return true;
+
+fail:
+    AUDERR ("Ignoring damaged render cache file %s.\n", (const char *) path);
+    close ();
+    return false;
+}
+
+void RenderCacheReader::close ()
+{
+    if (m_file)
+    {
+        fclose (m_file);
+        m_file = nullptr;
+    }
+
+    m_offsets.clear ();
+    m_coded.clear ();
+    m_block.clear ();
+    m_block_num = -1;
+}
+
+bool RenderCacheReader::load_block (int block)
+{
+    if (block == m_block_num)
+        return true;
+
+    int len = m_offsets[block + 1] - m_offsets[block];
+    m_coded.resize (len);
+
+    if (fseek (m_file, m_offsets[block], SEEK_SET) ||
+        fread (m_coded.begin (), 1, len, m_file) != (size_t) len)
+        return false;
+
+    int frames = aud::min ((int64_t) BLOCK_FRAMES, m_frames - (int64_t) block * BLOCK_FRAMES);
+    m_block.resize (frames * m_channels);
+    decode_block (m_coded.begin (), len, frames, m_channels, m_block.begin ());
+
+    m_block_num = block;
+    return true;
+}
+
+void RenderCacheReader::seek (int64_t frame)
+{
+    frame = aud::clamp (frame, (int64_t) 0, m_frames);
+
+    int block = frame / BLOCK_FRAMES;
+    if (block >= m_offsets.len () - 1)
+    {
+        /* at the end */
+        m_block_num = m_offsets.len () - 1;
+        m_block.resize (0);
+        m_block_pos = 0;
+        return;
+    }
+
+    if (! load_block (block))
+        m_block.resize (0);
+
+    m_block_pos = (frame - (int64_t) block * BLOCK_FRAMES) * m_channels;
+}
+
+int RenderCacheReader::read (int16_t * data, int max_frames)
+{
+    int done = 0;
+
+    while (done < max_frames && m_file)
+    {
+        if (m_block_pos >= m_block.len ())
+        {
+            int next = m_block_num + 1;
+            if (next >= m_offsets.len () - 1 || ! load_block (next))
+                break;
+
+            m_block_pos = 0;
+        }
+
+        int copy = aud::min ((max_frames - done) * m_channels, m_block.len () - m_block_pos);
+        memcpy (data + done * m_channels, & m_block[m_block_pos], sizeof (int16_t) * copy);
+
+        m_block_pos += copy;
+        done += copy / m_channels;
+    }
+
+    return done;
+}
+
+bool render_cache_play (const char * key, int channels, int rate)
+{
+    RenderCacheReader reader;
+
+    if (! key || ! key[0] || ! reader.open (key) ||
+        reader.channels () != channels || reader.rate () != rate)
+        return false;
+
+    int16_t data[1024 * MAX_CHANNELS];
+
+    InputPlugin::set_stream_bitrate (rate * channels * 16);
+    InputPlugin::open_audio (FMT_S16_NE, rate, channels);
+
+    while (! InputPlugin::check_stop ())
+    {
+        int seek = InputPlugin::check_seek ();
+        if (seek >= 0)
+            reader.seek ((int64_t) seek * rate / 1000);
+
+        int frames = reader.read (data, 1024);
+        if (! frames)
+            break;
+
+        InputPlugin::write_audio (data, frames * channels * sizeof data[0]);
+    }
+
+    return true;
+}
+
+/* ---- background rendering ---- */
+
+/* A render (job is set), a look at the playlist (add is set) or else a trim
+ * of the cache to its size limit. */
+struct Prerender
+{
+    String key;
+    int channels, rate;
+    SmartPtr<RenderCacheJob> job;
+
+    String filename;
+    PluginHandle * plugin;
+    RenderCacheAddFunc add;
+};
+
+static pthread_mutex_t prerender_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prerender_cond = PTHREAD_COND_INITIALIZER;
+
+static Index<SmartPtr<Prerender>> prerender_queue;
+static Index<String> prerender_keys;  /* queued or running */
+static Index<pthread_t> prerender_threads;
+static bool prerender_quit;
+static bool trim_queued;
+
+/* The playlist is read here rather than in play(), since the playback thread
+ * must never wait for the playlist lock. */
+static void prerender_lookahead (Prerender & item)
+{
+    auto playlist = Playlist::playing_playlist ();
+    int pos = playlist.get_position ();
+
+    if (pos < 0 || playlist.entry_filename (pos) != item.filename)
+        return;
+
+    int end = aud::min (pos + 1 + LOOKAHEAD, playlist.n_entries ());
+
+    for (int entry = pos + 1; entry < end && ! RenderCacheWriter::cancelled (); entry ++)
+    {
+        if (playlist.entry_decoder (entry, Playlist::NoWait) == item.plugin)
+            item.add (playlist.entry_filename (entry));
+    }
+}
+
+static void prerender_run (Prerender & item)
+{
+    if (item.add)
+    {
+        prerender_lookahead (item);
+        return;
+    }
+
+    if (! item.job)
+    {
+        pthread_mutex_lock (& prerender_mutex);
+        trim_queued = false;
+        pthread_mutex_unlock (& prerender_mutex);
+
+        enforce_limit ();
+        return;
+    }
+
+    if (cache_exists (item.key))
+        return;
+
+    RenderCacheWriter writer;
+    if (! writer.open (item.key, item.channels, item.rate))
+        return;
+
+    auto start = std::chrono::steady_clock::now ();
+
+    if (! item.job->render (writer) || RenderCacheWriter::cancelled ())
+    {
+        writer.discard ();
+        return;
+    }
+
+    double audio_secs = (double) writer.frames () / item.rate;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+
+    if (writer.finish ())
+        AUDINFO ("Rendered %s: %.1f s of audio in %.1f s.\n",
+         (const char *) item.key, audio_secs, elapsed.count ());
+}
+
+static void * prerender_worker (void *)
+{
+    pthread_mutex_lock (& prerender_mutex);
+
+    while (1)
+    {
+        if (! prerender_queue.len ())
+        {
+            if (prerender_quit)
+                break;
+
+            pthread_cond_wait (& prerender_cond, & prerender_mutex);
+            continue;
+        }
+
+        SmartPtr<Prerender> item = std::move (prerender_queue[0]);
+        prerender_queue.remove (0, 1);
+
+        pthread_mutex_unlock (& prerender_mutex);
+
+        prerender_run (* item);
+
+        pthread_mutex_lock (& prerender_mutex);
+
+        for (int i = 0; item->key && i < prerender_keys.len (); i ++)
+        {
+            if (prerender_keys[i] == item->key)
+            {
+                prerender_keys.remove (i, 1);
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock (& prerender_mutex);
+    return nullptr;
+}
+
+/* call with prerender_mutex held */
+static bool start_threads ()
+{
+    if (! prerender_threads.len ())
+    {
+        int threads = aud::clamp (aud_get_int ("render_cache", "threads"), 1, 16);
+        AUDDBG ("Starting %d render threads.\n", threads);
+
+        for (int i = 0; i < threads; i ++)
+        {
+            pthread_t thread;
+            if (! pthread_create (& thread, nullptr, prerender_worker, nullptr))
+                prerender_threads.append (thread);
+        }
+
+        if (! prerender_threads.len ())
+            AUDERR ("Failed to create render threads.\n");
+    }
+
+    return prerender_threads.len ();
+}
+
+void render_cache_prerender (const char * key, int channels, int rate,
+ RenderCacheJob * job)
+{
+    SmartPtr<RenderCacheJob> owned (job);
+
+    if (! key || ! key[0] || ! render_cache_prerender_enabled () || cache_exists (key))
+        return;
+
+    pthread_mutex_lock (& prerender_mutex);
+
+    for (const String & queued : prerender_keys)
+    {
+        if (! strcmp (queued, key))
+        {
+            pthread_mutex_unlock (& prerender_mutex);
+            return;
+        }
+    }
+
+    if (! prerender_quit && start_threads ())
+    {
+        prerender_keys.append (String (key));
+        prerender_queue.append (SmartNew<Prerender> (Prerender {String (key),
+         channels, rate, std::move (owned), String (), nullptr, nullptr}));
+
+        pthread_cond_broadcast (& prerender_cond);
+    }
+
+    pthread_mutex_unlock (& prerender_mutex);
+}
+
+void render_cache_prerender_next (const InputPlugin * plugin,
+ const char * filename, RenderCacheAddFunc add)
+{
+    if (! render_cache_prerender_enabled ())
+        return;
+
+    PluginHandle * handle = aud_plugin_by_header (plugin);
+    if (! handle)
+        return;
+
+    pthread_mutex_lock (& prerender_mutex);
+
+    /* ahead of the renders, which take much longer */
+    if (! prerender_quit && start_threads ())
+    {
+        prerender_queue.insert (0, 1);
+        prerender_queue[0] = SmartNew<Prerender> (Prerender {String (), 0, 0,
+         SmartPtr<RenderCacheJob> (), String (filename), handle, add});
+
+        pthread_cond_broadcast (& prerender_cond);
+    }
+
+    pthread_mutex_unlock (& prerender_mutex);
+}
+
+static void queue_trim ()
+{
+    pthread_mutex_lock (& prerender_mutex);
+
+    /* ahead of the renders, since these keep adding to the cache */
+    if (! trim_queued && ! prerender_quit && start_threads ())
+    {
+        prerender_queue.insert (0, 1);
+        prerender_queue[0] = SmartNew<Prerender> (Prerender {String (), 0, 0,
+         SmartPtr<RenderCacheJob> (), String (), nullptr, nullptr});
+
+        trim_queued = true;
+        pthread_cond_broadcast (& prerender_cond);
+    }
+
+    pthread_mutex_unlock (& prerender_mutex);
+}
+
+void render_cache_cleanup ()
+{
+    pthread_mutex_lock (& prerender_mutex);
+    prerender_quit = true;
+    s_cancel = true;
+    prerender_queue.clear ();
+    pthread_cond_broadcast (& prerender_cond);
+    pthread_mutex_unlock (& prerender_mutex);
+
+    for (pthread_t thread : prerender_threads)
+        pthread_join (thread, nullptr);
+
+    prerender_threads.clear ();
+    prerender_keys.clear ();
+    prerender_quit = false;
+    trim_queued = false;
+    s_cancel = false;
+}
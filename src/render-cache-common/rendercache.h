@@ -0,0 +1,165 @@
+/*
+ * Render Cache for Emulated Formats
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <libaudcore/index.h>
+#include <libaudcore/objects.h>
+#include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
+
+/* Emulated formats are synthesised from scratch on every play.  The render
+ * cache keeps the result as losslessly compressed 16-bit audio in the user
+ * directory, so that a track only has to be emulated once.  Tracks can be
+ * recorded while they play, or rendered ahead of time by background threads
+ * while the entries before them in the playlist are playing.
+ *
+ * Entries are keyed on the contents of the file, the version of the engine
+ * and a string describing every setting that changes the output, so
+ * changing any of them simply misses the cache.  The least recently played
+ * entries are deleted once the cache grows beyond its size limit.  The files
+ * are not portable between machines of different byte order. */
+
+/* Registers the configuration defaults; call from the plugin's init(). */
+void render_cache_init ();
+
+/* Stops the background threads, abandoning any unfinished renders; call
+ * from the plugin's cleanup(). */
+void render_cache_cleanup ();
+
+bool render_cache_enabled ();
+bool render_cache_prerender_enabled ();
+
+/* Cache key for a file of the given format (a short name such as "psf"),
+ * or an empty string if the cache is disabled.
+ *
+ * The version names the emulation engine.  Plugins built on an external
+ * library pass the library's version.  Plugins that carry their own
+ * emulator keep a version string of the form "<engine>-<n>" next to the
+ * key function, and must bump <n> with any change to the emulator (or to
+ * the settings it reads) that alters its output; otherwise the old renders
+ * keep playing in place of the new output.  Superseded entries are never
+ * hit again and are evicted like any others. */
+String render_cache_key (const char * format, const char * version,
+ const Index<char> & data, const char * settings);
+
+/* Plays the given key from the cache, from within InputPlugin::play(), if it
+ * is cached in the given format.  Returns false, without opening the audio
+ * output, if it is not. */
+bool render_cache_play (const char * key, int channels, int rate);
+
+/* Writes one cache entry.  The entry becomes visible only when finish()
+ * succeeds, so an interrupted render never leaves a truncated entry.  When
+ * recording in play(), call discard() on a seek or a change of settings, so
+ * that only a track played straight through is kept. */
+class RenderCacheWriter
+{
+public:
+    ~RenderCacheWriter () { discard (); }
+
+    bool open (const char * key, int channels, int rate);
+    bool is_open () const { return m_file; }
+    int64_t frames () const { return m_frames + m_block.len () / aud::max (m_channels, 1); }
+
+    void write (const int16_t * data, int frames);
+    bool finish ();
+    void discard ();
+
+    /* true if the render should be abandoned (the plugin is unloading) */
+    static bool cancelled ();
+
+private:
+    void write_block ();
+
+    FILE * m_file = nullptr;
+    String m_key, m_temp;
+    int m_channels = 0, m_rate = 0;
+    int64_t m_frames = 0;
+    bool m_error = false;
+    Index<int16_t> m_block;
+    Index<uint64_t> m_offsets;
+    Index<unsigned char> m_coded;
+};
+
+/* Reads a complete cache entry. */
+class RenderCacheReader
+{
+public:
+    ~RenderCacheReader () { close (); }
+
+    bool open (const char * key);
+    void close ();
+
+    int channels () const { return m_channels; }
+    int rate () const { return m_rate; }
+    int64_t frames () const { return m_frames; }
+
+    void seek (int64_t frame);
+
+    /* returns the number of frames read, 0 at the end */
+    int read (int16_t * data, int max_frames);
+
+private:
+    bool load_block (int block);
+
+    FILE * m_file = nullptr;
+    int m_channels = 0, m_rate = 0;
+    int64_t m_frames = 0;
+    Index<uint64_t> m_offsets;
+    Index<unsigned char> m_coded;
+    Index<int16_t> m_block;
+    int m_block_num = -1, m_block_pos = 0;
+};
+
+/* A background render.  render() runs on a worker thread and should feed
+ * the complete track to the writer, which has already been opened, and
+ * return false if it was abandoned (checking RenderCacheWriter::cancelled()
+ * now and then). */
+class RenderCacheJob
+{
+public:
+    virtual ~RenderCacheJob () {}
+    virtual bool render (RenderCacheWriter & writer) = 0;
+};
+
+/* Queues a job to render the given key, unless the key is already cached
+ * or queued.  Takes ownership of the job. */
+void render_cache_prerender (const char * key, int channels, int rate,
+ RenderCacheJob * job);
+
+/* Called on a worker thread with a playlist entry that the plugin should
+ * render, usually by computing its key and calling render_cache_prerender(). */
+typedef void (* RenderCacheAddFunc) (const char * filename);
+
+/* Call from InputPlugin::play().  Looks for entries handled by the same
+ * plugin among those following the one being played in the playlist, and
+ * passes them to <add> on a worker thread. */
+void render_cache_prerender_next (const InputPlugin * plugin,
+ const char * filename, RenderCacheAddFunc add);
+
+/* The "Render Cache" section of the plugin preferences, in full and for
+ * plugins that can only record tracks as they play */
+extern const PreferencesWidget render_cache_widgets[5];
+extern const PreferencesWidget render_cache_record_widgets[3];
+
+#endif
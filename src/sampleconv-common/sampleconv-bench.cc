@@ -0,0 +1,149 @@
+/*
+ * Sample Format Conversion Benchmark
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Reports the throughput of each sampleconv kernel next to the generic
+ * libaudcore conversion it replaces.  Run with "meson test --benchmark". */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libaudcore/audio.h>
+#include <libaudcore/index.h>
+
+#include "sampleconv.h"
+
+#define SAMPLES (1 << 20)
+#define ROUNDS 50
+
+static const struct {
+    int fmt;
+    const char * name;
+} formats[] = {
+    {FMT_FLOAT, "float"},
+    {FMT_S16_NE, "s16"},
+    {FMT_S24_NE, "s24"},
+    {FMT_S32_NE, "s32"}
+};
+
+static double now ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, & ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* millions of samples per second */
+template<class F>
+static double measure (F func)
+{
+    func ();  /* warm up */
+
+    double start = now ();
+    for (int i = 0; i < ROUNDS; i ++)
+        func ();
+
+    return (double) SAMPLES * ROUNDS / (now () - start) / 1e6;
+}
+
+static void generic_convert (const void * in, int in_fmt, void * out, int out_fmt,
+ Index<float> & temp)
+{
+    if (in_fmt == FMT_FLOAT)
+        audio_to_int ((const float *) in, out, out_fmt, SAMPLES);
+    else if (out_fmt == FMT_FLOAT)
+        audio_from_int (in, in_fmt, (float *) out, SAMPLES);
+    else
+    {
+        audio_from_int (in, in_fmt, temp.begin (), SAMPLES);
+        audio_to_int (temp.begin (), out, out_fmt, SAMPLES);
+    }
+}
+
+int main ()
+{
+    Index<float> source, temp;
+    Index<char> in, out;
+
+    source.resize (SAMPLES);
+    temp.resize (SAMPLES);
+    in.resize (4 * SAMPLES);
+    out.resize (4 * SAMPLES);
+
+    srand (1);
+    for (float & f : source)
+        f = (rand () / (float) RAND_MAX) * 2.2f - 1.1f;  /* includes some clipping */
+
+    printf ("Kernels: %s\n", sampleconv_isa ());
+    printf ("%-16s %12s %12s %8s\n", "conversion", "generic", "sampleconv", "speedup");
+
+    for (auto & from : formats)
+    {
+        if (from.fmt == FMT_FLOAT)
+            memcpy (in.begin (), source.begin (), sizeof (float) * SAMPLES);
+        else
+            audio_to_int (source.begin (), in.begin (), from.fmt, SAMPLES);
+
+        for (auto & to : formats)
+        {
+            if (to.fmt == from.fmt)
+                continue;
+
+            double generic = measure ([&] ()
+                { generic_convert (in.begin (), from.fmt, out.begin (), to.fmt, temp); });
+            double fast = measure ([&] ()
+                { sampleconv_convert (in.begin (), from.fmt, out.begin (), to.fmt, SAMPLES); });
+
+            printf ("%-6s -> %-6s %8.1f MS/s %8.1f MS/s %7.2fx\n", from.name, to.name,
+             generic, fast, fast / generic);
+        }
+    }
+
+    /* decoder-style packing of right-justified 32-bit samples */
+    auto wide = (int32_t *) in.begin ();
+    for (int i = 0; i < SAMPLES; i ++)
+        wide[i] = (rand () & 0xffff) - 0x8000;
+
+    double loop = measure ([&] () {
+        auto dest = (int16_t *) out.begin ();
+        for (int i = 0; i < SAMPLES; i ++)
+            dest[i] = wide[i] & 0xffff;
+    });
+    double fast = measure ([&] () { sampleconv_pack_s32 (wide, out.begin (), 2, SAMPLES); });
+
+    printf ("%-16s %8.1f MS/s %8.1f MS/s %7.2fx\n", "pack s32 -> s16", loop, fast, fast / loop);
+
+    /* stereo deinterleaving as done for the Vorbis encoder */
+    float * channels[2] = {temp.begin (), temp.begin () + SAMPLES / 2};
+
+    loop = measure ([&] () {
+        for (int c = 0; c < 2; c ++)
+        {
+            float * to = channels[c];
+            for (int i = c; i < SAMPLES; i += 2)
+                * to ++ = source[i];
+        }
+    });
+    fast = measure ([&] () { sampleconv_deinterleave (source.begin (), channels, 2, SAMPLES / 2); });
+
+    printf ("%-16s %8.1f MS/s %8.1f MS/s %7.2fx\n", "deinterleave 2ch", loop, fast, fast / loop);
+
+    return 0;
+}
@@ -0,0 +1,643 @@
+/*
+ * Sample Format Conversion Kernels
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "sampleconv.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <libaudcore/audio.h>
+#include <libaudcore/objects.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SAMPLECONV_SSE2
+#endif
+
+#if defined(SAMPLECONV_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SAMPLECONV_AVX2
+#define AVX2_TARGET __attribute__ ((target ("avx2")))
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SAMPLECONV_NEON
+#endif
+
+/* The scaling matches libaudcore's audio_to_int() and audio_from_int(): an
+ * integer of <bits> bits maps to [-1, 1) by dividing by 2^(bits - 1). */
+
+struct Kernels
+{
+    const char * isa;
+
+    void (* float_to_s16) (const float * in, int16_t * out, int samples);
+    void (* float_to_s32) (const float * in, int32_t * out, int samples, int bits);
+    void (* s16_to_float) (const int16_t * in, float * out, int samples);
+    void (* s32_to_float) (const int32_t * in, float * out, int samples, int bits);
+    void (* s16_to_s32) (const int16_t * in, int32_t * out, int samples, int shift);
+    void (* s32_to_s16) (const int32_t * in, int16_t * out, int samples, int shift);
+    void (* pack_s16) (const int32_t * in, int16_t * out, int samples);
+    void (* deinterleave_stereo) (const float * in, float * left, float * right, int frames);
+};
+
+/* ---- plain C++ ---- */
+
+static void float_to_s16_c (const float * in, int16_t * out, int samples)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = lrintf (aud::clamp (in[i] * 32768.0f, -32768.0f, 32767.0f));
+}
+
+static void float_to_s32_c (const float * in, int32_t * out, int samples, int bits)
+{
+    double range = (double) (1u << (bits - 1));
+
+    for (int i = 0; i < samples; i ++)
+        out[i] = lrint (aud::clamp (in[i] * range, -range, range - 1));
+}
+
+static void s16_to_float_c (const int16_t * in, float * out, int samples)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = in[i] * (1.0f / 32768.0f);
+}
+
+static void s32_to_float_c (const int32_t * in, float * out, int samples, int bits)
+{
+    float scale = 1.0f / (1u << (bits - 1));
+
+    for (int i = 0; i < samples; i ++)
+        out[i] = in[i] * scale;
+}
+
+static void s16_to_s32_c (const int16_t * in, int32_t * out, int samples, int shift)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = (int32_t) ((uint32_t) in[i] << shift);
+}
+
+/* (x >> shift) rounded to nearest without overflowing near INT32_MAX */
+static inline int32_t round_shift (int32_t x, int shift)
+{
+    return (x >> shift) + ((x >> (shift - 1)) & 1);
+}
+
+static void s32_to_s16_c (const int32_t * in, int16_t * out, int samples, int shift)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = aud::clamp (round_shift (in[i], shift), -32768, 32767);
+}
+
+static void pack_s16_c (const int32_t * in, int16_t * out, int samples)
+{
+    for (int i = 0; i < samples; i ++)
+        out[i] = aud::clamp (in[i], -32768, 32767);
+}
+
+static void deinterleave_stereo_c (const float * in, float * left, float * right, int frames)
+{
+    for (int i = 0; i < frames; i ++)
+    {
+        left[i] = in[2 * i];
+        right[i] = in[2 * i + 1];
+    }
+}
+
+/* ---- SSE2 ---- */
+
+#ifdef SAMPLECONV_SSE2
+
+static void float_to_s16_sse2 (const float * in, int16_t * out, int samples)
+{
+    const __m128 scale = _mm_set1_ps (32768.0f);
+    const __m128 lo = _mm_set1_ps (-32768.0f);
+    const __m128 hi = _mm_set1_ps (32767.0f);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128 x = _mm_mul_ps (_mm_loadu_ps (in + i), scale);
+        __m128 y = _mm_mul_ps (_mm_loadu_ps (in + i + 4), scale);
+        __m128i a = _mm_cvtps_epi32 (_mm_min_ps (_mm_max_ps (x, lo), hi));
+        __m128i b = _mm_cvtps_epi32 (_mm_min_ps (_mm_max_ps (y, lo), hi));
+        _mm_storeu_si128 ((__m128i *) (out + i), _mm_packs_epi32 (a, b));
+    }
+
+    float_to_s16_c (in + i, out + i, samples - i);
+}
+
+static void float_to_s32_sse2 (const float * in, int32_t * out, int samples, int bits)
+{
+    float range = (float) (1u << (bits - 1));
+    const __m128 scale = _mm_set1_ps (range);
+    const __m128 lo = _mm_set1_ps (-range);
+    /* 2^31 - 1 is not representable; let the conversion overflow instead */
+    const __m128 hi = _mm_set1_ps ((bits == 32) ? range : range - 1);
+    int i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128 x = _mm_mul_ps (_mm_loadu_ps (in + i), scale);
+        x = _mm_min_ps (_mm_max_ps (x, lo), hi);
+
+        /* overflow gives 0x80000000; flipping it yields 0x7fffffff */
+        __m128i overflow = _mm_castps_si128 (_mm_cmpge_ps (x, scale));
+        __m128i v = _mm_xor_si128 (_mm_cvtps_epi32 (x), overflow);
+        _mm_storeu_si128 ((__m128i *) (out + i), v);
+    }
+
+    float_to_s32_c (in + i, out + i, samples - i, bits);
+}
+
+static void s16_to_float_sse2 (const int16_t * in, float * out, int samples)
+{
+    const __m128 scale = _mm_set1_ps (1.0f / 32768.0f);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i x = _mm_loadu_si128 ((const __m128i *) (in + i));
+        __m128i a = _mm_srai_epi32 (_mm_unpacklo_epi16 (x, x), 16);
+        __m128i b = _mm_srai_epi32 (_mm_unpackhi_epi16 (x, x), 16);
+        _mm_storeu_ps (out + i, _mm_mul_ps (_mm_cvtepi32_ps (a), scale));
+        _mm_storeu_ps (out + i + 4, _mm_mul_ps (_mm_cvtepi32_ps (b), scale));
+    }
+
+    s16_to_float_c (in + i, out + i, samples - i);
+}
+
+static void s32_to_float_sse2 (const int32_t * in, float * out, int samples, int bits)
+{
+    const __m128 scale = _mm_set1_ps (1.0f / (1u << (bits - 1)));
+    int i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128i x = _mm_loadu_si128 ((const __m128i *) (in + i));
+        _mm_storeu_ps (out + i, _mm_mul_ps (_mm_cvtepi32_ps (x), scale));
+    }
+
+    s32_to_float_c (in + i, out + i, samples - i, bits);
+}
+
+static void s16_to_s32_sse2 (const int16_t * in, int32_t * out, int samples, int shift)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i count = _mm_cvtsi32_si128 (16 - shift);
+    int i = 0;
+
+    /* move each sample to the top half, then shift it back down */
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i x = _mm_loadu_si128 ((const __m128i *) (in + i));
+        __m128i a = _mm_sra_epi32 (_mm_unpacklo_epi16 (zero, x), count);
+        __m128i b = _mm_sra_epi32 (_mm_unpackhi_epi16 (zero, x), count);
+        _mm_storeu_si128 ((__m128i *) (out + i), a);
+        _mm_storeu_si128 ((__m128i *) (out + i + 4), b);
+    }
+
+    s16_to_s32_c (in + i, out + i, samples - i, shift);
+}
+
+static void s32_to_s16_sse2 (const int32_t * in, int16_t * out, int samples, int shift)
+{
+    const __m128i count = _mm_cvtsi32_si128 (shift);
+    const __m128i count1 = _mm_cvtsi32_si128 (shift - 1);
+    const __m128i one = _mm_set1_epi32 (1);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i a = _mm_loadu_si128 ((const __m128i *) (in + i));
+        __m128i b = _mm_loadu_si128 ((const __m128i *) (in + i + 4));
+        a = _mm_add_epi32 (_mm_sra_epi32 (a, count), _mm_and_si128 (_mm_sra_epi32 (a, count1), one));
+        b = _mm_add_epi32 (_mm_sra_epi32 (b, count), _mm_and_si128 (_mm_sra_epi32 (b, count1), one));
+        _mm_storeu_si128 ((__m128i *) (out + i), _mm_packs_epi32 (a, b));
+    }
+
+    s32_to_s16_c (in + i, out + i, samples - i, shift);
+}
+
+static void pack_s16_sse2 (const int32_t * in, int16_t * out, int samples)
+{
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i a = _mm_loadu_si128 ((const __m128i *) (in + i));
+        __m128i b = _mm_loadu_si128 ((const __m128i *) (in + i + 4));
+        _mm_storeu_si128 ((__m128i *) (out + i), _mm_packs_epi32 (a, b));
+    }
+
+    pack_s16_c (in + i, out + i, samples - i);
+}
+
+static void deinterleave_stereo_sse2 (const float * in, float * left, float * right, int frames)
+{
+    int i = 0;
+
+    for (; i + 4 <= frames; i += 4)
+    {
+        __m128 a = _mm_loadu_ps (in + 2 * i);
+        __m128 b = _mm_loadu_ps (in + 2 * i + 4);
+        _mm_storeu_ps (left + i, _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0)));
+        _mm_storeu_ps (right + i, _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1)));
+    }
+
+    deinterleave_stereo_c (in + 2 * i, left + i, right + i, frames - i);
+}
+
+#endif
+
+/* ---- AVX2 (selected at run time) ---- */
+
+#ifdef SAMPLECONV_AVX2
+
+AVX2_TARGET static void float_to_s16_avx2 (const float * in, int16_t * out, int samples)
+{
+    const __m256 scale = _mm256_set1_ps (32768.0f);
+    const __m256 lo = _mm256_set1_ps (-32768.0f);
+    const __m256 hi = _mm256_set1_ps (32767.0f);
+    int i = 0;
+
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256 x = _mm256_mul_ps (_mm256_loadu_ps (in + i), scale);
+        __m256 y = _mm256_mul_ps (_mm256_loadu_ps (in + i + 8), scale);
+        __m256i a = _mm256_cvtps_epi32 (_mm256_min_ps (_mm256_max_ps (x, lo), hi));
+        __m256i b = _mm256_cvtps_epi32 (_mm256_min_ps (_mm256_max_ps (y, lo), hi));
+        /* packs works within 128-bit lanes; put the quarters back in order */
+        __m256i v = _mm256_permute4x64_epi64 (_mm256_packs_epi32 (a, b), _MM_SHUFFLE (3, 1, 2, 0));
+        _mm256_storeu_si256 ((__m256i *) (out + i), v);
+    }
+
+    float_to_s16_sse2 (in + i, out + i, samples - i);
+}
+
+AVX2_TARGET static void float_to_s32_avx2 (const float * in, int32_t * out, int samples, int bits)
+{
+    float range = (float) (1u << (bits - 1));
+    const __m256 scale = _mm256_set1_ps (range);
+    const __m256 lo = _mm256_set1_ps (-range);
+    const __m256 hi = _mm256_set1_ps ((bits == 32) ? range : range - 1);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256 x = _mm256_mul_ps (_mm256_loadu_ps (in + i), scale);
+        x = _mm256_min_ps (_mm256_max_ps (x, lo), hi);
+
+        __m256i overflow = _mm256_castps_si256 (_mm256_cmp_ps (x, scale, _CMP_GE_OQ));
+        __m256i v = _mm256_xor_si256 (_mm256_cvtps_epi32 (x), overflow);
+        _mm256_storeu_si256 ((__m256i *) (out + i), v);
+    }
+
+    float_to_s32_sse2 (in + i, out + i, samples - i, bits);
+}
+
+AVX2_TARGET static void s16_to_float_avx2 (const int16_t * in, float * out, int samples)
+{
+    const __m256 scale = _mm256_set1_ps (1.0f / 32768.0f);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256i x = _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((const __m128i *) (in + i)));
+        _mm256_storeu_ps (out + i, _mm256_mul_ps (_mm256_cvtepi32_ps (x), scale));
+    }
+
+    s16_to_float_sse2 (in + i, out + i, samples - i);
+}
+
+AVX2_TARGET static void s32_to_float_avx2 (const int32_t * in, float * out, int samples, int bits)
+{
+    const __m256 scale = _mm256_set1_ps (1.0f / (1u << (bits - 1)));
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256 ((const __m256i *) (in + i));
+        _mm256_storeu_ps (out + i, _mm256_mul_ps (_mm256_cvtepi32_ps (x), scale));
+    }
+
+    s32_to_float_sse2 (in + i, out + i, samples - i, bits);
+}
+
+#endif
+
+/* ---- NEON ---- */
+
+#ifdef SAMPLECONV_NEON
+
+static void float_to_s16_neon (const float * in, int16_t * out, int samples)
+{
+    int i = 0;
+
+    /* the conversions saturate, so no explicit clipping is needed */
+    for (; i + 8 <= samples; i += 8)
+    {
+        int32x4_t a = vcvtnq_s32_f32 (vmulq_n_f32 (vld1q_f32 (in + i), 32768.0f));
+        int32x4_t b = vcvtnq_s32_f32 (vmulq_n_f32 (vld1q_f32 (in + i + 4), 32768.0f));
+        vst1q_s16 (out + i, vcombine_s16 (vqmovn_s32 (a), vqmovn_s32 (b)));
+    }
+
+    float_to_s16_c (in + i, out + i, samples - i);
+}
+
+static void float_to_s32_neon (const float * in, int32_t * out, int samples, int bits)
+{
+    float range = (float) (1u << (bits - 1));
+    const int32x4_t lo = vdupq_n_s32 (-(int32_t) (1u << (bits - 1)));
+    const int32x4_t hi = vdupq_n_s32 ((int32_t) ((1u << (bits - 1)) - 1));
+    int i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        int32x4_t x = vcvtnq_s32_f32 (vmulq_n_f32 (vld1q_f32 (in + i), range));
+        vst1q_s32 (out + i, vminq_s32 (vmaxq_s32 (x, lo), hi));
+    }
+
+    float_to_s32_c (in + i, out + i, samples - i, bits);
+}
+
+static void s16_to_float_neon (const int16_t * in, float * out, int samples)
+{
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x8_t x = vld1q_s16 (in + i);
+        float32x4_t a = vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (x)));
+        float32x4_t b = vcvtq_f32_s32 (vmovl_s16 (vget_high_s16 (x)));
+        vst1q_f32 (out + i, vmulq_n_f32 (a, 1.0f / 32768.0f));
+        vst1q_f32 (out + i + 4, vmulq_n_f32 (b, 1.0f / 32768.0f));
+    }
+
+    s16_to_float_c (in + i, out + i, samples - i);
+}
+
+static void s32_to_float_neon (const int32_t * in, float * out, int samples, int bits)
+{
+    float scale = 1.0f / (1u << (bits - 1));
+    int i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+        vst1q_f32 (out + i, vmulq_n_f32 (vcvtq_f32_s32 (vld1q_s32 (in + i)), scale));
+
+    s32_to_float_c (in + i, out + i, samples - i, bits);
+}
+
+static void s16_to_s32_neon (const int16_t * in, int32_t * out, int samples, int shift)
+{
+    const int32x4_t count = vdupq_n_s32 (shift);
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x8_t x = vld1q_s16 (in + i);
+        vst1q_s32 (out + i, vshlq_s32 (vmovl_s16 (vget_low_s16 (x)), count));
+        vst1q_s32 (out + i + 4, vshlq_s32 (vmovl_s16 (vget_high_s16 (x)), count));
+    }
+
+    s16_to_s32_c (in + i, out + i, samples - i, shift);
+}
+
+static void s32_to_s16_neon (const int32_t * in, int16_t * out, int samples, int shift)
+{
+    const int32x4_t count = vdupq_n_s32 (-shift);
+    int i = 0;
+
+    /* vrshlq with a negative count is a rounding right shift */
+    for (; i + 8 <= samples; i += 8)
+    {
+        int32x4_t a = vrshlq_s32 (vld1q_s32 (in + i), count);
+        int32x4_t b = vrshlq_s32 (vld1q_s32 (in + i + 4), count);
+        vst1q_s16 (out + i, vcombine_s16 (vqmovn_s32 (a), vqmovn_s32 (b)));
+    }
+
+    s32_to_s16_c (in + i, out + i, samples - i, shift);
+}
+
+static void pack_s16_neon (const int32_t * in, int16_t * out, int samples)
+{
+    int i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x4_t a = vqmovn_s32 (vld1q_s32 (in + i));
+        int16x4_t b = vqmovn_s32 (vld1q_s32 (in + i + 4));
+        vst1q_s16 (out + i, vcombine_s16 (a, b));
+    }
+
+    pack_s16_c (in + i, out + i, samples - i);
+}
+
+static void deinterleave_stereo_neon (const float * in, float * left, float * right, int frames)
+{
+    int i = 0;
+
+    for (; i + 4 <= frames; i += 4)
+    {
+        float32x4x2_t x = vld2q_f32 (in + 2 * i);
+        vst1q_f32 (left + i, x.val[0]);
+        vst1q_f32 (right + i, x.val[1]);
+    }
+
+    deinterleave_stereo_c (in + 2 * i, left + i, right + i, frames - i);
+}
+
+#endif
+
+static Kernels pick_kernels ()
+{
+    Kernels k = {
+        "none",
+        float_to_s16_c,
+        float_to_s32_c,
+        s16_to_float_c,
+        s32_to_float_c,
+        s16_to_s32_c,
+        s32_to_s16_c,
+        pack_s16_c,
+        deinterleave_stereo_c
+    };
+
+#ifdef SAMPLECONV_SSE2
+    k = {
+        "SSE2",
+        float_to_s16_sse2,
+        float_to_s32_sse2,
+        s16_to_float_sse2,
+        s32_to_float_sse2,
+        s16_to_s32_sse2,
+        s32_to_s16_sse2,
+        pack_s16_sse2,
+        deinterleave_stereo_sse2
+    };
+#endif
+
+#ifdef SAMPLECONV_AVX2
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx2"))
+    {
+        k.isa = "AVX2";
+        k.float_to_s16 = float_to_s16_avx2;
+        k.float_to_s32 = float_to_s32_avx2;
+        k.s16_to_float = s16_to_float_avx2;
+        k.s32_to_float = s32_to_float_avx2;
+    }
+#endif
+
+#ifdef SAMPLECONV_NEON
+    k = {
+        "NEON",
+        float_to_s16_neon,
+        float_to_s32_neon,
+        s16_to_float_neon,
+        s32_to_float_neon,
+        s16_to_s32_neon,
+        s32_to_s16_neon,
+        pack_s16_neon,
+        deinterleave_stereo_neon
+    };
+#endif
+
+    return k;
+}
+
+static const Kernels & kernels ()
+{
+    static const Kernels k = pick_kernels ();
+    return k;
+}
+
+const char * sampleconv_isa ()
+{
+    return kernels ().isa;
+}
+
+/* bits of precision for the supported formats, or 0 */
+static int format_bits (int format)
+{
+    switch (format)
+    {
+        case FMT_FLOAT: return 32;
+        case FMT_S16_NE: return 16;
+        case FMT_S24_NE: return 24;
+        case FMT_S32_NE: return 32;
+        default: return 0;
+    }
+}
+
+bool sampleconv_convert (const void * in, int in_fmt, void * out, int out_fmt, int samples)
+{
+    int in_bits = format_bits (in_fmt);
+    int out_bits = format_bits (out_fmt);
+
+    if (! in_bits || ! out_bits)
+        return false;
+
+    auto & k = kernels ();
+
+    if (in_fmt == out_fmt)
+        memcpy (out, in, FMT_SIZEOF (in_fmt) * samples);
+    else if (in_fmt == FMT_FLOAT)
+    {
+        if (out_bits == 16)
+            k.float_to_s16 ((const float *) in, (int16_t *) out, samples);
+        else
+            k.float_to_s32 ((const float *) in, (int32_t *) out, samples, out_bits);
+    }
+    else if (out_fmt == FMT_FLOAT)
+    {
+        if (in_bits == 16)
+            k.s16_to_float ((const int16_t *) in, (float *) out, samples);
+        else
+            k.s32_to_float ((const int32_t *) in, (float *) out, samples, in_bits);
+    }
+    else if (in_bits == 16)
+        k.s16_to_s32 ((const int16_t *) in, (int32_t *) out, samples, out_bits - 16);
+    else if (out_bits == 16)
+        k.s32_to_s16 ((const int32_t *) in, (int16_t *) out, samples, in_bits - 16);
+    else
+    {
+        /* 24 <-> 32 bits in 32-bit containers; rare enough to stay scalar */
+        auto src = (const int32_t *) in;
+        auto dest = (int32_t *) out;
+
+        if (in_bits < out_bits)
+        {
+            for (int i = 0; i < samples; i ++)
+                dest[i] = (int32_t) ((uint32_t) src[i] << 8);
+        }
+        else
+        {
+            for (int i = 0; i < samples; i ++)
+                dest[i] = aud::min (round_shift (src[i], 8), 0x7fffff);
+        }
+    }
+
+    return true;
+}
+
+void sampleconv_pack_s32 (const int32_t * in, void * out, int bytes, int samples)
+{
+    switch (bytes)
+    {
+    case 1:
+    {
+        auto dest = (int8_t *) out;
+        for (int i = 0; i < samples; i ++)
+            dest[i] = aud::clamp (in[i], -128, 127);
+        break;
+    }
+
+    case 2:
+        kernels ().pack_s16 (in, (int16_t *) out, samples);
+        break;
+
+    default:
+        memcpy (out, in, sizeof (int32_t) * samples);
+        break;
+    }
+}
+
+void sampleconv_widen_s16 (const int16_t * in, int32_t * out, int samples)
+{
+    kernels ().s16_to_s32 (in, out, samples, 0);
+}
+
+void sampleconv_deinterleave (const float * in, float * const * out, int channels, int frames)
+{
+    if (channels == 2)
+    {
+        kernels ().deinterleave_stereo (in, out[0], out[1], frames);
+        return;
+    }
+
+    for (int c = 0; c < channels; c ++)
+    {
+        float * to = out[c];
+        for (int i = 0; i < frames; i ++)
+            to[i] = in[i * channels + c];
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ * Sample Format Conversion Kernels
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef SAMPLECONV_H
+#define SAMPLECONV_H
+
+#include <stdint.h>
+
+/* Bulk sample format conversions for plugins that move a lot of audio between
+ * formats (FileWriter, lossless decoders).  Every kernel has a plain C++
+ * version plus SSE2/AVX2 (x86) or NEON (AArch64) variants; the best one the
+ * CPU supports is picked on first use. */
+
+/* Converts <samples> samples between any two of FMT_FLOAT, FMT_S16_NE,
+ * FMT_S24_NE and FMT_S32_NE.  Float input is clipped to [-1, 1]; narrowing
+ * integer conversions round to nearest and saturate.  Returns false for any
+ * other format, which the caller should hand to audio_from_int() and
+ * audio_to_int() instead. */
+bool sampleconv_convert (const void * in, int in_fmt, void * out, int out_fmt, int samples);
+
+/* Packs right-justified 32-bit samples, as produced by FLAC and WavPack
+ * decoders, into 1, 2 or 4 byte containers.  Out-of-range values saturate. */
+void sampleconv_pack_s32 (const int32_t * in, void * out, int bytes, int samples);
+
+/* Widens 16-bit samples to 32 bits without scaling. */
+void sampleconv_widen_s16 (const int16_t * in, int32_t * out, int samples);
+
+/* Splits interleaved float audio into one buffer per channel. */
+void sampleconv_deinterleave (const float * in, float * const * out, int channels, int frames);
+
+/* Name of the instruction set the kernels use on this CPU. */
+const char * sampleconv_isa ();
+
+#endif
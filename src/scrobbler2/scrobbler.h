@@ -19,6 +19,7 @@
 
 //audacious includes
 #include <libaudcore/i18n.h>
+#include <libaudcore/index.h>
 #include <libaudcore/mainloop.h>
 #include <libaudcore/preferences.h>
 #include <libaudcore/runtime.h>
@@ -80,6 +81,7 @@ extern gboolean read_authentication_test_result(String &error_code, String &erro
 extern gboolean read_token(String &error_code, String &error_detail);
 extern gboolean read_session_key(String &error_code, String &error_detail);
 extern gboolean read_scrobble_result(String &error_code, String &error_detail, gboolean *ignored, String &ignored_code);
+extern gboolean read_scrobble_batch_result(String &error_code, String &error_detail, Index<String> &ignored_codes);
 
 //scrobbler.c
 extern StringBuf clean_string(const char *string);
@@ -9,11 +9,13 @@
 
 //external includes
 #include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
 #include <curl/curl.h>
 
 #include <glib.h>
+#include <glib/gstdio.h>
 
 //audacious includes
 #include <libaudcore/audstrings.h>
@@ -72,10 +74,40 @@ static char * scrobbler_get_signature (Index<API_Parameter> & params)
     return g_compute_checksum_for_string (G_CHECKSUM_MD5, buf, -1);
 }
 
+/*
+ * Builds the POST body for a call to method_name with the given parameters
+ * (authentication parameters included) and signs it.
+ * api_sig (checksum) is always included, be it necessary or not
+ */
+static String create_message_to_lastfm (const char * method_name, Index<API_Parameter> & params)
+{
+    StringBuf buf = str_concat ({"method=", method_name});
+
+    for (const API_Parameter & param : params)
+    {
+        char * esc = curl_easy_escape (curlHandle, param.argument ? param.argument : "", 0);
+        buf.insert (-1, "&");
+        buf.insert (-1, param.paramName);
+        buf.insert (-1, "=");
+        buf.insert (-1, esc ? esc : "");
+        curl_free (esc);
+    }
+
+    params.append (String ("method"), String (method_name));
+
+    char * api_sig = scrobbler_get_signature (params);
+    buf.insert (-1, "&api_sig=");
+    buf.insert (-1, api_sig);
+    g_free (api_sig);
+
+    AUDDBG ("FINAL message: %s.\n", (const char *) buf);
+
+    return String (buf);
+}
+
 /*
  * n_args should count with the given authentication parameters
  * At most 2: api_key, session_key.
- * api_sig (checksum) is always included, be it necessary or not
  * Example usage:
  *   create_message_to_lastfm("track.scrobble", 5
  *        "artist", "Artist Name", "track", "Track Name", "timestamp", time(nullptr),
@@ -86,9 +118,6 @@ static char * scrobbler_get_signature (Index<API_Parameter> & params)
 static String create_message_to_lastfm (const char * method_name, int n_args, ...)
 {
     Index<API_Parameter> params;
-    params.append (String ("method"), String (method_name));
-
-    StringBuf buf = str_concat ({"method=", method_name});
 
     va_list vl;
     va_start (vl, n_args);
@@ -99,25 +128,11 @@ static String create_message_to_lastfm (const char * method_name, int n_args, ..
         const char * arg = va_arg (vl, const char *);
 
         params.append (String (name), String (arg));
-
-        char * esc = curl_easy_escape (curlHandle, arg, 0);
-        buf.insert (-1, "&");
-        buf.insert (-1, name);
-        buf.insert (-1, "=");
-        buf.insert (-1, esc ? esc : "");
-        curl_free (esc);
     }
 
     va_end (vl);
 
-    char * api_sig = scrobbler_get_signature (params);
-    buf.insert (-1, "&api_sig=");
-    buf.insert (-1, api_sig);
-    g_free (api_sig);
-
-    AUDDBG ("FINAL message: %s.\n", (const char *) buf);
-
-    return String (buf);
+    return create_message_to_lastfm (method_name, params);
 }
 
 static gboolean send_message_to_lastfm (const char * data)
@@ -285,90 +300,178 @@ gboolean scrobbler_communication_init() {
     return true;
 }
 
-static void set_timestamp_to_current(char **line) {
-    //line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]      line[8]
-    //artist  album   title   number  length  "L"     timestamp album_artist nullptr
+/*
+ * The tracks waiting to be scrobbled are kept in an append-only journal
+ * (scrobbler.log, appended to by queue_track_to_scrobble() in scrobbler.cc).
+ * Entries are never rewritten in place: the byte offset up to which the
+ * journal has been dealt with is stored in scrobbler.log.ack, and the journal
+ * itself is only rewritten once that acknowledged part has grown large.
+ */
 
-    char **split_line = g_strsplit(*line, "\t", 0);
-    g_free(split_line[6]);
-    split_line[6] = g_strdup_printf("%" G_GINT64_FORMAT, g_get_real_time() / G_USEC_PER_SEC);
-    AUDDBG("split line's timestamp is now: %s.\n", split_line[6]);
-    g_free(*line);
-    (*line) = g_strjoinv("\t", split_line);
-    g_strfreev(split_line);
+#define SCROBBLE_BATCH_SIZE 50 //most tracks accepted by a single track.scrobble call
+#define JOURNAL_COMPACT_SIZE (256 * 1024)
+
+//delay between retries, doubled on each consecutive failure (seconds)
+#define RETRY_DELAY_MIN 7
+#define RETRY_DELAY_MAX (30 * 60)
+
+static int retry_delay = 0;
+static int64_t retry_after = 0; //monotonic time before which nothing is retried
+
+static void schedule_retry (gboolean longest) {
+    if (longest)
+        retry_delay = RETRY_DELAY_MAX;
+    else
+        retry_delay = aud::clamp(retry_delay * 2, RETRY_DELAY_MIN, RETRY_DELAY_MAX);
+
+    retry_after = g_get_monotonic_time() + (int64_t) retry_delay * G_USEC_PER_SEC;
+    AUDDBG("Will retry in %d seconds.\n", retry_delay);
+}
+
+static void reset_retry () {
+    retry_delay = 0;
+    retry_after = 0;
+}
+
+static StringBuf journal_path () {
+    return filename_build({aud_get_path(AudPath::UserDir), "scrobbler.log"});
 }
 
-static void delete_lines_from_scrobble_log (GSList **lines_to_remove_ptr, GSList **lines_to_retry_ptr, char *queuepath) {
-    GSList *lines_to_remove = *lines_to_remove_ptr;
-    GSList *lines_to_retry = *lines_to_retry_ptr;
+static StringBuf journal_ack_path () {
+    return filename_build({aud_get_path(AudPath::UserDir), "scrobbler.log.ack"});
+}
+
+//must be called with log_access_mutex held
+static int64_t read_journal_ack () {
     char *contents = nullptr;
-    char **lines = nullptr;
-    char **finallines = g_new (char *, 1);
-    int n_finallines;
+    int64_t offset = 0;
 
-    if (lines_to_remove != nullptr) {
-        lines_to_remove = g_slist_reverse(lines_to_remove);
-    }
-    if (lines_to_retry != nullptr) {
-        lines_to_retry = g_slist_reverse(lines_to_retry);
+    if (g_file_get_contents(journal_ack_path(), &contents, nullptr, nullptr)) {
+        offset = aud::max(g_ascii_strtoll(contents, nullptr, 10), (gint64) 0);
+        g_free(contents);
     }
 
+    return offset;
+}
+
+//must be called with log_access_mutex held
+static void write_journal_ack (int64_t offset) {
+    StringBuf contents = str_printf("%" G_GINT64_FORMAT "\n", offset);
+
+    if (!g_file_set_contents(journal_ack_path(), contents, -1, nullptr))
+        AUDERR("Could not write to scrobbler.log.ack!\n");
+}
+
+//must be called with log_access_mutex held
+//returns the size of the journal, or -1 if it could not be opened
+static int64_t read_journal_from (FILE *f, int64_t offset, Index<char> &data) {
+    if (fseeko(f, 0, SEEK_END) < 0)
+        return -1;
+
+    int64_t size = ftello(f);
+    if (size < 0 || offset > size || fseeko(f, offset, SEEK_SET) < 0)
+        return size;
+
+    data.resize(size - offset);
+    data.remove(fread(data.begin(), 1, data.len(), f), -1);
+    return size;
+}
+
+//reads the unacknowledged part of the journal
+//returns the journal offset at which the data starts, or -1 on error
+static int64_t read_journal (Index<char> &data) {
     pthread_mutex_lock(&log_access_mutex);
 
-    gboolean success = g_file_get_contents(queuepath, &contents, nullptr, nullptr);
-    if (!success) {
-        AUDDBG("Could not read scrobbler.log contents.\n");
+    int64_t offset = read_journal_ack();
+    FILE *f = g_fopen(journal_path(), "rb");
+
+    if (f != nullptr) {
+        int64_t size = read_journal_from(f, offset, data);
+        if (size >= 0 && offset > size) {
+            //the journal was replaced behind our back; start it over
+            AUDDBG("scrobbler.log is shorter than its acknowledged part.\n");
+            offset = 0;
+            size = read_journal_from(f, offset, data);
+        }
+        fclose(f);
+
+        if (size < 0)
+            offset = -1;
     } else {
-        lines = g_strsplit(contents, "\n", 0);
+        offset = -1;
+    }
+
+    pthread_mutex_unlock(&log_access_mutex);
+    return offset;
+}
 
-        n_finallines = 0;
-        for (int i = 0 ; lines[i] != nullptr; i++) {
-            if (!strlen(lines[i])) continue;
+//queues lines again (at the end of the journal) and then acknowledges
+//everything before offset, in that order so that nothing is lost on a crash
+static void acknowledge_journal (int64_t offset, const Index<String> &requeue) {
+    pthread_mutex_lock(&log_access_mutex);
 
-            if (lines_to_remove != nullptr && *((int *) (lines_to_remove->data)) == i) {
-                //this line is to remove
-                lines_to_remove = g_slist_next(lines_to_remove);
-            } else {
-                //keep this line
-                AUDDBG("Going to keep line %i\n", i);
-                if (lines_to_retry != nullptr && *((int *) (lines_to_retry->data)) == i) {
-                  lines_to_retry = g_slist_next(lines_to_retry);
-                  //this line will be retried with a zero timestamp
-                  AUDDBG("Going to zero this line.\n");
-                  AUDDBG("Line before: %s.\n", lines[i]);
-                  set_timestamp_to_current(&(lines[i]));
-                  AUDDBG("Line after: %s.\n", lines[i]);
-                } else {
-                  AUDDBG("not zeroing this line\n");
-                }
-                n_finallines++;
-                finallines = g_renew (char *, finallines, n_finallines);
-                finallines[n_finallines-1] = g_strdup(lines[i]);
-            }
+    if (requeue.len()) {
+        FILE *f = g_fopen(journal_path(), "a");
+        if (f == nullptr) {
+            perror("fopen");
+        } else {
+            for (const String &line : requeue)
+                fprintf(f, "%s\n", (const char *)line);
+            fclose(f);
         }
+    }
 
-        finallines = g_renew (char *, finallines, n_finallines + 2);
-        finallines[n_finallines] = g_strdup("");
-        finallines[n_finallines+1] = nullptr;
-        g_free(contents);
-        contents = g_strjoinv("\n", finallines);
-        success = g_file_set_contents(queuepath, contents, -1, nullptr);
-        if (!success) {
-            AUDERR("Could not write to scrobbler.log!\n");
+    write_journal_ack(offset);
+
+    pthread_mutex_unlock(&log_access_mutex);
+}
+
+//drops the acknowledged part of the journal once it is fully submitted or
+//the acknowledged part has grown past JOURNAL_COMPACT_SIZE
+static void compact_journal () {
+    pthread_mutex_lock(&log_access_mutex);
+
+    StringBuf path = journal_path();
+    int64_t offset = read_journal_ack();
+    FILE *f = g_fopen(path, "rb");
+
+    if (f != nullptr && offset > 0) {
+        Index<char> data;
+        int64_t size = read_journal_from(f, offset, data);
+        fclose(f);
+        f = nullptr;
+
+        if (size >= 0 && (offset >= size || offset >= JOURNAL_COMPACT_SIZE)) {
+            AUDDBG("Compacting scrobbler.log (%" G_GINT64_FORMAT " of %"
+             G_GINT64_FORMAT " bytes acknowledged).\n", offset, size);
+
+            //reset the index first: a crash in between may cause tracks to be
+            //submitted twice, but never lost
+            write_journal_ack(0);
+            if (!g_file_set_contents(path, data.begin(), data.len(), nullptr))
+                AUDERR("Could not write to scrobbler.log!\n");
         }
     }
 
-    pthread_mutex_unlock(&log_access_mutex);
+    if (f != nullptr)
+        fclose(f);
 
-    g_strfreev(finallines);
-    g_strfreev(lines);
-    g_free(contents);
+    pthread_mutex_unlock(&log_access_mutex);
 }
 
-static void save_line_to_remove(GSList **lines_to_remove, int linenumber) {
-    int *rem = g_new (int, 1);
-    *rem = linenumber;
-    (*lines_to_remove) = g_slist_prepend((*lines_to_remove), rem);
+static String set_timestamp_to_current(const char *line) {
+    //line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]      line[8]
+    //artist  album   title   number  length  "L"     timestamp album_artist nullptr
+
+    char **split_line = g_strsplit(line, "\t", 0);
+    g_free(split_line[6]);
+    split_line[6] = g_strdup_printf("%" G_GINT64_FORMAT, g_get_real_time() / G_USEC_PER_SEC);
+    AUDDBG("split line's timestamp is now: %s.\n", split_line[6]);
+    char *joined = g_strjoinv("\t", split_line);
+    String result(joined);
+    g_free(joined);
+    g_strfreev(split_line);
+    return result;
 }
 
 static gboolean is_valid_scrobble_format(char **line) {
@@ -389,119 +492,162 @@ static gboolean is_valid_scrobble_format(char **line) {
     return true;
 }
 
-static void scrobble_cached_queue() {
-    char *queuepath = g_build_filename(aud_get_path(AudPath::UserDir),"scrobbler.log", nullptr);
-    char *contents = nullptr;
-    gboolean success;
-    char **lines = nullptr;
-    char **line;
-    GSList *lines_to_remove = nullptr; //lines to remove because they were scrobbled (or ignored, and will not be retried)
-    GSList *lines_to_retry = nullptr; //lines to retry later because they were too old TODO: or "daily scrobble limit reached"
+static void add_batch_parameter(Index<API_Parameter> &params, const char *name,
+ int index, const char *value) {
+    params.append(String(str_printf("%s[%d]", name, index)), String(value));
+}
 
-    pthread_mutex_lock(&log_access_mutex);
-    success = g_file_get_contents(queuepath, &contents, nullptr, nullptr);
-    pthread_mutex_unlock(&log_access_mutex);
+static String create_scrobble_message(const Index<String> &batch) {
+    Index<API_Parameter> params;
+
+    for (int i = 0; i < batch.len(); i++) {
+        //line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]      line[8]
+        //artist  album   title   number  length  "L"     timestamp album_artist nullptr
+        char **line = g_strsplit(batch[i], "\t", 0);
+
+        add_batch_parameter(params, "artist", i, line[0]);
+        add_batch_parameter(params, "album", i, line[1]);
+        add_batch_parameter(params, "track", i, line[2]);
+        add_batch_parameter(params, "trackNumber", i, line[3]);
+        add_batch_parameter(params, "duration", i, line[4]);
+        add_batch_parameter(params, "timestamp", i, line[6]);
+        //in case cache uses old format without album artist field
+        add_batch_parameter(params, "albumArtist", i, line[7] != nullptr ? line[7] : "");
+
+        g_strfreev(line);
+    }
+
+    params.append(String("api_key"), String(SCROBBLER_API_KEY));
+    params.append(String("sk"), session_key);
+
+    return create_message_to_lastfm("track.scrobble", params);
+}
+
+//collects up to max_tracks valid entries starting at pos
+//returns the position after the last line consumed; incomplete lines are left alone
+static const char *collect_batch(const char *pos, const char *end, int max_tracks,
+ Index<String> &batch) {
+    while (batch.len() < max_tracks && pos < end) {
+        auto newline = (const char *)memchr(pos, '\n', end - pos);
+        if (newline == nullptr)
+            break; //still being written
+
+        String line(str_copy(pos, newline - pos));
+        pos = newline + 1;
+
+        if (!line[0]) continue;
+
+        char **fields = g_strsplit(line, "\t", 0);
 
-    if (!success) {
+        if (is_valid_scrobble_format(fields))
+            batch.append(std::move(line));
+        else
+            AUDWARN("Dropping unscrobbable line from scrobbler.log: %s\n", (const char *)line);
+
+        g_strfreev(fields);
+    }
+
+    return pos;
+}
+
+static void scrobble_cached_queue() {
+    Index<char> data;
+    int64_t start = read_journal(data);
+
+    if (start < 0) {
         AUDDBG("Couldn't access the queue file.\n");
-    } else {
-        lines = g_strsplit(contents, "\n", 0);
-
-        for (int i = 0; lines[i] != nullptr && scrobbling_enabled; i++) {
-            if (!strlen(lines[i])) continue;
-
-            line = g_strsplit(lines[i], "\t", 0);
-
-            //line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]      line[8]
-            //artist  album   title   number  length  "L"     timestamp album_artist nullptr
-
-            if (is_valid_scrobble_format(line))
-            {
-                String scrobblemsg = create_message_to_lastfm ("track.scrobble",
-                 9, "artist", line[0], "album", line[1], "track", line[2],
-                 "trackNumber", line[3], "duration", line[4],
-                 "timestamp", line[6],
-                 "albumArtist", line[7] != nullptr ? line[7] : "",  //in case cache uses old format without album artist field
-                 "api_key", SCROBBLER_API_KEY, "sk", (const char *) session_key);
-
-                if (send_message_to_lastfm(scrobblemsg) == true) {
-                    String error_code;
-                    String error_detail;
-                    gboolean ignored = false;
-                    String ignored_code;
-
-                    if (read_scrobble_result(error_code, error_detail, &ignored, ignored_code) == true) {
-                        AUDDBG("SCROBBLE OK. Error code: %s. Error detail: %s\n",
-                         (const char *)error_code, (const char *)error_detail);
-                        AUDDBG("SCROBBLE OK. ignored: %i.\n", ignored);
-                        AUDDBG("SCROBBLE OK. ignored code: %s.\n",
-                         (const char *)ignored_code);
-                        if (ignored == true && g_strcmp0(ignored_code, "3") == 0) { //3: Timestamp was too old
-                            AUDDBG("SCROBBLE IGNORED!!! %i, detail: %s\n",
-                             ignored, (const char *)ignored_code);
-                            save_line_to_remove(&lines_to_retry, i);
-                        } else if (ignored == true && g_strcmp0(ignored_code, "") == 0) { //5: Daily scrobble limit reached
-                           //TODO: a track might not be scrobbled due to "daily scrobble limit exeeded".
-                           //This message comes on the ignoredMessage attribute, inside the XML of the response.
-                           //We are not dealing with this case currently and are losing that scrobble.
-                           //TODO
-                        } else {
-                            AUDDBG("Not ignored. Carrying on...\n");
-                            save_line_to_remove(&lines_to_remove, i);
-                        }
-                    } else {
-                        AUDINFO("SCROBBLE NOT OK. Error code: %s. Error detail: %s.\n",
-                         (const char *)error_code, (const char *)error_detail);
-
-                        if (! error_code) { //net error(?) or the answer from last.fm was not well read
-                            //scrobble to be retried
-                        }
-                        else if (g_strcmp0(error_code, "11") == 0 ||
-                                 g_strcmp0(error_code, "16") == 0){
-                            //error code 11: Service Offline - This service is temporarily offline. Try again later.
-                            //error code 16: The service is temporarily unavailable, please try again.
-                            //scrobble to be retried
-                        }
-                        else if (g_strcmp0(error_code,  "9") == 0) {
-                            //Bad Session. Reauth.
-                            scrobbling_enabled = false;
-                            session_key = String();
-                            aud_set_str("scrobbler", "session_key", "");
-                        }
-                        else {
-                            save_line_to_remove(&lines_to_remove, i);
-                        }
+        return;
+    }
+
+    const char *pos = data.begin();
+    const char *end = data.end();
+    //after a batch is rejected as a whole, its tracks are resent one by one
+    //so that one bad entry does not take the others down with it
+    const char *one_by_one_until = nullptr;
+    gboolean acknowledged = false;
+
+    while (scrobbling_enabled && pos < end) {
+        Index<String> batch;
+        const char *batch_end = collect_batch(pos, end,
+         (one_by_one_until && pos < one_by_one_until) ? 1 : SCROBBLE_BATCH_SIZE, batch);
+
+        if (batch_end == pos)
+            break;
+
+        Index<String> requeue; //tracks to be retried later
+        gboolean limit_reached = false;
+
+        if (batch.len()) {
+            String scrobblemsg = create_scrobble_message(batch);
+
+            if (send_message_to_lastfm(scrobblemsg) == false) {
+                AUDDBG("Could not scrobble a track on the queue. Network problem?\n");
+                //scrobble to be retried
+                scrobbling_enabled = false;
+                break;
+            }
+
+            String error_code;
+            String error_detail;
+            Index<String> ignored_codes;
+
+            if (read_scrobble_batch_result(error_code, error_detail, ignored_codes) == true) {
+                AUDDBG("SCROBBLE OK. %d tracks submitted.\n", batch.len());
+
+                for (int i = 0; i < batch.len(); i++) {
+                    const char *code = (i < ignored_codes.len()) ? (const char *)ignored_codes[i] : nullptr;
+
+                    if (g_strcmp0(code, "3") == 0) { //3: Timestamp was too old
+                        AUDDBG("SCROBBLE IGNORED (timestamp too old): %s\n", (const char *)batch[i]);
+                        requeue.append(set_timestamp_to_current(batch[i]));
+                    } else if (g_strcmp0(code, "5") == 0) { //5: Daily scrobble limit reached
+                        AUDDBG("SCROBBLE IGNORED (daily limit reached): %s\n", (const char *)batch[i]);
+                        requeue.append(batch[i]);
+                        limit_reached = true;
                     }
-                } else {
-                    AUDDBG("Could not scrobble a track on the queue. Network problem?\n");
-                    //scrobble to be retried
-                    scrobbling_enabled = false;
+                    //anything else was either accepted or will never be
                 }
-
-                //TODO: Avoid spamming last.fm --- It's not as simple as just adding a wait here:
-                //If audacious is closed while we're on this loop, tracks might be re-scrobbled.
-                //This shall be doable if we only pick one track at a time from the scrobbler.log
             } else {
-                AUDDBG("Unscrobbable line.\n");
-                //leave entry on the cache file
+                AUDINFO("SCROBBLE NOT OK. Error code: %s. Error detail: %s.\n",
+                 (const char *)error_code, (const char *)error_detail);
+
+                if (! error_code || //net error(?) or the answer from last.fm was not well read
+                    g_strcmp0(error_code, "11") == 0 || //Service Offline - This service is temporarily offline. Try again later.
+                    g_strcmp0(error_code, "16") == 0 || //The service is temporarily unavailable, please try again.
+                    g_strcmp0(error_code, "29") == 0) { //Rate limit exceeded
+                    //batch to be retried
+                    schedule_retry(false);
+                    break;
+                }
+                else if (g_strcmp0(error_code,  "9") == 0) {
+                    //Bad Session. Reauth.
+                    scrobbling_enabled = false;
+                    session_key = String();
+                    aud_set_str("scrobbler", "session_key", "");
+                    break;
+                }
+                else if (batch.len() > 1) {
+                    one_by_one_until = batch_end;
+                    continue;
+                }
+                //else the track is dropped
             }
-            g_strfreev(line);
-        }//for
+        }
 
-        delete_lines_from_scrobble_log(&lines_to_remove, &lines_to_retry, queuepath);
+        pos = batch_end;
+        acknowledge_journal(start + (pos - data.begin()), requeue);
+        acknowledged = true;
 
-        if (lines_to_remove != nullptr) {
-            g_slist_free_full(lines_to_remove, g_free);
-        }
-        if (lines_to_retry != nullptr) {
-            g_slist_free_full(lines_to_retry, g_free);
+        if (limit_reached) {
+            schedule_retry(true);
+            break;
         }
 
-        g_strfreev(lines);
+        reset_retry();
     }
 
-    g_free(contents);
-    g_free(queuepath);
+    if (acknowledged)
+        compact_journal();
 }
 
 static void send_now_playing() {
@@ -611,6 +757,29 @@ static void treat_permission_check_request() {
     } //session_key == nullptr || strlen(session_key) == 0
 }
 
+//waits until signalled or, if deadline is not zero, until that monotonic time
+static void wait_for_signal(int64_t deadline) {
+    pthread_mutex_lock(&communication_mutex);
+
+    if (!deadline) {
+        pthread_cond_wait(&communication_signal, &communication_mutex);
+    } else {
+        int64_t remaining = deadline - g_get_monotonic_time();
+
+        if (remaining > 0) {
+            struct timeval curtime;
+            struct timespec timeout;
+            gettimeofday(&curtime, nullptr);
+            int64_t usec = (int64_t) curtime.tv_usec + remaining;
+            timeout.tv_sec = curtime.tv_sec + usec / G_USEC_PER_SEC;
+            timeout.tv_nsec = (usec % G_USEC_PER_SEC) * 1000;
+            pthread_cond_timedwait(&communication_signal, &communication_mutex, &timeout);
+        }
+    }
+
+    pthread_mutex_unlock(&communication_mutex);
+}
+
 //Scrobbling will only be enabled after the first connection test passed
 void * scrobbling_thread (void * input_data) {
     while (scrobbler_running) {
@@ -627,30 +796,22 @@ void * scrobbling_thread (void * input_data) {
             }
             now_playing_requested = false;
         } else {
-            if (scrobbling_enabled) {
+            if (scrobbling_enabled && g_get_monotonic_time() >= retry_after) {
               scrobble_cached_queue();
             }
             //scrobbling may be disabled at this point if communication errors occur
 
-            pthread_mutex_lock(&communication_mutex);
             if (scrobbling_enabled) {
-                pthread_cond_wait(&communication_signal, &communication_mutex);
-                pthread_mutex_unlock(&communication_mutex);
+                wait_for_signal(retry_after);
             }
             else {
                 //We don't want to wait until receiving a signal to retry
                 //if submitting the cache failed due to network problems
-                pthread_mutex_unlock(&communication_mutex);
-
                 if (scrobbler_test_connection() == false || !scrobbling_enabled) {
-                    struct timeval curtime;
-                    struct timespec timeout;
-                    pthread_mutex_lock(&communication_mutex);
-                    gettimeofday(&curtime, nullptr);
-                    timeout.tv_sec = curtime.tv_sec + 7;
-                    timeout.tv_nsec = curtime.tv_usec * 1000;
-                    pthread_cond_timedwait(&communication_signal, &communication_mutex, &timeout);
-                    pthread_mutex_unlock(&communication_mutex);
+                    schedule_retry(false);
+                    wait_for_signal(retry_after);
+                } else {
+                    retry_after = 0;
                 }
             }
         }
@@ -665,5 +826,6 @@ void * scrobbling_thread (void * input_data) {
     curlHandle = nullptr;
 
     scrobbling_enabled = true;
+    reset_retry();
     return nullptr;
 }
@@ -170,8 +170,7 @@ gboolean read_scrobble_result(String &error_code, String &error_detail,
          (const char *)error_detail);
         result = false;
     } else {
-        //TODO: We are assuming that only one track is scrobbled per request! This will have to be
-        //re-done to support multiple tracks being scrobbled in batch
+        //Only one track per request here; see read_scrobble_batch_result()
         String ignored_scrobble = get_attribute_value("/lfm/scrobbles[@ignored]", "ignored");
 
         if (ignored_scrobble && strcmp(ignored_scrobble, "0")) {
@@ -188,6 +187,64 @@ gboolean read_scrobble_result(String &error_code, String &error_detail,
     return result;
 }
 
+/*
+ * Reads the answer to a track.scrobble call carrying several tracks.
+ * Returns:
+ *  * TRUE if the request was successful
+ *    * ignored_codes holds one entry per submitted track, in order:
+ *      the code of its ignoredMessage ("0" if the track was accepted)
+ *  * FALSE if the request was unsuccessful
+ *    * error_code_out and error_detail_out must be checked:
+ *      * They are nullptr if an API communication error occur
+ */
+gboolean read_scrobble_batch_result(String &error_code, String &error_detail,
+ Index<String> &ignored_codes) {
+    gboolean result = true;
+
+    if (!prepare_data()) {
+        AUDDBG("Could not read received data from last.fm. What's up?\n");
+        return false;
+    }
+
+    String status = check_status(error_code, error_detail);
+
+    if (!status) {
+        AUDDBG("Status was nullptr. Invalid API answer.\n");
+        clean_data();
+        return false;
+    }
+
+    if (!strcmp(status, "failed")) {
+        AUDDBG("Error code: %s. Detail: %s.\n", (const char *)error_code,
+         (const char *)error_detail);
+        result = false;
+    } else {
+        xmlXPathObjectPtr messages = xmlXPathEvalExpression(
+         (xmlChar *) "/lfm/scrobbles/scrobble/ignoredMessage", context);
+
+        if (messages == nullptr) {
+            AUDDBG ("Error in xmlXPathEvalExpression.\n");
+        } else {
+            if (!xmlXPathNodeSetIsEmpty(messages->nodesetval)) {
+                for (int i = 0; i < messages->nodesetval->nodeNr; i++) {
+                    xmlChar *code = xmlGetProp(messages->nodesetval->nodeTab[i], (xmlChar *) "code");
+                    ignored_codes.append((code && code[0]) ? (const char *)code : "0");
+                    xmlFree(code);
+                }
+            }
+
+            xmlXPathFreeObject(messages);
+        }
+
+        AUDDBG("scrobbles: %d, accepted: %s, ignored: %s\n", ignored_codes.len(),
+         (const char *)get_attribute_value("/lfm/scrobbles[@accepted]", "accepted"),
+         (const char *)get_attribute_value("/lfm/scrobbles[@ignored]", "ignored"));
+    }
+
+    clean_data();
+    return result;
+}
+
 //returns
 //FALSE if there was an error with the connection
 gboolean read_authentication_test_result (String &error_code, String &error_detail) {
@@ -33,6 +33,8 @@
 #include "xs_config.h"
 #include "xs_sidplay2.h"
 
+#include "../render-cache-common/rendercache.h"
+
 class SIDPlugin : public InputPlugin
 {
 public:
@@ -54,6 +56,7 @@ public:
     bool init() override
     {
         xs_init_configuration();
+        render_cache_init();
         return true;
     }
 
@@ -108,6 +111,8 @@ void SIDPlugin::cleanup()
     }
 
     m_init_failed = false;
+
+    render_cache_cleanup();
 }
 
 
@@ -125,6 +130,26 @@ bool SIDPlugin::is_our_file(const char *filename, VFSFile &file)
 }
 
 
+/*
+ * The render cache key covers the file, the engine version and every setting
+ * that changes the output.  Tunes without a length never end, so they are
+ * cached only when a maximum playback time is set.  Tunes are only recorded
+ * as they play, since there is a single emulation engine.
+ */
+static String xs_cache_key(const Index<char> &buf, int subTune, int length)
+{
+    if (!render_cache_enabled() || (length < 0 && !xs_cfg.playMaxTimeEnable))
+        return String();
+
+    return render_cache_key("sid", xs_sidplayfp_version(), buf,
+        str_printf("subtune=%d length=%d max=%d,%d,%d channels=%d rate=%d "
+        "clock=%d,%d model=%d,%d filter=%d", subTune, length,
+        xs_cfg.playMaxTimeEnable, xs_cfg.playMaxTimeUnknown, xs_cfg.playMaxTime,
+        xs_cfg.audioChannels, xs_cfg.audioFrequency, xs_cfg.clockSpeed,
+        xs_cfg.forceSpeed, xs_cfg.mos8580, xs_cfg.forceModel, xs_cfg.emulateFilters));
+}
+
+
 /*
  * Start playing the given file
  */
@@ -161,6 +186,17 @@ bool SIDPlugin::play(const char *filename, VFSFile &file)
             tmpLength = xs_cfg.playMinTime * 1000;
     }
 
+    /* Play from the render cache, if possible */
+    RenderCacheWriter writer;
+    String key = xs_cache_key(buf, subTune, tmpLength);
+
+    if (key) {
+        if (render_cache_play(key, xs_cfg.audioChannels, xs_cfg.audioFrequency))
+            return true;
+
+        writer.open(key, xs_cfg.audioChannels, xs_cfg.audioFrequency);
+    }
+
     /* Initialize song */
     if (!xs_sidplayfp_initsong(subTune)) {
         AUDERR("Couldn't initialize SID-tune '%s' (sub-tune #%i)!\n",
@@ -178,6 +214,7 @@ bool SIDPlugin::play(const char *filename, VFSFile &file)
 
     char *audioBuffer = new char[audioBufSize];
     int64_t bytes_played = 0;
+    bool ended = false;
 
     while (! check_stop ())
     {
@@ -187,6 +224,7 @@ bool SIDPlugin::play(const char *filename, VFSFile &file)
         int bufRemaining = xs_sidplayfp_fillbuffer(audioBuffer, audioBufSize);
 
         write_audio (audioBuffer, bufRemaining);
+        writer.write ((const int16_t *) audioBuffer, bufRemaining / (xs_cfg.audioChannels * 2));
         bytes_played += bufRemaining;
 
         /* Check if we have played enough */
@@ -197,19 +235,26 @@ bool SIDPlugin::play(const char *filename, VFSFile &file)
             if (xs_cfg.playMaxTimeUnknown) {
                 if (tmpLength < 0 &&
                     time_played >= xs_cfg.playMaxTime * 1000)
-                    break;
+                    ended = true;
             } else {
                 if (time_played >= xs_cfg.playMaxTime * 1000)
-                    break;
+                    ended = true;
             }
         }
 
         if (tmpLength >= 0) {
             if (time_played >= tmpLength)
-                break;
+                ended = true;
         }
+
+        if (ended)
+            break;
     }
 
+    /* only a tune played to the end goes into the cache */
+    if (ended)
+        writer.finish();
+
     delete[] audioBuffer;
 
     return true;
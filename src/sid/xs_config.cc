@@ -28,6 +28,8 @@
 #include <libaudcore/preferences.h>
 #include <libaudcore/runtime.h>
 
+#include "../render-cache-common/rendercache.h"
+
 /*
  * Configuration specific stuff
  */
@@ -103,7 +105,8 @@ static constexpr PreferencesWidget widgets[] = {
         {5, 3600, 5, N_("seconds")},
         WIDGET_CHILD),
     WidgetLabel(N_("<b>Note</b>")),
-    WidgetLabel(N_("These settings will take effect when Audacious is restarted."))
+    WidgetLabel(N_("These settings will take effect when Audacious is restarted.")),
+    WidgetBox({{render_cache_record_widgets}})
 };
 
 const PluginPreferences sid_prefs = {{widgets}};
@@ -61,6 +61,18 @@ struct SidState {
 static SidState state;
 
 
+#define XS_STRINGIFY2(x) #x
+#define XS_STRINGIFY(x) XS_STRINGIFY2(x)
+
+/* Version of the emulation engine, for the render cache key
+ */
+const char *xs_sidplayfp_version()
+{
+    return "libsidplayfp-" XS_STRINGIFY(LIBSIDPLAYFP_VERSION_MAJ) "."
+     XS_STRINGIFY(LIBSIDPLAYFP_VERSION_MIN) "." XS_STRINGIFY(LIBSIDPLAYFP_VERSION_LEV);
+}
+
+
 /* Check if we can play the given file
  */
 bool xs_sidplayfp_probe(const void *buf, int64_t bufSize)
@@ -5,6 +5,7 @@
 
 #include <stdint.h>
 
+const char *xs_sidplayfp_version();
 bool xs_sidplayfp_probe(const void *buf, int64_t bufSize);
 void xs_sidplayfp_close();
 bool xs_sidplayfp_init();
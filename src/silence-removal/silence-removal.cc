@@ -25,8 +25,22 @@
 
 #include <math.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #define MAX_BUFFER_SECS  10
 
+/* Audio is classified in windows of this length by its RMS level, which
+ * unlike single samples is not thrown off by noise around the threshold.
+ * Sound starts above threshold + HYSTERESIS_DB and ends below threshold -
+ * HYSTERESIS_DB, so that a level hovering near the threshold does not chop
+ * the audio up. */
+#define WINDOW_MS  20
+#define HYSTERESIS_DB  3
+
 class SilenceRemoval : public EffectPlugin
 {
 public:
@@ -50,6 +64,7 @@ public:
     void start (int & channels, int & rate) override;
     Index<float> & process (Index<float> & data) override;
     bool flush (bool force) override;
+    Index<float> & finish (Index<float> & data, bool end_of_playlist) override;
 };
 
 EXPORT SilenceRemoval aud_plugin_instance;
@@ -60,6 +75,8 @@ const char SilenceRemoval::about[] =
 
 const char * const SilenceRemoval::defaults[] = {
     "threshold", "-40",
+    "trim_inner", "FALSE",
+    "min_duration", "2",
     nullptr
 };
 
@@ -67,15 +84,39 @@ const PreferencesWidget SilenceRemoval::widgets[] = {
     WidgetLabel (N_("<b>Silence Removal</b>")),
     WidgetSpin (N_("Threshold:"),
         WidgetInt ("silence-removal", "threshold"),
-        {-60, -20, 1, N_("dB")})
+        {-60, -20, 1, N_("dB")}),
+    WidgetCheck (N_("Remove silence within songs"),
+        WidgetBool ("silence-removal", "trim_inner")),
+    WidgetSpin (N_("Shorten pauses to:"),
+        WidgetFloat ("silence-removal", "min_duration"),
+        {0.5, MAX_BUFFER_SECS, 0.5, N_("seconds")},
+        WIDGET_CHILD)
 };
 
 const PluginPreferences SilenceRemoval::prefs = {{widgets}};
 
+/* The buffer holds silence that may still have to be played, followed by
+ * the part of the current window that has been received so far. */
 static RingBuf<float> buffer;
 static Index<float> output;
-static int current_channels;
-static bool initial_silence;
+static int current_channels, current_rate;
+static int window_samples, window_filled, held_samples, max_held;
+static float window_energy;
+
+static int threshold_db;
+static float open_energy, close_energy;
+static bool trim_inner;
+static int min_held;
+
+static bool initial_silence;  /* nothing audible yet in this song */
+static bool silent;           /* state of the hysteresis */
+static bool dropping;         /* the current silence is being removed */
+static int64_t run_dropped;   /* samples removed from the current silence */
+
+static struct {
+    int64_t total, leading, inner, trailing;
+    int gaps;
+} stats;
 
 bool SilenceRemoval::init ()
 {
@@ -89,104 +130,257 @@ void SilenceRemoval::cleanup ()
     output.clear ();
 }
 
-void SilenceRemoval::start (int & channels, int & rate)
+/* windows are compared by their sum of squares, which avoids a square root
+ * per window */
+static void set_threshold (int db)
+{
+    threshold_db = db;
+    open_energy = window_samples * powf (10.0f, (db + HYSTERESIS_DB) / 10.0f);
+    close_energy = window_samples * powf (10.0f, (db - HYSTERESIS_DB) / 10.0f);
+}
+
+static void reset_state ()
 {
     buffer.discard ();
-    buffer.alloc (channels * rate * MAX_BUFFER_SECS);
     output.resize (0);
 
-    current_channels = channels;
+    window_filled = 0;
+    window_energy = 0;
+    held_samples = 0;
+
     initial_silence = true;
+    silent = true;
+    dropping = false;
+    run_dropped = 0;
 }
 
-static float * align_to_frame (float * begin, float * sample, bool align_to_end)
+void SilenceRemoval::start (int & channels, int & rate)
 {
-    if (! sample)
-        return nullptr;
+    current_channels = channels;
+    current_rate = rate;
+
+    window_samples = channels * aud::max (1, rate * WINDOW_MS / 1000);
+    max_held = channels * rate * MAX_BUFFER_SECS;
 
-    int offset = sample - begin;
-    if (align_to_end)
-        offset += current_channels;
+    reset_state ();
+    buffer.alloc (max_held + window_samples);
 
-    return begin + (offset - offset % current_channels);
+    set_threshold (aud_get_int ("silence-removal", "threshold"));
+    stats = {};
 }
 
-static void buffer_with_overflow (const float * data, int len)
+/* Sum of squares of a block.  Every sample of the stream passes through
+ * here exactly once, so on long silent stretches the plugin is limited by
+ * memory bandwidth rather than by this loop. */
+static float sum_squares (const float * data, int len)
 {
-    int max = buffer.size ();
+    float sum = 0;
+    int i = 0;
 
-    if (len > max)
+#if defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps ();
+    __m128 acc1 = _mm_setzero_ps ();
+
+    for (; i + 8 <= len; i += 8)
     {
-        buffer.move_out (output, -1, -1);
-        output.insert (data, -1, len - max);
-        buffer.copy_in (data + len - max, max);
+        __m128 a = _mm_loadu_ps (data + i);
+        __m128 b = _mm_loadu_ps (data + i + 4);
+        acc0 = _mm_add_ps (acc0, _mm_mul_ps (a, a));
+        acc1 = _mm_add_ps (acc1, _mm_mul_ps (b, b));
     }
-    else
+
+    float lanes[4];
+    _mm_storeu_ps (lanes, _mm_add_ps (acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32 (0);
+    float32x4_t acc1 = vdupq_n_f32 (0);
+
+    for (; i + 8 <= len; i += 8)
+    {
+        float32x4_t a = vld1q_f32 (data + i);
+        float32x4_t b = vld1q_f32 (data + i + 4);
+        acc0 = vmlaq_f32 (acc0, a, a);
+        acc1 = vmlaq_f32 (acc1, b, b);
+    }
+
+    float32x4_t acc = vaddq_f32 (acc0, acc1);
+    sum = (vgetq_lane_f32 (acc, 0) + vgetq_lane_f32 (acc, 1)) +
+     (vgetq_lane_f32 (acc, 2) + vgetq_lane_f32 (acc, 3));
+#endif
+
+    for (; i < len; i ++)
+        sum += data[i] * data[i];
+
+    return sum;
+}
+
+static void drop_held (int len)
+{
+    buffer.discard (len);
+    held_samples -= len;
+    run_dropped += len;
+}
+
+/* the window is either passed in place or already at the end of the buffer */
+static void hold_window (const float * data)
+{
+    if (data)
+        buffer.copy_in (data, window_samples);
+
+    held_samples += window_samples;
+
+    if (! initial_silence && ! dropping && trim_inner && held_samples >= min_held)
+    {
+        /* a pause within the song is shortened to the minimum length rather
+         * than removed: its beginning is played now, and its last window
+         * when the sound resumes */
+        int keep = aud::max (min_held - window_samples, 0);
+        buffer.move_out (output, -1, keep);
+        held_samples -= keep;
+        dropping = true;
+    }
+
+    if (initial_silence || dropping)
+    {
+        /* keep only the latest window, which is played before the sound
+         * resumes in case it contains the start of a soft attack */
+        drop_held (held_samples - window_samples);
+    }
+    else if (held_samples > max_held)
     {
-        int cur = buffer.len ();
-        if (cur + len > max)
-            buffer.move_out (output, -1, cur + len - max);
+        /* too long to hold, let the oldest part through */
+        buffer.move_out (output, -1, held_samples - max_held);
+        held_samples = max_held;
+    }
+}
 
-        buffer.copy_in (data, len);
+static void release_window (const float * data)
+{
+    if (initial_silence)
+        stats.leading += run_dropped;
+    else if (dropping)
+    {
+        stats.inner += run_dropped;
+        stats.gaps ++;
     }
+
+    initial_silence = false;
+    dropping = false;
+    run_dropped = 0;
+
+    buffer.move_out (output, -1, -1);
+    held_samples = 0;
+
+    if (data)
+        output.insert (data, -1, window_samples);
+}
+
+static void end_window (const float * data)
+{
+    if (silent ? window_energy > open_energy : window_energy < close_energy)
+        silent = ! silent;
+
+    if (silent)
+        hold_window (data);
+    else
+        release_window (data);
+
+    window_filled = 0;
+    window_energy = 0;
 }
 
 Index<float> & SilenceRemoval::process (Index<float> & data)
 {
-    const int threshold_db = aud_get_int ("silence-removal", "threshold");
-    const float threshold = powf (10.0f, threshold_db / 20.0f);
+    int db = aud_get_int ("silence-removal", "threshold");
+    if (db != threshold_db)
+        set_threshold (db);
 
-    float * first_sample = nullptr;
-    float * last_sample = nullptr;
+    double min_duration = aud_get_double ("silence-removal", "min_duration");
+    trim_inner = aud_get_bool ("silence-removal", "trim_inner");
+    min_held = current_channels * (int) (current_rate *
+     aud::clamp (min_duration, 0.0, (double) MAX_BUFFER_SECS));
 
-    for (float & sample : data)
+    output.resize (0);
+    stats.total += data.len ();
+
+    const float * in = data.begin ();
+    int remaining = data.len ();
+
+    while (remaining > 0)
     {
-        if (sample > threshold || sample < -threshold)
+        if (window_filled || remaining < window_samples)
+        {
+            /* a window split across calls is collected in the buffer */
+            int len = aud::min (remaining, window_samples - window_filled);
+
+            window_energy += sum_squares (in, len);
+            buffer.copy_in (in, len);
+            window_filled += len;
+
+            in += len;
+            remaining -= len;
+
+            if (window_filled == window_samples)
+                end_window (nullptr);
+        }
+        else
         {
-            if (! first_sample)
-                first_sample = & sample;
+            /* whole windows are classified in place and only copied if they
+             * are silent */
+            window_energy = sum_squares (in, window_samples);
+            end_window (in);
 
-            last_sample = & sample;
+            in += window_samples;
+            remaining -= window_samples;
         }
     }
 
-    first_sample = align_to_frame (data.begin (), first_sample, false);
-    last_sample = align_to_frame (data.begin (), last_sample, true);
+    return output;
+}
 
-    output.resize (0);
+Index<float> & SilenceRemoval::finish (Index<float> & data, bool end_of_playlist)
+{
+    process (data);
 
-    if (first_sample)
+    /* anything still held at the end of the song is trailing silence */
+    if (silent)
     {
-        /* do not skip leading silence if non-silence has been seen */
-        if (! initial_silence)
-            first_sample = data.begin ();
+        int64_t removed = run_dropped + held_samples + window_filled;
 
-        initial_silence = false;
+        if (initial_silence)
+            stats.leading += removed;
+        else
+            stats.trailing += removed;
 
-        /* copy any saved silence from previous call */
+        buffer.discard ();
+    }
+    else
         buffer.move_out (output, -1, -1);
 
-        /* copy non-silent portion */
-        output.insert (first_sample, -1, last_sample - first_sample);
+    held_samples = 0;
+    window_filled = 0;
+    window_energy = 0;
+    run_dropped = 0;
 
-        /* save trailing silence */
-        buffer_with_overflow (last_sample, data.end () - last_sample);
-    }
-    else
+    if (stats.leading || stats.inner || stats.trailing)
     {
-        /* if non-silence has been seen, save entire silent chunk */
-        if (! initial_silence)
-            buffer_with_overflow (data.begin (), data.len ());
+        float scale = 1.0f / (current_channels * current_rate);
+
+        AUDINFO ("Removed silence: %.1f s leading, %.1f s in %d gaps within "
+         "the song, %.1f s trailing (%.1f s of %.1f s).\n",
+         stats.leading * scale, stats.inner * scale, stats.gaps,
+         stats.trailing * scale, (stats.leading + stats.inner +
+         stats.trailing) * scale, stats.total * scale);
     }
 
+    stats = {};
+
     return output;
 }
 
 bool SilenceRemoval::flush (bool force)
 {
-    buffer.discard ();
-    output.resize (0);
-
-    initial_silence = true;
+    reset_state ();
     return true;
 }
@@ -78,6 +78,17 @@ void PlaylistWidget::calc_layout ()
         m_first = m_length - m_rows;
     if (m_first < 0)
         m_first = 0;
+
+    /* big enough that no two visible rows share a slot */
+    int slots = 32;
+    while (slots < 2 * m_rows)
+        slots *= 2;
+
+    if (m_cache.len () != slots)
+    {
+        m_cache.clear ();
+        m_cache.insert (0, slots);
+    }
 }
 
 int PlaylistWidget::calc_position (int y) const
@@ -126,138 +137,255 @@ void PlaylistWidget::cancel_all ()
 
     if (m_hover != -1)
     {
+        queue_hover (m_hover);
         m_hover = -1;
-        queue_draw ();
     }
 
     popup_hide ();
 }
 
-void PlaylistWidget::draw (QPainter & cr)
+int PlaylistWidget::text_width (const char * text)
 {
-    int active_entry = m_playlist.get_position ();
-    int left = 3, right = 3;
-    int width;
-    QRect rect;
-
-    cr.setFont (* m_font);
+    return m_metrics->horizontalAdvance (text);
+}
 
-    /* background */
+PlaylistWidget::CachedRow & PlaylistWidget::lookup_row (int entry)
+{
+    CachedRow & row = m_cache[entry & (m_cache.len () - 1)];
 
-    cr.fillRect (cr.window (), QColor (skin.colors[SKIN_PLEDIT_NORMALBG]));
+    if (row.entry != entry)
+    {
+        Tuple tuple = m_playlist.entry_tuple (entry, Playlist::NoWait);
+
+        row.entry = entry;
+        row.title = tuple.get_str (Tuple::FormattedTitle);
+        row.length = tuple.get_int (Tuple::Length);
+        row.number_width = text_width (str_printf ("%d.", 1 + entry));
+        row.length_width = (row.length >= 0) ? text_width (str_format_time (row.length)) : 0;
+        row.queue = -1;
+        row.queue_width = 0;
+        row.image.clear ();
+    }
 
-    /* playlist title */
+    return row;
+}
 
-    if (m_offset)
+void PlaylistWidget::invalidate_rows (int from, int to)
+{
+    for (CachedRow & row : m_cache)
     {
-        cr.setPen (QColor (skin.colors[SKIN_PLEDIT_NORMAL]));
-        cr.drawText (left, 0, m_width - left - right, m_row_height,
-         Qt::AlignCenter, (const char *) m_title_text);
+        if (row.entry >= from && row.entry < to)
+            row.entry = -1;
     }
+}
 
-    /* selection highlight */
+/* Measures the visible rows and works out the column positions.  Returns true
+ * (and throws away all the rendered rows) if anything has moved. */
+bool PlaylistWidget::update_row_layout ()
+{
+    bool queued = m_playlist.n_queued ();
+    int number_width = 0, length_width = 0, queue_width = 0;
 
     for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
     {
-        if (m_playlist.entry_selected (i))
-            cr.fillRect (0, m_offset + m_row_height * (i - m_first), m_width,
-             m_row_height, QColor (skin.colors[SKIN_PLEDIT_SELECTEDBG]));
+        CachedRow & row = lookup_row (i);
+
+        int queue = queued ? m_playlist.queue_find_entry (i) : -1;
+        if (queue != row.queue)
+        {
+            row.queue = queue;
+            row.queue_width = (queue >= 0) ? text_width (str_printf ("(#%d)", 1 + queue)) : 0;
+            row.image.clear ();
+        }
+
+        number_width = aud::max (number_width, row.number_width);
+        length_width = aud::max (length_width, row.length_width);
+        queue_width = aud::max (queue_width, row.queue_width);
     }
 
-    /* entry numbers */
+    RowLayout layout {};
+
+    layout.width = m_width;
+    layout.height = m_row_height;
+    layout.left = 3;
+    layout.right = 3 + length_width + 6;
+    layout.length_width = length_width;
 
     if (aud_get_bool ("show_numbers_in_pl"))
-    {
-        width = 0;
+        layout.left += number_width + 4;
+    if (queued)
+        layout.right += queue_width + 6;
 
-        for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
-        {
-            char buf[16];
-            snprintf (buf, sizeof buf, "%d.", 1 + i);
+    layout.colors[0] = skin.colors[SKIN_PLEDIT_NORMAL];
+    layout.colors[1] = skin.colors[SKIN_PLEDIT_CURRENT];
+    layout.colors[2] = skin.colors[SKIN_PLEDIT_NORMALBG];
+    layout.colors[3] = skin.colors[SKIN_PLEDIT_SELECTEDBG];
 
-            cr.setPen (QColor (skin.colors[(i == active_entry) ?
-             SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]));
-            cr.drawText (left, m_offset + m_row_height * (i - m_first),
-             m_width - left - right, m_row_height,
-             Qt::AlignLeft | Qt::AlignVCenter, buf, & rect);
+    if (layout == m_layout)
+        return false;
 
-            width = aud::max (width, rect.width ());
-        }
+    m_layout = layout;
 
-        left += width + 4;
-    }
+    for (CachedRow & row : m_cache)
+        row.image.clear ();
+
+    return true;
+}
 
-    /* entry lengths */
+bool PlaylistWidget::row_changed (CachedRow & row, int entry, int active_entry)
+{
+    return ! row.image || row.selected != m_playlist.entry_selected (entry) ||
+     row.current != (entry == active_entry);
+}
 
-    width = 0;
+void PlaylistWidget::render_row (CachedRow & row, int entry, int active_entry)
+{
+    row.selected = m_playlist.entry_selected (entry);
+    row.current = (entry == active_entry);
 
-    for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
+    if (! row.image)
     {
-        Tuple tuple = m_playlist.entry_tuple (i, Playlist::NoWait);
-        int len = tuple.get_int (Tuple::Length);
-        if (len < 0)
-            continue;
+        qreal ratio = devicePixelRatioF ();
+        row.image.capture (new QImage (m_width * ratio, m_row_height * ratio,
+         QImage::Format_RGB32));
+        row.image->setDevicePixelRatio (ratio);
+    }
+
+    QPainter cr (row.image.get ());
+
+    cr.fillRect (0, 0, m_width, m_row_height, QColor (skin.colors[row.selected ?
+     SKIN_PLEDIT_SELECTEDBG : SKIN_PLEDIT_NORMALBG]));
+
+    cr.setFont (* m_font);
+    cr.setPen (QColor (skin.colors[row.current ?
+     SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]));
+
+    /* entry number */
+
+    if (aud_get_bool ("show_numbers_in_pl"))
+        cr.drawText (3, 0, m_width - 6, m_row_height, Qt::AlignLeft | Qt::AlignVCenter,
+         (const char *) str_printf ("%d.", 1 + entry));
+
+    /* entry length */
+
+    if (row.length >= 0)
+        cr.drawText (3, 0, m_width - 6, m_row_height, Qt::AlignRight | Qt::AlignVCenter,
+         (const char *) str_format_time (row.length));
+
+    /* queue position */
+
+    if (row.queue >= 0)
+        cr.drawText (3, 0, m_width - 6 - m_layout.length_width - 6, m_row_height,
+         Qt::AlignRight | Qt::AlignVCenter, (const char *) str_printf ("(#%d)", 1 + row.queue));
+
+    /* title */
+
+    cr.drawText (m_layout.left, 0, m_width - m_layout.left - m_layout.right,
+     m_row_height, Qt::AlignLeft | Qt::AlignVCenter, (const char *) row.title);
+}
 
-        cr.setPen (QColor (skin.colors[(i == active_entry) ?
-         SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]));
-        cr.drawText (left, m_offset + m_row_height * (i - m_first),
-         m_width - left - right, m_row_height,
-         Qt::AlignRight | Qt::AlignVCenter,
-         (const char *) str_format_time (len), & rect);
+int PlaylistWidget::focus_shown () const
+{
+    int focus = m_playlist.get_focus ();
+
+    if (focus < m_first || focus > m_first + m_rows - 1)
+        return -1;
+
+    /* don't show rectangle if this is the only selected entry */
+    if (m_playlist.entry_selected (focus) && m_playlist.n_selected () <= 1)
+        return -1;
 
-        width = aud::max (width, rect.width ());
+    return focus;
+}
+
+void PlaylistWidget::queue_row (int entry)
+{
+    if (entry >= m_first && entry < m_first + m_rows)
+        queue_draw_area (0, m_offset + m_row_height * (entry - m_first),
+         m_width, m_row_height);
+}
+
+void PlaylistWidget::queue_hover (int hover)
+{
+    if (hover >= m_first && hover <= m_first + m_rows)
+        queue_draw_area (0, m_offset + m_row_height * (hover - m_first) - 1, m_width, 2);
+}
+
+/* Queues a redraw of just the rows that would look different from when they
+ * were last painted.  Scrolling or a change in the column layout still
+ * repaints everything, but from the cached rows. */
+void PlaylistWidget::queue_damage ()
+{
+    if (update_row_layout () || m_first != m_drawn_first || m_rows != m_drawn_rows ||
+     m_length != m_drawn_length || m_title_text != m_drawn_title)
+    {
+        queue_draw ();
+        return;
     }
 
-    right += width + 6;
+    int active_entry = m_playlist.get_position ();
 
-    /* queue positions */
+    for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
+    {
+        if (row_changed (lookup_row (i), i, active_entry))
+            queue_row (i);
+    }
 
-    if (m_playlist.n_queued ())
+    int focus = focus_shown ();
+    if (focus != m_drawn_focus)
     {
-        width = 0;
+        queue_row (m_drawn_focus);
+        queue_row (focus);
+    }
 
-        for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
-        {
-            int pos = m_playlist.queue_find_entry (i);
-            if (pos < 0)
-                continue;
+    if (m_hover != m_drawn_hover)
+    {
+        queue_hover (m_drawn_hover);
+        queue_hover (m_hover);
+    }
+}
 
-            char buf[16];
-            snprintf (buf, sizeof buf, "(#%d)", 1 + pos);
+void PlaylistWidget::draw (QPainter & cr)
+{
+    int active_entry = m_playlist.get_position ();
+    QRect clip = cr.hasClipping () ? cr.clipBoundingRect ().toAlignedRect () : rect ();
 
-            cr.setPen (QColor (skin.colors[(i == active_entry) ?
-             SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]));
-            cr.drawText (left, m_offset + m_row_height * (i - m_first),
-             m_width - left - right, m_row_height,
-             Qt::AlignRight | Qt::AlignVCenter, buf, & rect);
+    update_row_layout ();
 
-            width = aud::max (width, rect.width ());
-        }
+    /* background */
+
+    cr.fillRect (clip, QColor (skin.colors[SKIN_PLEDIT_NORMALBG]));
 
-        right += width + 6;
+    /* playlist title */
+
+    if (m_offset && clip.top () < m_offset)
+    {
+        cr.setFont (* m_font);
+        cr.setPen (QColor (skin.colors[SKIN_PLEDIT_NORMAL]));
+        cr.drawText (3, 0, m_width - 6, m_row_height,
+         Qt::AlignCenter, (const char *) m_title_text);
     }
 
-    /* titles */
+    /* entries, re-rendered only where they have changed */
 
     for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
     {
-        Tuple tuple = m_playlist.entry_tuple (i, Playlist::NoWait);
-        String title = tuple.get_str (Tuple::FormattedTitle);
-
-        cr.setPen (QColor (skin.colors[(i == active_entry) ?
-         SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]));
-        cr.drawText (left, m_offset + m_row_height * (i - m_first),
-         m_width - left - right, m_row_height,
-         Qt::AlignLeft | Qt::AlignVCenter, (const char *) title);
+        int y = m_offset + m_row_height * (i - m_first);
+        if (y + m_row_height <= clip.top () || y > clip.bottom ())
+            continue;
+
+        CachedRow & row = lookup_row (i);
+        if (row_changed (row, i, active_entry))
+            render_row (row, i, active_entry);
+
+        cr.drawImage (0, y, * row.image);
     }
 
     /* focus rectangle */
 
-    int focus = m_playlist.get_focus ();
+    int focus = focus_shown ();
 
-    /* don't show rectangle if this is the only selected entry */
-    if (focus >= m_first && focus <= m_first + m_rows - 1 &&
-        (! m_playlist.entry_selected (focus) || m_playlist.n_selected () > 1))
+    if (focus >= 0)
     {
         cr.setPen (QColor (skin.colors[SKIN_PLEDIT_NORMAL]));
         cr.drawRect (0, m_offset + m_row_height * (focus - m_first), m_width - 1, m_row_height - 1);
@@ -270,6 +398,13 @@ void PlaylistWidget::draw (QPainter & cr)
         cr.fillRect (0, m_offset + m_row_height * (m_hover - m_first) - 1, m_width, 2,
                      QColor (skin.colors[SKIN_PLEDIT_NORMAL]));
     }
+
+    m_drawn_title = m_title_text;
+    m_drawn_first = m_first;
+    m_drawn_rows = m_rows;
+    m_drawn_length = m_length;
+    m_drawn_focus = focus;
+    m_drawn_hover = m_hover;
 }
 
 PlaylistWidget::PlaylistWidget (int width, int height, const char * font) :
@@ -296,6 +431,9 @@ void PlaylistWidget::set_font (const char * font)
     m_font.capture (new QFont (audqt::qfont_from_string (font)));
     m_metrics.capture (new QFontMetrics (* m_font, this));
     m_row_height = m_metrics->height ();
+
+    /* the measured widths are no good with a different font */
+    invalidate_rows (0, m_length);
     refresh ();
 }
 
@@ -311,16 +449,31 @@ void PlaylistWidget::refresh ()
     if (m_playlist != prev_playlist)
     {
         cancel_all ();
+        invalidate_rows (0, m_length);
         m_first = 0;
         ensure_visible (m_playlist.get_focus ());
     }
 
-    queue_draw ();
+    queue_damage ();
 
     if (m_slider)
         m_slider->refresh ();
 }
 
+void PlaylistWidget::playlist_update ()
+{
+    auto update = m_playlist.update_detail ();
+    int entries = m_playlist.n_entries ();
+
+    /* entries after a structural change may have moved */
+    if (update.level == Playlist::Structure)
+        invalidate_rows (update.before, aud::max (m_length, entries));
+    else if (update.level == Playlist::Metadata)
+        invalidate_rows (update.before, entries - update.after);
+
+    refresh ();
+}
+
 void PlaylistWidget::ensure_visible (int position)
 {
     if (position < m_first || position >= m_first + m_rows)
@@ -575,17 +728,19 @@ void PlaylistWidget::hover (int x, int y)
 
     if (row != m_hover)
     {
+        queue_hover (m_hover);
         m_hover = row;
-        queue_draw ();
+        queue_hover (m_hover);
     }
 }
 
 int PlaylistWidget::hover_end ()
 {
     int temp = m_hover;
+
+    queue_hover (m_hover);
     m_hover = -1;
 
-    queue_draw ();
     return temp;
 }
 
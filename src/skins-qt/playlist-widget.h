@@ -28,6 +28,10 @@
 #ifndef SKINS_UI_SKINNED_PLAYLIST_H
 #define SKINS_UI_SKINNED_PLAYLIST_H
 
+#include <string.h>
+
+#include <QImage>
+
 #include <libaudcore/hook.h>
 #include <libaudcore/mainloop.h>
 #include <libaudcore/playlist.h>
@@ -48,6 +52,7 @@ public:
     void resize (int width, int height);
     void set_font (const char * font);
     void refresh ();
+    void playlist_update ();
     bool handle_keypress (QKeyEvent * event);
     void row_info (int * rows, int * first);
     void scroll_to (int row);
@@ -56,6 +61,26 @@ public:
     int hover_end ();
 
 private:
+    /* what is known about one entry; the text is kept until the entry's
+     * metadata changes, the image until its look or the layout changes */
+    struct CachedRow {
+        int entry = -1;
+        String title;
+        int length = -1, number_width = 0, length_width = 0;
+        int queue = -1, queue_width = 0;
+        bool selected = false, current = false;
+        SmartPtr<QImage> image;
+    };
+
+    /* column layout shared by all rows */
+    struct RowLayout {
+        int width, height, left, right, length_width;
+        uint32_t colors[4];
+
+        bool operator== (const RowLayout & b) const
+            { return ! memcmp (this, & b, sizeof (RowLayout)); }
+    };
+
     void draw (QPainter & cr) override;
     bool button_press (QMouseEvent * event) override;
     bool button_release (QMouseEvent * event) override;
@@ -69,6 +94,17 @@ private:
     void update_title ();
     void calc_layout ();
 
+    int text_width (const char * text);
+    CachedRow & lookup_row (int entry);
+    void invalidate_rows (int from, int to);
+    bool update_row_layout ();
+    bool row_changed (CachedRow & row, int entry, int active_entry);
+    void render_row (CachedRow & row, int entry, int active_entry);
+    int focus_shown () const;
+    void queue_row (int entry);
+    void queue_hover (int hover);
+    void queue_damage ();
+
     int calc_position (int y) const;
     int adjust_position (bool relative, int position) const;
 
@@ -99,6 +135,14 @@ private:
     int m_width = 0, m_height = 0, m_row_height = 1, m_offset = 0, m_rows = 0, m_first = 0;
     int m_scroll = 0, m_hover = -1, m_drag = 0, m_popup_pos = -1;
     QueuedFunc m_popup_timer;
+
+    Index<CachedRow> m_cache;
+    RowLayout m_layout {};
+
+    /* as last painted */
+    String m_drawn_title;
+    int m_drawn_first = -1, m_drawn_rows = 0, m_drawn_length = 0;
+    int m_drawn_focus = -1, m_drawn_hover = -1;
 };
 
 #endif
@@ -36,6 +36,7 @@
 #include "plugin.h"
 #include "skin.h"
 #include "skins_util.h"
+#include "../skins/skin-archive.h"
 
 struct SkinPixmapIdMapping {
     const char *name;
@@ -228,7 +229,7 @@ static bool skin_load_data (const char * path)
     if (file_is_archive (path))
     {
         AUDDBG ("Attempt to load archive\n");
-        archive_path = archive_decompress (path);
+        archive_path = skin_archive_get_cached (path);
 
         if (! archive_path)
         {
@@ -251,9 +252,6 @@ static bool skin_load_data (const char * path)
     else
         AUDDBG ("Skin loading failed\n");
 
-    if (archive_path)
-        del_directory (archive_path);
-
     return success;
 }
 
@@ -24,6 +24,7 @@
  */
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -49,6 +50,10 @@
 StringBuf find_file_case_path (const char * folder, const char * basename)
 {
     static SimpleHash<String, Index<String>> cache;
+    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    /* skin thumbnails are looked up from a background thread */
+    pthread_mutex_lock (& mutex);
 
     String key (folder);
     Index<String> * list = cache.lookup (key);
@@ -57,7 +62,10 @@ StringBuf find_file_case_path (const char * folder, const char * basename)
     {
         GDir * handle = g_dir_open (folder, 0, nullptr);
         if (! handle)
+        {
+            pthread_mutex_unlock (& mutex);
             return StringBuf ();
+        }
 
         list = cache.add (key, Index<String> ());
 
@@ -68,13 +76,19 @@ StringBuf find_file_case_path (const char * folder, const char * basename)
         g_dir_close (handle);
     }
 
+    String found;
     for (const String & entry : * list)
     {
         if (! strcmp_nocase (entry, basename))
-            return filename_build ({folder, entry});
+        {
+            found = entry;
+            break;
+        }
     }
 
-    return StringBuf ();
+    pthread_mutex_unlock (& mutex);
+
+    return found ? filename_build ({folder, found}) : StringBuf ();
 }
 
 VFSFile open_local_file_nocase (const char * folder, const char * basename)
@@ -116,8 +130,6 @@ enum ArchiveType {
     ARCHIVE_TBZ2
 };
 
-typedef StringBuf (* ArchiveExtractFunc) (const char *, const char *);
-
 struct ArchiveExtensionType {
     ArchiveType type;
     const char *ext;
@@ -133,69 +145,6 @@ static ArchiveExtensionType archive_extensions[] = {
     {ARCHIVE_TBZ2, ".bz2"}
 };
 
-static StringBuf archive_extract_tar (const char * archive, const char * dest);
-static StringBuf archive_extract_zip (const char * archive, const char * dest);
-static StringBuf archive_extract_tgz (const char * archive, const char * dest);
-static StringBuf archive_extract_tbz2 (const char * archive, const char * dest);
-
-static ArchiveExtractFunc archive_extract_funcs[] = {
-    nullptr,
-    archive_extract_tar,
-    archive_extract_tgz,
-    archive_extract_zip,
-    archive_extract_tbz2
-};
-
-/* FIXME: these functions can be generalised into a function using a
- * command lookup table */
-
-static const char * get_tar_command ()
-{
-    static const char * command = nullptr;
-
-    if (! command)
-    {
-        if (! (command = getenv("TARCMD")))
-            command = "tar";
-    }
-
-    return command;
-}
-
-static const char * get_unzip_command ()
-{
-    static const char * command = nullptr;
-
-    if (! command)
-    {
-        if (! (command = getenv("UNZIPCMD")))
-            command = "unzip";
-    }
-
-    return command;
-}
-
-static StringBuf archive_extract_tar (const char * archive, const char * dest)
-{
-    return str_printf ("%s >/dev/null xf \"%s\" -C %s", get_tar_command (), archive, dest);
-}
-
-static StringBuf archive_extract_zip (const char * archive, const char * dest)
-{
-    return str_printf ("%s >/dev/null -o -j \"%s\" -d %s", get_unzip_command (), archive, dest);
-}
-
-static StringBuf archive_extract_tgz (const char * archive, const char * dest)
-{
-    return str_printf ("%s >/dev/null xzf \"%s\" -C %s", get_tar_command (), archive, dest);
-}
-
-static StringBuf archive_extract_tbz2 (const char * archive, const char * dest)
-{
-    return str_printf ("bzip2 -dc \"%s\" | %s >/dev/null xf - -C %s", archive,
-     get_tar_command (), dest);
-}
-
 static ArchiveType archive_get_type (const char * filename)
 {
     for (auto & ext : archive_extensions)
@@ -223,67 +172,6 @@ StringBuf archive_basename (const char * str)
     return StringBuf ();
 }
 
-/**
- * Escapes characters that are special to the shell inside double quotes.
- *
- * @param string String to be escaped.
- * @return Given string with special characters escaped.
- */
-static StringBuf escape_shell_chars (const char * string)
-{
-    const char *special = "$`\"\\";    /* Characters to escape */
-
-    int num = 0;
-    for (const char * in = string; * in; in ++)
-    {
-        if (strchr (special, * in))
-            num ++;
-    }
-
-    StringBuf escaped (strlen (string) + num);
-
-    char * out = escaped;
-    for (const char * in = string; * in; in ++)
-    {
-        if (strchr (special, * in))
-            * out ++ = '\\';
-        * out ++ = * in;
-    }
-
-    return escaped;
-}
-
-/**
- * Decompresses the archive "filename" to a temporary directory,
- * returns the path to the temp dir, or nullptr if failed
- */
-StringBuf archive_decompress (const char * filename)
-{
-    ArchiveType type = archive_get_type (filename);
-    if (type == ARCHIVE_UNKNOWN)
-        return StringBuf ();
-
-    StringBuf tmpdir = filename_build ({g_get_tmp_dir (), "audacious.XXXXXX"});
-    if (! g_mkdtemp (tmpdir))
-    {
-        AUDWARN ("Error creating %s: %s\n", (const char *) tmpdir, strerror (errno));
-        return StringBuf ();
-    }
-
-    StringBuf escaped_filename = escape_shell_chars (filename);
-    StringBuf cmd = archive_extract_funcs[type] (escaped_filename, tmpdir);
-
-    AUDDBG ("Executing \"%s\"\n", (const char *) cmd);
-    int ret = system (cmd);
-    if (ret != 0)
-    {
-        AUDDBG ("Command \"%s\" returned error %d\n", (const char *) cmd, ret);
-        return StringBuf ();
-    }
-
-    return tmpdir;
-}
-
 static void del_directory_func (const char * path, const char *)
 {
     if (g_file_test (path, G_FILE_TEST_IS_DIR))
@@ -47,6 +47,5 @@ Index<int> string_to_int_array (const char *str);
 
 bool file_is_archive (const char * filename);
 StringBuf archive_basename (const char * str);
-StringBuf archive_decompress (const char * path);
 
 #endif
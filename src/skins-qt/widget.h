@@ -33,6 +33,8 @@ class Widget : public QWidget
 {
 public:
     void queue_draw () { update (); }
+    void queue_draw_area (int x, int y, int w, int h)
+        { update (x * m_scale, y * m_scale, w * m_scale, h * m_scale); }
 
 protected:
     void add_input (int width, int height, bool track_motion, bool drawable);
@@ -78,6 +78,17 @@ void PlaylistWidget::calc_layout ()
         m_first = m_length - m_rows;
     if (m_first < 0)
         m_first = 0;
+
+    /* big enough that no two visible rows share a slot */
+    int slots = 32;
+    while (slots < 2 * m_rows)
+        slots *= 2;
+
+    if (m_cache.len () != slots)
+    {
+        m_cache.clear ();
+        m_cache.insert (0, slots);
+    }
 }
 
 int PlaylistWidget::calc_position (int y) const
@@ -126,167 +137,294 @@ void PlaylistWidget::cancel_all ()
 
     if (m_hover != -1)
     {
+        queue_hover (m_hover);
         m_hover = -1;
-        queue_draw ();
     }
 
     popup_hide ();
 }
 
-void PlaylistWidget::draw (cairo_t * cr)
+PangoLayout * PlaylistWidget::create_layout (const char * text)
 {
-    int active_entry = m_playlist.get_position ();
-    int left = 3, right = 3;
-    PangoLayout * layout;
-    int width;
+    PangoLayout * layout = gtk_widget_create_pango_layout (gtk_dr (), text);
+    pango_layout_set_font_description (layout, m_font.get ());
+    return layout;
+}
 
-    /* background */
+int PlaylistWidget::text_width (const char * text)
+{
+    PangoLayout * layout = create_layout (text);
 
-    set_cairo_color (cr, skin.colors[SKIN_PLEDIT_NORMALBG]);
-    cairo_paint (cr);
+    PangoRectangle rect;
+    pango_layout_get_pixel_extents (layout, nullptr, & rect);
 
-    /* playlist title */
+    g_object_unref (layout);
+    return rect.width;
+}
+
+PlaylistWidget::CachedRow & PlaylistWidget::lookup_row (int entry)
+{
+    CachedRow & row = m_cache[entry & (m_cache.len () - 1)];
 
-    if (m_offset)
+    if (row.entry != entry)
     {
-        layout = gtk_widget_create_pango_layout (gtk_dr (), m_title_text);
-        pango_layout_set_font_description (layout, m_font.get ());
-        pango_layout_set_width (layout, PANGO_SCALE * (m_width - left - right));
-        pango_layout_set_alignment (layout, PANGO_ALIGN_CENTER);
-        pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_MIDDLE);
+        Tuple tuple = m_playlist.entry_tuple (entry, Playlist::NoWait);
+
+        row.entry = entry;
+        row.title = tuple.get_str (Tuple::FormattedTitle);
+        row.length = tuple.get_int (Tuple::Length);
+        row.number_width = text_width (str_printf ("%d.", 1 + entry));
+        row.length_width = (row.length >= 0) ? text_width (str_format_time (row.length)) : 0;
+        row.queue = -1;
+        row.queue_width = 0;
+        row.surface.clear ();
+    }
 
-        cairo_move_to (cr, left, 0);
-        set_cairo_color (cr, skin.colors[SKIN_PLEDIT_NORMAL]);
-        pango_cairo_show_layout (cr, layout);
-        g_object_unref (layout);
+    return row;
+}
+
+void PlaylistWidget::invalidate_rows (int from, int to)
+{
+    for (CachedRow & row : m_cache)
+    {
+        if (row.entry >= from && row.entry < to)
+            row.entry = -1;
     }
+}
 
-    /* selection highlight */
+/* Measures the visible rows and works out the column positions.  Returns true
+ * (and throws away all the rendered rows) if anything has moved. */
+bool PlaylistWidget::update_row_layout ()
+{
+    bool queued = m_playlist.n_queued ();
+    int number_width = 0, length_width = 0, queue_width = 0;
 
     for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
     {
-        if (! m_playlist.entry_selected (i))
-            continue;
+        CachedRow & row = lookup_row (i);
 
-        cairo_rectangle (cr, 0, m_offset + m_row_height * (i - m_first), m_width, m_row_height);
-        set_cairo_color (cr, skin.colors[SKIN_PLEDIT_SELECTEDBG]);
-        cairo_fill (cr);
+        int queue = queued ? m_playlist.queue_find_entry (i) : -1;
+        if (queue != row.queue)
+        {
+            row.queue = queue;
+            row.queue_width = (queue >= 0) ? text_width (str_printf ("(#%d)", 1 + queue)) : 0;
+            row.surface.clear ();
+        }
+
+        number_width = aud::max (number_width, row.number_width);
+        length_width = aud::max (length_width, row.length_width);
+        queue_width = aud::max (queue_width, row.queue_width);
     }
 
-    /* entry numbers */
+    RowLayout layout {};
+
+    layout.width = m_width;
+    layout.height = m_row_height;
+    layout.left = 3;
+    layout.right = 3 + length_width + 6;
+    layout.length_width = length_width;
 
     if (aud_get_bool ("show_numbers_in_pl"))
-    {
-        width = 0;
+        layout.left += number_width + 4;
+    if (queued)
+        layout.right += queue_width + 6;
 
-        for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
-        {
-            char buf[16];
-            snprintf (buf, sizeof buf, "%d.", 1 + i);
+    layout.colors[0] = skin.colors[SKIN_PLEDIT_NORMAL];
+    layout.colors[1] = skin.colors[SKIN_PLEDIT_CURRENT];
+    layout.colors[2] = skin.colors[SKIN_PLEDIT_NORMALBG];
+    layout.colors[3] = skin.colors[SKIN_PLEDIT_SELECTEDBG];
 
-            layout = gtk_widget_create_pango_layout (gtk_dr (), buf);
-            pango_layout_set_font_description (layout, m_font.get ());
+    if (layout == m_layout)
+        return false;
 
-            PangoRectangle rect;
-            pango_layout_get_pixel_extents (layout, nullptr, & rect);
-            width = aud::max (width, rect.width);
+    m_layout = layout;
 
-            cairo_move_to (cr, left, m_offset + m_row_height * (i - m_first));
-            set_cairo_color (cr, skin.colors[(i == active_entry) ?
-             SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
-            pango_cairo_show_layout (cr, layout);
-            g_object_unref (layout);
-        }
+    for (CachedRow & row : m_cache)
+        row.surface.clear ();
 
-        left += width + 4;
-    }
+    return true;
+}
 
-    /* entry lengths */
+bool PlaylistWidget::row_changed (CachedRow & row, int entry, int active_entry)
+{
+    return ! row.surface || row.selected != m_playlist.entry_selected (entry) ||
+     row.current != (entry == active_entry);
+}
 
-    width = 0;
+void PlaylistWidget::render_row (CachedRow & row, int entry, int active_entry)
+{
+    row.selected = m_playlist.entry_selected (entry);
+    row.current = (entry == active_entry);
 
-    for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
-    {
-        Tuple tuple = m_playlist.entry_tuple (i, Playlist::NoWait);
-        int len = tuple.get_int (Tuple::Length);
-        if (len < 0)
-            continue;
+    if (! row.surface)
+        row.surface.capture (cairo_image_surface_create (CAIRO_FORMAT_RGB24,
+         m_width, m_row_height));
 
-        layout = gtk_widget_create_pango_layout (gtk_dr (), str_format_time (len));
-        pango_layout_set_font_description (layout, m_font.get ());
+    cairo_t * cr = cairo_create (row.surface.get ());
+    PangoLayout * layout;
 
-        PangoRectangle rect;
-        pango_layout_get_pixel_extents (layout, nullptr, & rect);
-        width = aud::max (width, rect.width);
+    set_cairo_color (cr, skin.colors[row.selected ?
+     SKIN_PLEDIT_SELECTEDBG : SKIN_PLEDIT_NORMALBG]);
+    cairo_paint (cr);
+
+    set_cairo_color (cr, skin.colors[row.current ?
+     SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
+
+    /* entry number */
 
-        cairo_move_to (cr, m_width - right - rect.width, m_offset + m_row_height * (i - m_first));
-        set_cairo_color (cr, skin.colors[(i == active_entry) ?
-         SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
+    if (aud_get_bool ("show_numbers_in_pl"))
+    {
+        layout = create_layout (str_printf ("%d.", 1 + entry));
+        cairo_move_to (cr, 3, 0);
         pango_cairo_show_layout (cr, layout);
         g_object_unref (layout);
     }
 
-    right += width + 6;
+    /* entry length */
 
-    /* queue positions */
+    if (row.length >= 0)
+    {
+        layout = create_layout (str_format_time (row.length));
+        cairo_move_to (cr, m_width - 3 - row.length_width, 0);
+        pango_cairo_show_layout (cr, layout);
+        g_object_unref (layout);
+    }
 
-    if (m_playlist.n_queued ())
+    /* queue position */
+
+    if (row.queue >= 0)
     {
-        width = 0;
+        layout = create_layout (str_printf ("(#%d)", 1 + row.queue));
+        cairo_move_to (cr, m_width - 3 - m_layout.length_width - 6 - row.queue_width, 0);
+        pango_cairo_show_layout (cr, layout);
+        g_object_unref (layout);
+    }
 
-        for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
-        {
-            int pos = m_playlist.queue_find_entry (i);
-            if (pos < 0)
-                continue;
-
-            char buf[16];
-            snprintf (buf, sizeof buf, "(#%d)", 1 + pos);
-
-            layout = gtk_widget_create_pango_layout (gtk_dr (), buf);
-            pango_layout_set_font_description (layout, m_font.get ());
-
-            PangoRectangle rect;
-            pango_layout_get_pixel_extents (layout, nullptr, & rect);
-            width = aud::max (width, rect.width);
-
-            cairo_move_to (cr, m_width - right - rect.width, m_offset +
-             m_row_height * (i - m_first));
-            set_cairo_color (cr, skin.colors[(i == active_entry) ?
-             SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
-            pango_cairo_show_layout (cr, layout);
-            g_object_unref (layout);
-        }
+    /* title */
+
+    layout = create_layout (row.title);
+    pango_layout_set_width (layout, PANGO_SCALE * (m_width - m_layout.left - m_layout.right));
+    pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
+
+    cairo_move_to (cr, m_layout.left, 0);
+    pango_cairo_show_layout (cr, layout);
+    g_object_unref (layout);
+
+    cairo_destroy (cr);
+}
+
+int PlaylistWidget::focus_shown () const
+{
+    int focus = m_playlist.get_focus ();
+
+    if (focus < m_first || focus > m_first + m_rows - 1)
+        return -1;
+
+    /* don't show rectangle if this is the only selected entry */
+    if (m_playlist.entry_selected (focus) && m_playlist.n_selected () <= 1)
+        return -1;
 
-        right += width + 6;
+    return focus;
+}
+
+void PlaylistWidget::queue_row (int entry)
+{
+    if (entry >= m_first && entry < m_first + m_rows)
+        queue_draw_area (0, m_offset + m_row_height * (entry - m_first),
+         m_width, m_row_height);
+}
+
+void PlaylistWidget::queue_hover (int hover)
+{
+    if (hover >= m_first && hover <= m_first + m_rows)
+        queue_draw_area (0, m_offset + m_row_height * (hover - m_first) - 1, m_width, 2);
+}
+
+/* Queues a redraw of just the rows that would look different from when they
+ * were last painted.  Scrolling or a change in the column layout still
+ * repaints everything, but from the cached rows. */
+void PlaylistWidget::queue_damage ()
+{
+    if (update_row_layout () || m_first != m_drawn_first || m_rows != m_drawn_rows ||
+     m_length != m_drawn_length || m_title_text != m_drawn_title)
+    {
+        queue_draw ();
+        return;
     }
 
-    /* titles */
+    int active_entry = m_playlist.get_position ();
 
     for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
     {
-        Tuple tuple = m_playlist.entry_tuple (i, Playlist::NoWait);
-        String title = tuple.get_str (Tuple::FormattedTitle);
+        if (row_changed (lookup_row (i), i, active_entry))
+            queue_row (i);
+    }
+
+    int focus = focus_shown ();
+    if (focus != m_drawn_focus)
+    {
+        queue_row (m_drawn_focus);
+        queue_row (focus);
+    }
+
+    if (m_hover != m_drawn_hover)
+    {
+        queue_hover (m_drawn_hover);
+        queue_hover (m_hover);
+    }
+}
+
+void PlaylistWidget::draw (cairo_t * cr)
+{
+    int active_entry = m_playlist.get_position ();
+
+    double x1, y1, x2, y2;
+    cairo_clip_extents (cr, & x1, & y1, & x2, & y2);
+
+    update_row_layout ();
+
+    /* background */
+
+    set_cairo_color (cr, skin.colors[SKIN_PLEDIT_NORMALBG]);
+    cairo_paint (cr);
+
+    /* playlist title */
 
-        layout = gtk_widget_create_pango_layout (gtk_dr (), title);
-        pango_layout_set_font_description (layout, m_font.get ());
-        pango_layout_set_width (layout, PANGO_SCALE * (m_width - left - right));
-        pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
+    if (m_offset && y1 < m_offset)
+    {
+        PangoLayout * layout = create_layout (m_title_text);
+        pango_layout_set_width (layout, PANGO_SCALE * (m_width - 6));
+        pango_layout_set_alignment (layout, PANGO_ALIGN_CENTER);
+        pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_MIDDLE);
 
-        cairo_move_to (cr, left, m_offset + m_row_height * (i - m_first));
-        set_cairo_color (cr, skin.colors[(i == active_entry) ?
-         SKIN_PLEDIT_CURRENT : SKIN_PLEDIT_NORMAL]);
+        cairo_move_to (cr, 3, 0);
+        set_cairo_color (cr, skin.colors[SKIN_PLEDIT_NORMAL]);
         pango_cairo_show_layout (cr, layout);
         g_object_unref (layout);
     }
 
+    /* entries, re-rendered only where they have changed */
+
+    for (int i = m_first; i < m_first + m_rows && i < m_length; i ++)
+    {
+        int y = m_offset + m_row_height * (i - m_first);
+        if (y + m_row_height <= y1 || y >= y2)
+            continue;
+
+        CachedRow & row = lookup_row (i);
+        if (row_changed (row, i, active_entry))
+            render_row (row, i, active_entry);
+
+        cairo_set_source_surface (cr, row.surface.get (), 0, y);
+        cairo_rectangle (cr, 0, y, m_width, m_row_height);
+        cairo_fill (cr);
+    }
+
     /* focus rectangle */
 
-    int focus = m_playlist.get_focus ();
+    int focus = focus_shown ();
 
-    /* don't show rectangle if this is the only selected entry */
-    if (focus >= m_first && focus <= m_first + m_rows - 1 &&
-        (! m_playlist.entry_selected (focus) || m_playlist.n_selected () > 1))
+    if (focus >= 0)
     {
         cairo_new_path (cr);
         cairo_set_line_width (cr, 1);
@@ -307,6 +445,13 @@ void PlaylistWidget::draw (cairo_t * cr)
         set_cairo_color (cr, skin.colors[SKIN_PLEDIT_NORMAL]);
         cairo_stroke (cr);
     }
+
+    m_drawn_title = m_title_text;
+    m_drawn_first = m_first;
+    m_drawn_rows = m_rows;
+    m_drawn_length = m_length;
+    m_drawn_focus = focus;
+    m_drawn_hover = m_hover;
 }
 
 PlaylistWidget::PlaylistWidget (int width, int height, const char * font) :
@@ -340,6 +485,9 @@ void PlaylistWidget::set_font (const char * font)
     m_row_height = aud::max (rect.height, 1);
 
     g_object_unref (layout);
+
+    /* the measured widths are no good with a different font */
+    invalidate_rows (0, m_length);
     refresh ();
 }
 
@@ -355,16 +503,31 @@ void PlaylistWidget::refresh ()
     if (m_playlist != prev_playlist)
     {
         cancel_all ();
+        invalidate_rows (0, m_length);
         m_first = 0;
         ensure_visible (m_playlist.get_focus ());
     }
 
-    queue_draw ();
+    queue_damage ();
 
     if (m_slider)
         m_slider->refresh ();
 }
 
+void PlaylistWidget::playlist_update ()
+{
+    auto update = m_playlist.update_detail ();
+    int entries = m_playlist.n_entries ();
+
+    /* entries after a structural change may have moved */
+    if (update.level == Playlist::Structure)
+        invalidate_rows (update.before, aud::max (m_length, entries));
+    else if (update.level == Playlist::Metadata)
+        invalidate_rows (update.before, entries - update.after);
+
+    refresh ();
+}
+
 void PlaylistWidget::ensure_visible (int position)
 {
     if (position < m_first || position >= m_first + m_rows)
@@ -618,17 +781,19 @@ void PlaylistWidget::hover (int x, int y)
 
     if (row != m_hover)
     {
+        queue_hover (m_hover);
         m_hover = row;
-        queue_draw ();
+        queue_hover (m_hover);
     }
 }
 
 int PlaylistWidget::hover_end ()
 {
     int temp = m_hover;
+
+    queue_hover (m_hover);
     m_hover = -1;
 
-    queue_draw ();
     return temp;
 }
 
@@ -0,0 +1,504 @@
+/*
+ * skin-archive.cc
+ * Copyright 2026 Audacious developers
+ *
+ * This file is part of Audacious.
+ *
+ * Audacious is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2 or version 3 of the License.
+ *
+ * Audacious is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Audacious. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The Audacious team does not consider modular code linking to Audacious or
+ * using our public API to be a derived work.
+ */
+
+/*
+ * Skins are usually distributed as .wsz files, which are plain ZIP archives,
+ * or less often as (compressed) tarballs.  ZIP and gzipped or uncompressed tar
+ * archives are read here directly with zlib; only .tar.bz2 still goes through
+ * the external bzip2 and tar commands.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/runtime.h>
+#include <libaudcore/vfs.h>
+
+#include "skin-archive.h"
+#include "skins_util.h"
+
+/* unpacked skins kept in the cache, least recently used are removed first */
+#define CACHE_SIZE 32
+
+/* refuse to inflate anything larger than this */
+#define MAX_UNPACKED_SIZE (64 << 20)
+
+static const char * const pixmap_exts[] = {".bmp", ".png", ".xpm"};
+
+/* only these files are ever looked up by the skin loader */
+static const char * const skin_file_exts[] = {".bmp", ".png", ".xpm", ".txt", ".hints"};
+
+struct ArchiveEntry {
+    String name;        /* base name, without any directories */
+    int64_t offset;     /* offset of the (packed) data in the archive */
+    int64_t size, packed;
+    bool deflated;
+};
+
+class ArchiveReader
+{
+public:
+    bool load (Index<char> && data);
+
+    const ArchiveEntry * find (const char * name) const;
+    Index<char> read (const ArchiveEntry & entry) const;
+
+    bool extract (const char * dest) const;
+
+private:
+    bool parse_zip ();
+    bool parse_tar ();
+    void add_entry (const char * name, int len, int64_t offset, int64_t size,
+     int64_t packed, bool deflated);
+
+    Index<char> m_data;
+    Index<ArchiveEntry> m_entries;
+};
+
+static inline unsigned get16 (const unsigned char * p)
+    { return p[0] | (p[1] << 8); }
+static inline uint32_t get32 (const unsigned char * p)
+    { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24); }
+
+static bool gunzip (const Index<char> & in, Index<char> & out)
+{
+    z_stream z {};
+    if (inflateInit2 (& z, 16 + MAX_WBITS) != Z_OK)
+        return false;
+
+    z.next_in = (Bytef *) in.begin ();
+    z.avail_in = in.len ();
+
+    int ret = Z_OK;
+    while (ret == Z_OK)
+    {
+        if (out.len () >= MAX_UNPACKED_SIZE)
+            break;
+
+        int pos = out.len ();
+        out.resize (aud::max (pos * 2, 65536));
+
+        z.next_out = (Bytef *) out.begin () + pos;
+        z.avail_out = out.len () - pos;
+
+        ret = inflate (& z, Z_NO_FLUSH);
+        out.remove (z.total_out, -1);
+    }
+
+    inflateEnd (& z);
+    return ret == Z_STREAM_END;
+}
+
+static bool has_skin_file_ext (const char * name)
+{
+    for (const char * ext : skin_file_exts)
+    {
+        if (str_has_suffix_nocase (name, ext))
+            return true;
+    }
+
+    return false;
+}
+
+void ArchiveReader::add_entry (const char * name, int len, int64_t offset,
+ int64_t size, int64_t packed, bool deflated)
+{
+    /* archives are flattened, as "unzip -j" would do */
+    for (int i = len; i --; )
+    {
+        if (name[i] == '/' || name[i] == '\\')
+        {
+            name += i + 1;
+            len -= i + 1;
+            break;
+        }
+    }
+
+    if (! len || (len <= 2 && name[0] == '.' && name[len - 1] == '.'))
+        return;
+
+    if (offset < 0 || packed < 0 || offset + packed > m_data.len () ||
+     size < 0 || size > MAX_UNPACKED_SIZE)
+        return;
+
+    m_entries.append (String (str_copy (name, len)), offset, size, packed, deflated);
+}
+
+bool ArchiveReader::parse_zip ()
+{
+    auto data = (const unsigned char *) m_data.begin ();
+    int64_t len = m_data.len ();
+
+    /* the end of central directory record is followed by a comment of up to
+     * 64 KiB, so search backwards for its signature */
+    int64_t eocd = -1;
+    for (int64_t pos = len - 22; pos >= 0 && pos >= len - 22 - 65535; pos --)
+    {
+        if (get32 (data + pos) == 0x06054b50)
+        {
+            eocd = pos;
+            break;
+        }
+    }
+
+    if (eocd < 0)
+        return false;
+
+    int count = get16 (data + eocd + 10);
+    int64_t pos = get32 (data + eocd + 16);
+
+    for (int i = 0; i < count; i ++)
+    {
+        if (pos + 46 > len || get32 (data + pos) != 0x02014b50)
+            return false;
+
+        const unsigned char * cd = data + pos;
+        unsigned method = get16 (cd + 10);
+        int64_t packed = get32 (cd + 20);
+        int64_t size = get32 (cd + 24);
+        int name_len = get16 (cd + 28);
+        int64_t local = get32 (cd + 42);
+
+        if (pos + 46 + name_len > len)
+            return false;
+
+        auto name = (const char *) cd + 46;
+        pos += 46 + name_len + get16 (cd + 30) + get16 (cd + 32);
+
+        /* skip directories and anything we cannot unpack */
+        if (! name_len || name[name_len - 1] == '/' || (method != 0 && method != 8))
+            continue;
+
+        /* the data follows the local header, whose extra field may differ
+         * from the one in the central directory */
+        if (local + 30 > len || get32 (data + local) != 0x04034b50)
+            continue;
+
+        int64_t offset = local + 30 + get16 (data + local + 26) + get16 (data + local + 28);
+        add_entry (name, name_len, offset, size, packed, method == 8);
+    }
+
+    return true;
+}
+
+static int64_t parse_octal (const char * field, int len)
+{
+    int64_t value = 0;
+
+    for (int i = 0; i < len && field[i]; i ++)
+    {
+        if (field[i] >= '0' && field[i] <= '7')
+            value = (value << 3) | (field[i] - '0');
+        else if (field[i] != ' ')
+            break;
+    }
+
+    return value;
+}
+
+bool ArchiveReader::parse_tar ()
+{
+    const char * data = m_data.begin ();
+    int64_t len = m_data.len ();
+    String long_name;
+
+    for (int64_t pos = 0; pos + 512 <= len; )
+    {
+        const char * header = data + pos;
+
+        if (! header[0])
+            break;  /* end of archive */
+
+        int64_t size = parse_octal (header + 124, 12);
+        char type = header[156];
+        pos += 512;
+
+        if (type == 'L')  /* GNU long name for the next entry */
+        {
+            long_name = String (str_copy (data + pos, strnlen (data + pos, aud::min (size, len - pos))));
+        }
+        else if (type == '0' || type == '\0')
+        {
+            if (long_name)
+                add_entry (long_name, strlen (long_name), pos, size, size, false);
+            else
+                add_entry (header, strnlen (header, 100), pos, size, size, false);
+        }
+
+        if (type != 'L')
+            long_name = String ();
+
+        pos += (size + 511) & ~(int64_t) 511;
+    }
+
+    return m_entries.len () > 0;
+}
+
+bool ArchiveReader::load (Index<char> && data)
+{
+    m_data = std::move (data);
+    m_entries.clear ();
+
+    if (m_data.len () < 4)
+        return false;
+
+    auto magic = (const unsigned char *) m_data.begin ();
+
+    if (magic[0] == 'P' && magic[1] == 'K')
+        return parse_zip ();
+
+    if (magic[0] == 0x1f && magic[1] == 0x8b)
+    {
+        Index<char> tar;
+        if (! gunzip (m_data, tar))
+            return false;
+
+        m_data = std::move (tar);
+    }
+
+    /* the ustar magic is missing in old-style archives, so just try */
+    return m_data.len () >= 512 && parse_tar ();
+}
+
+const ArchiveEntry * ArchiveReader::find (const char * name) const
+{
+    for (const ArchiveEntry & entry : m_entries)
+    {
+        if (! strcmp_nocase (entry.name, name))
+            return & entry;
+    }
+
+    return nullptr;
+}
+
+Index<char> ArchiveReader::read (const ArchiveEntry & entry) const
+{
+    Index<char> out;
+    const char * in = m_data.begin () + entry.offset;
+
+    if (! entry.deflated)
+    {
+        out.insert (in, 0, aud::min (entry.size, entry.packed));
+        return out;
+    }
+
+    z_stream z {};
+    if (inflateInit2 (& z, -MAX_WBITS) != Z_OK)
+        return out;
+
+    out.resize (entry.size);
+
+    z.next_in = (Bytef *) in;
+    z.avail_in = entry.packed;
+    z.next_out = (Bytef *) out.begin ();
+    z.avail_out = out.len ();
+
+    int ret = inflate (& z, Z_FINISH);
+    inflateEnd (& z);
+
+    if (ret != Z_STREAM_END || z.total_out != (uLong) entry.size)
+    {
+        AUDWARN ("Corrupt archive member %s\n", (const char *) entry.name);
+        out.clear ();
+    }
+
+    return out;
+}
+
+bool ArchiveReader::extract (const char * dest) const
+{
+    bool found = false;
+
+    for (const ArchiveEntry & entry : m_entries)
+    {
+        if (! has_skin_file_ext (entry.name))
+            continue;
+
+        Index<char> contents = read (entry);
+        StringBuf path = filename_build ({dest, entry.name});
+        GError * err = nullptr;
+
+        if (! g_file_set_contents (path, contents.begin (), contents.len (), & err))
+        {
+            AUDWARN ("Failed to write %s: %s\n", (const char *) path, err->message);
+            g_error_free (err);
+            return false;
+        }
+
+        found = true;
+    }
+
+    return found;
+}
+
+Index<char> skin_archive_read_pixmap (const char * archive, const char * basename)
+{
+    ArchiveReader reader;
+    if (! reader.load (VFSFile (archive, "r").read_all ()))
+        return Index<char> ();
+
+    for (const char * ext : pixmap_exts)
+    {
+        const ArchiveEntry * entry = reader.find (str_concat ({basename, ext}));
+        if (entry)
+            return reader.read (* entry);
+    }
+
+    return Index<char> ();
+}
+
+/* .tar.bz2 skins are rare enough not to warrant another library, so bzip2 is
+ * run as a separate process and the tar stream it produces is read in memory.
+ * The file name goes straight into the argument vector; no shell is involved. */
+static Index<char> bunzip2_external (const char * archive)
+{
+    Index<char> out;
+    if (! str_has_suffix_nocase (archive, ".bz2"))
+        return out;
+
+    const char * argv[] = {"bzip2", "-dc", "--", archive, nullptr};
+    GSpawnFlags flags = (GSpawnFlags) (G_SPAWN_SEARCH_PATH | G_SPAWN_STDERR_TO_DEV_NULL);
+    GError * err = nullptr;
+    int fd = -1;
+
+    if (! g_spawn_async_with_pipes (nullptr, (char * *) argv, nullptr, flags,
+     nullptr, nullptr, nullptr, nullptr, & fd, nullptr, & err))
+    {
+        AUDWARN ("Failed to run bzip2: %s\n", err->message);
+        g_error_free (err);
+        return out;
+    }
+
+    while (out.len () < MAX_UNPACKED_SIZE)
+    {
+        int pos = out.len ();
+        out.resize (pos + 65536);
+
+        ssize_t got = read (fd, out.begin () + pos, 65536);
+        out.remove (pos + aud::max (got, (ssize_t) 0), -1);
+
+        if (got <= 0)
+            break;
+    }
+
+    close (fd);
+    return out;
+}
+
+static StringBuf get_cache_dir ()
+{
+    return filename_build ({g_get_user_cache_dir (), "audacious", "skins"});
+}
+
+struct CachedSkin {
+    String path;
+    time_t used;
+};
+
+static void prune_cache (const char * cache_dir)
+{
+    Index<CachedSkin> skins;
+
+    GDir * dir = g_dir_open (cache_dir, 0, nullptr);
+    if (! dir)
+        return;
+
+    const char * name;
+    while ((name = g_dir_read_name (dir)))
+    {
+        StringBuf path = filename_build ({cache_dir, name});
+        GStatBuf st;
+
+        if (g_stat (path, & st) == 0 && S_ISDIR (st.st_mode))
+            skins.append (String (path), st.st_mtime);
+    }
+
+    g_dir_close (dir);
+
+    if (skins.len () <= CACHE_SIZE)
+        return;
+
+    skins.sort ([] (const CachedSkin & a, const CachedSkin & b)
+        { return (a.used > b.used) - (a.used < b.used); });
+
+    for (int i = 0; i < skins.len () - CACHE_SIZE; i ++)
+    {
+        AUDDBG ("Removing cached skin %s\n", (const char *) skins[i].path);
+        del_directory (skins[i].path);
+    }
+}
+
+StringBuf skin_archive_get_cached (const char * archive)
+{
+    Index<char> data = VFSFile (archive, "r").read_all ();
+    if (! data.len ())
+        return StringBuf ();
+
+    CharPtr hash (g_compute_checksum_for_data (G_CHECKSUM_SHA1,
+     (const unsigned char *) data.begin (), data.len ()));
+
+    StringBuf cache_dir = get_cache_dir ();
+    StringBuf skin_dir = filename_build ({cache_dir, hash});
+
+    if (g_file_test (skin_dir, G_FILE_TEST_IS_DIR))
+    {
+        AUDDBG ("Using cached skin in %s\n", (const char *) skin_dir);
+        g_utime (skin_dir, nullptr);  /* mark as recently used */
+        return skin_dir;
+    }
+
+    make_directory (cache_dir);
+
+    /* unpack next to the final location, then move it into place */
+    StringBuf temp_dir = filename_build ({cache_dir, "unpack.XXXXXX"});
+    if (! g_mkdtemp (temp_dir))
+    {
+        AUDWARN ("Error creating %s: %s\n", (const char *) temp_dir, strerror (errno));
+        return StringBuf ();
+    }
+
+    ArchiveReader reader;
+    bool success = (reader.load (std::move (data)) ||
+     reader.load (bunzip2_external (archive))) && reader.extract (temp_dir);
+
+    if (success && g_rename (temp_dir, skin_dir) != 0)
+    {
+        AUDWARN ("Error creating %s: %s\n", (const char *) skin_dir, strerror (errno));
+        success = false;
+    }
+
+    if (! success)
+    {
+        del_directory (temp_dir);
+        return StringBuf ();
+    }
+
+    prune_cache (cache_dir);
+    return skin_dir.settle ();
+}
@@ -0,0 +1,38 @@
+/*
+ * skin-archive.h
+ * Copyright 2026 Audacious developers
+ *
+ * This file is part of Audacious.
+ *
+ * Audacious is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 2 or version 3 of the License.
+ *
+ * Audacious is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * Audacious. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The Audacious team does not consider modular code linking to Audacious or
+ * using our public API to be a derived work.
+ */
+
+#ifndef SKINS_SKIN_ARCHIVE_H
+#define SKINS_SKIN_ARCHIVE_H
+
+#include <libaudcore/index.h>
+#include <libaudcore/objects.h>
+
+/* Reads one pixmap ("main" for main.bmp, main.png, etc.) out of a skin archive
+ * without unpacking anything else.  Returns the raw file contents, or an empty
+ * buffer if the archive has no such pixmap.  Safe to call from any thread. */
+Index<char> skin_archive_read_pixmap (const char * archive, const char * basename);
+
+/* Returns a directory holding the files of a skin archive.  Archives are
+ * unpacked once into a cache keyed by the hash of their contents, so loading
+ * the same skin again costs no more than loading an unpacked one. */
+StringBuf skin_archive_get_cached (const char * archive);
+
+#endif /* SKINS_SKIN_ARCHIVE_H */
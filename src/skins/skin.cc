@@ -35,6 +35,7 @@
 #include "plugin.h"
 #include "surface.h"
 #include "skin.h"
+#include "skin-archive.h"
 #include "skins_util.h"
 
 struct SkinPixmapIdMapping {
@@ -215,7 +216,7 @@ static bool skin_load_data (const char * path)
     if (file_is_archive (path))
     {
         AUDDBG ("Attempt to load archive\n");
-        archive_path = archive_decompress (path);
+        archive_path = skin_archive_get_cached (path);
 
         if (! archive_path)
         {
@@ -238,9 +239,6 @@ static bool skin_load_data (const char * path)
     else
         AUDDBG ("Skin loading failed\n");
 
-    if (archive_path)
-        del_directory (archive_path);
-
     return success;
 }
 
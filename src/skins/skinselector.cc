@@ -21,6 +21,7 @@
  * using our public API to be a derived work.
  */
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -31,6 +32,7 @@
 
 #include "plugin.h"
 #include "skin.h"
+#include "skin-archive.h"
 #include "skinselector.h"
 #include "skins_util.h"
 #include "view.h"
@@ -48,33 +50,65 @@ struct SkinNode {
 
 static Index<SkinNode> skinlist;
 
+/* Thumbnails are made in a background thread, since that may mean reading
+ * hundreds of skin archives.  Finished ones are queued and picked up by an
+ * idle callback in the main thread. */
+
+struct ThumbJob {
+    Index<String> paths;
+    int generation, size;
+};
+
+struct ThumbResult {
+    int generation, row;
+    GdkPixbuf * pixbuf;
+};
+
+static pthread_mutex_t thumb_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t thumb_thread;
+static bool thumb_thread_running;
+static bool thumb_cancel;                /* protected by thumb_mutex */
+static Index<ThumbResult> thumb_results; /* protected by thumb_mutex */
+static unsigned thumb_source;            /* protected by thumb_mutex */
+
+/* main thread only */
+static int thumb_generation;
+static GtkListStore * thumb_store;
+
 static void skin_view_on_cursor_changed (GtkTreeView * treeview);
 
 static AudguiPixbuf skin_get_preview (const char * path)
 {
     AudguiPixbuf preview;
 
-    StringBuf archive_path;
     if (file_is_archive (path))
     {
-        archive_path = archive_decompress (path);
-        if (! archive_path)
+        /* only the main window bitmap is read; nothing is unpacked to disk */
+        Index<char> data = skin_archive_read_pixmap (path, "main");
+        if (! data.len ())
             return preview;
 
-        path = archive_path;
+        GdkPixbufLoader * loader = gdk_pixbuf_loader_new ();
+        bool success = gdk_pixbuf_loader_write (loader,
+         (const unsigned char *) data.begin (), data.len (), nullptr);
+        success = gdk_pixbuf_loader_close (loader, nullptr) && success;
+
+        GdkPixbuf * pixbuf = success ? gdk_pixbuf_loader_get_pixbuf (loader) : nullptr;
+        if (pixbuf)
+            preview.capture ((GdkPixbuf *) g_object_ref (pixbuf));
+
+        g_object_unref (loader);
+        return preview;
     }
 
     StringBuf preview_path = skin_pixmap_locate (path, "main");
     if (preview_path)
         preview.capture (gdk_pixbuf_new_from_file (preview_path, nullptr));
 
-    if (archive_path)
-        del_directory (archive_path);
-
     return preview;
 }
 
-static AudguiPixbuf skin_get_thumbnail (const char * path)
+static AudguiPixbuf skin_get_thumbnail (const char * path, int size)
 {
     StringBuf base = filename_get_base (path);
     base.insert (-1, ".png");
@@ -97,11 +131,128 @@ static AudguiPixbuf skin_get_thumbnail (const char * path)
     }
 
     if (thumb)
-        audgui_pixbuf_scale_within (thumb, audgui_get_dpi () * 3 / 2);
+        audgui_pixbuf_scale_within (thumb, size);
 
     return thumb;
 }
 
+static gboolean thumbs_ready (void *)
+{
+    pthread_mutex_lock (& thumb_mutex);
+    Index<ThumbResult> results = std::move (thumb_results);
+    thumb_source = 0;
+    pthread_mutex_unlock (& thumb_mutex);
+
+    for (const ThumbResult & result : results)
+    {
+        GtkTreeIter iter;
+        if (result.generation == thumb_generation && thumb_store &&
+         gtk_tree_model_iter_nth_child ((GtkTreeModel *) thumb_store, & iter,
+         nullptr, result.row))
+        {
+            gtk_list_store_set (thumb_store, & iter, SKIN_VIEW_COL_PREVIEW,
+             result.pixbuf, -1);
+        }
+
+        g_object_unref (result.pixbuf);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static void * thumbs_worker (void * data)
+{
+    auto job = (ThumbJob *) data;
+
+    for (int row = 0; row < job->paths.len (); row ++)
+    {
+        AudguiPixbuf thumb = skin_get_thumbnail (job->paths[row], job->size);
+
+        pthread_mutex_lock (& thumb_mutex);
+
+        if (thumb_cancel)
+        {
+            pthread_mutex_unlock (& thumb_mutex);
+            break;
+        }
+
+        if (thumb)
+        {
+            thumb_results.append (ThumbResult {job->generation, row, thumb.release ()});
+
+            if (! thumb_source)
+                thumb_source = g_idle_add (thumbs_ready, nullptr);
+        }
+
+        pthread_mutex_unlock (& thumb_mutex);
+    }
+
+    delete job;
+    return nullptr;
+}
+
+static void thumbs_stop ()
+{
+    if (thumb_thread_running)
+    {
+        pthread_mutex_lock (& thumb_mutex);
+        thumb_cancel = true;
+        pthread_mutex_unlock (& thumb_mutex);
+
+        pthread_join (thumb_thread, nullptr);
+        thumb_thread_running = false;
+    }
+
+    /* drop anything not yet shown */
+    pthread_mutex_lock (& thumb_mutex);
+
+    if (thumb_source)
+    {
+        g_source_remove (thumb_source);
+        thumb_source = 0;
+    }
+
+    for (const ThumbResult & result : thumb_results)
+        g_object_unref (result.pixbuf);
+
+    thumb_results.clear ();
+    thumb_cancel = false;
+
+    pthread_mutex_unlock (& thumb_mutex);
+
+    thumb_generation ++;
+
+    if (thumb_store)
+    {
+        g_object_unref (thumb_store);
+        thumb_store = nullptr;
+    }
+}
+
+static void thumbs_start (GtkListStore * store)
+{
+    auto job = new ThumbJob;
+
+    for (const SkinNode & node : skinlist)
+        job->paths.append (node.path);
+
+    job->generation = thumb_generation;
+    job->size = audgui_get_dpi () * 3 / 2;
+
+    /* make sure the path is set up before the thread reads it */
+    skins_get_skin_thumb_dir ();
+
+    if (pthread_create (& thumb_thread, nullptr, thumbs_worker, job))
+    {
+        AUDERR ("Failed to create thumbnail thread.\n");
+        delete job;
+        return;
+    }
+
+    thumb_thread_running = true;
+    thumb_store = (GtkListStore *) g_object_ref (store);
+}
+
 static void scan_skindir_func (const char * path, const char * basename)
 {
     if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
@@ -141,6 +292,8 @@ void skin_view_update (GtkTreeView * treeview)
 {
     g_signal_handlers_block_by_func (treeview, (void *) skin_view_on_cursor_changed, nullptr);
 
+    thumbs_stop ();
+
     auto store = (GtkListStore *) gtk_tree_view_get_model (treeview);
     gtk_list_store_clear (store);
 
@@ -151,14 +304,13 @@ void skin_view_update (GtkTreeView * treeview)
 
     for (const SkinNode & node : skinlist)
     {
-        AudguiPixbuf thumbnail = skin_get_thumbnail (node.path);
         StringBuf formattedname = str_concat ({"<big><b>", node.name,
          "</b></big>\n<i>", node.desc, "</i>"});
 
         GtkTreeIter iter;
         gtk_list_store_append (store, & iter);
         gtk_list_store_set (store, & iter,
-         SKIN_VIEW_COL_PREVIEW, thumbnail.get (),
+         SKIN_VIEW_COL_PREVIEW, nullptr,
          SKIN_VIEW_COL_FORMATTEDNAME, (const char *) formattedname,
          SKIN_VIEW_COL_NAME, (const char *) node.name, -1);
 
@@ -174,6 +326,8 @@ void skin_view_update (GtkTreeView * treeview)
         gtk_tree_path_free (current_skin);
     }
 
+    thumbs_start (store);
+
     g_signal_handlers_unblock_by_func (treeview, (void *) skin_view_on_cursor_changed, nullptr);
 }
 
@@ -229,4 +383,5 @@ void skin_view_realize (GtkTreeView * treeview)
 
     g_signal_connect (treeview, "cursor-changed",
      (GCallback) skin_view_on_cursor_changed, nullptr);
+    g_signal_connect (treeview, "destroy", (GCallback) thumbs_stop, nullptr);
 }
@@ -30,6 +30,7 @@
 #include "main.h"
 #include "vis-callbacks.h"
 #include "vis.h"
+#include "../vis-common/bandmap.h"
 
 class VisCallbacks : public Visualizer
 {
@@ -110,22 +111,18 @@ void VisCallbacks::render_multi_pcm (const float * pcm, int channels)
 static void make_log_graph (const float * freq, int bands, int db_range,
  int int_range, unsigned char * graph)
 {
-    static int last_bands = 0;
-    static Index<float> xscale;
+    static BandMapper mapper;
 
-    /* conversion table for the x-axis */
-    if (bands != last_bands)
-    {
-        xscale.resize (bands + 1);
-        Visualizer::compute_log_xscale (& xscale[0], bands);
-        last_bands = bands;
-    }
+    if (bands != mapper.bands ())
+        mapper.init (bands);
+
+    float db[256];
+    mapper.compute_db (freq, db);
 
     for (int i = 0; i < bands; i ++)
     {
-        float val = Visualizer::compute_freq_band (freq, & xscale[0], i, bands);
         /* scale (-db_range, 0.0) to (0.0, int_range) */
-        val = (1 + val / db_range) * int_range;
+        float val = (1 + db[i] / db_range) * int_range;
         graph[i] = aud::clamp ((int) val, 0, int_range);
     }
 }
@@ -98,6 +98,22 @@ void Widget::add_drawable (int width, int height)
     set_drawable (widget);
 }
 
+void Widget::queue_draw_area (int x, int y, int width, int height)
+{
+    x *= m_scale;
+    y *= m_scale;
+
+#ifndef USE_GTK3
+    /* GTK 2 expects window coordinates */
+    GtkAllocation alloc;
+    gtk_widget_get_allocation (m_drawable, & alloc);
+    x += alloc.x;
+    y += alloc.y;
+#endif
+
+    gtk_widget_queue_draw_area (m_drawable, x, y, width * m_scale, height * m_scale);
+}
+
 #ifdef USE_GTK3
 void Widget::draw_now ()
 {
@@ -141,6 +157,13 @@ gboolean Widget::draw_cb (GtkWidget * widget, GdkEventExpose * event, Widget * m
 {
     cairo_t * cr = gdk_cairo_create (gtk_widget_get_window (widget));
 
+    /* GTK 3 does this for us */
+    if (event)
+    {
+        gdk_cairo_region (cr, event->region);
+        cairo_clip (cr);
+    }
+
     if (! gtk_widget_get_has_window (widget))
     {
         GtkAllocation alloc;
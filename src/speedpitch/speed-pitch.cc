@@ -18,23 +18,42 @@
  */
 
 #include <math.h>
+#include <string.h>
 #include <samplerate.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include <libaudcore/hook.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
+#include <libaudcore/ringbuf.h>
 
 /* The general idea of the speed change algorithm is to divide the input signal
  * into pieces, spaced at a time interval A, using a cosine-shaped window
  * function.  The pieces are then reassembled by adding them together again,
  * spaced at another time interval B.  By varying the ratio A:B, we change the
- * speed of the audio. */
+ * speed of the audio.
+ *
+ * Plain overlap-add cuts the pieces at fixed positions, so that waveforms
+ * which do not line up partially cancel out, which is heard as a warble.  The
+ * WSOLA engine (waveform similarity overlap-add) shifts each piece by up to a
+ * few milliseconds, to wherever it best matches the audio that would have
+ * followed the previous piece.  The match is found by cross-correlation of a
+ * mono mix, first at a quarter of the sample rate and then refined. */
 
 #define FREQ    10
 #define OVERLAP  3
 
+#define WSOLA_WINDOW 0.030 /* seconds, at 50% overlap */
+#define WSOLA_SEARCH 0.010 /* seconds either way */
+#define DECIMATE 4
+
 #define CFGSECT "speed-pitch"
 #define MINSPEED 0.25
 #define MAXSPEED 2.0
@@ -43,6 +62,11 @@
 #define MINSEMITONES -12.0
 #define MAXSEMITONES 12.0
 
+enum {
+    ENGINE_OVERLAP_ADD,
+    ENGINE_WSOLA
+};
+
 class SpeedPitch : public EffectPlugin
 {
 public:
@@ -78,12 +102,23 @@ private:
 EXPORT SpeedPitch aud_plugin_instance;
 
 static double semitones;
-static int curchans, currate;
+static int curchans, currate, curengine, curmethod;
 static SRC_STATE * srcstate;
-static int outstep, width;
+
+/* All positions and sizes below are in frames.  The input and output are kept
+ * in ring buffers, so that consumed audio is dropped without moving the rest;
+ * the input is also kept as a mono mix for the similarity search. */
+static int window, outstep, search;
 static Index<float> cosine;
-static Index<float> in, out;
-static int src, dst;
+static RingBuf<float> in, mono, out;
+static Index<float> resampled, segment, region, natural, coarse, coarse_natural;
+static Index<double> energy;
+
+static double src;    /* nominal start of the next window in the input */
+static int last_src;  /* where the previous window was actually taken, or -1 */
+static int dst;       /* start of the next window in the output */
+static int skip;      /* output frames of priming silence still to drop */
+static double owed;   /* output frames due for the input so far */
 
 static void add_data (Index<float> & b, Index<float> & data, float ratio)
 {
@@ -104,99 +139,376 @@ static void add_data (Index<float> & b, Index<float> & data, float ratio)
     b.resize (oldlen + d.output_frames_gen * curchans);
 }
 
-bool SpeedPitch::flush (bool force)
+/* Calls func (data, len, done) for each contiguous part (there are at most
+ * two) of a range of a ring buffer. */
+template<class F>
+static void ring_spans (RingBuf<float> & ring, int offset, int len, F func)
 {
-    src_reset (srcstate);
+    int linear = ring.linear ();
+    int done = 0;
 
-    in.resize (0);
-    out.resize (0);
+    if (offset < linear)
+    {
+        done = aud::min (len, linear - offset);
+        func (& ring[offset], done, 0);
+    }
 
-    /* The source and destination pointers give the center of the next cosine
-     * window to be copied, relative to the current input and output buffers. */
-    src = dst = 0;
+    if (done < len)
+        func (& ring[offset + done], len - done, done);
+}
 
-    /* The output buffer always extends right of the destination pointer by half
-     * the width of a cosine window. */
-    out.insert (0, width / 2);
+static void ring_copy (RingBuf<float> & ring, int offset, int len, float * dest)
+{
+    ring_spans (ring, offset, len, [dest] (float * data, int n, int done)
+        { memcpy (dest + done, data, sizeof (float) * n); });
+}
 
-    return true;
+static void ring_reserve (RingBuf<float> & ring, int len)
+{
+    if (ring.space () < len)
+        ring.alloc (aud::max (ring.size () * 2, ring.len () + len));
 }
 
-void SpeedPitch::start (int & chans, int & rate)
+/* Appends frames (or silence) to the input and its mono mix. */
+static void add_input (const float * data, int frames)
 {
-    curchans = chans;
-    currate = rate;
+    ring_reserve (in, frames * curchans);
+    ring_reserve (mono, frames);
+
+    if (! data)
+    {
+        in.add (frames * curchans);
+        mono.add (frames);
+        ring_spans (in, in.len () - frames * curchans, frames * curchans,
+         [] (float * p, int n, int) { memset (p, 0, sizeof (float) * n); });
+        ring_spans (mono, mono.len () - frames, frames,
+         [] (float * p, int n, int) { memset (p, 0, sizeof (float) * n); });
+        return;
+    }
+
+    in.copy_in (data, frames * curchans);
+
+    float scale = 1.0f / curchans;
+    for (int f = 0; f < frames; f ++)
+    {
+        float sum = 0;
+        for (int c = 0; c < curchans; c ++)
+            sum += * data ++;
+
+        mono.push (sum * scale);
+    }
+}
+
+static float dot (const float * a, const float * b, int len)
+{
+    int i = 0;
+    float sum = 0;
+
+#if defined(__SSE2__)
+    __m128 acc = _mm_setzero_ps ();
+    for (; i + 4 <= len; i += 4)
+        acc = _mm_add_ps (acc, _mm_mul_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+
+    acc = _mm_add_ps (acc, _mm_movehl_ps (acc, acc));
+    acc = _mm_add_ss (acc, _mm_shuffle_ps (acc, acc, 1));
+    sum = _mm_cvtss_f32 (acc);
+#elif defined(__ARM_NEON)
+    float32x4_t acc = vdupq_n_f32 (0);
+    for (; i + 4 <= len; i += 4)
+        acc = vmlaq_f32 (acc, vld1q_f32 (a + i), vld1q_f32 (b + i));
+
+    float32x2_t half = vadd_f32 (vget_low_f32 (acc), vget_high_f32 (acc));
+    sum = vget_lane_f32 (vpadd_f32 (half, half), 0);
+#endif
+
+    for (; i < len; i ++)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+static void decimate (const float * data, int len, Index<float> & dest)
+{
+    dest.resize (len / DECIMATE);
+
+    for (int i = 0; i < dest.len (); i ++)
+    {
+        float sum = 0;
+        for (int j = 0; j < DECIMATE; j ++)
+            sum += * data ++;
+
+        dest[i] = sum;
+    }
+}
+
+/* Finds where, within the search range around the nominal position, the
+ * input best continues the previous window (normalized cross-correlation). */
+static int find_src (int target)
+{
+    int overlap = window - outstep;
+    int lo = aud::max (0, target - search);
+    int count = target + search - lo + 1;
+
+    natural.resize (overlap);
+    ring_copy (mono, last_src + outstep, overlap, natural.begin ());
+    region.resize (count + overlap);
+    ring_copy (mono, lo, count + overlap, region.begin ());
+
+    /* coarse search */
+    decimate (natural.begin (), overlap, coarse_natural);
+    decimate (region.begin (), count + overlap, coarse);
+
+    int clen = coarse_natural.len ();
+    int ccount = coarse.len () - clen + 1;
+
+    energy.resize (coarse.len () + 1);
+    energy[0] = 0;
+    for (int i = 0; i < coarse.len (); i ++)
+        energy[i + 1] = energy[i] + coarse[i] * coarse[i];
+
+    int best = target - lo;
+    int cbest = best / DECIMATE;
+    double score = -1;
+
+    for (int k = 0; k < ccount; k ++)
+    {
+        double e = energy[k + clen] - energy[k];
+        double s = dot (coarse_natural.begin (), & coarse[k], clen) / sqrt (e + 1e-9);
+
+        if (s > score)
+        {
+            score = s;
+            cbest = k;
+        }
+    }
+
+    /* refine at the full rate */
+    score = -1;
+
+    int from = aud::max (0, cbest * DECIMATE - DECIMATE + 1);
+    int to = aud::min (count - 1, cbest * DECIMATE + DECIMATE - 1);
+
+    for (int k = from; k <= to; k ++)
+    {
+        const float * cand = & region[k];
+        double s = dot (natural.begin (), cand, overlap) /
+         sqrt (dot (cand, cand, overlap) + 1e-9);
+
+        if (s > score)
+        {
+            score = s;
+            best = k;
+        }
+    }
+
+    return lo + best;
+}
+
+/* Overlap-adds the window of input starting at src_frame onto the output. */
+static void add_window (int src_frame)
+{
+    int samples = window * curchans;
+
+    segment.resize (samples);
+    ring_copy (in, src_frame * curchans, samples, segment.begin ());
+
+    for (int i = 0; i < samples; i ++)
+        segment[i] *= cosine[i];
+
+    /* the start of the window overlaps audio already in the output, the
+     * rest is new */
+    int overlap = out.len () - dst * curchans;
+
+    if (overlap < samples)
+    {
+        ring_reserve (out, samples - overlap);
+        out.add (samples - overlap);
+    }
+
+    const float * seg = segment.begin ();
+
+    ring_spans (out, dst * curchans, samples, [seg, overlap] (float * data, int n, int done)
+    {
+        int i = 0;
+
+        for (; i < n && done + i < overlap; i ++)
+            data[i] += seg[done + i];
+        for (; i < n; i ++)
+            data[i] = seg[done + i];
+    });
+}
+
+static void reset ()
+{
+    in.discard ();
+    mono.discard ();
+    out.discard ();
+
+    /* Prime the input with silence, so that the first real frames already
+     * get the full set of overlapping windows.  The output for the silence
+     * is dropped again. */
+    float speed = aud_get_double (CFGSECT, "speed");
+    float pitch = aud_get_double (CFGSECT, "pitch");
+    int prime = window - outstep;
+
+    add_input (nullptr, prime);
+
+    src = 0;
+    last_src = -1;
+    dst = 0;
+    skip = (int) round (prime * pitch / speed);
+    owed = 0;
+}
+
+static void setup ()
+{
+    curengine = aud_get_int (CFGSECT, "engine");
+    curmethod = aud_get_int (CFGSECT, "method");
 
     if (srcstate)
         src_delete (srcstate);
 
-    srcstate = src_new (SRC_LINEAR, curchans, nullptr);
+    int error;
+    if (! (srcstate = src_new (curmethod, curchans, & error)))
+    {
+        AUDERR ("%s\n", src_strerror (error));
+        srcstate = src_new (SRC_LINEAR, curchans, nullptr);
+    }
 
-    /* Calculate the width of the cosine window and the spacing interval for
-     * output.  Make them both even numbers for convenience.  Note that the
-     * cosine window is applied without deinterleaving the audio samples. */
-    outstep = ((currate / FREQ) & ~1) * curchans;
-    width = outstep * OVERLAP;
+    /* Calculate the width of the window and the spacing interval for output.
+     * Note that the window is applied without deinterleaving the audio
+     * samples. */
+    if (curengine == ENGINE_WSOLA)
+    {
+        outstep = aud::max (1, (int) (currate * WSOLA_WINDOW / 2));
+        window = outstep * 2;
+        search = (int) (currate * WSOLA_SEARCH);
+    }
+    else
+    {
+        outstep = aud::max (1, (currate / FREQ) & ~1);
+        window = outstep * OVERLAP;
+        search = 0;
+    }
 
     /* Generate the cosine window, scaled vertically to compensate for the
      * overlap of the reassembled pieces of audio. */
-    cosine.resize (width);
-    for (int i = 0; i < width; i ++)
-        cosine[i] = (1.0 - cos (2.0 * M_PI * i / width)) / OVERLAP;
+    int overlap = window / outstep;
 
-    flush (true);
+    cosine.resize (window * curchans);
+    for (int i = 0; i < window; i ++)
+    {
+        for (int c = 0; c < curchans; c ++)
+            cosine[i * curchans + c] = (1.0 - cos (2.0 * M_PI * i / window)) / overlap;
+    }
+
+    reset ();
+}
+
+bool SpeedPitch::flush (bool force)
+{
+    src_reset (srcstate);
+    reset ();
+
+    return true;
+}
+
+void SpeedPitch::start (int & chans, int & rate)
+{
+    curchans = chans;
+    currate = rate;
+
+    setup ();
 }
 
 Index<float> & SpeedPitch::process (Index<float> & data, bool ending)
 {
-    const float * cosine_center = & cosine[width / 2];
+    if (aud_get_int (CFGSECT, "engine") != curengine ||
+     aud_get_int (CFGSECT, "method") != curmethod)
+        setup ();
+
     float pitch = aud_get_double (CFGSECT, "pitch");
     float speed = aud_get_double (CFGSECT, "speed");
 
-    /* Copy the passed audio to the input buffer, scaled to adjust pitch. */
-    add_data (in, data, 1.0 / pitch);
+    /* Resample the passed audio to adjust pitch. */
+    resampled.resize (0);
+    add_data (resampled, data, 1.0 / pitch);
 
     if (! aud_get_bool (CFGSECT, "decouple"))
     {
-        data = std::move (in);
+        data = std::move (resampled);
         return data;
     }
 
     /* Calculate the spacing interval for input. */
-    int instep = (int) round ((outstep / curchans) * speed / pitch) * curchans;
+    double instep = (double) outstep * speed / pitch;
+    int frames = resampled.len () / curchans;
+
+    add_input (resampled.begin (), frames);
+    owed += frames * pitch / speed;
+
+    /* If the song is ending, pad the input with silence so that every real
+     * frame is covered by a complete set of windows. */
+    if (ending)
+        add_input (nullptr, window + search);
 
-    /* Stop copying half a window's width before the end of the input buffer (or
-     * right up to the end of the buffer if the song is ending). */
-    int stop = in.len () - (ending ? 0 : width / 2);
+    int in_frames = in.len () / curchans;
 
-    while (src <= stop)
+    while (1)
     {
-        /* Truncate the window to avoid overflows if necessary. */
-        int begin = aud::max (-(width / 2), aud::max (-src, -dst));
-        int end = aud::min (width / 2, aud::min (in.len () - src, out.len () - dst));
+        int target = (int) round (src);
+        if (target + search + window > in_frames)
+            break;
 
-        for (int i = begin; i < end; i ++)
-            out[dst + i] += in[src + i] * cosine_center[i];
+        int from = (search && last_src >= 0) ? find_src (target) : target;
+        add_window (from);
 
+        last_src = from;
         src += instep;
         dst += outstep;
-
-        out.insert (-1, outstep);
     }
 
-    /* Discard input up to half a window's width before the source pointer (or
-     * right up to the previous source pointer if the song is ending. */
-    int seek = aud::clamp (0, src - (ending ? instep : width / 2), in.len ());
-    in.remove (0, seek);
+    /* Discard input that neither the search nor the next comparison can
+     * reach any more (keeping the previous window's start, which also keeps
+     * last_src from going negative). */
+    int keep = (int) src - search;
+    if (last_src >= 0)
+        keep = aud::min (keep, last_src);
+
+    int seek = aud::clamp (keep, 0, in_frames);
+    in.discard (seek * curchans);
+    mono.discard (seek);
     src -= seek;
+    if (last_src >= 0)
+        last_src -= seek;
 
     data.resize (0);
 
-    /* Return output up to half a window's width before the destination pointer
-     * (or right up to the previous destination pointer if the song is ending). */
-    int ret = aud::clamp (0, dst - (ending ? outstep : width / 2), out.len ());
-    data.move_from (out, 0, 0, ret, true, true);
+    /* Return output up to the start of the next window (or everything that
+     * is due if the song is ending). */
+    int ret = ending ? out.len () / curchans : dst;
+
+    int drop = aud::min (skip, ret);
+    out.discard (drop * curchans);
+    skip -= drop;
+    dst -= drop;
+    ret -= drop;
+
+    if (ending)
+        ret = aud::clamp ((int) round (owed), 0, ret);
+
+    out.move_out (data, -1, ret * curchans);
     dst -= ret;
+    owed -= ret;
+
+    if (ending)
+    {
+        int missing = (int) round (owed);
+        if (missing > 0)
+            data.insert (-1, missing * curchans);
+
+        reset ();
+    }
 
     return data;
 }
@@ -206,12 +518,12 @@ int SpeedPitch::adjust_delay (int delay)
     if (! aud_get_bool (CFGSECT, "decouple"))
         return delay;
 
-    float samples_to_ms = 1000.0 / (curchans * currate);
+    float frames_to_ms = 1000.0 / currate;
     float speed = aud_get_double (CFGSECT, "speed");
-    int in_samples = in.len () - src;
-    int out_samples = dst;
+    float in_frames = in.len () / curchans - src;
+    int out_frames = dst - skip;
 
-    return (delay + in_samples * samples_to_ms) * speed + out_samples * samples_to_ms;
+    return (delay + in_frames * frames_to_ms) * speed + out_frames * frames_to_ms;
 }
 
 static void sync_speed ()
@@ -241,8 +553,22 @@ const char * const SpeedPitch::defaults[] = {
  "decouple", "TRUE",
  "speed", "1",
  "pitch", "1",
+ "engine", aud::numeric_string<ENGINE_WSOLA>::str,
+ "method", aud::numeric_string<SRC_LINEAR>::str,
  nullptr};
 
+static const ComboItem engine_list[] = {
+    ComboItem (N_("Overlap-add (fastest)"), ENGINE_OVERLAP_ADD),
+    ComboItem (N_("WSOLA (best for speech)"), ENGINE_WSOLA)
+};
+
+static const ComboItem method_list[] = {
+    ComboItem (N_("Linear interpolation"), SRC_LINEAR),
+    ComboItem (N_("Fast sinc interpolation"), SRC_SINC_FASTEST),
+    ComboItem (N_("Medium sinc interpolation"), SRC_SINC_MEDIUM_QUALITY),
+    ComboItem (N_("Best sinc interpolation"), SRC_SINC_BEST_QUALITY)
+};
+
 const PreferencesWidget SpeedPitch::widgets[] = {
     WidgetLabel (N_("<b>Speed</b>")),
     WidgetCheck (N_("Decouple from pitch"),
@@ -258,7 +584,14 @@ const PreferencesWidget SpeedPitch::widgets[] = {
     WidgetSpin (N_("Multiplier:"),
         WidgetFloat (CFGSECT, "pitch", pitch_changed, "speed-pitch set pitch"),
         {MINPITCH, MAXPITCH, 0.005},
-        WIDGET_CHILD)
+        WIDGET_CHILD),
+    WidgetLabel (N_("<b>Quality</b>")),
+    WidgetCombo (N_("Time stretching:"),
+        WidgetInt (CFGSECT, "engine"),
+        {{engine_list}}),
+    WidgetCombo (N_("Resampling:"),
+        WidgetInt (CFGSECT, "method"),
+        {{method_list}})
 };
 
 const PluginPreferences SpeedPitch::prefs = {{widgets}};
@@ -278,6 +611,14 @@ void SpeedPitch::cleanup ()
     srcstate = nullptr;
 
     cosine.clear ();
-    in.clear ();
-    out.clear ();
+    in.destroy ();
+    mono.destroy ();
+    out.destroy ();
+    resampled.clear ();
+    segment.clear ();
+    region.clear ();
+    natural.clear ();
+    coarse.clear ();
+    coarse_natural.clear ();
+    energy.clear ();
 }
@@ -0,0 +1,828 @@
+/*
+ * Tee Output Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/*
+ * The tee output passes audio on to a primary output plugin (the one you
+ * listen to) and copies it to any number of secondary sinks: FileWriter, a
+ * pipe to an external command, or a TCP socket.
+ *
+ * Each secondary sink runs in its own thread and is fed through its own ring
+ * buffer.  The output thread never waits for a secondary sink: if a sink falls
+ * so far behind that its buffer fills up, the audio that does not fit is
+ * dropped for that sink (and counted), while the primary output carries on.
+ * Nor does it wait for them at the end of a stream: the sinks are left to
+ * write out what they have buffered in the background.
+ */
+
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/i18n.h>
+#include <libaudcore/plugin.h>
+#include <libaudcore/plugins.h>
+#include <libaudcore/preferences.h>
+#include <libaudcore/ringbuf.h>
+#include <libaudcore/runtime.h>
+
+class TeeOutput : public OutputPlugin
+{
+public:
+    static const char about[];
+    static const char * const defaults[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
+    static constexpr PluginInfo info = {
+        N_("Tee Output"),
+        PACKAGE,
+        about,
+        & prefs
+    };
+
+    /* lowest priority, so that it is never picked automatically */
+    constexpr TeeOutput () : OutputPlugin (info, 0) {}
+
+    bool init () override;
+    void cleanup () override;
+
+    StereoVolume get_volume () override;
+    void set_volume (StereoVolume v) override;
+
+    void set_info (const char * filename, const Tuple & tuple) override;
+    bool open_audio (int fmt, int rate, int nch, String & error) override;
+    void close_audio () override;
+
+    void period_wait () override;
+    int write_audio (const void * ptr, int length) override;
+    void drain () override;
+
+    int get_delay () override;
+
+    void pause (bool pause) override;
+    void flush () override;
+};
+
+EXPORT TeeOutput aud_plugin_instance;
+
+const char * const TeeOutput::defaults[] = {
+    "primary", "",
+    "capture_file", "TRUE",
+    "pipe_enabled", "FALSE",
+    "pipe_command", "",
+    "socket_enabled", "FALSE",
+    "socket_address", "localhost:4953",
+    "buffer_ms", "4000",
+    nullptr
+};
+
+/* ----- secondary sinks ----- */
+
+class SecondarySink
+{
+public:
+    virtual ~SecondarySink () {}
+
+    /* all three are called from the sink's own thread */
+    virtual bool open (int fmt, int rate, int nch) = 0;
+    virtual bool write (const void * data, int length) = 0;
+    virtual void close () = 0;
+};
+
+/* Base for the raw sinks, which always deliver signed 16-bit little-endian
+ * PCM regardless of the format the player is sending. */
+class RawSink : public SecondarySink
+{
+public:
+    bool open (int fmt, int rate, int nch) override
+    {
+        in_fmt = fmt;
+        return open_raw (rate, nch);
+    }
+
+    bool write (const void * data, int length) override
+    {
+        int samples = length / FMT_SIZEOF (in_fmt);
+
+        if (in_fmt != FMT_S16_LE)
+        {
+            out.resize (2 * samples);
+
+            if (in_fmt == FMT_FLOAT)
+                audio_to_int ((const float *) data, out.begin (), FMT_S16_LE, samples);
+            else
+            {
+                temp.resize (samples);
+                audio_from_int (data, in_fmt, temp.begin (), samples);
+                audio_to_int (temp.begin (), out.begin (), FMT_S16_LE, samples);
+            }
+
+            data = out.begin ();
+        }
+
+        return write_raw (data, 2 * samples);
+    }
+
+protected:
+    virtual bool open_raw (int rate, int nch) = 0;
+    virtual bool write_raw (const void * data, int length) = 0;
+
+private:
+    int in_fmt = FMT_S16_LE;
+    Index<char> out;
+    Index<float> temp;
+};
+
+/* Runs a shell command with the audio on its standard input.  "%r" and "%c"
+ * in the command are replaced by the sample rate and channel count. */
+class PipeSink : public RawSink
+{
+public:
+    void close () override
+    {
+        if (pipe)
+        {
+            int status = pclose (pipe);
+            if (status)
+                AUDWARN ("Tee: pipe command exited with status %d.\n", status);
+
+            pipe = nullptr;
+        }
+    }
+
+protected:
+    bool open_raw (int rate, int nch) override
+    {
+        String command = aud_get_str ("tee", "pipe_command");
+        StringBuf expanded = str_copy ("");
+
+        for (const char * c = command; * c; c ++)
+        {
+            if (c[0] == '%' && c[1] == 'r')
+            {
+                str_append_printf (expanded, "%d", rate);
+                c ++;
+            }
+            else if (c[0] == '%' && c[1] == 'c')
+            {
+                str_append_printf (expanded, "%d", nch);
+                c ++;
+            }
+            else
+                expanded.insert (-1, c, 1);
+        }
+
+        if (! expanded[0])
+        {
+            AUDERR ("Tee: no pipe command configured.\n");
+            return false;
+        }
+
+        if (! (pipe = popen (expanded, "w")))
+        {
+            AUDERR ("Tee: failed to run %s: %s.\n", (const char *) expanded, strerror (errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    bool write_raw (const void * data, int length) override
+    {
+        if (fwrite (data, 1, length, pipe) != (size_t) length)
+        {
+            AUDERR ("Tee: error writing to pipe: %s.\n", strerror (errno));
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    FILE * pipe = nullptr;
+};
+
+/* Streams the audio to a TCP listener given as "host:port". */
+class SocketSink : public RawSink
+{
+public:
+    void close () override
+    {
+        if (sock >= 0)
+        {
+            ::close (sock);
+            sock = -1;
+        }
+    }
+
+protected:
+    bool open_raw (int rate, int nch) override
+    {
+        String address = aud_get_str ("tee", "socket_address");
+        const char * colon = strrchr (address, ':');
+
+        if (! colon)
+        {
+            AUDERR ("Tee: invalid socket address %s (expected host:port).\n", (const char *) address);
+            return false;
+        }
+
+        StringBuf host = str_copy (address, colon - address);
+
+        addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo * list = nullptr;
+        int ret = getaddrinfo (host, colon + 1, & hints, & list);
+
+        if (ret)
+        {
+            AUDERR ("Tee: cannot resolve %s: %s.\n", (const char *) address, gai_strerror (ret));
+            return false;
+        }
+
+        for (addrinfo * ai = list; ai && sock < 0; ai = ai->ai_next)
+        {
+            sock = socket (ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+            if (sock >= 0 && connect (sock, ai->ai_addr, ai->ai_addrlen) < 0)
+            {
+                ::close (sock);
+                sock = -1;
+            }
+        }
+
+        freeaddrinfo (list);
+
+        if (sock < 0)
+        {
+            AUDERR ("Tee: cannot connect to %s.\n", (const char *) address);
+            return false;
+        }
+
+        /* a listener that stops reading must not keep the sink (and in the
+         * end, the plugin's cleanup) waiting forever */
+        timeval timeout = {10, 0};
+        setsockopt (sock, SOL_SOCKET, SO_SNDTIMEO, & timeout, sizeof timeout);
+
+        return true;
+    }
+
+    bool write_raw (const void * data, int length) override
+    {
+        auto ptr = (const char *) data;
+
+        while (length > 0)
+        {
+            ssize_t sent = send (sock, ptr, length, MSG_NOSIGNAL);
+
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                AUDERR ("Tee: error writing to socket: %s.\n", strerror (errno));
+                return false;
+            }
+
+            ptr += sent;
+            length -= sent;
+        }
+
+        return true;
+    }
+
+private:
+    int sock = -1;
+};
+
+/* FileWriter has only one output file open at a time, so a new stream waits
+ * here (in its own thread) until the previous one has been written out. */
+static pthread_mutex_t filewriter_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static String current_filename;
+static Tuple current_tuple;
+
+/* Feeds the audio into the FileWriter plugin, with whatever file format and
+ * naming options are configured there. */
+class FileWriterSink : public SecondarySink
+{
+public:
+    FileWriterSink (OutputPlugin * plugin, const char * filename, Tuple && tuple) :
+        plugin (plugin), filename (filename), tuple (std::move (tuple)) {}
+
+    bool open (int fmt, int rate, int nch) override
+    {
+        String error;
+
+        pthread_mutex_lock (& filewriter_mutex);
+        plugin->set_info (filename, tuple);
+
+        if (! plugin->open_audio (fmt, rate, nch, error))
+        {
+            AUDERR ("Tee: FileWriter failed: %s\n", error ? (const char *) error : "");
+            pthread_mutex_unlock (& filewriter_mutex);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool write (const void * data, int length) override
+    {
+        auto ptr = (const char *) data;
+
+        while (length > 0)
+        {
+            int written = plugin->write_audio (ptr, length);
+            ptr += written;
+            length -= written;
+
+            if (length > 0)
+                plugin->period_wait ();
+        }
+
+        return true;
+    }
+
+    void close () override
+    {
+        plugin->drain ();
+        plugin->close_audio ();
+        pthread_mutex_unlock (& filewriter_mutex);
+    }
+
+private:
+    OutputPlugin * plugin;
+    String filename;
+    Tuple tuple;
+};
+
+/* ----- sink threads ----- */
+
+struct SinkThread
+{
+    SmartPtr<SecondarySink> sink;
+    const char * name;
+
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    pthread_t thread;
+
+    RingBuf<char> buffer;
+    bool quit = false;
+    bool done = false; /* set when the thread is about to exit */
+    int64_t dropped = 0;
+    int skip = 0; /* rest of a partly dropped frame */
+
+    int fmt = 0, rate = 0, nch = 0;
+};
+
+static void * sink_worker (void * data)
+{
+    auto st = (SinkThread *) data;
+
+    /* Writing to a pipe or socket whose reader has gone away raises SIGPIPE.
+     * Block it in this thread so that we just get EPIPE instead. */
+    sigset_t sigs;
+    sigemptyset (& sigs);
+    sigaddset (& sigs, SIGPIPE);
+    pthread_sigmask (SIG_BLOCK, & sigs, nullptr);
+
+    bool ok = st->sink->open (st->fmt, st->rate, st->nch);
+    if (! ok)
+        AUDERR ("Tee: %s sink disabled for this stream.\n", st->name);
+
+    int frame_size = FMT_SIZEOF (st->fmt) * st->nch;
+    Index<char> block;
+
+    pthread_mutex_lock (& st->mutex);
+
+    while (1)
+    {
+        int length = st->buffer.len ();
+        length -= length % frame_size;
+
+        if (! length)
+        {
+            if (st->quit)
+                break;
+
+            pthread_cond_wait (& st->cond, & st->mutex);
+            continue;
+        }
+
+        block.resize (length);
+        st->buffer.move_out (block.begin (), length);
+
+        pthread_mutex_unlock (& st->mutex);
+
+        /* a failed sink keeps draining its buffer so that the realtime side
+         * does not see it as full and count everything as dropped */
+        if (ok && ! st->sink->write (block.begin (), length))
+        {
+            AUDERR ("Tee: %s sink failed, disabled for this stream.\n", st->name);
+            st->sink->close ();
+            ok = false;
+        }
+
+        pthread_mutex_lock (& st->mutex);
+    }
+
+    pthread_mutex_unlock (& st->mutex);
+
+    if (ok)
+        st->sink->close ();
+
+    pthread_mutex_lock (& st->mutex);
+    st->done = true;
+    pthread_mutex_unlock (& st->mutex);
+
+    return nullptr;
+}
+
+static OutputPlugin * primary;
+static PluginHandle * filewriter_handle;
+static OutputPlugin * filewriter;
+static Index<SmartPtr<SinkThread>> sinks;
+static Index<SmartPtr<SinkThread>> closing; /* still writing out their buffers */
+
+static void start_sink (SecondarySink * sink, const char * name, int fmt, int rate, int nch)
+{
+    auto st = SmartNew<SinkThread> ();
+
+    st->sink.capture (sink);
+    st->name = name;
+    st->fmt = fmt;
+    st->rate = rate;
+    st->nch = nch;
+
+    int buffer_ms = aud::clamp (aud_get_int ("tee", "buffer_ms"), 100, 60000);
+    int frame_size = FMT_SIZEOF (fmt) * nch;
+    st->buffer.alloc (frame_size * aud::rescale (buffer_ms, 1000, rate));
+
+    if (pthread_create (& st->thread, nullptr, sink_worker, st.get ()))
+    {
+        AUDERR ("Tee: failed to create thread for %s sink.\n", name);
+        return;
+    }
+
+    sinks.append (std::move (st));
+}
+
+/* Never blocks for longer than it takes to copy the data.  The buffer size is
+ * a whole number of frames, so a full buffer always ends on a frame boundary;
+ * when data has to be dropped, the rest of the last frame is skipped as well
+ * so that the sink stays in step with the channel layout. */
+static void feed_sink (SinkThread & st, const char * data, int length)
+{
+    int frame_size = FMT_SIZEOF (st.fmt) * st.nch;
+
+    pthread_mutex_lock (& st.mutex);
+
+    int skip = aud::min (length, st.skip);
+    data += skip;
+    length -= skip;
+    st.skip -= skip;
+    st.dropped += skip;
+
+    int copy = aud::min (length, st.buffer.space ());
+    st.buffer.copy_in (data, copy);
+
+    if (copy < length)
+    {
+        int drop = length - copy;
+        st.dropped += drop;
+        st.skip = (frame_size - drop % frame_size) % frame_size;
+    }
+
+    pthread_cond_broadcast (& st.cond);
+    pthread_mutex_unlock (& st.mutex);
+}
+
+/* tells the sinks to finish up, without waiting for them */
+static void stop_sinks ()
+{
+    for (auto & st : sinks)
+    {
+        pthread_mutex_lock (& st->mutex);
+        st->quit = true;
+        pthread_cond_broadcast (& st->cond);
+        pthread_mutex_unlock (& st->mutex);
+
+        closing.append (std::move (st));
+    }
+
+    sinks.clear ();
+}
+
+/* joins the sink threads that have exited, or with <wait>, all of them */
+static void reap_sinks (bool wait)
+{
+    for (int i = closing.len () - 1; i >= 0; i --)
+    {
+        SinkThread * st = closing[i].get ();
+
+        if (! wait)
+        {
+            pthread_mutex_lock (& st->mutex);
+            bool done = st->done;
+            pthread_mutex_unlock (& st->mutex);
+
+            if (! done)
+                continue;
+        }
+
+        pthread_join (st->thread, nullptr);
+
+        if (st->dropped)
+            AUDWARN ("Tee: %s sink fell behind, %d ms of audio dropped.\n", st->name,
+             (int) aud::rescale<int64_t> (st->dropped / (FMT_SIZEOF (st->fmt) * st->nch), st->rate, 1000));
+
+        closing.remove (i, 1);
+    }
+}
+
+/* ----- primary output ----- */
+
+/* The wrapped plugins are initialized and cleaned up by us, not by the
+ * plugin core, so we keep away from any plugin that the core has running
+ * itself; otherwise it would be initialized twice and we would clean it up
+ * while the core still uses it. */
+static bool free_to_wrap (PluginHandle * handle)
+{
+    if (aud_plugin_get_enabled (handle))
+    {
+        AUDERR ("Tee: %s is already in use.\n", aud_plugin_get_name (handle));
+        return false;
+    }
+
+    return true;
+}
+
+static bool usable_primary (PluginHandle * handle)
+{
+    const char * basename = aud_plugin_get_basename (handle);
+    return handle != aud_plugin_by_header (& aud_plugin_instance) &&
+     strcmp (basename, "filewriter");
+}
+
+static OutputPlugin * load_primary ()
+{
+    String name = aud_get_str ("tee", "primary");
+
+    for (PluginHandle * handle : aud_plugin_list (PluginType::Output))
+    {
+        if (! usable_primary (handle))
+            continue;
+
+        /* with no explicit choice, take the first plugin that initializes
+         * (the list is sorted by priority) */
+        if (name[0] && strcmp (aud_plugin_get_basename (handle), name))
+            continue;
+
+        if (! free_to_wrap (handle))
+            continue;
+
+        auto plugin = (OutputPlugin *) aud_plugin_get_header (handle);
+        if (plugin && plugin->init ())
+        {
+            AUDINFO ("Tee: primary output is %s.\n", aud_plugin_get_name (handle));
+            return plugin;
+        }
+    }
+
+    AUDERR ("Tee: no usable primary output plugin.\n");
+    return nullptr;
+}
+
+bool TeeOutput::init ()
+{
+    aud_config_set_defaults ("tee", defaults);
+
+    primary = load_primary ();
+    return primary != nullptr;
+}
+
+void TeeOutput::cleanup ()
+{
+    reap_sinks (true);
+
+    if (primary)
+    {
+        primary->cleanup ();
+        primary = nullptr;
+    }
+
+    if (filewriter)
+    {
+        filewriter->cleanup ();
+        filewriter = nullptr;
+    }
+
+    filewriter_handle = nullptr;
+}
+
+StereoVolume TeeOutput::get_volume ()
+{
+    return primary->get_volume ();
+}
+
+void TeeOutput::set_volume (StereoVolume v)
+{
+    primary->set_volume (v);
+}
+
+void TeeOutput::set_info (const char * filename, const Tuple & tuple)
+{
+    primary->set_info (filename, tuple);
+
+    current_filename = String (filename);
+    current_tuple = tuple.ref ();
+}
+
+static OutputPlugin * get_filewriter ()
+{
+    if (filewriter)
+        return filewriter;
+
+    if (! filewriter_handle)
+        filewriter_handle = aud_plugin_lookup_basename ("filewriter");
+
+    if (filewriter_handle && free_to_wrap (filewriter_handle))
+    {
+        auto plugin = (OutputPlugin *) aud_plugin_get_header (filewriter_handle);
+        if (plugin && plugin->init ())
+            filewriter = plugin;
+    }
+
+    if (! filewriter)
+        AUDERR ("Tee: FileWriter plugin is not available.\n");
+
+    return filewriter;
+}
+
+bool TeeOutput::open_audio (int fmt, int rate, int nch, String & error)
+{
+    reap_sinks (false);
+
+    if (! primary->open_audio (fmt, rate, nch, error))
+        return false;
+
+    if (aud_get_bool ("tee", "capture_file"))
+    {
+        OutputPlugin * fw = get_filewriter ();
+        if (fw)
+            start_sink (new FileWriterSink (fw, current_filename,
+             current_tuple.ref ()), "FileWriter", fmt, rate, nch);
+    }
+
+    if (aud_get_bool ("tee", "pipe_enabled"))
+        start_sink (new PipeSink, "pipe", fmt, rate, nch);
+
+    if (aud_get_bool ("tee", "socket_enabled"))
+        start_sink (new SocketSink, "socket", fmt, rate, nch);
+
+    return true;
+}
+
+void TeeOutput::close_audio ()
+{
+    primary->close_audio ();
+    stop_sinks ();
+}
+
+void TeeOutput::period_wait ()
+{
+    primary->period_wait ();
+}
+
+int TeeOutput::write_audio (const void * ptr, int length)
+{
+    /* copy only what the primary output accepted, so that every sink gets
+     * exactly the same stream */
+    length = primary->write_audio (ptr, length);
+
+    for (auto & st : sinks)
+        feed_sink (* st, (const char *) ptr, length);
+
+    return length;
+}
+
+void TeeOutput::drain ()
+{
+    primary->drain ();
+}
+
+int TeeOutput::get_delay ()
+{
+    return primary->get_delay ();
+}
+
+void TeeOutput::pause (bool pause)
+{
+    primary->pause (pause);
+}
+
+void TeeOutput::flush ()
+{
+    /* the secondary sinks keep what they have already received */
+    primary->flush ();
+}
+
+/* ----- preferences ----- */
+
+static Index<ComboItem> primary_items;
+
+static void primary_list_fill ()
+{
+    primary_items.append (_("Automatic"), "");
+
+    for (PluginHandle * handle : aud_plugin_list (PluginType::Output))
+    {
+        if (usable_primary (handle))
+            primary_items.append (aud_plugin_get_name (handle), aud_plugin_get_basename (handle));
+    }
+}
+
+static ArrayRef<ComboItem> primary_combo_fill ()
+    { return {primary_items.begin (), primary_items.len ()}; }
+
+static void primary_changed ()
+{
+    aud_output_reset (OutputReset::ResetPlugin);
+}
+
+static void tee_prefs_init ()
+{
+    primary_list_fill ();
+}
+
+static void tee_prefs_cleanup ()
+{
+    primary_items.clear ();
+}
+
+const PreferencesWidget TeeOutput::widgets[] = {
+    WidgetCombo (N_("Primary output:"),
+        WidgetString ("tee", "primary", primary_changed),
+        {nullptr, primary_combo_fill}),
+    WidgetLabel (N_("<b>Secondary Outputs</b>")),
+    WidgetCheck (N_("Record with FileWriter"),
+        WidgetBool ("tee", "capture_file")),
+    WidgetCheck (N_("Pipe to command:"),
+        WidgetBool ("tee", "pipe_enabled")),
+    WidgetEntry (nullptr,
+        WidgetString ("tee", "pipe_command"),
+        {false},
+        WIDGET_CHILD),
+    WidgetCheck (N_("Send to TCP socket (host:port):"),
+        WidgetBool ("tee", "socket_enabled")),
+    WidgetEntry (nullptr,
+        WidgetString ("tee", "socket_address"),
+        {false},
+        WIDGET_CHILD),
+    WidgetSpin (N_("Secondary buffer size:"),
+        WidgetInt ("tee", "buffer_ms"),
+        {100, 60000, 100, N_("ms")}),
+    WidgetLabel (N_("Pipes and sockets receive signed 16-bit little-endian PCM.\n"
+                    "In the pipe command, %r and %c stand for the sample rate\n"
+                    "and number of channels."))
+};
+
+const PluginPreferences TeeOutput::prefs = {
+    {widgets},
+    tee_prefs_init,
+    nullptr,  // apply
+    tee_prefs_cleanup
+};
+
+const char TeeOutput::about[] =
+ N_("Tee Output Plugin for Audacious\n"
+    "Copyright 2026 Audacious developers\n\n"
+    "Plays audio through a primary output plugin while copying it to "
+    "FileWriter, a pipe or a network socket.");
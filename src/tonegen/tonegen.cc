@@ -16,20 +16,29 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <libaudcore/audio.h>
 #include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
 
-#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
 #define MIN_FREQ        10
-#define MAX_FREQ        20000
 #define OUTPUT_FREQ     44100
+#define MIN_RATE        8000
+#define MAX_RATE        768000
 #define BUF_SAMPLES     512
-#define BUF_BYTES       (BUF_SAMPLES * sizeof(float))
+#define SINE_TABLE_BITS 12
+#define SINE_TABLE_SIZE (1 << SINE_TABLE_BITS)
 
 #ifndef PI
 #define PI              3.14159265358979323846
@@ -64,83 +73,378 @@ bool ToneGen::is_our_file(const char *filename, VFSFile &file)
     return false;
 }
 
-static Index<double> tone_filename_parse(const char *filename)
+enum class Wave { Sine, Square, Saw, Noise };
+
+static const char *const wave_names[] = {"sine", "square", "saw", "noise"};
+
+struct tone_params_t
 {
     Index<double> frequencies;
+    Wave wave = Wave::Sine;
+    double sweep = 0;  /* seconds from the first frequency to the last */
+    int rate = OUTPUT_FREQ;
+    int channels = 1;
+};
 
+/* tone://freq1;freq2;...;option=value;...
+ * Options are wave=sine|square|saw|noise, sweep=<seconds>, rate=<Hz> and
+ * channels=<count>. */
+static bool tone_filename_parse(const char *filename, tone_params_t &params)
+{
     if (strncmp(filename, "tone://", 7))
-        return frequencies;
+        return false;
 
     auto strings = str_list_to_index(filename + 7, ";");
+    Index<double> candidates;
 
     for (const char *str : strings)
     {
-        double freq = strtod(str, nullptr);
-        if (freq >= MIN_FREQ && freq <= MAX_FREQ)
-            frequencies.append(freq);
+        const char *value = strchr(str, '=');
+        if (!value)
+        {
+            candidates.append(strtod(str, nullptr));
+            continue;
+        }
+
+        value++;
+
+        if (!strncmp(str, "wave=", 5))
+        {
+            for (int w = 0; w < aud::n_elems(wave_names); w++)
+            {
+                if (!strcmp(value, wave_names[w]))
+                    params.wave = (Wave)w;
+            }
+        }
+        else if (!strncmp(str, "sweep=", 6))
+            params.sweep = aud::max(strtod(value, nullptr), 0.0);
+        else if (!strncmp(str, "rate=", 5))
+            params.rate = aud::clamp(atoi(value), MIN_RATE, MAX_RATE);
+        else if (!strncmp(str, "channels=", 9))
+            params.channels = aud::clamp(atoi(value), 1, AUD_MAX_CHANNELS);
+    }
+
+    for (double freq : candidates)
+    {
+        if (freq >= MIN_FREQ && freq < params.rate / 2)
+            params.frequencies.append(freq);
     }
 
-    return frequencies;
+    /* a sweep needs two frequencies and runs a single oscillator */
+    if (params.frequencies.len() < 2 || params.wave == Wave::Noise)
+        params.sweep = 0;
+
+    return params.frequencies.len() || params.wave == Wave::Noise;
 }
 
 static StringBuf tone_title(const char *filename)
 {
-    auto freqs = tone_filename_parse(filename);
-    if (!freqs.len())
+    tone_params_t params;
+    if (!tone_filename_parse(filename, params))
         return StringBuf();
 
+    auto &freqs = params.frequencies;
+
+    if (params.wave == Wave::Noise)
+        return str_printf(_("%s white noise"), _("Tone Generator: "));
+
+    if (params.sweep > 0)
+        return str_printf(_("%s %.1f Hz to %.1f Hz in %.1f s"), _("Tone Generator: "),
+         freqs[0], freqs[freqs.len() - 1], params.sweep);
+
     auto title = str_printf(_("%s %.1f Hz"), _("Tone Generator: "), freqs[0]);
     for (int i = 1; i < freqs.len(); i++)
         str_append_printf(title, ";%.1f Hz", freqs[i]);
 
+    if (params.wave != Wave::Sine)
+        str_append_printf(title, " (%s)", wave_names[(int)params.wave]);
+
     return title;
 }
 
+static float sine_table[SINE_TABLE_SIZE + 1];
+
+static void make_sine_table()
+{
+    if (sine_table[SINE_TABLE_SIZE / 4] == 1)
+        return;
+
+    for (int i = 0; i <= SINE_TABLE_SIZE; i++)
+        sine_table[i] = sin(2 * PI * i / SINE_TABLE_SIZE);
+}
+
+/* phase in cycles, 0 <= phase < 1 */
+static inline float table_sine(double phase)
+{
+    double pos = phase * SINE_TABLE_SIZE;
+    int i = (int)pos;
+    float frac = pos - i;
+    return sine_table[i] + (sine_table[i + 1] - sine_table[i]) * frac;
+}
+
+/* Band-limited step correction (polynomial BLEP) for a discontinuity at
+ * phase 0, for an oscillator advancing by <inc> cycles per sample. */
+static inline double poly_blep(double phase, double inc)
+{
+    if (phase < inc)
+    {
+        double x = phase / inc;
+        return x + x - x * x - 1;
+    }
+    if (phase > 1 - inc)
+    {
+        double x = (phase - 1) / inc;
+        return x * x + x + x + 1;
+    }
+    return 0;
+}
+
+/* Adds a steady sine tone to a block by rotating a phasor: four phasors,
+ * one sample apart, are each rotated four samples per step, so that the
+ * recurrence runs four samples at a time.  The phasors are set up afresh
+ * from the exact phase for every block, so no error accumulates. */
+static void add_sine(float *out, int frames, double phase, double w, float amp)
+{
+    float re[4], im[4];
+    for (int k = 0; k < 4; k++)
+    {
+        re[k] = amp * cos(phase + k * w);
+        im[k] = amp * sin(phase + k * w);
+    }
+
+    float c = cos(4 * w), s = sin(4 * w);
+    int i = 0;
+
+#if defined(__SSE2__)
+    __m128 vre = _mm_loadu_ps(re), vim = _mm_loadu_ps(im);
+    __m128 vc = _mm_set1_ps(c), vs = _mm_set1_ps(s);
+
+    for (; i + 4 <= frames; i += 4)
+    {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), vim));
+        __m128 next = _mm_sub_ps(_mm_mul_ps(vre, vc), _mm_mul_ps(vim, vs));
+        vim = _mm_add_ps(_mm_mul_ps(vre, vs), _mm_mul_ps(vim, vc));
+        vre = next;
+    }
+
+    _mm_storeu_ps(re, vre);
+    _mm_storeu_ps(im, vim);
+#elif defined(__ARM_NEON)
+    float32x4_t vre = vld1q_f32(re), vim = vld1q_f32(im);
+
+    for (; i + 4 <= frames; i += 4)
+    {
+        vst1q_f32(out + i, vaddq_f32(vld1q_f32(out + i), vim));
+        float32x4_t next = vmlsq_n_f32(vmulq_n_f32(vre, c), vim, s);
+        vim = vmlaq_n_f32(vmulq_n_f32(vre, s), vim, c);
+        vre = next;
+    }
+
+    vst1q_f32(re, vre);
+    vst1q_f32(im, vim);
+#endif
+
+    for (; i + 4 <= frames; i += 4)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            out[i + k] += im[k];
+            float next = re[k] * c - im[k] * s;
+            im[k] = re[k] * s + im[k] * c;
+            re[k] = next;
+        }
+    }
+
+    for (int k = 0; i < frames; i++, k++)
+        out[i] += im[k];
+}
+
 struct tone_t
 {
-    double wd;
-    unsigned period, t;
+    double phase;  /* radians for steady sines, else cycles */
+    double inc;    /* per sample, in the same unit */
 };
 
-bool ToneGen::play(const char *filename, VFSFile &file)
+/* Generates a mono block at a time of any of the supported signals. */
+class ToneBank
 {
-    float data[BUF_SAMPLES];
+public:
+    ToneBank(const tone_params_t &params);
+    void fill(float *out, int frames);
 
-    auto frequencies = tone_filename_parse(filename);
-    if (!frequencies.len())
-        return false;
+private:
+    void fill_noise(float *out, int frames);
+    void fill_phase(float *out, int frames, tone_t &tone);
 
-    set_stream_bitrate(16 * OUTPUT_FREQ);
-    open_audio(FMT_FLOAT, OUTPUT_FREQ, 1);
+    Wave m_wave;
+    Index<tone_t> m_tones;
+    float m_amp;
 
-    Index<tone_t> tone;
-    tone.resize(frequencies.len());
-    for (int i = 0; i < frequencies.len(); i++)
+    /* sweep */
+    double m_start_inc = 0, m_ratio = 1;
+    int64_t m_sweep_len = 0, m_sweep_pos = 0;
+
+    uint32_t m_seed = 0x12345678;
+};
+
+ToneBank::ToneBank(const tone_params_t &params) :
+    m_wave(params.wave)
+{
+    auto &freqs = params.frequencies;
+    bool steady_sine = (m_wave == Wave::Sine && params.sweep <= 0);
+
+    /* dithering can cause a little bit of clipping */
+    m_amp = 0.999 / aud::max(freqs.len(), 1);
+
+    if (params.sweep > 0)
+    {
+        double first = freqs[0], last = freqs[freqs.len() - 1];
+        m_sweep_len = aud::max((int64_t)(params.sweep * params.rate), (int64_t)1);
+        m_start_inc = first / params.rate;
+        m_ratio = pow(last / first, 1.0 / m_sweep_len);
+        m_tones.append(tone_t{0, m_start_inc});
+        m_amp = 0.999;
+    }
+    else
     {
-        double f = frequencies[i];
-        tone[i].wd = 2 * PI * f / OUTPUT_FREQ;
-        tone[i].period = (INT_MAX * 2U / OUTPUT_FREQ) * (OUTPUT_FREQ / f);
-        tone[i].t = 0;
+        for (double f : freqs)
+        {
+            if (steady_sine)
+                m_tones.append(tone_t{0, 2 * PI * f / params.rate});
+            else
+                m_tones.append(tone_t{0, f / params.rate});
+        }
     }
 
-    while (!check_stop())
+    if (m_wave == Wave::Sine && !steady_sine)
+        make_sine_table();
+}
+
+void ToneBank::fill_noise(float *out, int frames)
+{
+    uint32_t seed = m_seed;
+    float scale = 0.999f / 2147483648.0f;
+
+    for (int i = 0; i < frames; i++)
     {
-        for (int i = 0; i < BUF_SAMPLES; i++)
+        /* xorshift32 */
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        out[i] = (int32_t)seed * scale;
+    }
+
+    m_seed = seed;
+}
+
+/* square, saw and swept sine: a phase accumulator per tone */
+void ToneBank::fill_phase(float *out, int frames, tone_t &tone)
+{
+    double phase = tone.phase, inc = tone.inc;
+    float amp = m_amp;
+
+    for (int i = 0; i < frames; i++)
+    {
+        float value;
+
+        switch (m_wave)
         {
-            double sum_sines = 0;
+        case Wave::Square:
+        {
+            double half = phase + 0.5;
+            if (half >= 1)
+                half -= 1;
+
+            value = (phase < 0.5 ? 1 : -1) + poly_blep(phase, inc) - poly_blep(half, inc);
+            break;
+        }
+        case Wave::Saw:
+            value = 2 * phase - 1 - poly_blep(phase, inc);
+            break;
+        default:
+            value = table_sine(phase);
+            break;
+        }
 
-            for (int j = 0; j < frequencies.len(); j++)
+        out[i] += amp * value;
+
+        phase += inc;
+        if (phase >= 1)
+            phase -= 1;
+
+        if (m_sweep_len)
+        {
+            inc *= m_ratio;
+            if (++m_sweep_pos == m_sweep_len)
             {
-                sum_sines += sin(tone[j].wd * tone[j].t);
-                if (tone[j].t > tone[j].period)
-                    tone[j].t -= tone[j].period;
-                tone[j].t++;
+                m_sweep_pos = 0;
+                inc = m_start_inc;
             }
-            /* dithering can cause a little bit of clipping */
-            data[i] = (sum_sines * 0.999 / (double)frequencies.len());
+        }
+    }
+
+    tone.phase = phase;
+    tone.inc = inc;
+}
+
+void ToneBank::fill(float *out, int frames)
+{
+    if (m_wave == Wave::Noise)
+    {
+        fill_noise(out, frames);
+        return;
+    }
+
+    memset(out, 0, sizeof(float) * frames);
+
+    for (tone_t &tone : m_tones)
+    {
+        if (m_wave == Wave::Sine && !m_sweep_len)
+        {
+            add_sine(out, frames, tone.phase, tone.inc, m_amp);
+            tone.phase = fmod(tone.phase + tone.inc * frames, 2 * PI);
+        }
+        else
+            fill_phase(out, frames, tone);
+    }
+}
+
+bool ToneGen::play(const char *filename, VFSFile &file)
+{
+    float data[BUF_SAMPLES];
+
+    tone_params_t params;
+    if (!tone_filename_parse(filename, params))
+        return false;
+
+    int channels = params.channels;
+    ToneBank bank(params);
+    Index<float> out;
+
+    if (channels > 1)
+        out.resize(BUF_SAMPLES * channels);
+
+    set_stream_bitrate(32 * params.rate * channels);
+    open_audio(FMT_FLOAT, params.rate, channels);
+
+    while (!check_stop())
+    {
+        bank.fill(data, BUF_SAMPLES);
+
+        if (channels == 1)
+        {
+            write_audio(data, sizeof data);
+            continue;
+        }
+
+        float *dest = out.begin();
+        for (int i = 0; i < BUF_SAMPLES; i++)
+        {
+            for (int c = 0; c < channels; c++)
+                *dest++ = data[i];
         }
 
-        write_audio(data, BUF_BYTES);
+        write_audio(out.begin(), sizeof(float) * out.len());
     }
 
     return true;
@@ -148,12 +452,12 @@ bool ToneGen::play(const char *filename, VFSFile &file)
 
 bool ToneGen::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *image)
 {
-    StringBuf title = tone_title(filename);
-    if (!title)
+    tone_params_t params;
+    if (!tone_filename_parse(filename, params))
         return false;
 
-    tuple.set_str(Tuple::Title, title);
-    tuple.set_int(Tuple::Channels, 1);
+    tuple.set_str(Tuple::Title, tone_title(filename));
+    tuple.set_int(Tuple::Channels, params.channels);
     return true;
 }
 
@@ -161,6 +465,10 @@ const char ToneGen::about[] =
  N_("Sine tone generator by Håvard Kvålen <havardk@xmms.org>\n"
     "Modified by Daniel J. Peng <danielpeng@bigfoot.com>\n\n"
     "To use it, add a URL: tone://frequency1;frequency2;frequency3;...\n"
-    "e.g. tone://2000;2005 to play a 2000 Hz tone and a 2005 Hz tone");
+    "e.g. tone://2000;2005 to play a 2000 Hz tone and a 2005 Hz tone\n\n"
+    "Options may follow the frequencies:\n"
+    "wave=sine|square|saw|noise, sweep=seconds (from the first frequency\n"
+    "to the last), rate=Hz and channels=count\n"
+    "e.g. tone://20;20000;sweep=10;rate=96000;channels=2");
 
 const char *const ToneGen::schemes[] = {"tone", nullptr};
@@ -0,0 +1,149 @@
+/*
+ * Spectrum Band Mapper
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "bandmap.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <libaudcore/objects.h>
+#include <libaudcore/plugin.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BANDMAP_NEON
+#endif
+
+#define FREQ_BINS 256
+
+void BandMapper::init (int bands, const float * xscale)
+{
+    Index<float> log_xscale;
+
+    if (! xscale)
+    {
+        log_xscale.resize (bands + 1);
+        Visualizer::compute_log_xscale (log_xscale.begin (), bands);
+        xscale = log_xscale.begin ();
+    }
+
+    m_start.resize (bands);
+    m_offset.resize (bands + 1);
+    m_weights.clear ();
+
+    /* fudge factor to make the graph have the same overall height as a
+       12-band one no matter how many bands there are */
+    float fudge = (float) bands / 12;
+
+    for (int i = 0; i < bands; i ++)
+    {
+        /* weights of the bins between xscale[i] and xscale[i + 1],
+           including fractional parts */
+        int a = ceilf (xscale[i]);
+        int b = floorf (xscale[i + 1]);
+
+        m_offset[i] = m_weights.len ();
+
+        if (b < a)
+        {
+            m_start[i] = b;
+            m_weights.append ((xscale[i + 1] - xscale[i]) * fudge);
+        }
+        else
+        {
+            m_start[i] = (a > 0) ? a - 1 : a;
+
+            if (a > 0)
+                m_weights.append ((a - xscale[i]) * fudge);
+            for (; a < b; a ++)
+                m_weights.append (fudge);
+            if (b < FREQ_BINS)
+                m_weights.append ((xscale[i + 1] - b) * fudge);
+        }
+    }
+
+    m_offset[bands] = m_weights.len ();
+}
+
+static float dot (const float * a, const float * b, int n)
+{
+    float sum = 0;
+    int i = 0;
+
+#if defined(__SSE__)
+    __m128 acc = _mm_setzero_ps ();
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_add_ps (acc, _mm_mul_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+
+    float lanes[4];
+    _mm_storeu_ps (lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(BANDMAP_NEON)
+    float32x4_t acc = vdupq_n_f32 (0);
+    for (; i + 4 <= n; i += 4)
+        acc = vmlaq_f32 (acc, vld1q_f32 (a + i), vld1q_f32 (b + i));
+
+    sum = vaddvq_f32 (acc);
+#endif
+
+    for (; i < n; i ++)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+/* 20 * log10 (x) using the float exponent and a quadratic fit of log2 on the
+ * mantissa; good to about 0.05 dB, which is far below one pixel.  Unlike
+ * log10f(), zero gives a large finite value (about -770 dB) instead of -inf. */
+static inline float fast_db (float x)
+{
+    uint32_t bits;
+    memcpy (& bits, & x, sizeof bits);
+
+    float exponent = (float) ((int) ((bits >> 23) & 0xff) - 128);
+
+    bits = (bits & 0x7fffff) | 0x3f800000;  /* mantissa in [1, 2) */
+    float m;
+    memcpy (& m, & bits, sizeof m);
+
+    float log2 = exponent + (-0.34484843f * m + 2.02466578f) * m - 0.67487759f;
+    return 6.0206f * log2;  /* 20 * log10 (2) */
+}
+
+void BandMapper::compute_db (const float * freq, float * db) const
+{
+    for (int i = 0; i < m_start.len (); i ++)
+    {
+        float sum = dot (freq + m_start[i], & m_weights[m_offset[i]],
+         m_offset[i + 1] - m_offset[i]);
+
+        db[i] = fast_db (sum);
+    }
+}
+
+void BandMapper::compute_scaled (const float * freq, float db_range, float * out) const
+{
+    compute_db (freq, out);
+
+    for (int i = 0; i < m_start.len (); i ++)
+        out[i] = aud::clamp (1 + out[i] / db_range, 0.0f, 1.0f);
+}
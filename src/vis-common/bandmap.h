@@ -0,0 +1,52 @@
+/*
+ * Spectrum Band Mapper
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef BANDMAP_H
+#define BANDMAP_H
+
+#include <libaudcore/index.h>
+
+/* Maps the 256 linear frequency bins passed to VisPlugin::render_freq() onto
+ * logarithmically spaced bands, as Visualizer::compute_freq_band() does.  The
+ * fractional bin weights of each band are worked out once in init(), so every
+ * frame is just one short dot product per band plus a fast dB conversion. */
+
+class BandMapper
+{
+public:
+    /* <xscale> holds <bands> + 1 band edges in bins; if it is not given,
+     * Visualizer::compute_log_xscale() is used */
+    void init (int bands, const float * xscale = nullptr);
+
+    int bands () const
+        { return m_start.len (); }
+
+    /* band levels in dB, as compute_freq_band() would return them */
+    void compute_db (const float * freq, float * db) const;
+
+    /* band levels scaled from (-db_range, 0) dB to (0, 1) and clipped */
+    void compute_scaled (const float * freq, float db_range, float * out) const;
+
+private:
+    Index<int> m_start;         /* first bin of each band */
+    Index<int> m_offset;        /* start of each band's weights in m_weights */
+    Index<float> m_weights;     /* m_offset[i + 1] - m_offset[i] weights per band */
+};
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * Blur Scope Image
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "blurimage.h"
+
+#include <string.h>
+
+#include <libaudcore/objects.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BLURIMAGE_NEON
+#endif
+
+/* The image has a one-pixel black border all around, so that the blur can
+ * read the neighbours of edge pixels without any special cases. */
+
+void BlurImage::resize (int width, int height, int scale)
+{
+    m_full_width = width;
+    m_full_height = height;
+    m_scale = aud::max (scale, 1);
+    m_width = (width + m_scale - 1) / m_scale;
+    m_height = (height + m_scale - 1) / m_scale;
+    m_stride = m_width + 2;
+
+    m_image.resize (m_stride * (m_height + 2));
+    m_row.resize (m_stride);
+    m_corner = m_image.begin () + m_stride + 1;
+
+    clear ();
+}
+
+void BlurImage::clear ()
+{
+    if (m_image.len ())
+        memset (m_image.begin (), 0, sizeof (uint32_t) * m_image.len ());
+}
+
+void BlurImage::blur ()
+{
+    /* We do a quick and dirty average of four color values, first masking off
+     * the lowest two bits.  Over a large area, this masking has the net effect
+     * of subtracting 1.5 from each value, which by a happy chance is just right
+     * for a gradual fade effect.
+     *
+     * Rows are done top to bottom in place, so the row above has already been
+     * blurred.  The left and right neighbours are read from a copy of the
+     * current row, which lets several pixels be done at once. */
+    const uint32_t mask = 0xFCFCFC;
+
+    for (int y = 0; y < m_height; y ++)
+    {
+        uint32_t * p = m_corner + m_stride * y;
+        const uint32_t * plast = p - m_stride;
+        const uint32_t * pnext = p + m_stride;
+        const uint32_t * row = m_row.begin () + 1;
+
+        memcpy (m_row.begin (), p - 1, sizeof (uint32_t) * m_stride);
+
+        int x = 0;
+
+#if defined(__SSE2__)
+        const __m128i vmask = _mm_set1_epi32 (mask);
+
+        for (; x + 4 <= m_width; x += 4)
+        {
+            __m128i a = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (plast + x)), vmask);
+            __m128i b = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (row + x - 1)), vmask);
+            __m128i c = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (row + x + 1)), vmask);
+            __m128i d = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (pnext + x)), vmask);
+
+            __m128i sum = _mm_add_epi32 (_mm_add_epi32 (a, b), _mm_add_epi32 (c, d));
+            _mm_storeu_si128 ((__m128i *) (p + x), _mm_srli_epi32 (sum, 2));
+        }
+#elif defined(BLURIMAGE_NEON)
+        const uint32x4_t vmask = vdupq_n_u32 (mask);
+
+        for (; x + 4 <= m_width; x += 4)
+        {
+            uint32x4_t a = vandq_u32 (vld1q_u32 (plast + x), vmask);
+            uint32x4_t b = vandq_u32 (vld1q_u32 (row + x - 1), vmask);
+            uint32x4_t c = vandq_u32 (vld1q_u32 (row + x + 1), vmask);
+            uint32x4_t d = vandq_u32 (vld1q_u32 (pnext + x), vmask);
+
+            uint32x4_t sum = vaddq_u32 (vaddq_u32 (a, b), vaddq_u32 (c, d));
+            vst1q_u32 (p + x, vshrq_n_u32 (sum, 2));
+        }
+#endif
+
+        for (; x < m_width; x ++)
+            p[x] = ((plast[x] & mask) + (row[x - 1] & mask) +
+             (row[x + 1] & mask) + (pnext[x] & mask)) >> 2;
+    }
+}
+
+void BlurImage::draw_vert_line (int x, int y1, int y2, uint32_t color)
+{
+    int y, h;
+
+    if (y1 < y2) {y = y1 + 1; h = y2 - y1;}
+    else if (y2 < y1) {y = y2; h = y1 - y2;}
+    else {y = y1; h = 1;}
+
+    uint32_t * p = m_corner + y * m_stride + x;
+
+    for (; h >= 4; h -= 4, p += 4 * m_stride)
+        p[0] = p[m_stride] = p[2 * m_stride] = p[3 * m_stride] = color;
+    for (; h --; p += m_stride)
+        * p = color;
+}
+
+void BlurImage::render (const float * pcm, uint32_t color)
+{
+    if (! m_width || ! m_height)
+        return;
+
+    blur ();
+
+    int prev_y = (0.5 + pcm[0]) * m_height;
+    prev_y = aud::clamp (prev_y, 0, m_height - 1);
+
+    for (int i = 0; i < m_width; i ++)
+    {
+        int y = (0.5 + pcm[i * 512 / m_width]) * m_height;
+        y = aud::clamp (y, 0, m_height - 1);
+        draw_vert_line (i, prev_y, y, color);
+        prev_y = y;
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Blur Scope Image
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef BLURIMAGE_H
+#define BLURIMAGE_H
+
+#include <stdint.h>
+
+#include <libaudcore/index.h>
+
+/* The fading oscilloscope image shared by the GTK and Qt blur scopes.  Pixels
+ * are 0x00RRGGBB, laid out for CAIRO_FORMAT_RGB24 and QImage::Format_RGB32.
+ * With a scale of 2, the image is kept at half the widget size and the caller
+ * is expected to scale it up when painting. */
+
+class BlurImage
+{
+public:
+    void resize (int width, int height, int scale);
+    void set_scale (int scale)
+        { resize (m_full_width, m_full_height, scale); }
+
+    void clear ();
+
+    /* fades the previous image and draws the 512 samples over it */
+    void render (const float * pcm, uint32_t color);
+
+    int width () const
+        { return m_width; }
+    int height () const
+        { return m_height; }
+    int scale () const
+        { return m_scale; }
+
+    /* top left pixel and distance between rows, in bytes */
+    const unsigned char * pixels () const
+        { return (const unsigned char *) m_corner; }
+    int stride () const
+        { return m_stride * sizeof (uint32_t); }
+
+private:
+    void blur ();
+    void draw_vert_line (int x, int y1, int y2, uint32_t color);
+
+    int m_full_width = 0, m_full_height = 0;
+    int m_width = 0, m_height = 0, m_stride = 0, m_scale = 1;
+    Index<uint32_t> m_image, m_row;
+    uint32_t * m_corner = nullptr;
+};
+
+#endif
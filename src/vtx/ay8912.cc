@@ -3,6 +3,7 @@
 #include "ayemu_8912.h"
 
 #include <inttypes.h>
+#include <math.h>
 #include <libaudcore/runtime.h>
 
 const char * ayemu_err;
@@ -22,6 +23,12 @@ enum
 static int bEnvGenInit = 0;
 static int Envelope[16][128];
 
+/* Band-limited step table (will be calculated by gen_blep()) */
+#define BLEP_PHASES 64
+#define BLEP_BITS 15
+static int bBlepGenInit = 0;
+static int Blep[BLEP_PHASES][AYEMU_BLEP_TAPS];
+
 /* AY volume table (c) by V_Soft and Lion 17 */
 static int Lion17_AY_table[16] = {
     0,     513,   828,   1239,  1923,  3238,  4926,  9110,
@@ -134,6 +141,51 @@ static void gen_env()
     bEnvGenInit = 1;
 }
 
+/* Generate the band-limited step table: a Blackman-windowed sinc with its
+ * cutoff at 0.45 of the output rate, integrated into a step and cut into
+ * per-sample differences, for each of BLEP_PHASES start positions within
+ * an output sample.  Each row sums to exactly 1 << BLEP_BITS, so that the
+ * output settles on the exact level after every step.
+ * Will be executed once before first use. */
+static void gen_blep()
+{
+    const int len = (AYEMU_BLEP_TAPS - 1) * BLEP_PHASES;
+    const double center = (AYEMU_BLEP_TAPS - 1) / 2.0;
+    const double cutoff = 0.45;
+    static double step[(AYEMU_BLEP_TAPS - 1) * BLEP_PHASES + 1];
+
+    step[0] = 0;
+    for (int i = 0; i < len; i++)
+    {
+        double x = (i + 0.5) / BLEP_PHASES;
+        double t = x - center;
+        double w = 0.42 - 0.5 * cos(2 * M_PI * x / (AYEMU_BLEP_TAPS - 1)) +
+                   0.08 * cos(4 * M_PI * x / (AYEMU_BLEP_TAPS - 1));
+
+        step[i + 1] = step[i] + w * ((t != 0) ? sin(2 * M_PI * cutoff * t) / (M_PI * t) : 2 * cutoff);
+    }
+
+    for (int phase = 0; phase < BLEP_PHASES; phase++)
+    {
+        int sum = 0;
+
+        for (int k = 0; k < AYEMU_BLEP_TAPS; k++)
+        {
+            int hi = (k + 1) * BLEP_PHASES - phase;
+            int lo = hi - BLEP_PHASES;
+            double s_hi = (hi >= len) ? 1 : step[hi] / step[len];
+            double s_lo = (lo <= 0) ? 0 : step[lo] / step[len];
+
+            Blep[phase][k] = (int)lrint((s_hi - s_lo) * (1 << BLEP_BITS));
+            sum += Blep[phase][k];
+        }
+
+        Blep[phase][AYEMU_BLEP_TAPS / 2] += (1 << BLEP_BITS) - sum;
+    }
+
+    bBlepGenInit = 1;
+}
+
 /**
  * Initialize the ayemu_ay_t structure.
  * \arg \c ay - pointer to ayemu_ay_t structure.
@@ -163,6 +215,14 @@ void ayemu_reset(ayemu_ay_t * ay)
     ay->bit_a = ay->bit_b = ay->bit_c = ay->bit_n = 0;
     ay->env_pos = ay->EnvNum = 0;
     ay->Cur_Seed = 0xffff;
+    ay->run = ay->pending = 0;
+    ay->level_l = ay->level_r = 0;
+
+    for (int k = 0; k < AYEMU_BLEP_TAPS; k++)
+        ay->blep_l[k] = ay->blep_r[k] = 0;
+
+    ay->blep_pos = 0;
+    ay->out_l = ay->out_r = 0;
 }
 
 static void set_table_ay(ayemu_ay_t * ay, int tbl[16])
@@ -332,6 +392,63 @@ int ayemu_set_stereo(ayemu_ay_t * ay, ayemu_stereo_t stereo_type, int * custom_e
     return 1;
 }
 
+/* Advances a counter by <tacts> chip counts and returns the number of times
+ * it reached its period.  Equivalent to running "if (++cnt >= period) cnt = 0"
+ * once per count. */
+static int advance_counter(int * cnt, int period, int tacts)
+{
+    int first = (period - *cnt > 1) ? period - *cnt : 1;
+    if (tacts < first)
+    {
+        *cnt += tacts;
+        return 0;
+    }
+
+    int step = (period > 1) ? period : 1;
+    tacts -= first;
+    *cnt = tacts % step;
+    return 1 + tacts / step;
+}
+
+static void advance_chip(ayemu_ay_t * ay, int tacts)
+{
+    ay->bit_a ^= advance_counter(&ay->cnt_a, ay->regs.tone_a, tacts) & 1;
+    ay->bit_b ^= advance_counter(&ay->cnt_b, ay->regs.tone_b, tacts) & 1;
+    ay->bit_c ^= advance_counter(&ay->cnt_c, ay->regs.tone_c, tacts) & 1;
+
+    /* GenNoise (c) Hacker KAY & Sergey Bulba */
+    int n = advance_counter(&ay->cnt_n, ay->regs.noise * 2, tacts);
+    if (n)
+    {
+        unsigned seed = ay->Cur_Seed;
+        while (n--)
+            seed = (seed * 2 + 1) ^ (((seed >> 16) ^ (seed >> 13)) & 1);
+
+        ay->Cur_Seed = seed;
+        ay->bit_n = ((seed >> 16) & 1);
+    }
+
+    int e = advance_counter(&ay->cnt_e, ay->regs.env_freq, tacts);
+    if (e)
+    {
+        ay->env_pos += e;
+        if (ay->env_pos > 127)
+            ay->env_pos = 64 + (ay->env_pos - 128) % 64;
+    }
+}
+
+/* Applies the chip counts already played at the current level (the first
+ * of which was applied when the level was computed), so that new register
+ * values take effect from the next count on. */
+static void sync_counters(ayemu_ay_t * ay)
+{
+    if (ay->pending > 0)
+        advance_chip(ay, ay->pending - (int)(ay->run >> 16));
+
+    ay->pending = 0;
+    ay->run &= 0xffff; /* rest of the count in progress */
+}
+
 #define WARN_IF_REGISTER_GREATER_THAN(r, m)                                    \
     if (*(regs + r) > m)                                                       \
         AUDWARN("Possible bad register data- R%d > %d\n", r, m)
@@ -353,6 +470,8 @@ void ayemu_set_regs(ayemu_ay_t * ay, unsigned char * regs)
     WARN_IF_REGISTER_GREATER_THAN(9, 31);
     WARN_IF_REGISTER_GREATER_THAN(10, 31);
 
+    sync_counters(ay);
+
     ay->regs.tone_a = regs[0] + ((regs[1] & 0x0f) << 8);
     ay->regs.tone_b = regs[2] + ((regs[3] & 0x0f) << 8);
     ay->regs.tone_c = regs[4] + ((regs[5] & 0x0f) << 8);
@@ -393,6 +512,9 @@ static void prepare_generation(ayemu_ay_t * ay)
     if (!bEnvGenInit)
         gen_env();
 
+    if (!bBlepGenInit)
+        gen_blep();
+
     if (ay->default_chip_flag)
         ayemu_set_chip_type(ay, AYEMU_AY, nullptr);
 
@@ -402,7 +524,8 @@ static void prepare_generation(ayemu_ay_t * ay)
     if (ay->default_sound_format_flag)
         ayemu_set_sound_format(ay, 44100, 2, 16);
 
-    ay->ChipTacts_per_outcount = ay->ChipFreq / ay->sndfmt.freq / 8;
+    ay->tacts_step = ((int64_t)ay->ChipFreq << 16) / (ay->sndfmt.freq * 8);
+    ay->ChipTacts_per_outcount = ay->tacts_step >> 16;
 
     {
         /* GenVols */
@@ -423,22 +546,99 @@ static void prepare_generation(ayemu_ay_t * ay)
     max_l = ay->vols[0][31] + ay->vols[2][31] + ay->vols[3][31];
     max_r = ay->vols[1][31] + ay->vols[3][31] + ay->vols[5][31];
     vol = (max_l > max_r) ? max_l : max_r; /* =157283 on all defaults */
-    ay->Amp_Global = ay->ChipTacts_per_outcount * vol / AYEMU_MAX_AMP;
+    ay->Amp_Global = ((ay->tacts_step * vol / AYEMU_MAX_AMP) >> 16);
+    if (ay->Amp_Global < 1)
+        ay->Amp_Global = 1;
+
     ay->dirty = 0;
 }
 
+#define ENVVOL Envelope[ay->regs.env_style][ay->env_pos]
+
+/* Computes the output level for the current generator state, and how many
+ * chip counts it lasts (including this one) before a generator that can
+ * change it flips. */
+static int next_level(ayemu_ay_t * ay)
+{
+    int mix_l = 0, mix_r = 0;
+    int tacts = 1 << 16;
+    int noise_used = 0, env_used = 0;
+
+    const int tone_on[3] = {ay->regs.R7_tone_a, ay->regs.R7_tone_b, ay->regs.R7_tone_c};
+    const int noise_on[3] = {ay->regs.R7_noise_a, ay->regs.R7_noise_b, ay->regs.R7_noise_c};
+    const int bit[3] = {ay->bit_a, ay->bit_b, ay->bit_c};
+    const int env[3] = {ay->regs.env_a, ay->regs.env_b, ay->regs.env_c};
+    const int vol[3] = {ay->regs.vol_a, ay->regs.vol_b, ay->regs.vol_c};
+    const int tone[3] = {ay->regs.tone_a, ay->regs.tone_b, ay->regs.tone_c};
+    const int cnt[3] = {ay->cnt_a, ay->cnt_b, ay->cnt_c};
+
+    for (int ch = 0; ch < 3; ch++)
+    {
+        int tmpvol = env[ch] ? ENVVOL : vol[ch] * 2 + 1;
+        int * vols_l = ay->vols[ch * 2];
+        int * vols_r = ay->vols[ch * 2 + 1];
+
+        if ((bit[ch] | !tone_on[ch]) & (ay->bit_n | !noise_on[ch]))
+        {
+            mix_l += vols_l[tmpvol];
+            mix_r += vols_r[tmpvol];
+        }
+
+        /* a silent channel cannot change the level */
+        if (!env[ch] && !vols_l[tmpvol] && !vols_r[tmpvol])
+            continue;
+
+        if (tone_on[ch] && tone[ch] - cnt[ch] < tacts)
+            tacts = tone[ch] - cnt[ch];
+
+        noise_used |= noise_on[ch];
+        env_used |= env[ch];
+    }
+
+    if (noise_used && ay->regs.noise * 2 - ay->cnt_n < tacts)
+        tacts = ay->regs.noise * 2 - ay->cnt_n;
+    if (env_used && ay->regs.env_freq - ay->cnt_e < tacts)
+        tacts = ay->regs.env_freq - ay->cnt_e;
+
+    ay->level_l = mix_l;
+    ay->level_r = mix_r;
+
+    return (tacts > 1) ? tacts : 1;
+}
+
+/* Adds a band-limited step from the previous level to the current one,
+ * starting <phase> / BLEP_PHASES of the way into the next output sample. */
+static void add_step(ayemu_ay_t * ay, int phase, int delta_l, int delta_r)
+{
+    const int * kernel = Blep[phase];
+
+    for (int k = 0; k < AYEMU_BLEP_TAPS; k++)
+    {
+        int i = (ay->blep_pos + k) & (AYEMU_BLEP_TAPS - 1);
+        ay->blep_l[i] += (int64_t)delta_l * kernel[k];
+        ay->blep_r[i] += (int64_t)delta_r * kernel[k];
+    }
+}
+
 /**
  * Generate sound: Fill sound buffer with current register data.
  * \arg \c ay - pointer to ayemu_t structure.
  * \arg \c buf - pointer to sound buffer.
  * \arg \c sound_bufsize - size of buffer.
  * \return pointer to next data in output sound buffer.
+ *
+ * The output level only changes when a tone, noise or envelope generator
+ * flips, so rather than stepping the chip once per count, the generator
+ * jumps from one flip to the next.  Each change of level goes into the
+ * output as a band-limited step (from the table built by gen_blep()) placed
+ * at the exact time of the flip, so square waves above the output rate no
+ * longer alias down into the audible range.  The steps delay the output by
+ * about AYEMU_BLEP_TAPS / 2 samples.  Output samples may span a fractional
+ * number of chip counts.
  */
 void * ayemu_gen_sound(ayemu_ay_t * ay, void * buf, size_t sound_bufsize)
 {
     int mix_l, mix_r;
-    int tmpvol;
-    int m;
     int snd_numcount;
     unsigned char * sound_buf = (unsigned char *)buf;
 
@@ -451,80 +651,47 @@ void * ayemu_gen_sound(ayemu_ay_t * ay, void * buf, size_t sound_bufsize)
 
     while (snd_numcount-- > 0)
     {
-        mix_l = mix_r = 0;
+        int64_t need = ay->tacts_step;
 
-        for (m = 0; m < ay->ChipTacts_per_outcount; m++)
+        while (need > 0)
         {
-            if (++ay->cnt_a >= ay->regs.tone_a)
+            if (!ay->run)
             {
-                ay->cnt_a = 0;
-                ay->bit_a = !ay->bit_a;
-            }
+                /* finish the last span, flip, and find the next flip */
+                int old_l = ay->level_l, old_r = ay->level_r;
 
-            if (++ay->cnt_b >= ay->regs.tone_b)
-            {
-                ay->cnt_b = 0;
-                ay->bit_b = !ay->bit_b;
-            }
+                advance_chip(ay, ay->pending + 1);
+                int tacts = next_level(ay);
+                ay->pending = tacts - 1;
+                ay->run = (int64_t)tacts << 16;
 
-            if (++ay->cnt_c >= ay->regs.tone_c)
-            {
-                ay->cnt_c = 0;
-                ay->bit_c = !ay->bit_c;
-            }
-
-            /* GenNoise (c) Hacker KAY & Sergey Bulba */
-            if (++ay->cnt_n >= (ay->regs.noise * 2))
-            {
-                ay->cnt_n = 0;
-                ay->Cur_Seed =
-                    (ay->Cur_Seed * 2 + 1) ^
-                    (((ay->Cur_Seed >> 16) ^ (ay->Cur_Seed >> 13)) & 1);
-                ay->bit_n = ((ay->Cur_Seed >> 16) & 1);
-            }
-
-            if (++ay->cnt_e >= ay->regs.env_freq)
-            {
-                ay->cnt_e = 0;
-                if (++ay->env_pos > 127)
-                    ay->env_pos = 64;
+                if (ay->level_l != old_l || ay->level_r != old_r)
+                    add_step(ay, (int)((ay->tacts_step - need) * BLEP_PHASES / ay->tacts_step),
+                             ay->level_l - old_l, ay->level_r - old_r);
             }
 
-#define ENVVOL Envelope[ay->regs.env_style][ay->env_pos]
-
-            if ((ay->bit_a | !ay->regs.R7_tone_a) &
-                (ay->bit_n | !ay->regs.R7_noise_a))
-            {
-                tmpvol = (ay->regs.env_a) ? ENVVOL : ay->regs.vol_a * 2 + 1;
-                mix_l += ay->vols[0][tmpvol];
-                mix_r += ay->vols[1][tmpvol];
-            }
+            int64_t take = (ay->run < need) ? ay->run : need;
+            ay->run -= take;
+            need -= take;
+        }
 
-            if ((ay->bit_b | !ay->regs.R7_tone_b) &
-                (ay->bit_n | !ay->regs.R7_noise_b))
-            {
-                tmpvol = (ay->regs.env_b) ? ENVVOL : ay->regs.vol_b * 2 + 1;
-                mix_l += ay->vols[2][tmpvol];
-                mix_r += ay->vols[3][tmpvol];
-            }
+        ay->out_l += ay->blep_l[ay->blep_pos];
+        ay->out_r += ay->blep_r[ay->blep_pos];
+        ay->blep_l[ay->blep_pos] = ay->blep_r[ay->blep_pos] = 0;
+        ay->blep_pos = (ay->blep_pos + 1) & (AYEMU_BLEP_TAPS - 1);
 
-            if ((ay->bit_c | !ay->regs.R7_tone_c) &
-                (ay->bit_n | !ay->regs.R7_noise_c))
-            {
-                tmpvol = (ay->regs.env_c) ? ENVVOL : ay->regs.vol_c * 2 + 1;
-                mix_l += ay->vols[4][tmpvol];
-                mix_r += ay->vols[5][tmpvol];
-            }
-        }
+        /* same scale as a level held for a whole sample */
+        mix_l = (int)((ay->out_l * ay->tacts_step) >> (16 + BLEP_BITS));
+        mix_r = (int)((ay->out_r * ay->tacts_step) >> (16 + BLEP_BITS));
 
         mix_l /= ay->Amp_Global;
         mix_r /= ay->Amp_Global;
 
         if (ay->sndfmt.bpc == 8)
         {
-            /* 8 bit sound */
-            mix_l = (mix_l >> 8) | 128;
-            mix_r = (mix_r >> 8) | 128;
+            /* 8 bit sound (the steps ring slightly below zero) */
+            mix_l = (mix_l >> 8) + 128;
+            mix_r = (mix_r >> 8) + 128;
             *sound_buf++ = mix_l;
 
             if (ay->sndfmt.channels != 1)
@@ -76,6 +76,9 @@ typedef struct
  */
 /*@{*/
 
+/** Length of the band-limited step, in output samples (a power of 2) */
+#define AYEMU_BLEP_TAPS 16
+
 /**
  * Data structure for sound chip emulation \internal
  */
@@ -108,13 +111,27 @@ typedef struct
     int cnt_c;                  /**< back counter of C */
     int cnt_n;                  /**< back counter of noise generator */
     int cnt_e;                  /**< back counter of envelop generator */
-    int ChipTacts_per_outcount; /**< chip's counts per one sound signal count */
+    int ChipTacts_per_outcount; /**< chip's counts per one sound signal count (whole part) */
+    int64_t tacts_step;         /**< chip's counts per one sound signal count (16.16 fixed point) */
     int Amp_Global;             /**< scale factor for amplitude */
     int vols[6][32];            /**< stereo type (channel volumes) and chip table.
                                      This cache is calculated by #table and #eq. */
     int EnvNum;   /**< number of current envilopment (0...15) */
     int env_pos;  /**< current position in envelop (0...127) */
     int Cur_Seed; /**< random numbers counter */
+
+    /* event-based generator state */
+    int64_t run;  /**< chip counts (16.16) left at the current output level */
+    int pending;  /**< chip counts not yet applied to the counters */
+    int level_l;  /**< current output level, left */
+    int level_r;  /**< current output level, right */
+
+    /* band-limited steps not yet output */
+    int64_t blep_l[AYEMU_BLEP_TAPS]; /**< level differences per output sample, left */
+    int64_t blep_r[AYEMU_BLEP_TAPS]; /**< level differences per output sample, right */
+    int blep_pos;                    /**< entry for the next output sample */
+    int64_t out_l;                   /**< band-limited output level, left */
+    int64_t out_r;                   /**< band-limited output level, right */
 } ayemu_ay_t;
 
 extern void ayemu_init(ayemu_ay_t * ay);
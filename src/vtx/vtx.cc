@@ -28,27 +28,36 @@
 #include <libaudcore/audstrings.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
 #include <libaudcore/runtime.h>
 
 #include "ayemu_8912.h"
 #include "ayemu_vtxfile.h"
 #include "vtx.h"
 
+#include "../render-cache-common/rendercache.h"
+
 class VTXPlugin : public InputPlugin
 {
 public:
     static const char about[];
     static const char * const exts[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
 
     static constexpr PluginInfo info = {
         N_("VTX Decoder"),
         PACKAGE,
-        about
+        about,
+        & prefs
     };
 
     constexpr VTXPlugin() : InputPlugin(info, InputInfo()
         .with_exts(exts)) {}
 
+    bool init() override;
+    void cleanup() override;
+
     bool is_our_file(const char *filename, VFSFile &file) override;
     bool read_tag(const char *filename, VFSFile &file, Tuple &tuple,
                   Index<char> *image) override;
@@ -66,7 +75,6 @@ public:
 EXPORT VTXPlugin aud_plugin_instance;
 
 #define SNDBUFSIZE 1024
-static char sndbuf[SNDBUFSIZE];
 static constexpr int freq = 44100;
 static constexpr int chans = 2;
 static constexpr int bits = 16;
@@ -107,22 +115,19 @@ bool VTXPlugin::read_tag(const char * filename, VFSFile & file, Tuple & tuple,
     return true;
 }
 
-bool VTXPlugin::play(const char * filename, VFSFile & file)
+/* An AY/YM song being played or rendered */
+struct VTXSong
 {
     ayemu_ay_t ay;
     ayemu_vtx_t vtx;
+    int left = 0; /* how many sound frames can play with current AY register frame */
 
-    bool eof = false;
-    void * stream; /* pointer to current position in sound buffer */
-    unsigned char regs[14];
-    int need;
-    int left; /* how many sound frames can play with current AY register frame */
-    int donow;
-    int rate;
-
-    left = 0;
-    rate = chans * (bits / 8);
+    bool load(const char * filename, VFSFile & file);
+    bool fill(char * sndbuf);
+};
 
+bool VTXSong::load(const char * filename, VFSFile & file)
+{
     memset(&ay, 0, sizeof ay);
 
     if (!vtx.read_header(file))
@@ -142,6 +147,142 @@ bool VTXPlugin::play(const char * filename, VFSFile & file)
     ayemu_set_chip_freq(&ay, vtx.hdr.chipFreq);
     ayemu_set_stereo(&ay, (ayemu_stereo_t)vtx.hdr.stereo, nullptr);
 
+    return true;
+}
+
+/* Fills the sound buffer; returns false if the song ended (the rest of the
+ * buffer is then silent). */
+bool VTXSong::fill(char * sndbuf)
+{
+    void * stream = sndbuf; /* pointer to current position in sound buffer */
+    unsigned char regs[14];
+    int need;
+    int donow;
+    int rate = chans * (bits / 8);
+    bool eof = false;
+
+    for (need = SNDBUFSIZE / rate; need > 0; need -= donow)
+    {
+        if (left > 0)
+        {
+            /* use current AY register frame */
+            donow = (need > left) ? left : need;
+            left -= donow;
+            stream = ayemu_gen_sound(&ay, (char *)stream, donow * rate);
+        }
+        else
+        {
+            /* get next AY register frame */
+            if (!vtx.get_next_frame(regs))
+            {
+                donow = need;
+                memset(stream, 0, donow * rate);
+                eof = true;
+            }
+            else
+            {
+                left = freq / vtx.hdr.playerFreq;
+                ayemu_set_regs(&ay, regs);
+                donow = 0;
+            }
+        }
+    }
+
+    return !eof;
+}
+
+/* ay8912.cc */
+static const char engine_version[] = "ayemu-2";
+
+static String cache_key(const Index<char> & data)
+{
+    return render_cache_key("vtx", engine_version, data, "");
+}
+
+/* Only the file name is kept until the render starts, since a VTX song is
+ * unpacked in full when it is opened. */
+class VTXRenderJob : public RenderCacheJob
+{
+public:
+    explicit VTXRenderJob(const char * filename) : m_filename(filename) {}
+
+    bool render(RenderCacheWriter & writer) override;
+
+private:
+    String m_filename;
+};
+
+bool VTXRenderJob::render(RenderCacheWriter & writer)
+{
+    VFSFile file(m_filename, "r");
+    VTXSong song;
+    char sndbuf[SNDBUFSIZE];
+
+    if (!file || !song.load(m_filename, file))
+        return false;
+
+    bool more = true;
+
+    while (more)
+    {
+        if (RenderCacheWriter::cancelled())
+            return false;
+
+        more = song.fill(sndbuf);
+        writer.write((const int16_t *)sndbuf, SNDBUFSIZE / (chans * (bits / 8)));
+    }
+
+    return true;
+}
+
+static void prerender_add(const char * filename)
+{
+    VFSFile file(filename, "r");
+    if (!file)
+        return;
+
+    String key = cache_key(file.read_all());
+    if (key)
+        render_cache_prerender(key, chans, freq, new VTXRenderJob(filename));
+}
+
+bool VTXPlugin::init()
+{
+    render_cache_init();
+    return true;
+}
+
+void VTXPlugin::cleanup()
+{
+    render_cache_cleanup();
+}
+
+bool VTXPlugin::play(const char * filename, VFSFile & file)
+{
+    VTXSong song;
+    RenderCacheWriter writer;
+    char sndbuf[SNDBUFSIZE];
+    bool eof = false;
+
+    render_cache_prerender_next(this, filename, prerender_add);
+
+    String key;
+    if (render_cache_enabled())
+    {
+        key = cache_key(file.read_all());
+        if (file.fseek(0, VFS_SEEK_SET))
+            return false;
+    }
+
+    if (render_cache_play(key, chans, freq))
+        return true;
+
+    if (!song.load(filename, file))
+        return false;
+
+    if (key)
+        writer.open(key, chans, freq);
+
     set_stream_bitrate(14 * 50 * 8);
     open_audio(FMT_S16_NE, freq, chans);
 
@@ -150,44 +291,30 @@ bool VTXPlugin::play(const char * filename, VFSFile & file)
         /* (time in sec) * 50 = offset in AY register data frames */
         int seek_value = check_seek();
         if (seek_value >= 0)
-            vtx.pos = seek_value / 20;
-
-        /* fill sound buffer */
-        stream = sndbuf;
-
-        for (need = SNDBUFSIZE / rate; need > 0; need -= donow)
         {
-            if (left > 0)
-            {
-                /* use current AY register frame */
-                donow = (need > left) ? left : need;
-                left -= donow;
-                stream = ayemu_gen_sound(&ay, (char *)stream, donow * rate);
-            }
-            else
-            {
-                /* get next AY register frame */
-                if (!vtx.get_next_frame(regs))
-                {
-                    donow = need;
-                    memset(stream, 0, donow * rate);
-                    eof = true;
-                }
-                else
-                {
-                    left = freq / vtx.hdr.playerFreq;
-                    ayemu_set_regs(&ay, regs);
-                    donow = 0;
-                }
-            }
+            writer.discard();
+            song.vtx.pos = seek_value / 20;
         }
 
+        /* fill sound buffer */
+        eof = !song.fill(sndbuf);
+
         write_audio(sndbuf, SNDBUFSIZE);
+        writer.write((const int16_t *)sndbuf, SNDBUFSIZE / (chans * (bits / 8)));
     }
 
+    if (eof)
+        writer.finish();
+
     return true;
 }
 
+const PreferencesWidget VTXPlugin::widgets[] = {
+    WidgetBox({{render_cache_widgets}})
+};
+
+const PluginPreferences VTXPlugin::prefs = {{widgets}};
+
 const char VTXPlugin::about[] =
  N_("Vortex file format player by Sashnov Alexander <sashnov@ngs.ru>\n"
     "Based on in_vtx.dll by Roman Sherbakov <v_soft@microfor.ru>\n"
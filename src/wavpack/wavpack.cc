@@ -9,6 +9,8 @@
 #include <libaudcore/plugin.h>
 #include <libaudcore/runtime.h>
 
+#include "../sampleconv-common/sampleconv.h"
+
 #define BUFFER_SIZE 256 /* read buffer size, in samples / frames */
 #define SAMPLE_SIZE(a) (a <= 8 ? sizeof (uint8_t) : (a <= 16 ? sizeof (uint16_t) : sizeof (uint32_t)))
 #define SAMPLE_FMT(a) (a <= 8 ? FMT_S8 : (a <= 16 ? FMT_S16_NE : (a <= 24 ? FMT_S24_NE : FMT_S32_NE)))
@@ -165,26 +167,8 @@ bool WavpackPlugin::play (const char * filename, VFSFile & file)
         else
         {
             /* Perform audio data conversion and output */
-            int32_t * rp = input.begin ();
-            int8_t * wp = (int8_t *) output.begin ();
-            int16_t * wp2 = (int16_t *) output.begin ();
-            int32_t * wp4 = (int32_t *) output.begin ();
-
-            if (bits_per_sample <= 8)
-            {
-                for (int i = 0; i < ret * num_channels; i++, wp++, rp++)
-                    * wp = * rp & 0xff;
-            }
-            else if (bits_per_sample <= 16)
-            {
-                for (int i = 0; i < ret * num_channels; i++, wp2++, rp++)
-                    * wp2 = * rp & 0xffff;
-            }
-            else
-            {
-                for (int i = 0; i < ret * num_channels; i++, wp4++, rp++)
-                    * wp4 = * rp;
-            }
+            sampleconv_pack_s32 (input.begin (), output.begin (),
+             SAMPLE_SIZE (bits_per_sample), ret * num_channels);
 
             write_audio (output.begin (),
              ret * num_channels * SAMPLE_SIZE (bits_per_sample));
@@ -54,6 +54,8 @@
 #include "sndif2sf.h"
 #include "XSFFile.h"
 
+#include "../render-cache-common/rendercache.h"
+
 #if _WIN32
 #include <windows.h>
 #define sleep Sleep
@@ -80,6 +82,7 @@ public:
 		.with_exts(exts)) {}
 
 	bool init() override;
+	void cleanup() override;
 
 	bool is_our_file(const char *filename, VFSFile &file) override;
 	bool read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *image) override;
@@ -177,9 +180,15 @@ const char* const XSFPlugin::defaults[] =
 bool XSFPlugin::init()
 {
 	aud_config_set_defaults(CFG_ID, defaults);
+	render_cache_init();
 	return true;
 }
 
+void XSFPlugin::cleanup()
+{
+	render_cache_cleanup();
+}
+
 Index<char> xsf_get_lib(char *filename)
 {
 	VFSFile file(filename_build({dirpath, filename}), "r");
@@ -295,6 +304,25 @@ void setInterp() {
   CommonSettings.spuInterpolationMode = (SPUInterpolationMode)interpMode;
 }
 
+/* the bundled DeSmuME and the 2SF driver */
+static const char engine_version[] = "desmume-1";
+
+/* The render cache key covers the ROM as assembled from the file and its
+ * libraries, the length and fade from the tags, and every setting that
+ * changes the output.  Songs played with
+ * the length ignored never end, so they are not cached. */
+static String cache_key(const std::vector<uint8_t>& rom, int length, int fade, int frameSkip, int sampleRate)
+{
+  if (!render_cache_enabled() || aud_get_bool(CFG_ID, "ignore_length"))
+    return String();
+
+  Index<char> data;
+  data.insert(reinterpret_cast<const char*>(rom.data()), 0, rom.size());
+
+  return render_cache_key("2sf", engine_version, data, str_printf("length=%d fade=%d frames=%d rate=%d interp=%d",
+   length, fade, frameSkip, sampleRate, (int)CommonSettings.spuInterpolationMode));
+}
+
 bool XSFPlugin::play(const char *filename, VFSFile &file)
 {
 	int length = -1;
@@ -302,6 +330,7 @@ bool XSFPlugin::play(const char *filename, VFSFile &file)
   int fade = aud_get_int(CFG_ID, "fade");
   int frameSkip = -1;
 	float pos = 0.0;
+	RenderCacheWriter recorder;
 	setInterp();
 
 	const char * slash = strrchr(filename, '/');
@@ -330,12 +359,25 @@ bool XSFPlugin::play(const char *filename, VFSFile &file)
     if (!recursiveLoad2SF(rom, &xsf, 0) || !rom.size())
       return false;
 
-    if (NDS_Init())
-      return false;
+    frameSkip = xsf.GetTagValue<int>("_frames", -1);
 
     int sampleRate = aud_get_int(CFG_ID, "sample_rate");
     if (sampleRate < 11025 || sampleRate > 96000)
       sampleRate = 32728;
+
+    String key = cache_key(rom, length, fade, frameSkip, sampleRate);
+    if (key) {
+      if (render_cache_play(key, 2, sampleRate)) {
+        dirpath = String();
+        return true;
+      }
+
+      recorder.open(key, 2, sampleRate);
+    }
+
+    if (NDS_Init())
+      return false;
+
     SetDesmumeSampleRate(sampleRate); // TODO: config
     int BUFFERSIZE = DESMUME_SAMPLE_RATE / 59.837; //truncates to 737, the traditional value, for 44100
     SPU_ChangeSoundCore(SNDIFID_2SF, BUFFERSIZE);
@@ -346,7 +388,6 @@ bool XSFPlugin::play(const char *filename, VFSFile &file)
     NDS_SetROM(rom.data(), rom.size());
     gameInfo.loadData((char*)rom.data(), rom.size());
 
-    frameSkip = xsf.GetTagValue<int>("_frames", -1);
     CommonSettings.rigorous_timing = true;
     CommonSettings.spu_advanced = true;
     CommonSettings.advanced_timing = true;
@@ -363,6 +404,8 @@ bool XSFPlugin::play(const char *filename, VFSFile &file)
 
       if (seek_value >= 0)
       {
+        recorder.discard();
+
         if (seek_value < pos) {
           xsf_reset(frameSkip);
           pos = 0;
@@ -394,10 +437,15 @@ bool XSFPlugin::play(const char *filename, VFSFile &file)
           }
         }
         write_audio(front.data(), front.size());
+        if (recorder.is_open())
+          recorder.write(reinterpret_cast<const int16_t*>(front.data()), front.size() / 4);
         pos += front.size() * 1000 / DESMUME_SAMPLE_RATE / 4;
         buffer_rope.pop_front();
       }
     }
+
+    if (recorder.is_open() && !check_stop() && pos >= length && !ignore_length)
+      recorder.finish();
   } catch (std::exception& e) {
     std::cerr << "Exception: " << e.what() << std::endl;
     error = true;
@@ -443,7 +491,8 @@ const PreferencesWidget XSFPlugin::widgets[] = {
   WidgetCheck(N_("Ignore length from file"), WidgetBool(CFG_ID, "ignore_length", [] { ignore_length = aud_get_bool(CFG_ID, "ignore_length"); } )),
   WidgetSpin(N_("Default fade time:"), WidgetInt(CFG_ID, "fade"), { 0, 15000, 100, N_("ms") }),
   WidgetCombo(N_("Sample rate:"), WidgetInt(CFG_ID, "sample_rate"), {{ sampleRateItems }}),
-  WidgetCombo(N_("Interpolation mode:"), WidgetString(CFG_ID, "interpolation_mode", setInterp), {{ interpItems }})
+  WidgetCombo(N_("Interpolation mode:"), WidgetString(CFG_ID, "interpolation_mode", setInterp), {{ interpItems }}),
+  WidgetBox({{render_cache_record_widgets}})
 };
 
 const PluginPreferences XSFPlugin::prefs = {{widgets}};